@@ -7,6 +7,7 @@
 #include <regex>
 #include <utility>
 
+#include "flutter/fml/async_file.h"
 #include "flutter/fml/eintr_wrapper.h"
 #include "flutter/fml/file.h"
 #include "flutter/fml/mapping.h"
@@ -69,6 +70,11 @@ std::vector<std::unique_ptr<fml::Mapping>> DirectoryAssetBundle::GetAsMappings(
     return mappings;
   }
 
+  // Only the files are opened while visiting the directories, they are read
+  // in parallel afterwards.
+  std::vector<std::pair<std::string,
+                        std::future<std::unique_ptr<fml::Mapping>>>>
+      reads;
   std::regex asset_regex(asset_pattern);
   fml::FileVisitor visitor = [&](const fml::UniqueFD& directory,
                                  const std::string& filename) {
@@ -84,13 +90,7 @@ std::vector<std::unique_ptr<fml::Mapping>> DirectoryAssetBundle::GetAsMappings(
         return true;
       }
 
-      auto mapping = std::make_unique<fml::FileMapping>(fd);
-
-      if (mapping && mapping->IsValid()) {
-        mappings.push_back(std::move(mapping));
-      } else {
-        FML_LOG(ERROR) << "Mapping " << filename << " failed";
-      }
+      reads.emplace_back(filename, fml::ReadFileAsync(std::move(fd)));
     }
     return true;
   };
@@ -107,6 +107,15 @@ std::vector<std::unique_ptr<fml::Mapping>> DirectoryAssetBundle::GetAsMappings(
     fml::VisitFiles(subdir_fd, visitor);
   }
 
+  for (auto& [filename, read] : reads) {
+    auto mapping = read.get();
+    if (mapping) {
+      mappings.push_back(std::move(mapping));
+    } else {
+      FML_LOG(ERROR) << "Mapping " << filename << " failed";
+    }
+  }
+
   return mappings;
 }
 
@@ -4,11 +4,14 @@
 
 #include "flutter/common/graphics/persistent_cache.h"
 
+#include <algorithm>
 #include <future>
+#include <limits>
 #include <memory>
 #include <string>
 #include <string_view>
 
+#include "flutter/fml/async_file.h"
 #include "flutter/fml/base32.h"
 #include "flutter/fml/file.h"
 #include "flutter/fml/logging.h"
@@ -51,6 +54,7 @@ bool PersistentCache::gIsReadOnly = false;
 
 std::atomic<bool> PersistentCache::cache_sksl_ = false;
 std::atomic<bool> PersistentCache::strategy_set_ = false;
+std::atomic<bool> PersistentCache::defer_sksl_precompilation_ = false;
 
 void PersistentCache::SetCacheSkSL(bool value) {
   if (strategy_set_ && value != cache_sksl_) {
@@ -61,6 +65,10 @@ void PersistentCache::SetCacheSkSL(bool value) {
   cache_sksl_ = value;
 }
 
+void PersistentCache::SetDeferSkSLPrecompilation(bool value) {
+  defer_sksl_precompilation_ = value;
+}
+
 PersistentCache* PersistentCache::GetCacheForProcess() {
   std::scoped_lock lock(instance_mutex_);
   if (gPersistentCache == nullptr) {
@@ -104,13 +112,24 @@ bool PersistentCache::Purge() {
       removed.set_value(false);
     }
   });
-  return removed.get_future().get();
+  bool result = removed.get_future().get();
+  // The archive would otherwise keep serving the purged SkSLs.
+  sksl_archive_->Discard();
+  return result;
 }
 
 namespace {
 
 constexpr char kEngineComponent[] = "flutter_engine";
 
+// How long the SkSL usage is gathered before being saved, so that a burst of
+// shader compilations results in a single write.
+constexpr fml::TimeDelta kSkSLUsageSaveDelay = fml::TimeDelta::FromSeconds(5);
+
+std::string SkDataToString(const SkData& data) {
+  return std::string(reinterpret_cast<const char*>(data.data()), data.size());
+}
+
 static void FreeOldCacheDirectory(const fml::UniqueFD& cache_base_dir) {
   fml::UniqueFD engine_dir =
       fml::OpenDirectoryReadOnly(cache_base_dir, kEngineComponent);
@@ -192,7 +211,7 @@ sk_sp<SkData> ParseBase64(const std::string& input) {
   return data;
 }
 
-size_t PersistentCache::PrecompileKnownSkSLs(GrDirectContext* context) const {
+size_t PersistentCache::PrecompileKnownSkSLs(GrDirectContext* context) {
   auto known_sksls = LoadSkSLs();
   // A trace must be present even if no precompilations have been completed.
   FML_TRACE_EVENT("flutter", "PersistentCache::PrecompileKnownSkSLs", "count",
@@ -202,31 +221,109 @@ size_t PersistentCache::PrecompileKnownSkSLs(GrDirectContext* context) const {
     return 0;
   }
 
+  // The SkSLs used by the first frame are sorted first by |LoadSkSLs|.
+  auto first_deferred = known_sksls.end();
+  if (defer_sksl_precompilation_) {
+    first_deferred = std::find_if(
+        known_sksls.begin(), known_sksls.end(), [this](const SkSLCache& sksl) {
+          auto priority = sksl_usage_->GetPriority(SkDataToString(*sksl.first));
+          return !priority || !priority->is_used_by_first_frame;
+        });
+  }
+
+  size_t precompiled_count = 0;
+  for (auto sksl = known_sksls.begin(); sksl != first_deferred; ++sksl) {
+    TRACE_EVENT0("flutter", "PrecompilingSkSL");
+    if (context->precompileShader(*sksl->first, *sksl->second)) {
+      precompiled_count++;
+    }
+  }
+
+  std::scoped_lock lock(sksl_precompilation_mutex_);
+  sksl_precompilation_context_ = context;
+  pending_sksl_precompilations_.assign(first_deferred, known_sksls.end());
+  sksl_precompilation_progress_ = {known_sksls.size(), precompiled_count,
+                                   pending_sksl_precompilations_.size()};
+  TraceSkSLPrecompilationProgressLocked();
+  return precompiled_count;
+}
+
+bool PersistentCache::HasPendingSkSLPrecompilations(
+    GrDirectContext* context) const {
+  std::scoped_lock lock(sksl_precompilation_mutex_);
+  return context == sksl_precompilation_context_ &&
+         !pending_sksl_precompilations_.empty();
+}
+
+size_t PersistentCache::PrecompilePendingSkSLs(GrDirectContext* context,
+                                               fml::TimeDelta budget) {
+  TRACE_EVENT0("flutter", "PersistentCache::PrecompilePendingSkSLs");
+  if (context == nullptr) {
+    return 0;
+  }
+  const fml::TimePoint deadline = fml::TimePoint::Now() + budget;
   size_t precompiled_count = 0;
-  for (const auto& sksl : known_sksls) {
+  // The deadline is checked before each compilation, so that a slice never
+  // starts a compilation once its budget is spent.
+  while (fml::TimePoint::Now() < deadline) {
+    SkSLCache sksl;
+    {
+      std::scoped_lock lock(sksl_precompilation_mutex_);
+      if (context != sksl_precompilation_context_ ||
+          pending_sksl_precompilations_.empty()) {
+        break;
+      }
+      sksl = std::move(pending_sksl_precompilations_.front());
+      pending_sksl_precompilations_.pop_front();
+      sksl_precompilation_progress_.pending_count =
+          pending_sksl_precompilations_.size();
+    }
+    // The lock is not held while compiling, which may take several
+    // milliseconds.
     TRACE_EVENT0("flutter", "PrecompilingSkSL");
     if (context->precompileShader(*sksl.first, *sksl.second)) {
       precompiled_count++;
     }
   }
 
+  std::scoped_lock lock(sksl_precompilation_mutex_);
+  if (context == sksl_precompilation_context_) {
+    sksl_precompilation_progress_.precompiled_count += precompiled_count;
+    TraceSkSLPrecompilationProgressLocked();
+  }
+  return precompiled_count;
+}
+
+PersistentCache::SkSLPrecompilationProgress
+PersistentCache::GetSkSLPrecompilationProgress() const {
+  std::scoped_lock lock(sksl_precompilation_mutex_);
+  return sksl_precompilation_progress_;
+}
+
+void PersistentCache::TraceSkSLPrecompilationProgressLocked() const {
+  const SkSLPrecompilationProgress& progress = sksl_precompilation_progress_;
   FML_TRACE_COUNTER("flutter", "PersistentCache::PrecompiledSkSLs",
                     reinterpret_cast<int64_t>(this),  // Trace Counter ID
-                    "Successful", precompiled_count);
-  return precompiled_count;
+                    "Successful", progress.precompiled_count, "Pending",
+                    progress.pending_count);
+}
+
+void PersistentCache::MarkFirstFrameRasterized() {
+  sksl_usage_->MarkFirstFrameRasterized();
 }
 
 std::vector<PersistentCache::SkSLCache> PersistentCache::LoadSkSLs() const {
   TRACE_EVENT0("flutter", "PersistentCache::LoadSkSLs");
   std::vector<PersistentCache::SkSLCache> result;
-  fml::FileVisitor visitor = [&result](const fml::UniqueFD& directory,
-                                       const std::string& filename) {
-    sk_sp<SkData> key = ParseBase32(filename);
-    sk_sp<SkData> data = LoadFile(directory, filename);
-    if (key != nullptr && data != nullptr) {
-      result.push_back({key, data});
-    } else {
-      FML_LOG(ERROR) << "Failed to load: " << filename;
+  // The files are read in parallel once they have all been found.
+  std::vector<std::string> filenames;
+  fml::FileVisitor visitor = [&filenames](const fml::UniqueFD& directory,
+                                          const std::string& filename) {
+    // The archive is visited separately. The shaders stored one per file are
+    // only left next to it by read-only caches, which do not migrate them.
+    if (filename.rfind(SkSLArchive::kFileName, 0) != 0 &&
+        filename != SkSLUsage::kFileName) {
+      filenames.push_back(filename);
     }
     return true;
   };
@@ -235,12 +332,36 @@ std::vector<PersistentCache::SkSLCache> PersistentCache::LoadSkSLs() const {
   // However, we'd like to continue visit the asset dir even if this persistent
   // cache is invalid.
   if (IsValid()) {
+    sksl_archive_->VisitEntries(
+        [&result](const fml::Mapping& key, const fml::Mapping& value) {
+          if (key.GetSize() == 0 || value.GetSize() == 0) {
+            return;
+          }
+          result.push_back(
+              {SkData::MakeWithCopy(key.GetMapping(), key.GetSize()),
+               SkData::MakeWithCopy(value.GetMapping(), value.GetSize())});
+        });
+
     // In case `rewinddir` doesn't work reliably, load SkSLs from a freshly
     // opened directory (https://github.com/flutter/flutter/issues/65258).
     fml::UniqueFD fresh_dir =
         fml::OpenDirectoryReadOnly(*cache_directory_, kSkSLSubdirName);
     if (fresh_dir.is_valid()) {
       fml::VisitFiles(fresh_dir, visitor);
+      auto mappings = fml::ReadFilesInParallel(fresh_dir, filenames);
+      for (size_t i = 0; i < filenames.size(); i++) {
+        sk_sp<SkData> key = ParseBase32(filenames[i]);
+        sk_sp<SkData> data;
+        if (mappings[i] && mappings[i]->GetSize() > 0) {
+          data = SkData::MakeWithCopy(mappings[i]->GetMapping(),
+                                      mappings[i]->GetSize());
+        }
+        if (key != nullptr && data != nullptr) {
+          result.push_back({key, data});
+        } else {
+          FML_LOG(ERROR) << "Failed to load: " << filenames[i];
+        }
+      }
     }
   }
 
@@ -271,21 +392,49 @@ std::vector<PersistentCache::SkSLCache> PersistentCache::LoadSkSLs() const {
     }
   }
 
-  return result;
+  // Sort the SkSLs used by the previous runs first, in their priority order.
+  std::vector<size_t> ranks;
+  ranks.reserve(result.size());
+  for (const SkSLCache& sksl : result) {
+    auto priority = sksl_usage_->GetPriority(SkDataToString(*sksl.first));
+    ranks.push_back(priority ? priority->rank
+                              : std::numeric_limits<size_t>::max());
+  }
+  std::vector<size_t> order(result.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), [&ranks](size_t a, size_t b) {
+    return ranks[a] < ranks[b];
+  });
+  std::vector<SkSLCache> sorted_result;
+  sorted_result.reserve(result.size());
+  for (size_t i : order) {
+    sorted_result.push_back(std::move(result[i]));
+  }
+  return sorted_result;
 }
 
 PersistentCache::PersistentCache(bool read_only)
     : is_read_only_(read_only),
       cache_directory_(MakeCacheDirectory(cache_base_path_, read_only, false)),
       sksl_cache_directory_(
-          MakeCacheDirectory(cache_base_path_, read_only, true)) {
+          MakeCacheDirectory(cache_base_path_, read_only, true)),
+      sksl_archive_(
+          std::make_shared<SkSLArchive>(sksl_cache_directory_, read_only)),
+      sksl_usage_(std::make_shared<SkSLUsage>(sksl_cache_directory_)) {
   if (!IsValid()) {
     FML_LOG(WARNING) << "Could not acquire the persistent cache directory. "
                         "Caching of GPU resources on disk is disabled.";
   }
 }
 
-PersistentCache::~PersistentCache() = default;
+PersistentCache::~PersistentCache() {
+  // Does nothing if no SkSL use was recorded.
+  if (!is_read_only_) {
+    sksl_usage_->Save();
+  }
+}
 
 bool PersistentCache::IsValid() const {
   return cache_directory_ && cache_directory_->is_valid();
@@ -310,6 +459,7 @@ sk_sp<SkData> PersistentCache::load(const SkData& key) {
   if (!IsValid()) {
     return nullptr;
   }
+  RecordSkSLUse(key);
   auto file_name = SkKeyToFilePath(key);
   if (file_name.size() == 0) {
     return nullptr;
@@ -349,6 +499,31 @@ static void PersistentCacheStore(fml::RefPtr<fml::TaskRunner> worker,
   }
 }
 
+static void SkSLArchiveStore(fml::RefPtr<fml::TaskRunner> worker,
+                             std::shared_ptr<SkSLArchive> archive,
+                             std::unique_ptr<fml::Mapping> key,
+                             std::unique_ptr<fml::Mapping> value) {
+  auto task = fml::MakeCopyable([archive,                  //
+                                 key = std::move(key),     //
+                                 value = std::move(value)  //
+  ]() mutable {
+    TRACE_EVENT0("flutter", "SkSLArchiveStore");
+    if (!archive->Append(*key, *value)) {
+      FML_LOG(WARNING) << "Could not write the SkSL to the archive.";
+    }
+  });
+
+  if (!worker) {
+    FML_LOG(WARNING)
+        << "The persistent cache has no available workers. Performing the task "
+           "on the current thread. This slow operation is going to occur on a "
+           "frame workload.";
+    task();
+  } else {
+    worker->PostTask(std::move(task));
+  }
+}
+
 // |GrContextOptions::PersistentCache|
 void PersistentCache::store(const SkData& key, const SkData& data) {
   stored_new_shaders_ = true;
@@ -374,9 +549,33 @@ void PersistentCache::store(const SkData& key, const SkData& data) {
     return;
   }
 
-  PersistentCacheStore(GetWorkerTaskRunner(),
-                       cache_sksl_ ? sksl_cache_directory_ : cache_directory_,
-                       std::move(file_name), std::move(mapping));
+  if (cache_sksl_) {
+    SkSLArchiveStore(GetWorkerTaskRunner(), sksl_archive_,
+                     std::make_unique<fml::DataMapping>(std::vector<uint8_t>{
+                         key.bytes(), key.bytes() + key.size()}),
+                     std::move(mapping));
+  } else {
+    PersistentCacheStore(GetWorkerTaskRunner(), cache_directory_,
+                         std::move(file_name), std::move(mapping));
+  }
+}
+
+void PersistentCache::RecordSkSLUse(const SkData& key) {
+  // The usage only orders deferred precompilations, so it is neither recorded
+  // nor saved when nothing will read it.
+  if (is_read_only_ || !cache_sksl_ || !defer_sksl_precompilation_ ||
+      key.size() == 0) {
+    return;
+  }
+  if (!sksl_usage_->RecordUse(SkDataToString(key))) {
+    return;
+  }
+  // Without a worker, the usage is saved when the cache is destroyed.
+  if (auto worker = GetWorkerTaskRunner()) {
+    worker->PostDelayedTask(
+        [sksl_usage = sksl_usage_]() { sksl_usage->Save(); },
+        kSkSLUsageSaveDelay);
+  }
 }
 
 void PersistentCache::DumpSkp(const SkData& data) {
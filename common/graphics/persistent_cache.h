@@ -5,13 +5,17 @@
 #ifndef FLUTTER_COMMON_GRAPHICS_PERSISTENT_CACHE_H_
 #define FLUTTER_COMMON_GRAPHICS_PERSISTENT_CACHE_H_
 
+#include <deque>
 #include <memory>
 #include <mutex>
 #include <set>
 
 #include "flutter/assets/asset_manager.h"
+#include "flutter/common/graphics/sksl_archive.h"
+#include "flutter/common/graphics/sksl_usage.h"
 #include "flutter/fml/macros.h"
 #include "flutter/fml/task_runner.h"
+#include "flutter/fml/time/time_delta.h"
 #include "flutter/fml/unique_fd.h"
 #include "third_party/skia/include/gpu/GrContextOptions.h"
 
@@ -71,13 +75,29 @@ class PersistentCache : public GrContextOptions::PersistentCache {
 
   using SkSLCache = std::pair<sk_sp<SkData>, sk_sp<SkData>>;
 
-  /// Load all the SkSL shader caches in the right directory.
+  struct SkSLPrecompilationProgress {
+    /// The number of SkSLs to precompile in the current context.
+    size_t total_count = 0;
+    /// The number of SkSLs successfully precompiled so far.
+    size_t precompiled_count = 0;
+    /// The number of SkSLs left to precompile while the raster thread is
+    /// idle.
+    size_t pending_count = 0;
+  };
+
+  /// Load all the SkSL shader caches in the right directory. The SkSLs used by
+  /// the first frame of the previous runs come first, in the order they were
+  /// used, followed by the other SkSLs from the most to the least used.
   std::vector<SkSLCache> LoadSkSLs() const;
 
   //----------------------------------------------------------------------------
   /// @brief      Precompile SkSLs packaged with the application and gathered
   ///             during previous runs in the given context.
   ///
+  ///             If the precompilation is deferred, only the SkSLs used by the
+  ///             first frame of the previous runs are precompiled. The others
+  ///             are left to |PrecompilePendingSkSLs|.
+  ///
   /// @warning    The context must be the rendering context. This context may be
   ///             destroyed during application suspension and subsequently
   ///             recreated. The SkSLs must be precompiled again in the new
@@ -87,7 +107,30 @@ class PersistentCache : public GrContextOptions::PersistentCache {
   ///
   /// @return     The number of SkSLs precompiled.
   ///
-  size_t PrecompileKnownSkSLs(GrDirectContext* context) const;
+  size_t PrecompileKnownSkSLs(GrDirectContext* context);
+
+  /// Whether SkSLs deferred by |PrecompileKnownSkSLs| remain to be
+  /// precompiled in |context|.
+  bool HasPendingSkSLPrecompilations(GrDirectContext* context) const;
+
+  //----------------------------------------------------------------------------
+  /// @brief      Precompile the SkSLs deferred by |PrecompileKnownSkSLs| until
+  ///             |budget| is exhausted.
+  ///
+  /// @param      context  The rendering context given to
+  ///                      |PrecompileKnownSkSLs|.
+  /// @param      budget   The time after which no more SkSLs are precompiled.
+  ///
+  /// @return     The number of SkSLs precompiled.
+  ///
+  size_t PrecompilePendingSkSLs(GrDirectContext* context,
+                                fml::TimeDelta budget);
+
+  SkSLPrecompilationProgress GetSkSLPrecompilationProgress() const;
+
+  /// Marks the end of the first frame, so the SkSLs used until then are
+  /// precompiled first by the next runs.
+  void MarkFirstFrameRasterized();
 
   // Return mappings for all skp's accessible through the AssetManager
   std::vector<std::unique_ptr<fml::Mapping>> GetSkpsFromAssetManager() const;
@@ -103,6 +146,14 @@ class PersistentCache : public GrContextOptions::PersistentCache {
 
   static void SetCacheSkSL(bool value);
 
+  static bool defer_sksl_precompilation() {
+    return defer_sksl_precompilation_;
+  }
+
+  // If true, |PrecompileKnownSkSLs| only precompiles the SkSLs needed by the
+  // first frame, and leaves the others to |PrecompilePendingSkSLs|.
+  static void SetDeferSkSLPrecompilation(bool value);
+
   static void MarkStrategySet() { strategy_set_ = true; }
 
   static constexpr char kSkSLSubdirName[] = "sksl";
@@ -126,12 +177,24 @@ class PersistentCache : public GrContextOptions::PersistentCache {
   // strategy_set_ becomes true.
   static std::atomic<bool> strategy_set_;
 
+  static std::atomic<bool> defer_sksl_precompilation_;
+
   const bool is_read_only_;
   const std::shared_ptr<fml::UniqueFD> cache_directory_;
   const std::shared_ptr<fml::UniqueFD> sksl_cache_directory_;
+  // The SkSLs, packed into a single file of |sksl_cache_directory_|.
+  const std::shared_ptr<SkSLArchive> sksl_archive_;
+  const std::shared_ptr<SkSLUsage> sksl_usage_;
   mutable std::mutex worker_task_runners_mutex_;
   std::multiset<fml::RefPtr<fml::TaskRunner>> worker_task_runners_;
 
+  mutable std::mutex sksl_precompilation_mutex_;
+  // The context the pending SkSLs are precompiled in. It is only compared
+  // against and never dereferenced.
+  GrDirectContext* sksl_precompilation_context_ = nullptr;
+  std::deque<SkSLCache> pending_sksl_precompilations_;
+  SkSLPrecompilationProgress sksl_precompilation_progress_;
+
   bool stored_new_shaders_ = false;
   bool is_dumping_skp_ = false;
 
@@ -147,6 +210,10 @@ class PersistentCache : public GrContextOptions::PersistentCache {
 
   fml::RefPtr<fml::TaskRunner> GetWorkerTaskRunner() const;
 
+  void RecordSkSLUse(const SkData& key);
+
+  void TraceSkSLPrecompilationProgressLocked() const;
+
   friend class testing::ShellTest;
 
   FML_DISALLOW_COPY_AND_ASSIGN(PersistentCache);
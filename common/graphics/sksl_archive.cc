@@ -0,0 +1,478 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/common/graphics/sksl_archive.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "flutter/fml/async_file.h"
+#include "flutter/fml/base32.h"
+#include "flutter/fml/file.h"
+#include "flutter/fml/logging.h"
+#include "flutter/fml/trace_event.h"
+
+namespace flutter {
+
+namespace {
+
+// "FSKA" and "FSKR" in little endian.
+constexpr uint32_t kArchiveMagic = 0x414b5346;
+constexpr uint32_t kRecordMagic = 0x524b5346;
+constexpr uint32_t kArchiveVersion = 1;
+
+struct Header {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t entry_count;
+  // The size of the header, the index and the indexed entries. The appended
+  // records follow.
+  uint64_t data_size;
+};
+
+struct RecordHeader {
+  uint32_t magic;
+  uint32_t key_size;
+  uint32_t value_size;
+  uint32_t checksum;
+};
+
+constexpr uint64_t kHashOffsetBasis = 14695981039346656037ull;
+
+// FNV-1a.
+uint64_t Hash(const uint8_t* data,
+              size_t size,
+              uint64_t hash = kHashOffsetBasis) {
+  for (size_t i = 0; i < size; i++) {
+    hash ^= data[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+uint64_t HashKey(const std::string& key) {
+  return Hash(reinterpret_cast<const uint8_t*>(key.data()), key.size());
+}
+
+uint32_t Checksum(const uint8_t* key,
+                  size_t key_size,
+                  const uint8_t* value,
+                  size_t value_size) {
+  return static_cast<uint32_t>(Hash(value, value_size, Hash(key, key_size)));
+}
+
+template <class T>
+T ReadAt(const uint8_t* data) {
+  T result;
+  memcpy(&result, data, sizeof(T));
+  return result;
+}
+
+std::string ToString(const uint8_t* data, size_t size) {
+  if (size == 0) {
+    return std::string();
+  }
+  return std::string(reinterpret_cast<const char*>(data), size);
+}
+
+const uint8_t* ToBytes(const std::string& string) {
+  return reinterpret_cast<const uint8_t*>(string.data());
+}
+
+bool FitsInRecord(const std::string& key, const std::string& value) {
+  return key.size() <= std::numeric_limits<uint32_t>::max() &&
+         value.size() <= std::numeric_limits<uint32_t>::max();
+}
+
+}  // namespace
+
+SkSLArchive::SkSLArchive(std::shared_ptr<fml::UniqueFD> directory,
+                         bool read_only)
+    : directory_(std::move(directory)), read_only_(read_only) {}
+
+SkSLArchive::~SkSLArchive() = default;
+
+size_t SkSLArchive::GetEntryCount() {
+  std::scoped_lock lock(mutex_);
+  EnsureLoadedLocked();
+  size_t count = appended_entries_.size();
+  for (size_t i = 0; i < index_count_; i++) {
+    const IndexEntry entry = GetIndexEntryLocked(i);
+    const uint8_t* key = mapping_->GetMapping() + entry.offset;
+    if (appended_entries_.count(ToString(key, entry.key_size)) == 0) {
+      count++;
+    }
+  }
+  return count;
+}
+
+std::unique_ptr<fml::Mapping> SkSLArchive::Find(const fml::Mapping& key) {
+  std::scoped_lock lock(mutex_);
+  EnsureLoadedLocked();
+  const std::string key_string = ToString(key.GetMapping(), key.GetSize());
+  auto appended_entry = appended_entries_.find(key_string);
+  if (appended_entry != appended_entries_.end()) {
+    return std::make_unique<fml::DataMapping>(appended_entry->second);
+  }
+  IndexEntry entry;
+  if (!FindIndexEntryLocked(key_string, &entry)) {
+    return nullptr;
+  }
+  const uint8_t* value =
+      mapping_->GetMapping() + entry.offset + entry.key_size;
+  return std::make_unique<fml::DataMapping>(
+      std::vector<uint8_t>{value, value + entry.value_size});
+}
+
+void SkSLArchive::VisitEntries(const EntryVisitor& visitor) {
+  std::scoped_lock lock(mutex_);
+  EnsureLoadedLocked();
+  for (size_t i = 0; i < index_count_; i++) {
+    const IndexEntry entry = GetIndexEntryLocked(i);
+    const uint8_t* key = mapping_->GetMapping() + entry.offset;
+    if (!appended_entries_.empty() &&
+        appended_entries_.count(ToString(key, entry.key_size)) > 0) {
+      continue;
+    }
+    visitor(fml::NonOwnedMapping(key, entry.key_size),
+            fml::NonOwnedMapping(key + entry.key_size, entry.value_size));
+  }
+  for (const auto& [key, value] : appended_entries_) {
+    visitor(fml::NonOwnedMapping(ToBytes(key), key.size()),
+            fml::NonOwnedMapping(ToBytes(value), value.size()));
+  }
+}
+
+bool SkSLArchive::Append(const fml::Mapping& key, const fml::Mapping& value) {
+  std::scoped_lock lock(mutex_);
+  if (read_only_ || !directory_ || !directory_->is_valid()) {
+    return false;
+  }
+  EnsureLoadedLocked();
+
+  std::string key_string = ToString(key.GetMapping(), key.GetSize());
+  std::string value_string = ToString(value.GetMapping(), value.GetSize());
+  if (!FitsInRecord(key_string, value_string)) {
+    return false;
+  }
+
+  // Skia may store the same shader again, which does not need to grow the
+  // archive.
+  auto appended_entry = appended_entries_.find(key_string);
+  if (appended_entry != appended_entries_.end()) {
+    if (appended_entry->second == value_string) {
+      return true;
+    }
+  } else {
+    IndexEntry entry;
+    if (FindIndexEntryLocked(key_string, &entry) &&
+        entry.value_size == value_string.size() &&
+        memcmp(mapping_->GetMapping() + entry.offset + entry.key_size,
+               value_string.data(), value_string.size()) == 0) {
+      return true;
+    }
+  }
+
+  if (!file_.is_valid() && !CompactLocked()) {
+    return false;
+  }
+
+  const RecordHeader record = {
+      kRecordMagic,
+      static_cast<uint32_t>(key_string.size()),
+      static_cast<uint32_t>(value_string.size()),
+      Checksum(ToBytes(key_string), key_string.size(), ToBytes(value_string),
+               value_string.size()),
+  };
+  std::vector<uint8_t> buffer(sizeof(RecordHeader) + key_string.size() +
+                              value_string.size());
+  memcpy(buffer.data(), &record, sizeof(RecordHeader));
+  std::copy(key_string.begin(), key_string.end(),
+            buffer.begin() + sizeof(RecordHeader));
+  std::copy(value_string.begin(), value_string.end(),
+            buffer.begin() + sizeof(RecordHeader) + key_string.size());
+
+  if (!fml::AppendToFile(file_,
+                         fml::NonOwnedMapping(buffer.data(), buffer.size()))) {
+    FML_LOG(WARNING) << "Could not append to the SkSL archive.";
+    // Do not leave a partial record for the next ones to follow.
+    fml::TruncateFile(file_, file_size_);
+    return false;
+  }
+  file_size_ += buffer.size();
+  appended_entries_[std::move(key_string)] = std::move(value_string);
+  appended_record_count_++;
+  return true;
+}
+
+bool SkSLArchive::Compact() {
+  std::scoped_lock lock(mutex_);
+  EnsureLoadedLocked();
+  return CompactLocked();
+}
+
+void SkSLArchive::Discard() {
+  std::scoped_lock lock(mutex_);
+  ResetLocked();
+  is_loaded_ = false;
+}
+
+void SkSLArchive::EnsureLoadedLocked() {
+  if (!directory_ || !directory_->is_valid()) {
+    is_loaded_ = true;
+    return;
+  }
+  // Reload the archive if it was removed or created behind our back, such as
+  // when the cache directory is cleared.
+  if (is_loaded_ &&
+      file_.is_valid() == fml::FileExists(*directory_, kFileName)) {
+    return;
+  }
+  is_loaded_ = true;
+
+  TRACE_EVENT0("flutter", "SkSLArchive::Load");
+  const bool is_valid = LoadLocked();
+  if (read_only_) {
+    return;
+  }
+  const std::vector<std::string> migrated_files = MigrateFilesLocked();
+  if (is_valid && migrated_files.empty() &&
+      appended_record_count_ <= kMaxAppendedEntries) {
+    return;
+  }
+  if (!CompactLocked()) {
+    return;
+  }
+  // The migrated shaders are only removed once they are safely archived.
+  for (const std::string& file_name : migrated_files) {
+    fml::UnlinkFile(*directory_, file_name.c_str());
+  }
+}
+
+void SkSLArchive::ResetLocked() {
+  mapping_.reset();
+  file_.reset();
+  file_size_ = 0;
+  index_ = nullptr;
+  index_count_ = 0;
+  appended_entries_.clear();
+  appended_record_count_ = 0;
+}
+
+bool SkSLArchive::LoadLocked() {
+  ResetLocked();
+
+  fml::UniqueFD file =
+      fml::OpenFile(*directory_, kFileName, false,
+                    read_only_ ? fml::FilePermission::kRead
+                               : fml::FilePermission::kReadWrite);
+  if (!file.is_valid()) {
+    return false;
+  }
+  auto mapping = std::make_unique<fml::FileMapping>(file);
+  const uint8_t* data = mapping->GetMapping();
+  const size_t size = mapping->GetSize();
+  if (data == nullptr || size < sizeof(Header)) {
+    FML_LOG(WARNING) << "Discarding the invalid SkSL archive.";
+    return false;
+  }
+
+  const Header header = ReadAt<Header>(data);
+  const size_t index_end =
+      sizeof(Header) + header.entry_count * sizeof(IndexEntry);
+  if (header.magic != kArchiveMagic || header.version != kArchiveVersion ||
+      header.data_size < sizeof(Header) || header.data_size > size ||
+      header.entry_count >
+          (header.data_size - sizeof(Header)) / sizeof(IndexEntry)) {
+    FML_LOG(WARNING) << "Discarding the invalid SkSL archive.";
+    return false;
+  }
+  for (size_t i = 0; i < header.entry_count; i++) {
+    const IndexEntry entry =
+        ReadAt<IndexEntry>(data + sizeof(Header) + i * sizeof(IndexEntry));
+    if (entry.offset < index_end || entry.offset > header.data_size ||
+        uint64_t{entry.key_size} + entry.value_size >
+            header.data_size - entry.offset) {
+      FML_LOG(WARNING) << "Discarding the invalid SkSL archive.";
+      return false;
+    }
+  }
+  index_ = data + sizeof(Header);
+  index_count_ = header.entry_count;
+
+  size_t offset = header.data_size;
+  while (size - offset >= sizeof(RecordHeader)) {
+    const RecordHeader record = ReadAt<RecordHeader>(data + offset);
+    const size_t record_size =
+        sizeof(RecordHeader) + size_t{record.key_size} + record.value_size;
+    if (record.magic != kRecordMagic || record_size > size - offset) {
+      break;
+    }
+    const uint8_t* key = data + offset + sizeof(RecordHeader);
+    const uint8_t* value = key + record.key_size;
+    if (Checksum(key, record.key_size, value, record.value_size) !=
+        record.checksum) {
+      break;
+    }
+    appended_entries_[ToString(key, record.key_size)] =
+        ToString(value, record.value_size);
+    appended_record_count_++;
+    offset += record_size;
+  }
+
+  mapping_ = std::move(mapping);
+  file_ = std::move(file);
+  file_size_ = offset;
+  if (offset != size) {
+    FML_LOG(WARNING) << "Ignoring the torn records of the SkSL archive.";
+    if (!read_only_) {
+      fml::TruncateFile(file_, file_size_);
+    }
+    return false;
+  }
+  return true;
+}
+
+std::vector<std::string> SkSLArchive::MigrateFilesLocked() {
+  // In case `rewinddir` doesn't work reliably, visit a freshly opened
+  // directory (https://github.com/flutter/flutter/issues/65258).
+  fml::UniqueFD directory = fml::OpenDirectoryReadOnly(*directory_, ".");
+  if (!directory.is_valid()) {
+    return {};
+  }
+  std::vector<std::string> file_names;
+  fml::VisitFiles(directory, [&file_names](const fml::UniqueFD& directory,
+                                           const std::string& file_name) {
+    if (file_name.rfind(kFileName, 0) != 0 &&
+        !fml::IsDirectory(directory, file_name.c_str())) {
+      file_names.push_back(file_name);
+    }
+    return true;
+  });
+  if (file_names.empty()) {
+    return {};
+  }
+
+  TRACE_EVENT0("flutter", "SkSLArchive::MigrateFiles");
+  std::vector<std::string> migrated_files;
+  auto mappings = fml::ReadFilesInParallel(directory, file_names);
+  for (size_t i = 0; i < file_names.size(); i++) {
+    // The files are named after the Base32 encoding of their keys.
+    auto [is_key, key] = fml::Base32Decode(file_names[i]);
+    if (!is_key || !mappings[i] || mappings[i]->GetSize() == 0) {
+      continue;
+    }
+    IndexEntry entry;
+    if (appended_entries_.count(key) == 0 &&
+        !FindIndexEntryLocked(key, &entry)) {
+      appended_entries_[key] =
+          ToString(mappings[i]->GetMapping(), mappings[i]->GetSize());
+    }
+    migrated_files.push_back(file_names[i]);
+  }
+  return migrated_files;
+}
+
+bool SkSLArchive::CompactLocked() {
+  if (read_only_ || !directory_ || !directory_->is_valid()) {
+    return false;
+  }
+  TRACE_EVENT0("flutter", "SkSLArchive::Compact");
+
+  struct Blob {
+    uint64_t key_hash;
+    const uint8_t* key;
+    size_t key_size;
+    const uint8_t* value;
+    size_t value_size;
+  };
+  std::vector<Blob> blobs;
+  for (size_t i = 0; i < index_count_; i++) {
+    const IndexEntry entry = GetIndexEntryLocked(i);
+    const uint8_t* key = mapping_->GetMapping() + entry.offset;
+    if (appended_entries_.count(ToString(key, entry.key_size)) == 0) {
+      blobs.push_back({entry.key_hash, key, entry.key_size,
+                       key + entry.key_size, entry.value_size});
+    }
+  }
+  for (const auto& [key, value] : appended_entries_) {
+    if (FitsInRecord(key, value)) {
+      blobs.push_back({HashKey(key), ToBytes(key), key.size(), ToBytes(value),
+                       value.size()});
+    }
+  }
+  std::sort(blobs.begin(), blobs.end(), [](const Blob& a, const Blob& b) {
+    return a.key_hash < b.key_hash;
+  });
+
+  size_t data_size = sizeof(Header) + blobs.size() * sizeof(IndexEntry);
+  for (const Blob& blob : blobs) {
+    data_size += blob.key_size + blob.value_size;
+  }
+  std::vector<uint8_t> buffer(data_size);
+  const Header header = {kArchiveMagic, kArchiveVersion, blobs.size(),
+                         data_size};
+  memcpy(buffer.data(), &header, sizeof(Header));
+  size_t offset = sizeof(Header) + blobs.size() * sizeof(IndexEntry);
+  for (size_t i = 0; i < blobs.size(); i++) {
+    const Blob& blob = blobs[i];
+    const IndexEntry entry = {blob.key_hash, offset,
+                              static_cast<uint32_t>(blob.key_size),
+                              static_cast<uint32_t>(blob.value_size)};
+    memcpy(buffer.data() + sizeof(Header) + i * sizeof(IndexEntry), &entry,
+           sizeof(IndexEntry));
+    std::copy(blob.key, blob.key + blob.key_size, buffer.begin() + offset);
+    offset += blob.key_size;
+    std::copy(blob.value, blob.value + blob.value_size,
+              buffer.begin() + offset);
+    offset += blob.value_size;
+  }
+
+  // The blobs are copied, so the current archive can be let go of. Windows
+  // does not replace files that are still mapped.
+  ResetLocked();
+  const fml::NonOwnedMapping archive(buffer.data(), buffer.size());
+  if (!fml::WriteAtomically(*directory_, kFileName, archive)) {
+    FML_LOG(WARNING) << "Could not write the SkSL archive.";
+    LoadLocked();
+    return false;
+  }
+  return LoadLocked();
+}
+
+SkSLArchive::IndexEntry SkSLArchive::GetIndexEntryLocked(size_t index) const {
+  return ReadAt<IndexEntry>(index_ + index * sizeof(IndexEntry));
+}
+
+bool SkSLArchive::FindIndexEntryLocked(const std::string& key,
+                                       IndexEntry* entry) const {
+  const uint64_t key_hash = HashKey(key);
+  // Binary search for the first entry with the hash of the key.
+  size_t low = 0;
+  size_t high = index_count_;
+  while (low < high) {
+    const size_t middle = low + (high - low) / 2;
+    if (GetIndexEntryLocked(middle).key_hash < key_hash) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  for (size_t i = low; i < index_count_; i++) {
+    const IndexEntry candidate = GetIndexEntryLocked(i);
+    if (candidate.key_hash != key_hash) {
+      break;
+    }
+    if (candidate.key_size == key.size() &&
+        memcmp(mapping_->GetMapping() + candidate.offset, key.data(),
+               key.size()) == 0) {
+      *entry = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace flutter
@@ -0,0 +1,133 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FLUTTER_COMMON_GRAPHICS_SKSL_ARCHIVE_H_
+#define FLUTTER_COMMON_GRAPHICS_SKSL_ARCHIVE_H_
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "flutter/fml/macros.h"
+#include "flutter/fml/mapping.h"
+#include "flutter/fml/unique_fd.h"
+
+namespace flutter {
+
+/// A single file archive of the SkSL shaders of the persistent cache.
+///
+/// The archive starts with a header, followed by an index of the entries
+/// sorted by the hash of their keys, and by the keys and values of the
+/// entries. The new entries are appended after these as records that carry
+/// their own sizes and checksum. The file is mapped once when the archive is
+/// first used, so that loading the cache only takes a handful of system calls
+/// instead of opening every shader.
+///
+/// Compacting the archive rewrites it atomically with every entry in the
+/// index. This happens when the archive is first used, if too many entries
+/// were appended since the last compaction, or if shaders stored as one file
+/// per shader, in the layout the persistent cache used before, were migrated
+/// into the archive.
+///
+/// Records torn by a crash while appending are ignored, and an archive that
+/// is not valid is discarded. The archive is read again if its file is removed
+/// or created by someone else. It is thread-safe.
+class SkSLArchive {
+ public:
+  static constexpr char kFileName[] = "sksl.archive";
+
+  /// The number of appended entries above which the archive is compacted
+  /// when first used.
+  static constexpr size_t kMaxAppendedEntries = 64;
+
+  using EntryVisitor =
+      std::function<void(const fml::Mapping& key, const fml::Mapping& value)>;
+
+  //----------------------------------------------------------------------------
+  /// @brief      Creates the archive in |directory|. The archive is only read
+  ///             when it is first used.
+  ///
+  /// @param[in]  directory  The directory of the archive, which may also
+  ///                        contain shaders to migrate.
+  /// @param[in]  read_only  Whether to leave the directory untouched. The
+  ///                        shaders stored one per file are not migrated
+  ///                        then.
+  ///
+  SkSLArchive(std::shared_ptr<fml::UniqueFD> directory, bool read_only);
+
+  ~SkSLArchive();
+
+  size_t GetEntryCount();
+
+  /// Returns a copy of the value stored for |key|, or nullptr if there is
+  /// none.
+  std::unique_ptr<fml::Mapping> Find(const fml::Mapping& key);
+
+  /// Calls |visitor| with every entry, while holding the lock of the archive.
+  /// The mappings are only valid during the call.
+  void VisitEntries(const EntryVisitor& visitor);
+
+  /// Stores |value| for |key|, replacing any previous value.
+  bool Append(const fml::Mapping& key, const fml::Mapping& value);
+
+  /// Rewrites the archive atomically with every entry in its index.
+  bool Compact();
+
+  /// Forgets the entries read so far, so the archive is read again from the
+  /// disk when next used. Used when the directory was purged.
+  void Discard();
+
+ private:
+  struct IndexEntry {
+    uint64_t key_hash;
+    // The offset of the key, which is followed by the value.
+    uint64_t offset;
+    uint32_t key_size;
+    uint32_t value_size;
+  };
+
+  const std::shared_ptr<fml::UniqueFD> directory_;
+  const bool read_only_;
+
+  std::mutex mutex_;
+  bool is_loaded_ = false;
+  fml::UniqueFD file_;
+  size_t file_size_ = 0;
+  std::unique_ptr<fml::FileMapping> mapping_;
+  // The entries in the index of |mapping_|.
+  const uint8_t* index_ = nullptr;
+  size_t index_count_ = 0;
+  // The entries appended since the last compaction, which override those in
+  // the index.
+  std::unordered_map<std::string, std::string> appended_entries_;
+  size_t appended_record_count_ = 0;
+
+  void EnsureLoadedLocked();
+
+  void ResetLocked();
+
+  // Maps the archive file and reads its index and appended records. Returns
+  // false if the file is missing or needs to be rewritten.
+  bool LoadLocked();
+
+  // Reads the shaders stored one per file in the directory, and returns the
+  // names of their files.
+  std::vector<std::string> MigrateFilesLocked();
+
+  bool CompactLocked();
+
+  IndexEntry GetIndexEntryLocked(size_t index) const;
+
+  // Finds the indexed entry for |key|, ignoring the appended entries.
+  bool FindIndexEntryLocked(const std::string& key, IndexEntry* entry) const;
+
+  FML_DISALLOW_COPY_AND_ASSIGN(SkSLArchive);
+};
+
+}  // namespace flutter
+
+#endif  // FLUTTER_COMMON_GRAPHICS_SKSL_ARCHIVE_H_
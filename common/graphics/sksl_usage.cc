@@ -0,0 +1,161 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/common/graphics/sksl_usage.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include "flutter/fml/base32.h"
+#include "flutter/fml/file.h"
+#include "flutter/fml/logging.h"
+#include "flutter/fml/mapping.h"
+#include "flutter/fml/trace_event.h"
+
+namespace flutter {
+
+SkSLUsage::SkSLUsage(std::shared_ptr<fml::UniqueFD> directory)
+    : directory_(std::move(directory)) {}
+
+SkSLUsage::~SkSLUsage() = default;
+
+bool SkSLUsage::RecordUse(const std::string& key) {
+  std::scoped_lock lock(mutex_);
+  auto found = entry_indices_.find(key);
+  if (found == entry_indices_.end()) {
+    entry_indices_[key] = entries_.size();
+    entries_.push_back({key, 1, !is_first_frame_rasterized_});
+  } else {
+    entries_[found->second].use_count++;
+  }
+  is_dirty_ = true;
+  if (is_save_requested_) {
+    return false;
+  }
+  is_save_requested_ = true;
+  return true;
+}
+
+void SkSLUsage::MarkFirstFrameRasterized() {
+  std::scoped_lock lock(mutex_);
+  is_first_frame_rasterized_ = true;
+}
+
+std::optional<SkSLUsage::Priority> SkSLUsage::GetPriority(
+    const std::string& key) {
+  std::scoped_lock lock(mutex_);
+  EnsureLoadedLocked();
+  auto found = saved_priorities_.find(key);
+  if (found == saved_priorities_.end()) {
+    return std::nullopt;
+  }
+  return found->second;
+}
+
+bool SkSLUsage::Save() {
+  std::scoped_lock lock(mutex_);
+  is_save_requested_ = false;
+  if (!is_dirty_ || !directory_ || !directory_->is_valid()) {
+    return false;
+  }
+  TRACE_EVENT0("flutter", "SkSLUsage::Save");
+  EnsureLoadedLocked();
+
+  std::ostringstream stream;
+  for (const Entry& entry : MergeLocked()) {
+    auto [is_encoded, encoded_key] = fml::Base32Encode(entry.key);
+    if (is_encoded && !encoded_key.empty()) {
+      stream << encoded_key << ' ' << entry.use_count << ' '
+             << entry.is_used_by_first_frame << '\n';
+    }
+  }
+  if (!fml::WriteAtomically(*directory_, kFileName,
+                            fml::DataMapping(stream.str()))) {
+    FML_LOG(WARNING) << "Could not save the SkSL usage.";
+    return false;
+  }
+  is_dirty_ = false;
+  return true;
+}
+
+void SkSLUsage::EnsureLoadedLocked() {
+  if (is_loaded_) {
+    return;
+  }
+  is_loaded_ = true;
+  if (!directory_ || !directory_->is_valid()) {
+    return;
+  }
+  auto file = fml::OpenFileReadOnly(*directory_, kFileName);
+  if (!file.is_valid()) {
+    return;
+  }
+  fml::FileMapping mapping(file);
+  if (mapping.GetMapping() == nullptr) {
+    return;
+  }
+  std::istringstream stream(
+      std::string(reinterpret_cast<const char*>(mapping.GetMapping()),
+                  mapping.GetSize()));
+  std::string encoded_key;
+  uint64_t use_count;
+  bool is_used_by_first_frame;
+  while (saved_entries_.size() < kMaxSavedEntries &&
+         stream >> encoded_key >> use_count >> is_used_by_first_frame) {
+    auto [is_decoded, key] = fml::Base32Decode(encoded_key);
+    if (!is_decoded || saved_priorities_.count(key) > 0) {
+      continue;
+    }
+    saved_priorities_[key] = {saved_entries_.size(), is_used_by_first_frame};
+    saved_entries_.push_back({std::move(key), use_count,
+                              is_used_by_first_frame});
+  }
+}
+
+std::vector<SkSLUsage::Entry> SkSLUsage::MergeLocked() const {
+  std::vector<Entry> first_frame_entries;
+  std::vector<Entry> other_entries;
+  // The shaders this run did not use keep their saved priority. Those used by
+  // the first frame of the previous runs were precompiled before the first
+  // frame of this run, so Skia never loaded them, and demoting them would
+  // leave them out of the first frame of the next run.
+  for (const Entry& entry : saved_entries_) {
+    if (entry_indices_.count(entry.key) > 0) {
+      continue;
+    }
+    if (entry.is_used_by_first_frame) {
+      first_frame_entries.push_back(entry);
+    } else {
+      other_entries.push_back(entry);
+    }
+  }
+  for (const Entry& entry : entries_) {
+    Entry merged = entry;
+    auto found = saved_priorities_.find(entry.key);
+    if (found != saved_priorities_.end()) {
+      merged.use_count += saved_entries_[found->second.rank].use_count;
+    }
+    if (merged.is_used_by_first_frame) {
+      first_frame_entries.push_back(std::move(merged));
+    } else {
+      other_entries.push_back(std::move(merged));
+    }
+  }
+  std::stable_sort(other_entries.begin(), other_entries.end(),
+                   [](const Entry& a, const Entry& b) {
+                     return a.use_count > b.use_count;
+                   });
+
+  std::vector<Entry> merged = std::move(first_frame_entries);
+  for (Entry& entry : other_entries) {
+    if (merged.size() >= kMaxSavedEntries) {
+      break;
+    }
+    merged.push_back(std::move(entry));
+  }
+  merged.resize(std::min(merged.size(), kMaxSavedEntries));
+  return merged;
+}
+
+}  // namespace flutter
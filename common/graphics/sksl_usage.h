@@ -0,0 +1,93 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FLUTTER_COMMON_GRAPHICS_SKSL_USAGE_H_
+#define FLUTTER_COMMON_GRAPHICS_SKSL_USAGE_H_
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "flutter/fml/macros.h"
+#include "flutter/fml/unique_fd.h"
+
+namespace flutter {
+
+/// Records which SkSL shaders are used, how often and in which order, so the
+/// next runs can precompile the shaders they are likely to need first.
+///
+/// The usage of the previous runs is read from |kFileName| when first needed.
+/// Saving merges it with the usage of this run: the shaders used before the
+/// first frame was rasterized come first, in the order they were first used,
+/// followed by the other shaders from the most to the least used. Shaders
+/// this run did not use, such as those precompiled before its first frame,
+/// keep their saved priority. It is thread-safe.
+class SkSLUsage {
+ public:
+  static constexpr char kFileName[] = "sksl.usage";
+
+  /// The number of shaders whose usage is saved.
+  static constexpr size_t kMaxSavedEntries = 4096;
+
+  struct Priority {
+    /// The position of the shader in the saved usage. Lower ranks are
+    /// precompiled first.
+    size_t rank = 0;
+    /// Whether the shader was used before the first frame was rasterized.
+    bool is_used_by_first_frame = false;
+  };
+
+  explicit SkSLUsage(std::shared_ptr<fml::UniqueFD> directory);
+
+  ~SkSLUsage();
+
+  /// Records a use of the shader for |key|. Returns true if the usage needs
+  /// to be saved and no save was requested since the last one.
+  bool RecordUse(const std::string& key);
+
+  /// Marks the end of the first frame. The shaders used from then on are not
+  /// prioritized by the next runs.
+  void MarkFirstFrameRasterized();
+
+  /// Returns the priority saved by the previous runs for the shader for
+  /// |key|, if any.
+  std::optional<Priority> GetPriority(const std::string& key);
+
+  /// Merges the usage of this run into the saved usage, if it changed.
+  bool Save();
+
+ private:
+  struct Entry {
+    std::string key;
+    uint64_t use_count = 0;
+    bool is_used_by_first_frame = false;
+  };
+
+  const std::shared_ptr<fml::UniqueFD> directory_;
+
+  std::mutex mutex_;
+  bool is_loaded_ = false;
+  // The usage saved by the previous runs, in priority order.
+  std::vector<Entry> saved_entries_;
+  std::unordered_map<std::string, Priority> saved_priorities_;
+  // The usage of this run, in the order of first use.
+  std::vector<Entry> entries_;
+  std::unordered_map<std::string, size_t> entry_indices_;
+  bool is_first_frame_rasterized_ = false;
+  bool is_dirty_ = false;
+  bool is_save_requested_ = false;
+
+  void EnsureLoadedLocked();
+
+  std::vector<Entry> MergeLocked() const;
+
+  FML_DISALLOW_COPY_AND_ASSIGN(SkSLUsage);
+};
+
+}  // namespace flutter
+
+#endif  // FLUTTER_COMMON_GRAPHICS_SKSL_USAGE_H_
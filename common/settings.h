@@ -16,6 +16,7 @@
 
 #include "flutter/fml/closure.h"
 #include "flutter/fml/mapping.h"
+#include "flutter/fml/time/time_delta.h"
 #include "flutter/fml/time/time_point.h"
 #include "flutter/fml/unique_fd.h"
 
@@ -45,9 +46,18 @@ class FrameTiming {
   uint64_t GetFrameNumber() const { return frame_number_; }
   void SetFrameNumber(uint64_t frame_number) { frame_number_ = frame_number; }
 
+  // The time the frame waited for the raster and platform threads to merge
+  // or un-merge, which is zero for most frames. This is not reported to the
+  // framework.
+  fml::TimeDelta GetThreadMergeLatency() const { return thread_merge_latency_; }
+  void SetThreadMergeLatency(fml::TimeDelta latency) {
+    thread_merge_latency_ = latency;
+  }
+
  private:
   fml::TimePoint data_[kCount];
   uint64_t frame_number_;
+  fml::TimeDelta thread_merge_latency_;
 };
 
 using TaskObserverAdd =
@@ -114,8 +124,14 @@ struct Settings {
   std::vector<std::string> trace_skia_allowlist;
   bool trace_startup = false;
   bool trace_systrace = false;
+  // If not empty, trace events are recorded to the trace buffer and written
+  // to this path when a shell shuts down or if the process crashes.
+  std::string trace_to_file;
   bool dump_skp_on_shader_compilation = false;
   bool cache_sksl = false;
+  // Only precompile the SkSLs used by the first frame of the previous runs
+  // before the first frame, and the others while the raster thread is idle.
+  bool defer_sksl_precompilation = false;
   bool purge_persistent_cache = false;
   bool endless_trace_buffer = false;
   bool enable_dart_profiling = false;
@@ -168,6 +184,35 @@ struct Settings {
   // Selects the DisplayList for storage of rendering operations.
   bool enable_display_list = false;
 
+  // The number of consecutive frames that an entry in the raster cache may go
+  // unused before it is evicted. The default of 1 evicts any entry that was
+  // not used in the frame that was just drawn.
+  size_t raster_cache_max_unused_frames = 1;
+
+  // The maximum number of bytes of rasterized images that the raster cache
+  // retains, or 0 for no limit. Entries that were used in neither the current
+  // frame nor the previous one are evicted in least recently used order to
+  // stay within this budget.
+  size_t raster_cache_max_bytes = 0;
+
+  // Whether the raster cache rasterizes pictures and display lists after the
+  // frame has been submitted, while the raster thread is idle, instead of
+  // within the frame that first makes them eligible for caching.
+  bool raster_cache_async_rasterization = false;
+
+  // Whether the raster cache packs small images into shared atlas pages
+  // instead of giving each of them a surface of its own.
+  bool raster_cache_use_atlas = false;
+
+  // Whether the rasterizer prerolls the children of containers with many
+  // children on the concurrent worker threads of the VM.
+  bool concurrent_preroll = false;
+
+  // How late, in microseconds, the message loops may serve a delayed task so
+  // that it shares a timer wake up with an earlier one. Only supported on
+  // Linux. Immediate tasks are never delayed.
+  int64_t message_loop_timer_slack_us = 0;
+
   // All shells in the process share the same VM. The last shell to shutdown
   // should typically shut down the VM as well. However, applications depend on
   // the behavior of "warming-up" the VM by creating a shell that does not do
@@ -220,6 +265,16 @@ struct Settings {
   // calls in this callback will cause applications to jank.
   LogMessageCallback log_message_callback;
   bool enable_software_rendering = false;
+  // Resample the pointer moves to the frame times, instead of dispatching
+  // them as the platform delivers them. See
+  // |ResamplingPointerDataDispatcher|.
+  bool enable_pointer_resampling = false;
+  // Dispatch the pointer data at most once per frame, merging the moves. See
+  // |CoalescingPointerDataDispatcher|. Resampling takes precedence, as it
+  // already dispatches the pointer data once per frame.
+  bool enable_pointer_coalescing = false;
+  // Dispatch every pointer sample even when coalescing.
+  bool keep_pointer_history = false;
   bool skia_deterministic_rendering_on_cpu = false;
   bool verbose_logging = false;
   std::string log_tag = "flutter";
@@ -9,6 +9,65 @@
 
 namespace flutter {
 
+std::optional<SkRect> FrameDamage::ComputeClipRect(
+    LayerTree& layer_tree,
+    const SkMatrix& root_transformation) {
+#ifdef FLUTTER_ENABLE_DIFF_CONTEXT
+  if (!layer_tree.root_layer()) {
+    return std::nullopt;
+  }
+
+  const LayerTree* prev_layer_tree = prev_layer_tree_;
+  if (prev_layer_tree &&
+      (prev_layer_tree->frame_size() != layer_tree.frame_size() ||
+       prev_layer_tree->device_pixel_ratio() !=
+           layer_tree.device_pixel_ratio())) {
+    prev_layer_tree = nullptr;
+  }
+
+  PaintRegionMap empty_paint_region_map;
+  DiffContext context(layer_tree.frame_size(), layer_tree.device_pixel_ratio(),
+                      layer_tree.paint_region_map(),
+                      prev_layer_tree ? prev_layer_tree->paint_region_map()
+                                      : empty_paint_region_map);
+  context.PushCullRect(SkRect::Make(layer_tree.frame_size()));
+  context.PushTransform(root_transformation);
+  if (!prev_layer_tree) {
+    // Every layer is new, which still records the paint regions.
+    context.MarkSubtreeDirty();
+  }
+  layer_tree.root_layer()->Diff(
+      &context, prev_layer_tree ? prev_layer_tree->root_layer() : nullptr);
+
+  if (!prev_layer_tree) {
+    return std::nullopt;
+  }
+
+  damage_ = context.ComputeDamage(additional_damage_);
+  return SkRect::Make(damage_->buffer_damage);
+#else
+  return std::nullopt;
+#endif  // FLUTTER_ENABLE_DIFF_CONTEXT
+}
+
+std::optional<SkIRect> FrameDamage::GetFrameDamage() const {
+#ifdef FLUTTER_ENABLE_DIFF_CONTEXT
+  if (damage_) {
+    return damage_->frame_damage;
+  }
+#endif  // FLUTTER_ENABLE_DIFF_CONTEXT
+  return std::nullopt;
+}
+
+std::optional<SkIRect> FrameDamage::GetBufferDamage() const {
+#ifdef FLUTTER_ENABLE_DIFF_CONTEXT
+  if (damage_) {
+    return damage_->buffer_damage;
+  }
+#endif  // FLUTTER_ENABLE_DIFF_CONTEXT
+  return std::nullopt;
+}
+
 CompositorContext::CompositorContext(fml::Milliseconds frame_budget)
     : raster_time_(frame_budget), ui_time_(frame_budget) {}
 
@@ -69,8 +128,14 @@ CompositorContext::ScopedFrame::~ScopedFrame() {
 
 RasterStatus CompositorContext::ScopedFrame::Raster(
     flutter::LayerTree& layer_tree,
-    bool ignore_raster_cache) {
+    bool ignore_raster_cache,
+    FrameDamage* frame_damage) {
   TRACE_EVENT0("flutter", "CompositorContext::ScopedFrame::Raster");
+  std::optional<SkRect> clip_rect =
+      frame_damage ? frame_damage->ComputeClipRect(
+                         layer_tree, root_surface_transformation())
+                   : std::nullopt;
+
   bool root_needs_readback = layer_tree.Preroll(*this, ignore_raster_cache);
   bool needs_save_layer = root_needs_readback && !surface_supports_readback();
   PostPrerollResult post_preroll_result = PostPrerollResult::kSuccess;
@@ -87,10 +152,20 @@ RasterStatus CompositorContext::ScopedFrame::Raster(
   }
   // Clearing canvas after preroll reduces one render target switch when preroll
   // paints some raster cache.
+  SkAutoCanvasRestore clip_restore(canvas(), clip_rect.has_value());
   if (canvas()) {
+    if (clip_rect) {
+      // The damage is in device pixels, so clip without the root surface
+      // transformation. Only the area outside of the damage is left intact.
+      SkMatrix matrix = canvas()->getTotalMatrix();
+      canvas()->resetMatrix();
+      canvas()->clipRect(*clip_rect);
+      canvas()->setMatrix(matrix);
+    }
     if (needs_save_layer) {
       FML_LOG(INFO) << "Using SaveLayer to protect non-readback surface";
-      SkRect bounds = SkRect::Make(layer_tree.frame_size());
+      SkRect bounds =
+          clip_rect.value_or(SkRect::Make(layer_tree.frame_size()));
       SkPaint paint;
       paint.setBlendMode(SkBlendMode::kSrc);
       canvas()->saveLayer(&bounds, &paint);
@@ -6,12 +6,15 @@
 #define FLUTTER_FLOW_COMPOSITOR_CONTEXT_H_
 
 #include <memory>
+#include <optional>
 #include <string>
 
 #include "flutter/common/graphics/texture.h"
+#include "flutter/flow/diff_context.h"
 #include "flutter/flow/embedded_views.h"
 #include "flutter/flow/instrumentation.h"
 #include "flutter/flow/raster_cache.h"
+#include "flutter/fml/concurrent_message_loop.h"
 #include "flutter/fml/macros.h"
 #include "flutter/fml/raster_thread_merger.h"
 #include "third_party/skia/include/core/SkCanvas.h"
@@ -50,6 +53,46 @@ enum class RasterStatus {
   kDiscarded
 };
 
+// Computes the area of a frame that has to be repainted by diffing its layer
+// tree against the layer tree of the frame presented before it.
+//
+// Damage can only be computed when the diffing support of the layers is
+// compiled in (FLUTTER_ENABLE_DIFF_CONTEXT), which is only the case in debug
+// builds for now. Otherwise, and whenever there is no previous layer tree to
+// diff against, the whole frame is repainted.
+class FrameDamage {
+ public:
+  // Sets the layer tree of the previous frame. That layer tree must itself
+  // have been diffed so that its paint regions are known.
+  void SetPreviousLayerTree(const LayerTree* prev_layer_tree) {
+    prev_layer_tree_ = prev_layer_tree;
+  }
+
+  // Adds damage that the target buffer accumulated before this frame, see
+  // SurfaceFrame::FramebufferInfo::existing_damage.
+  void AddAdditionalDamage(const SkIRect& damage) {
+    additional_damage_.join(damage);
+  }
+
+  // Diffs |layer_tree| against the previous layer tree and returns the area
+  // in device pixels that painting should be clipped to, or nullopt if the
+  // whole frame has to be repainted. The paint regions of |layer_tree| are
+  // recorded in either case so that the next frame can be diffed against it.
+  std::optional<SkRect> ComputeClipRect(LayerTree& layer_tree,
+                                        const SkMatrix& root_transformation);
+
+  // The damage computed by ComputeClipRect, if any.
+  std::optional<SkIRect> GetFrameDamage() const;
+  std::optional<SkIRect> GetBufferDamage() const;
+
+ private:
+  const LayerTree* prev_layer_tree_ = nullptr;
+  SkIRect additional_damage_ = SkIRect::MakeEmpty();
+#ifdef FLUTTER_ENABLE_DIFF_CONTEXT
+  std::optional<Damage> damage_;
+#endif  // FLUTTER_ENABLE_DIFF_CONTEXT
+};
+
 class CompositorContext {
  public:
   class ScopedFrame {
@@ -79,8 +122,11 @@ class CompositorContext {
 
     GrDirectContext* gr_context() const { return gr_context_; }
 
+    // Paints the layer tree into the frame. If |frame_damage| is provided,
+    // painting is clipped to the area that changed since the previous frame.
     virtual RasterStatus Raster(LayerTree& layer_tree,
-                                bool ignore_raster_cache);
+                                bool ignore_raster_cache,
+                                FrameDamage* frame_damage = nullptr);
 
    private:
     CompositorContext& context_;
@@ -122,12 +168,26 @@ class CompositorContext {
 
   Stopwatch& ui_time() { return ui_time_; }
 
+  // The runner whose workers preroll the children of large containers
+  // concurrently with the raster thread, or nullptr to preroll layer trees
+  // on the raster thread only, which is the default.
+  const std::shared_ptr<fml::ConcurrentTaskRunner>&
+  concurrent_preroll_task_runner() const {
+    return concurrent_preroll_task_runner_;
+  }
+
+  void set_concurrent_preroll_task_runner(
+      std::shared_ptr<fml::ConcurrentTaskRunner> task_runner) {
+    concurrent_preroll_task_runner_ = std::move(task_runner);
+  }
+
  private:
   RasterCache raster_cache_;
   TextureRegistry texture_registry_;
   Counter frame_count_;
   Stopwatch raster_time_;
   Stopwatch ui_time_;
+  std::shared_ptr<fml::ConcurrentTaskRunner> concurrent_preroll_task_runner_;
 
   void BeginFrame(ScopedFrame& frame, bool enable_instrumentation);
 
@@ -2,6 +2,7 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <algorithm>
 #include <type_traits>
 
 #include "flutter/flow/display_list.h"
@@ -822,12 +823,132 @@ DEFINE_DRAW_SHADOW_OP(ShadowOccludes, true)
 
 #pragma pack(pop, DLOp_Alignment)
 
+// See the comment above FOR_EACH_DISPLAY_LIST_OP for the op ordering
+// that these tests rely on.
+static bool IsAttributeOp(DisplayListOpType type) {
+  return type < DisplayListOpType::kSave;
+}
+static bool IsDrawOp(DisplayListOpType type) {
+  return type >= DisplayListOpType::kDrawPaint;
+}
+
 void DisplayList::ComputeBounds() {
   DisplayListBoundsCalculator calculator(bounds_cull_);
   Dispatch(calculator);
   bounds_ = calculator.getBounds();
 }
 
+void DisplayList::ComputeRTree() {
+  DisplayListBoundsCalculator calculator(bounds_cull_);
+  std::vector<SkRect> rects;
+  // Records whether each outstanding save was a saveLayer.
+  std::vector<bool> saves;
+  int layer_depth = 0;
+  int layer_begin = 0;
+  int op_index = 0;
+  uint8_t* ptr = ptr_;
+  uint8_t* end = ptr_ + used_;
+  while (ptr < end) {
+    auto op = (const DLOp*)ptr;
+    uint8_t* next = ptr + op->size;
+    Dispatch(calculator, ptr, next);
+    // Rendering ops inside of a saveLayer cannot be bounded individually
+    // since the layer may be filtered when it is restored, so the entire
+    // top level saveLayer/restore sequence is treated as a single range.
+    int range_begin = -1;
+    switch (op->type) {
+      case DisplayListOpType::kSave:
+        saves.push_back(false);
+        break;
+      case DisplayListOpType::kSaveLayer:
+      case DisplayListOpType::kSaveLayerBounds:
+        if (layer_depth++ == 0) {
+          layer_begin = op_index;
+        }
+        saves.push_back(true);
+        break;
+      case DisplayListOpType::kRestore:
+        if (!saves.empty()) {
+          if (saves.back() && --layer_depth == 0) {
+            range_begin = layer_begin;
+          }
+          saves.pop_back();
+        }
+        break;
+      default:
+        if (layer_depth == 0 && IsDrawOp(op->type)) {
+          range_begin = op_index;
+        }
+        break;
+    }
+    if (range_begin >= 0) {
+      SkRect rect = calculator.takeBounds();
+      // Ranges with empty bounds are left out of the RTree and will
+      // always be dispatched rather than risk culling an operation
+      // whose bounds could not be accurately computed.
+      if (!rect.isEmpty()) {
+        rects.push_back(rect);
+        rtree_op_ranges_.push_back({range_begin, op_index + 1});
+      }
+    }
+    ptr = next;
+    op_index++;
+  }
+  rtree_ = sk_make_sp<RTree>();
+  rtree_->insert(rects.data(), static_cast<int>(rects.size()));
+}
+
+void DisplayList::Dispatch(Dispatcher& dispatcher,
+                           const SkRect& cull_rect) const {
+  if (!rtree_) {
+    Dispatch(dispatcher);
+    return;
+  }
+  std::vector<int> visible;
+  rtree_->search(cull_rect, &visible);
+  if (visible.size() == rtree_op_ranges_.size()) {
+    Dispatch(dispatcher);
+    return;
+  }
+  std::sort(visible.begin(), visible.end());
+
+  // Runs of ops that are not culled are dispatched together. Only the
+  // non-attribute ops inside of a culled range are skipped so that the
+  // attribute state seen by the dispatcher is unaffected by culling.
+  // All other state ops are balanced within a range and so they can be
+  // skipped along with the rendering ops.
+  size_t range_index = 0;
+  size_t visible_index = 0;
+  int op_index = 0;
+  uint8_t* run_start = ptr_;
+  uint8_t* ptr = ptr_;
+  uint8_t* end = ptr_ + used_;
+  while (ptr < end) {
+    auto op = (const DLOp*)ptr;
+    uint8_t* next = ptr + op->size;
+    while (range_index < rtree_op_ranges_.size() &&
+           rtree_op_ranges_[range_index].end <= op_index) {
+      range_index++;
+    }
+    if (range_index < rtree_op_ranges_.size() &&
+        rtree_op_ranges_[range_index].begin <= op_index &&
+        !IsAttributeOp(op->type)) {
+      while (visible_index < visible.size() &&
+             visible[visible_index] < static_cast<int>(range_index)) {
+        visible_index++;
+      }
+      if (visible_index == visible.size() ||
+          visible[visible_index] != static_cast<int>(range_index)) {
+        Dispatch(dispatcher, run_start, ptr);
+        run_start = next;
+      }
+    }
+    ptr = next;
+    op_index++;
+  }
+  Dispatch(dispatcher, run_start, end);
+}
+
 void DisplayList::Dispatch(Dispatcher& dispatcher,
                            uint8_t* ptr,
                            uint8_t* end) const {
@@ -944,7 +1065,11 @@ static bool CompareOps(uint8_t* ptrA,
 
 void DisplayList::RenderTo(SkCanvas* canvas) const {
   DisplayListCanvasDispatcher dispatcher(canvas);
-  Dispatch(dispatcher);
+  if (rtree_) {
+    Dispatch(dispatcher, canvas->getLocalClipBounds());
+  } else {
+    Dispatch(dispatcher);
+  }
 }
 
 bool DisplayList::Equals(const DisplayList& other) const {
@@ -959,11 +1084,15 @@ bool DisplayList::Equals(const DisplayList& other) const {
 
 DisplayList::DisplayList(uint8_t* ptr,
                          size_t used,
+                         size_t capacity,
                          int op_count,
-                         const SkRect& cull)
+                         const SkRect& cull,
+                         sk_sp<DisplayListStoragePool> pool)
     : ptr_(ptr),
       used_(used),
+      capacity_(capacity),
       op_count_(op_count),
+      pool_(std::move(pool)),
       bounds_({0, 0, -1, -1}),
       bounds_cull_(cull) {
   static std::atomic<uint32_t> nextID{1};
@@ -974,6 +1103,67 @@ DisplayList::DisplayList(uint8_t* ptr,
 
 DisplayList::~DisplayList() {
   DisposeOps(ptr_, ptr_ + used_);
+  if (pool_) {
+    pool_->Recycle(ptr_, capacity_);
+  } else {
+    sk_free(ptr_);
+  }
+}
+
+DisplayListStoragePool::DisplayListStoragePool(size_t max_buffers,
+                                               size_t max_buffer_bytes)
+    : max_buffers_(max_buffers), max_buffer_bytes_(max_buffer_bytes) {}
+
+DisplayListStoragePool::~DisplayListStoragePool() {
+  for (const Buffer& buffer : buffers_) {
+    sk_free(buffer.ptr);
+  }
+}
+
+uint8_t* DisplayListStoragePool::Acquire(size_t min_bytes, size_t* capacity) {
+  std::scoped_lock lock(mutex_);
+  auto smallest = buffers_.end();
+  for (auto it = buffers_.begin(); it != buffers_.end(); ++it) {
+    if (it->capacity >= min_bytes &&
+        (smallest == buffers_.end() || it->capacity < smallest->capacity)) {
+      smallest = it;
+    }
+  }
+  if (smallest == buffers_.end()) {
+    return nullptr;
+  }
+  uint8_t* ptr = smallest->ptr;
+  *capacity = smallest->capacity;
+  buffers_.erase(smallest);
+  return ptr;
+}
+
+size_t DisplayListStoragePool::bytes() const {
+  std::scoped_lock lock(mutex_);
+  size_t bytes = 0;
+  for (const Buffer& buffer : buffers_) {
+    bytes += buffer.capacity;
+  }
+  return bytes;
+}
+
+void DisplayListStoragePool::Recycle(uint8_t* buffer, size_t capacity) {
+  if (!buffer) {
+    return;
+  }
+  if (capacity <= max_buffer_bytes_) {
+    std::scoped_lock lock(mutex_);
+    if (buffers_.size() < max_buffers_) {
+      buffers_.push_back({buffer, capacity});
+      return;
+    }
+  }
+  sk_free(buffer);
+}
+
+size_t DisplayListStoragePool::buffer_count() const {
+  std::scoped_lock lock(mutex_);
+  return buffers_.size();
 }
 
 #define DL_BUILDER_PAGE 4096
@@ -990,21 +1180,42 @@ static void CopyV(void* dst, const S* src, int n, Rest&&... rest) {
   CopyV(SkTAddOffset<void>(dst, n * sizeof(S)), std::forward<Rest>(rest)...);
 }
 
+void DisplayListBuilder::Grow(size_t min_bytes) {
+  static_assert(SkIsPow2(DL_BUILDER_PAGE),
+                "This math needs updating for non-pow2.");
+  if (!storage_ && pool_) {
+    size_t capacity;
+    uint8_t* buffer = pool_->Acquire(min_bytes, &capacity);
+    if (buffer) {
+      storage_ = buffer;
+      allocated_ = capacity;
+      return;
+    }
+  }
+  // Doubling the buffer keeps the total amount of copying done by realloc
+  // linear in the size of the list, at the cost of leaving up to half of
+  // the buffer unused.
+  size_t allocated = std::max(allocated_ * 2, min_bytes);
+  // Next greater or equal multiple of DL_BUILDER_PAGE.
+  allocated = (allocated + DL_BUILDER_PAGE - 1) & ~(DL_BUILDER_PAGE - 1);
+  storage_ = static_cast<uint8_t*>(sk_realloc_throw(storage_, allocated));
+  allocated_ = allocated;
+}
+
 template <typename T, typename... Args>
 void* DisplayListBuilder::Push(size_t pod, Args&&... args) {
   size_t size = SkAlignPtr(sizeof(T) + pod);
   FML_DCHECK(size < (1 << 24));
   if (used_ + size > allocated_) {
-    static_assert(SkIsPow2(DL_BUILDER_PAGE),
-                  "This math needs updating for non-pow2.");
-    // Next greater multiple of DL_BUILDER_PAGE.
-    allocated_ = (used_ + size + DL_BUILDER_PAGE) & ~(DL_BUILDER_PAGE - 1);
-    storage_.realloc(allocated_);
-    FML_DCHECK(storage_.get());
-    memset(storage_.get() + used_, 0, allocated_ - used_);
+    Grow(used_ + size);
   }
   FML_DCHECK(used_ + size <= allocated_);
-  auto op = (T*)(storage_.get() + used_);
+  auto op = (T*)(storage_ + used_);
+  // The storage is not cleared when it is allocated, so that a large pooled
+  // buffer only has the part that is used written to. The op is cleared
+  // instead so that its padding compares equal in DisplayList::Equals.
+  memset(op, 0, size);
+  last_op_offset_ = used_;
   used_ += size;
   new (op) T{std::forward<Args>(args)...};
   op->type = T::kType;
@@ -1013,86 +1224,178 @@ void* DisplayListBuilder::Push(size_t pod, Args&&... args) {
   return op + 1;
 }
 
+template <typename T>
+const T* DisplayListBuilder::LastOp() const {
+  if (last_op_offset_ == kNoOp) {
+    return nullptr;
+  }
+  auto op = reinterpret_cast<const T*>(storage_ + last_op_offset_);
+  return op->type == T::kType ? op : nullptr;
+}
+
+template <typename T>
+void DisplayListBuilder::PopLastOp() {
+  static_assert(std::is_trivially_destructible<T>::value,
+                "Popped ops are not disposed.");
+  FML_DCHECK(LastOp<T>() != nullptr);
+  used_ = last_op_offset_;
+  last_op_offset_ = kNoOp;
+  op_count_--;
+}
+
 sk_sp<DisplayList> DisplayListBuilder::Build() {
-  while (save_level_ > 0) {
+  while (!save_offsets_.empty()) {
     restore();
   }
-  size_t used = used_;
-  int count = op_count_;
+  // A list that uses a small part of a large buffer, such as one taken from
+  // the pool, would keep the rest of it alive for as long as the list lives.
+  size_t trimmed = (used_ + DL_BUILDER_PAGE - 1) & ~(DL_BUILDER_PAGE - 1);
+  if (trimmed > 0 && trimmed <= allocated_ / 2) {
+    storage_ = static_cast<uint8_t*>(sk_realloc_throw(storage_, trimmed));
+    allocated_ = trimmed;
+  }
+  sk_sp<DisplayList> display_list(new DisplayList(
+      storage_, used_, allocated_, op_count_, cull_, pool_));
+  storage_ = nullptr;
   used_ = allocated_ = op_count_ = 0;
-  storage_.realloc(used);
-  return sk_sp<DisplayList>(
-      new DisplayList(storage_.release(), used, count, cull_));
+  last_op_offset_ = kNoOp;
+  current_ = AttributeState();
+  display_list->ComputeBounds();
+  if (prepare_rtree_ && !cull_.isEmpty()) {
+    display_list->ComputeRTree();
+  }
+  return display_list;
 }
 
-DisplayListBuilder::DisplayListBuilder(const SkRect& cull) : cull_(cull) {}
+DisplayListBuilder::DisplayListBuilder(const SkRect& cull,
+                                       bool prepare_rtree,
+                                       sk_sp<DisplayListStoragePool> pool)
+    : cull_(cull), prepare_rtree_(prepare_rtree), pool_(std::move(pool)) {}
 
 DisplayListBuilder::~DisplayListBuilder() {
-  uint8_t* ptr = storage_.get();
-  if (ptr) {
-    DisposeOps(ptr, ptr + used_);
+  if (storage_) {
+    DisposeOps(storage_, storage_ + used_);
+    if (pool_) {
+      pool_->Recycle(storage_, allocated_);
+    } else {
+      sk_free(storage_);
+    }
   }
 }
 
 void DisplayListBuilder::setAA(bool aa) {
-  Push<SetAAOp>(0, aa);
+  if (current_.aa != aa) {
+    Push<SetAAOp>(0, current_.aa = aa);
+  }
 }
 void DisplayListBuilder::setDither(bool dither) {
-  Push<SetDitherOp>(0, dither);
+  if (current_.dither != dither) {
+    Push<SetDitherOp>(0, current_.dither = dither);
+  }
 }
 void DisplayListBuilder::setInvertColors(bool invert) {
-  Push<SetInvertColorsOp>(0, invert);
+  if (current_.invert_colors != invert) {
+    Push<SetInvertColorsOp>(0, current_.invert_colors = invert);
+  }
 }
 void DisplayListBuilder::setCaps(SkPaint::Cap cap) {
-  Push<SetCapsOp>(0, cap);
+  if (current_.cap != cap) {
+    Push<SetCapsOp>(0, current_.cap = cap);
+  }
 }
 void DisplayListBuilder::setJoins(SkPaint::Join join) {
-  Push<SetJoinsOp>(0, join);
+  if (current_.join != join) {
+    Push<SetJoinsOp>(0, current_.join = join);
+  }
 }
 void DisplayListBuilder::setDrawStyle(SkPaint::Style style) {
-  Push<SetDrawStyleOp>(0, style);
+  if (current_.style != style) {
+    Push<SetDrawStyleOp>(0, current_.style = style);
+  }
 }
 void DisplayListBuilder::setStrokeWidth(SkScalar width) {
-  Push<SetStrokeWidthOp>(0, width);
+  if (current_.stroke_width != width) {
+    Push<SetStrokeWidthOp>(0, current_.stroke_width = width);
+  }
 }
 void DisplayListBuilder::setMiterLimit(SkScalar limit) {
-  Push<SetMiterLimitOp>(0, limit);
+  if (current_.miter_limit != limit) {
+    Push<SetMiterLimitOp>(0, current_.miter_limit = limit);
+  }
 }
 void DisplayListBuilder::setColor(SkColor color) {
-  Push<SetColorOp>(0, color);
+  if (current_.color != color) {
+    Push<SetColorOp>(0, current_.color = color);
+  }
 }
 void DisplayListBuilder::setBlendMode(SkBlendMode mode) {
-  Push<SetBlendModeOp>(0, mode);
+  if (current_.blender || current_.blend_mode != mode) {
+    current_.blender = nullptr;
+    Push<SetBlendModeOp>(0, current_.blend_mode = mode);
+  }
 }
 void DisplayListBuilder::setBlender(sk_sp<SkBlender> blender) {
-  blender  //
-      ? Push<SetBlenderOp>(0, std::move(blender))
-      : Push<ClearBlenderOp>(0);
+  if (!blender) {
+    // Clearing the blender restores the default blend mode.
+    if (current_.blender || current_.blend_mode != SkBlendMode::kSrcOver) {
+      current_.blender = nullptr;
+      current_.blend_mode = SkBlendMode::kSrcOver;
+      Push<ClearBlenderOp>(0);
+    }
+  } else if (current_.blender != blender) {
+    Push<SetBlenderOp>(0, current_.blender = std::move(blender));
+  }
 }
 void DisplayListBuilder::setShader(sk_sp<SkShader> shader) {
+  if (current_.shader == shader) {
+    return;
+  }
+  current_.shader = shader;
   shader  //
       ? Push<SetShaderOp>(0, std::move(shader))
       : Push<ClearShaderOp>(0);
 }
 void DisplayListBuilder::setImageFilter(sk_sp<SkImageFilter> filter) {
+  if (current_.image_filter == filter) {
+    return;
+  }
+  current_.image_filter = filter;
   filter  //
       ? Push<SetImageFilterOp>(0, std::move(filter))
       : Push<ClearImageFilterOp>(0);
 }
 void DisplayListBuilder::setColorFilter(sk_sp<SkColorFilter> filter) {
+  if (current_.color_filter == filter) {
+    return;
+  }
+  current_.color_filter = filter;
   filter  //
       ? Push<SetColorFilterOp>(0, std::move(filter))
       : Push<ClearColorFilterOp>(0);
 }
 void DisplayListBuilder::setPathEffect(sk_sp<SkPathEffect> effect) {
+  if (current_.path_effect == effect) {
+    return;
+  }
+  current_.path_effect = effect;
   effect  //
       ? Push<SetPathEffectOp>(0, std::move(effect))
       : Push<ClearPathEffectOp>(0);
 }
 void DisplayListBuilder::setMaskFilter(sk_sp<SkMaskFilter> filter) {
-  Push<SetMaskFilterOp>(0, std::move(filter));
+  if (current_.mask_sigma < 0 && current_.mask_filter == filter) {
+    return;
+  }
+  current_.mask_sigma = -1;
+  Push<SetMaskFilterOp>(0, current_.mask_filter = std::move(filter));
 }
 void DisplayListBuilder::setMaskBlurFilter(SkBlurStyle style, SkScalar sigma) {
+  if (current_.mask_sigma == sigma && current_.mask_blur_style == style) {
+    return;
+  }
+  current_.mask_filter = nullptr;
+  current_.mask_blur_style = style;
+  current_.mask_sigma = sigma;
   switch (style) {
     case kNormal_SkBlurStyle:
       Push<SetMaskBlurFilterNormalOp>(0, sigma);
@@ -1110,33 +1413,61 @@ void DisplayListBuilder::setMaskBlurFilter(SkBlurStyle style, SkScalar sigma) {
 }
 
 void DisplayListBuilder::save() {
-  save_level_++;
+  save_offsets_.push_back(used_);
   Push<SaveOp>(0);
 }
 void DisplayListBuilder::restore() {
-  if (save_level_ > 0) {
+  if (save_offsets_.empty()) {
+    return;
+  }
+  size_t save_offset = save_offsets_.back();
+  save_offsets_.pop_back();
+  if (save_offset != kNoOp &&
+      save_offset + SkAlignPtr(sizeof(SaveOp)) == used_) {
+    // Nothing was recorded since the matching save(), which is therefore
+    // the last op, so neither op has any effect.
+    last_op_offset_ = save_offset;
+    PopLastOp<SaveOp>();
+  } else {
     Push<RestoreOp>(0);
-    save_level_--;
   }
 }
 void DisplayListBuilder::saveLayer(const SkRect* bounds, bool with_paint) {
-  save_level_++;
+  save_offsets_.push_back(kNoOp);
   bounds  //
       ? Push<SaveLayerBoundsOp>(0, *bounds, with_paint)
       : Push<SaveLayerOp>(0, with_paint);
 }
 
 void DisplayListBuilder::translate(SkScalar tx, SkScalar ty) {
-  Push<TranslateOp>(0, tx, ty);
+  if (const TranslateOp* last = LastOp<TranslateOp>()) {
+    tx += last->tx;
+    ty += last->ty;
+    PopLastOp<TranslateOp>();
+  }
+  if (tx != 0 || ty != 0) {
+    Push<TranslateOp>(0, tx, ty);
+  }
 }
 void DisplayListBuilder::scale(SkScalar sx, SkScalar sy) {
-  Push<ScaleOp>(0, sx, sy);
+  if (const ScaleOp* last = LastOp<ScaleOp>()) {
+    sx *= last->sx;
+    sy *= last->sy;
+    PopLastOp<ScaleOp>();
+  }
+  if (sx != 1 || sy != 1) {
+    Push<ScaleOp>(0, sx, sy);
+  }
 }
 void DisplayListBuilder::rotate(SkScalar degrees) {
-  Push<RotateOp>(0, degrees);
+  if (degrees != 0) {
+    Push<RotateOp>(0, degrees);
+  }
 }
 void DisplayListBuilder::skew(SkScalar sx, SkScalar sy) {
-  Push<SkewOp>(0, sx, sy);
+  if (sx != 0 || sy != 0) {
+    Push<SkewOp>(0, sx, sy);
+  }
 }
 void DisplayListBuilder::transform2x3(SkScalar mxx,
                                       SkScalar mxy,
@@ -1144,6 +1475,10 @@ void DisplayListBuilder::transform2x3(SkScalar mxx,
                                       SkScalar myx,
                                       SkScalar myy,
                                       SkScalar myt) {
+  if (mxx == 1 && mxy == 0 && mxt == 0 &&  //
+      myx == 0 && myy == 1 && myt == 0) {
+    return;
+  }
   Push<Transform2x3Op>(0, mxx, mxy, mxt, myx, myy, myt);
 }
 void DisplayListBuilder::transform3x3(SkScalar mxx,
@@ -1155,6 +1490,11 @@ void DisplayListBuilder::transform3x3(SkScalar mxx,
                                       SkScalar px,
                                       SkScalar py,
                                       SkScalar pt) {
+  if (mxx == 1 && mxy == 0 && mxt == 0 &&  //
+      myx == 0 && myy == 1 && myt == 0 &&  //
+      px == 0 && py == 0 && pt == 1) {
+    return;
+  }
   Push<Transform3x3Op>(0, mxx, mxy, mxt, myx, myy, myt, px, py, pt);
 }
 
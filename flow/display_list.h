@@ -5,6 +5,10 @@
 #ifndef FLUTTER_FLOW_DISPLAY_LIST_H_
 #define FLUTTER_FLOW_DISPLAY_LIST_H_
 
+#include <mutex>
+#include <vector>
+
+#include "flutter/flow/rtree.h"
 #include "third_party/skia/include/core/SkBlender.h"
 #include "third_party/skia/include/core/SkBlurTypes.h"
 #include "third_party/skia/include/core/SkCanvas.h"
@@ -27,6 +31,8 @@
 //             or detecting various rendering optimization scenarios
 // DisplayListBuilder: a class for constructing a DisplayList from the same
 //                     calls defined in the Dispatcher
+// DisplayListStoragePool: a cache of the buffers of destroyed DisplayLists
+//                         that DisplayListBuilders can record into again
 //
 // Other files include various class definitions for dealing with display
 // lists, such as:
@@ -57,12 +63,24 @@
 // to Skia using a DisplayListCanvasDispatcher or simply by passing an
 // SkCanvas pointer to its renderTo() method.
 //
+// A DisplayList can also be built with a spatial index (an RTree) over the
+// bounds of its rendering operations by passing |prepare_rtree| to the
+// DisplayListBuilder. Such a list can then be dispatched with a cull rect
+// and only the rendering operations that intersect the cull rect will be
+// dispatched, though all attribute, transform and clip operations will
+// still be dispatched so that the state seen by the Dispatcher remains
+// consistent.
+//
 // The mechanism is inspired by the SkLiteDL class that is not directly
 // supported by Skia, but has been recommended as a basis for custom
 // display lists for a number of their customers.
 
 namespace flutter {
 
+// The ops are listed in groups: all of the attribute ops come first,
+// followed by the save/restore, transform and clip ops and then all of
+// the rendering ops. The culled dispatch mechanism relies on this order
+// to quickly classify an op, so new ops must be added to the right group.
 #define FOR_EACH_DISPLAY_LIST_OP(V) \
   V(SetAA)                          \
   V(SetDither)                      \
@@ -157,6 +175,50 @@ enum class DisplayListOpType { FOR_EACH_DISPLAY_LIST_OP(DL_OP_TO_ENUM_VALUE) };
 class Dispatcher;
 class DisplayListBuilder;
 
+// A thread safe cache of the op storage of destroyed DisplayLists.
+//
+// A DisplayListBuilder that is given a pool starts recording into the
+// smallest buffer in the pool that fits its first op instead of growing a
+// new one from scratch, and the DisplayList it builds returns its buffer to
+// the same pool when it is destroyed. Apps that record similar content
+// every frame then mostly record into buffers that are already allocated.
+class DisplayListStoragePool : public SkRefCnt {
+ public:
+  static constexpr size_t kDefaultMaxBuffers = 8;
+  static constexpr size_t kDefaultMaxBufferBytes = 1 << 20;
+
+  explicit DisplayListStoragePool(
+      size_t max_buffers = kDefaultMaxBuffers,
+      size_t max_buffer_bytes = kDefaultMaxBufferBytes);
+  ~DisplayListStoragePool();
+
+  // Removes the smallest buffer of at least |min_bytes| bytes from the pool
+  // and returns it along with its size in |capacity|. Returns nullptr if the
+  // pool has no such buffer. The contents of the buffer are undefined.
+  uint8_t* Acquire(size_t min_bytes, size_t* capacity);
+
+  // Takes ownership of a buffer allocated with sk_malloc. The buffer is
+  // freed instead of being kept if the pool is full or if it is larger
+  // than the pool is allowed to keep.
+  void Recycle(uint8_t* buffer, size_t capacity);
+
+  size_t buffer_count() const;
+
+  // The total size of the buffers in the pool.
+  size_t bytes() const;
+
+ private:
+  struct Buffer {
+    uint8_t* ptr;
+    size_t capacity;
+  };
+
+  const size_t max_buffers_;
+  const size_t max_buffer_bytes_;
+  mutable std::mutex mutex_;
+  std::vector<Buffer> buffers_;
+};
+
 // The base class that contains a sequence of rendering operations
 // for dispatch to a Dispatcher. These objects must be instantiated
 // through an instance of DisplayListBuilder::build().
@@ -170,6 +232,7 @@ class DisplayList : public SkRefCnt {
   DisplayList()
       : ptr_(nullptr),
         used_(0),
+        capacity_(0),
         op_count_(0),
         unique_id_(0),
         bounds_({0, 0, 0, 0}),
@@ -179,29 +242,53 @@ class DisplayList : public SkRefCnt {
 
   void Dispatch(Dispatcher& ctx) const { Dispatch(ctx, ptr_, ptr_ + used_); }
 
+  // Dispatches only the rendering operations whose bounds intersect the
+  // |cull_rect| along with all of the attribute, transform and clip
+  // operations. If the list was not built with an RTree then all of the
+  // operations will be dispatched.
+  void Dispatch(Dispatcher& ctx, const SkRect& cull_rect) const;
+
+  // Renders the list to the canvas, culling any rendering operations
+  // outside of the local clip bounds of the canvas if the list was
+  // built with an RTree.
   void RenderTo(SkCanvas* canvas) const;
 
   size_t bytes() const { return used_; }
   int op_count() const { return op_count_; }
   uint32_t unique_id() const { return unique_id_; }
 
-  const SkRect& bounds() {
-    if (bounds_.width() < 0.0) {
-      // ComputeBounds() will leave the variable with a
-      // non-negative width and height
-      ComputeBounds();
-    }
-    return bounds_;
-  }
+  // The bounds are computed when the list is built, so that lists shared
+  // by layers that are prerolled on several threads are never written to.
+  const SkRect& bounds() const { return bounds_; }
 
   bool Equals(const DisplayList& other) const;
 
+  bool has_rtree() const { return rtree_ != nullptr; }
+  sk_sp<const RTree> rtree() const { return rtree_; }
+
  private:
-  DisplayList(uint8_t* ptr, size_t used, int op_count, const SkRect& cull_rect);
+  DisplayList(uint8_t* ptr,
+              size_t used,
+              size_t capacity,
+              int op_count,
+              const SkRect& cull_rect,
+              sk_sp<DisplayListStoragePool> pool);
+
+  // The range of op indices [begin, end) represented by each of the
+  // rects inserted into the RTree, in the order they were inserted.
+  // A range covers either a single rendering op or an entire top level
+  // saveLayer/restore sequence.
+  struct RTreeOpRange {
+    int begin;
+    int end;
+  };
 
   uint8_t* ptr_;
   size_t used_;
+  size_t capacity_;
   int op_count_;
+  // The pool that |ptr_| is returned to when the list is destroyed, if any.
+  sk_sp<DisplayListStoragePool> pool_;
 
   uint32_t unique_id_;
   SkRect bounds_;
@@ -209,10 +296,15 @@ class DisplayList : public SkRefCnt {
   // Only used for drawPaint() and drawColor()
   SkRect bounds_cull_;
 
+  sk_sp<RTree> rtree_;
+  std::vector<RTreeOpRange> rtree_op_ranges_;
+
   void ComputeBounds();
+  void ComputeRTree();
   void Dispatch(Dispatcher& ctx, uint8_t* ptr, uint8_t* end) const;
 
   friend class DisplayListBuilder;
+  friend class DisplayListSerializer;
 };
 
 // The pure virtual interface for interacting with a display list.
@@ -332,9 +424,25 @@ class Dispatcher {
 // If there is some code that already renders to an SkCanvas object,
 // those rendering commands can be captured into a DisplayList using
 // the DisplayListCanvasRecorder class.
+//
+// The builder skips calls that would not change the result of rendering
+// the list: attributes set to the value they already have, identity
+// transforms and save/restore pairs with nothing between them. Adjacent
+// translate and scale calls are folded into a single op.
 class DisplayListBuilder final : public virtual Dispatcher, public SkRefCnt {
  public:
-  DisplayListBuilder(const SkRect& cull = SkRect::MakeEmpty());
+  // If |prepare_rtree| is true then the DisplayList returned from Build()
+  // will contain an RTree of the bounds of its rendering operations which
+  // allows it to be dispatched with a cull rect. Operations whose bounds
+  // cannot be determined are assumed to cover the |cull| rect, so an RTree
+  // is only prepared when the |cull| rect is not empty.
+  //
+  // If a |pool| is provided then recording starts in a buffer taken from
+  // the pool and the built DisplayList returns its buffer to the pool
+  // when it is destroyed.
+  DisplayListBuilder(const SkRect& cull = SkRect::MakeEmpty(),
+                     bool prepare_rtree = false,
+                     sk_sp<DisplayListStoragePool> pool = nullptr);
   ~DisplayListBuilder();
 
   void setAA(bool aa) override;
@@ -441,19 +549,68 @@ class DisplayListBuilder final : public virtual Dispatcher, public SkRefCnt {
                   bool occludes,
                   SkScalar dpr) override;
 
+  // Hands the recorded ops over to a new DisplayList without copying them
+  // and resets the builder so that it can record a new list.
   sk_sp<DisplayList> Build();
 
  private:
-  SkAutoTMalloc<uint8_t> storage_;
+  uint8_t* storage_ = nullptr;
   size_t used_ = 0;
   size_t allocated_ = 0;
   int op_count_ = 0;
-  int save_level_ = 0;
+
+  // The offset of the most recently pushed op, or kNoOp if it has been
+  // removed.
+  static constexpr size_t kNoOp = ~static_cast<size_t>(0);
+  size_t last_op_offset_ = kNoOp;
+
+  // The offset of the SaveOp for each unrestored save() call, or kNoOp
+  // for a saveLayer() call.
+  std::vector<size_t> save_offsets_;
+
+  // The attribute values that a Dispatcher would hold after dispatching
+  // the ops recorded so far. A Dispatcher starts with the values of a
+  // default SkPaint.
+  struct AttributeState {
+    bool aa = false;
+    bool dither = false;
+    bool invert_colors = false;
+    SkColor color = SK_ColorBLACK;
+    SkBlendMode blend_mode = SkBlendMode::kSrcOver;
+    SkPaint::Style style = SkPaint::Style::kFill_Style;
+    SkScalar stroke_width = 0.0;
+    SkScalar miter_limit = 4.0;
+    SkPaint::Cap cap = SkPaint::Cap::kButt_Cap;
+    SkPaint::Join join = SkPaint::Join::kMiter_Join;
+    sk_sp<SkBlender> blender;
+    sk_sp<SkShader> shader;
+    sk_sp<SkColorFilter> color_filter;
+    sk_sp<SkImageFilter> image_filter;
+    sk_sp<SkPathEffect> path_effect;
+    // Only one of |mask_filter| and a mask blur with a non-negative
+    // |mask_sigma| is set at a time.
+    sk_sp<SkMaskFilter> mask_filter;
+    SkBlurStyle mask_blur_style = kNormal_SkBlurStyle;
+    SkScalar mask_sigma = -1;
+  };
+  AttributeState current_;
 
   SkRect cull_;
+  bool prepare_rtree_;
+  sk_sp<DisplayListStoragePool> pool_;
+
+  void Grow(size_t min_bytes);
 
   template <typename T, typename... Args>
   void* Push(size_t extra, Args&&... args);
+
+  // Returns the last op pushed if it has type T.
+  template <typename T>
+  const T* LastOp() const;
+
+  // Removes the last op pushed, which must have a trivial destructor.
+  template <typename T>
+  void PopLastOp();
 };
 
 }  // namespace flutter
@@ -0,0 +1,102 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/flow/display_list.h"
+
+#include "flutter/benchmarking/benchmarking.h"
+#include "flutter/flow/display_list_canvas.h"
+#include "flutter/flow/display_list_utils.h"
+#include "third_party/skia/include/core/SkPath.h"
+#include "third_party/skia/include/core/SkRRect.h"
+#include "third_party/skia/include/core/SkSurface.h"
+
+namespace flutter {
+namespace benchmarking {
+
+// Records |op_groups| groups of operations that resemble the output of a
+// typical widget: a transformed and clipped group of shapes with a few
+// attribute changes.
+static void RecordOps(DisplayListBuilder& builder, int op_groups) {
+  SkPath path = SkPath::Circle(10, 10, 8);
+  for (int i = 0; i < op_groups; i++) {
+    SkScalar x = (i * 37) % 400;
+    SkScalar y = (i * 53) % 600;
+    builder.save();
+    builder.translate(x, y);
+    builder.clipRect({0, 0, 100, 40}, true, SkClipOp::kIntersect);
+    builder.setColor(0xFF000000 | (i * 0x010203));
+    builder.drawRect({0, 0, 100, 40});
+    builder.setColor(SK_ColorWHITE);
+    builder.drawRRect(SkRRect::MakeRectXY({4, 4, 96, 36}, 6, 6));
+    builder.drawPath(path);
+    builder.drawLine({0, 39}, {100, 39});
+    builder.restore();
+  }
+}
+
+static sk_sp<DisplayList> MakeDisplayList(int op_groups) {
+  DisplayListBuilder builder;
+  RecordOps(builder, op_groups);
+  return builder.Build();
+}
+
+static void BM_DisplayListBuilderRecord(benchmark::State& state) {
+  while (state.KeepRunning()) {
+    DisplayListBuilder builder;
+    RecordOps(builder, state.range(0));
+    benchmark::DoNotOptimize(builder.Build());
+  }
+  state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_DisplayListBuilderRecord)
+    ->RangeMultiplier(4)
+    ->Range(1 << 4, 1 << 12)
+    ->Complexity();
+
+static void BM_DisplayListDispatchToCanvas(benchmark::State& state) {
+  sk_sp<DisplayList> display_list = MakeDisplayList(state.range(0));
+  sk_sp<SkSurface> surface = SkSurface::MakeRasterN32Premul(500, 650);
+  SkCanvas* canvas = surface->getCanvas();
+  DisplayListCanvasDispatcher dispatcher(canvas);
+  while (state.KeepRunning()) {
+    display_list->Dispatch(dispatcher);
+  }
+  state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_DisplayListDispatchToCanvas)
+    ->RangeMultiplier(4)
+    ->Range(1 << 4, 1 << 10)
+    ->Complexity();
+
+static void BM_DisplayListEquals(benchmark::State& state) {
+  // Two separately recorded lists so that the comparison cannot stop at
+  // the pointer check and has to walk every operation.
+  sk_sp<DisplayList> a = MakeDisplayList(state.range(0));
+  sk_sp<DisplayList> b = MakeDisplayList(state.range(0));
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(a->Equals(*b));
+  }
+  state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_DisplayListEquals)
+    ->RangeMultiplier(4)
+    ->Range(1 << 4, 1 << 12)
+    ->Complexity();
+
+static void BM_DisplayListBoundsCalculator(benchmark::State& state) {
+  sk_sp<DisplayList> display_list = MakeDisplayList(state.range(0));
+  while (state.KeepRunning()) {
+    DisplayListBoundsCalculator calculator;
+    display_list->Dispatch(calculator);
+    benchmark::DoNotOptimize(calculator.getBounds());
+  }
+  state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_DisplayListBoundsCalculator)
+    ->RangeMultiplier(4)
+    ->Range(1 << 4, 1 << 12)
+    ->Complexity();
+
+}  // namespace benchmarking
+}  // namespace flutter
@@ -164,7 +164,7 @@ void DisplayListCanvasDispatcher::drawDisplayList(
   int save_count = canvas_->save();
   {
     DisplayListCanvasDispatcher dispatcher(canvas_);
-    display_list->Dispatch(dispatcher);
+    display_list->Dispatch(dispatcher, canvas_->getLocalClipBounds());
   }
   canvas_->restoreToCount(save_count);
 }
@@ -182,9 +182,14 @@ void DisplayListCanvasDispatcher::drawShadow(const SkPath& path,
                                           occludes, dpr);
 }
 
-DisplayListCanvasRecorder::DisplayListCanvasRecorder(const SkRect& bounds)
+DisplayListCanvasRecorder::DisplayListCanvasRecorder(
+    const SkRect& bounds,
+    bool prepare_rtree,
+    sk_sp<DisplayListStoragePool> pool)
     : SkCanvasVirtualEnforcer(bounds.width(), bounds.height()),
-      builder_(sk_make_sp<DisplayListBuilder>(bounds)) {}
+      builder_(sk_make_sp<DisplayListBuilder>(bounds,
+                                              prepare_rtree,
+                                              std::move(pool))) {}
 
 sk_sp<DisplayList> DisplayListCanvasRecorder::Build() {
   sk_sp<DisplayList> display_list = builder_->Build();
@@ -406,32 +411,28 @@ void DisplayListCanvasRecorder::RecordPaintAttributes(const SkPaint* paint,
       FML_DCHECK(false);
       return;
   }
+  // The builder skips any attribute that already has the value found in
+  // the paint, so each attribute needed by the operation can simply be
+  // forwarded to it.
+  SkPaint default_paint;
   if (paint == nullptr) {
-    paint = new SkPaint();
+    paint = &default_paint;
   }
-  if ((dataNeeded & kAaNeeded_) != 0 && current_aa_ != paint->isAntiAlias()) {
-    builder_->setAA(current_aa_ = paint->isAntiAlias());
+  if ((dataNeeded & kAaNeeded_) != 0) {
+    builder_->setAA(paint->isAntiAlias());
   }
-  if ((dataNeeded & kDitherNeeded_) != 0 &&
-      current_dither_ != paint->isDither()) {
-    builder_->setDither(current_dither_ = paint->isDither());
+  if ((dataNeeded & kDitherNeeded_) != 0) {
+    builder_->setDither(paint->isDither());
   }
-  if ((dataNeeded & kColorNeeded_) != 0 &&
-      current_color_ != paint->getColor()) {
-    builder_->setColor(current_color_ = paint->getColor());
+  if ((dataNeeded & kColorNeeded_) != 0) {
+    builder_->setColor(paint->getColor());
   }
   if ((dataNeeded & kBlendNeeded_)) {
     skstd::optional<SkBlendMode> mode_optional = paint->asBlendMode();
     if (mode_optional) {
-      SkBlendMode mode = mode_optional.value();
-      if (current_blender_ || current_blend_ != mode) {
-        builder_->setBlendMode(current_blend_ = mode);
-        current_blender_ = nullptr;
-      }
+      builder_->setBlendMode(mode_optional.value());
     } else {
-      if (current_blender_.get() != paint->getBlender()) {
-        builder_->setBlender(current_blender_ = sk_ref_sp(paint->getBlender()));
-      }
+      builder_->setBlender(sk_ref_sp(paint->getBlender()));
     }
   }
   // invert colors is a Flutter::Paint thing, not an SkPaint thing
@@ -443,50 +444,31 @@ void DisplayListCanvasRecorder::RecordPaintAttributes(const SkPaint* paint,
   //          : _CanvasOp.clearInvertColors, 0);
   // }
   if ((dataNeeded & kPaintStyleNeeded_) != 0) {
-    if (current_style_ != paint->getStyle()) {
-      builder_->setDrawStyle(current_style_ = paint->getStyle());
-    }
-    if (current_style_ == SkPaint::Style::kStroke_Style) {
+    builder_->setDrawStyle(paint->getStyle());
+    if (paint->getStyle() == SkPaint::Style::kStroke_Style) {
       dataNeeded |= kStrokeStyleNeeded_;
     }
   }
   if ((dataNeeded & kStrokeStyleNeeded_) != 0) {
-    if (current_stroke_width_ != paint->getStrokeWidth()) {
-      builder_->setStrokeWidth(current_stroke_width_ = paint->getStrokeWidth());
-    }
-    if (current_cap_ != paint->getStrokeCap()) {
-      builder_->setCaps(current_cap_ = paint->getStrokeCap());
-    }
-    if (current_join_ != paint->getStrokeJoin()) {
-      builder_->setJoins(current_join_ = paint->getStrokeJoin());
-    }
-    if (current_miter_limit_ != paint->getStrokeMiter()) {
-      builder_->setMiterLimit(current_miter_limit_ = paint->getStrokeMiter());
-    }
+    builder_->setStrokeWidth(paint->getStrokeWidth());
+    builder_->setCaps(paint->getStrokeCap());
+    builder_->setJoins(paint->getStrokeJoin());
+    builder_->setMiterLimit(paint->getStrokeMiter());
   }
-  if ((dataNeeded & kShaderNeeded_) != 0 &&
-      current_shader_.get() != paint->getShader()) {
-    builder_->setShader(current_shader_ = sk_ref_sp(paint->getShader()));
+  if ((dataNeeded & kShaderNeeded_) != 0) {
+    builder_->setShader(sk_ref_sp(paint->getShader()));
   }
-  if ((dataNeeded & kColorFilterNeeded_) != 0 &&
-      current_color_filter_.get() != paint->getColorFilter()) {
-    builder_->setColorFilter(current_color_filter_ =
-                                 sk_ref_sp(paint->getColorFilter()));
+  if ((dataNeeded & kColorFilterNeeded_) != 0) {
+    builder_->setColorFilter(sk_ref_sp(paint->getColorFilter()));
   }
-  if ((dataNeeded & kImageFilterNeeded_) != 0 &&
-      current_image_filter_.get() != paint->getImageFilter()) {
-    builder_->setImageFilter(current_image_filter_ =
-                                 sk_ref_sp(paint->getImageFilter()));
+  if ((dataNeeded & kImageFilterNeeded_) != 0) {
+    builder_->setImageFilter(sk_ref_sp(paint->getImageFilter()));
   }
-  if ((dataNeeded & kPathEffectNeeded_) != 0 &&
-      current_path_effect_.get() != paint->getPathEffect()) {
-    builder_->setPathEffect(current_path_effect_ =
-                                sk_ref_sp(paint->getPathEffect()));
+  if ((dataNeeded & kPathEffectNeeded_) != 0) {
+    builder_->setPathEffect(sk_ref_sp(paint->getPathEffect()));
   }
-  if ((dataNeeded & kMaskFilterNeeded_) != 0 &&
-      current_mask_filter_.get() != paint->getMaskFilter()) {
-    builder_->setMaskFilter(current_mask_filter_ =
-                                sk_ref_sp(paint->getMaskFilter()));
+  if ((dataNeeded & kMaskFilterNeeded_) != 0) {
+    builder_->setMaskFilter(sk_ref_sp(paint->getMaskFilter()));
   }
 }
 
@@ -122,7 +122,9 @@ class DisplayListCanvasRecorder
     : public SkCanvasVirtualEnforcer<SkNoDrawCanvas>,
       public SkRefCnt {
  public:
-  DisplayListCanvasRecorder(const SkRect& bounds);
+  DisplayListCanvasRecorder(const SkRect& bounds,
+                            bool prepare_rtree = false,
+                            sk_sp<DisplayListStoragePool> pool = nullptr);
 
   const sk_sp<DisplayListBuilder> builder() { return builder_; }
 
@@ -291,22 +293,6 @@ class DisplayListCanvasRecorder
   static constexpr int kSaveLayerMask_ =
       kColorNeeded_ | kBlendNeeded_ | kInvertColorsNeeded_ |
       kColorFilterNeeded_ | kImageFilterNeeded_;
-
-  bool current_aa_ = false;
-  bool current_dither_ = false;
-  SkColor current_color_ = 0xFF000000;
-  SkBlendMode current_blend_ = SkBlendMode::kSrcOver;
-  SkPaint::Style current_style_ = SkPaint::Style::kFill_Style;
-  SkScalar current_stroke_width_ = 0.0;
-  SkScalar current_miter_limit_ = 4.0;
-  SkPaint::Cap current_cap_ = SkPaint::Cap::kButt_Cap;
-  SkPaint::Join current_join_ = SkPaint::Join::kMiter_Join;
-  sk_sp<SkBlender> current_blender_;
-  sk_sp<SkShader> current_shader_;
-  sk_sp<SkColorFilter> current_color_filter_;
-  sk_sp<SkImageFilter> current_image_filter_;
-  sk_sp<SkPathEffect> current_path_effect_;
-  sk_sp<SkMaskFilter> current_mask_filter_;
 };
 
 }  // namespace flutter
@@ -0,0 +1,1148 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/flow/display_list_serialization.h"
+
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include "flutter/fml/logging.h"
+#include "flutter/fml/trace_event.h"
+#include "third_party/skia/include/core/SkImage.h"
+#include "third_party/skia/include/core/SkMaskFilter.h"
+#include "third_party/skia/include/core/SkPath.h"
+#include "third_party/skia/include/core/SkPicture.h"
+#include "third_party/skia/include/core/SkRRect.h"
+#include "third_party/skia/include/core/SkRSXform.h"
+#include "third_party/skia/include/core/SkSerialProcs.h"
+#include "third_party/skia/include/core/SkTextBlob.h"
+
+namespace flutter {
+
+namespace {
+
+// The tags of the operation records. The values are part of the format so
+// new tags must only ever be appended.
+enum class RecordTag : uint32_t {
+  kSetAA,
+  kSetDither,
+  kSetInvertColors,
+  kSetCaps,
+  kSetJoins,
+  kSetDrawStyle,
+  kSetStrokeWidth,
+  kSetMiterLimit,
+  kSetColor,
+  kSetBlendMode,
+  kSetBlender,
+  kSetShader,
+  kSetImageFilter,
+  kSetColorFilter,
+  kSetPathEffect,
+  kSetMaskFilter,
+  kSetMaskBlurFilter,
+
+  kSave,
+  kRestore,
+  kSaveLayer,
+
+  kTranslate,
+  kScale,
+  kRotate,
+  kSkew,
+  kTransform2x3,
+  kTransform3x3,
+
+  kClipRect,
+  kClipRRect,
+  kClipPath,
+
+  kDrawPaint,
+  kDrawColor,
+  kDrawLine,
+  kDrawRect,
+  kDrawOval,
+  kDrawCircle,
+  kDrawRRect,
+  kDrawDRRect,
+  kDrawPath,
+  kDrawArc,
+  kDrawPoints,
+  kDrawImage,
+  kDrawImageRect,
+  kDrawImageNine,
+  kDrawImageLattice,
+  kDrawAtlas,
+  kDrawPicture,
+  kDrawDisplayList,
+  kDrawTextBlob,
+  kDrawShadow,
+
+  kLastTag = kDrawShadow,
+};
+
+// The kinds of objects stored in the object table. Also part of the format.
+enum class ObjectType : uint32_t {
+  kImage,
+  kPath,
+  kTextBlob,
+  kPicture,
+  kDisplayList,
+  kBlender,
+  kShader,
+  kImageFilter,
+  kColorFilter,
+  kPathEffect,
+  kMaskFilter,
+};
+
+// The index used by records for a null object reference.
+constexpr uint32_t kNullObject = ~0u;
+
+struct Header {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t flags;
+  SkRect cull_rect;
+  uint32_t ops_offset;
+  uint32_t ops_length;
+  uint32_t objects_offset;
+  uint32_t object_count;
+};
+
+constexpr uint32_t kHasRTreeFlag = 1 << 0;
+
+struct ObjectEntry {
+  ObjectType type;
+  uint32_t offset;
+  uint32_t length;
+};
+
+size_t Align4(size_t size) {
+  return (size + 3) & ~static_cast<size_t>(3);
+}
+
+// Encodes the operations dispatched to it into records and collects the
+// objects that they reference.
+class DisplayListWriter final : public virtual Dispatcher {
+ public:
+  sk_sp<SkData> Finish(const SkRect& cull_rect, bool has_rtree) {
+    if (!ok_) {
+      return nullptr;
+    }
+    size_t objects_offset = sizeof(Header) + ops_.size();
+    size_t data_offset =
+        objects_offset + objects_.size() * sizeof(ObjectEntry);
+    size_t total = data_offset;
+    for (const sk_sp<SkData>& data : object_data_) {
+      total += Align4(data->size());
+    }
+    if (total > UINT32_MAX) {
+      return nullptr;
+    }
+
+    sk_sp<SkData> result = SkData::MakeZeroInitialized(total);
+    uint8_t* out = static_cast<uint8_t*>(result->writable_data());
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    header.magic = DisplayListSerializer::kMagic;
+    header.version = DisplayListSerializer::kVersion;
+    header.flags = has_rtree ? kHasRTreeFlag : 0;
+    header.cull_rect = cull_rect;
+    header.ops_offset = sizeof(Header);
+    header.ops_length = ops_.size();
+    header.objects_offset = objects_offset;
+    header.object_count = objects_.size();
+    memcpy(out, &header, sizeof(header));
+    memcpy(out + header.ops_offset, ops_.data(), ops_.size());
+
+    size_t offset = data_offset;
+    for (size_t i = 0; i < objects_.size(); i++) {
+      ObjectEntry entry = objects_[i];
+      entry.offset = offset;
+      memcpy(out + objects_offset + i * sizeof(ObjectEntry), &entry,
+             sizeof(entry));
+      const sk_sp<SkData>& data = object_data_[i];
+      memcpy(out + offset, data->data(), data->size());
+      offset += Align4(data->size());
+    }
+    return result;
+  }
+
+  void setAA(bool aa) override { WriteRecord(RecordTag::kSetAA, Bool(aa)); }
+  void setDither(bool dither) override {
+    WriteRecord(RecordTag::kSetDither, Bool(dither));
+  }
+  void setInvertColors(bool invert) override {
+    WriteRecord(RecordTag::kSetInvertColors, Bool(invert));
+  }
+  void setCaps(SkPaint::Cap cap) override {
+    WriteRecord(RecordTag::kSetCaps, Enum(cap));
+  }
+  void setJoins(SkPaint::Join join) override {
+    WriteRecord(RecordTag::kSetJoins, Enum(join));
+  }
+  void setDrawStyle(SkPaint::Style style) override {
+    WriteRecord(RecordTag::kSetDrawStyle, Enum(style));
+  }
+  void setStrokeWidth(SkScalar width) override {
+    WriteRecord(RecordTag::kSetStrokeWidth, width);
+  }
+  void setMiterLimit(SkScalar limit) override {
+    WriteRecord(RecordTag::kSetMiterLimit, limit);
+  }
+  void setColor(SkColor color) override {
+    WriteRecord(RecordTag::kSetColor, color);
+  }
+  void setBlendMode(SkBlendMode mode) override {
+    WriteRecord(RecordTag::kSetBlendMode, Enum(mode));
+  }
+  void setBlender(sk_sp<SkBlender> blender) override {
+    WriteRecord(RecordTag::kSetBlender,
+                AddFlattenable(ObjectType::kBlender, blender.get()));
+  }
+  void setShader(sk_sp<SkShader> shader) override {
+    WriteRecord(RecordTag::kSetShader,
+                AddFlattenable(ObjectType::kShader, shader.get()));
+  }
+  void setImageFilter(sk_sp<SkImageFilter> filter) override {
+    WriteRecord(RecordTag::kSetImageFilter,
+                AddFlattenable(ObjectType::kImageFilter, filter.get()));
+  }
+  void setColorFilter(sk_sp<SkColorFilter> filter) override {
+    WriteRecord(RecordTag::kSetColorFilter,
+                AddFlattenable(ObjectType::kColorFilter, filter.get()));
+  }
+  void setPathEffect(sk_sp<SkPathEffect> effect) override {
+    WriteRecord(RecordTag::kSetPathEffect,
+                AddFlattenable(ObjectType::kPathEffect, effect.get()));
+  }
+  void setMaskFilter(sk_sp<SkMaskFilter> filter) override {
+    WriteRecord(RecordTag::kSetMaskFilter,
+                AddFlattenable(ObjectType::kMaskFilter, filter.get()));
+  }
+  void setMaskBlurFilter(SkBlurStyle style, SkScalar sigma) override {
+    WriteRecord(RecordTag::kSetMaskBlurFilter, Enum(style), sigma);
+  }
+
+  void save() override { WriteRecord(RecordTag::kSave); }
+  void restore() override { WriteRecord(RecordTag::kRestore); }
+  void saveLayer(const SkRect* bounds, bool restore_with_paint) override {
+    WriteRecord(RecordTag::kSaveLayer, Bool(bounds != nullptr),
+                bounds ? *bounds : SkRect::MakeEmpty(),
+                Bool(restore_with_paint));
+  }
+
+  void translate(SkScalar tx, SkScalar ty) override {
+    WriteRecord(RecordTag::kTranslate, tx, ty);
+  }
+  void scale(SkScalar sx, SkScalar sy) override {
+    WriteRecord(RecordTag::kScale, sx, sy);
+  }
+  void rotate(SkScalar degrees) override {
+    WriteRecord(RecordTag::kRotate, degrees);
+  }
+  void skew(SkScalar sx, SkScalar sy) override {
+    WriteRecord(RecordTag::kSkew, sx, sy);
+  }
+  void transform2x3(SkScalar mxx,
+                    SkScalar mxy,
+                    SkScalar mxt,
+                    SkScalar myx,
+                    SkScalar myy,
+                    SkScalar myt) override {
+    WriteRecord(RecordTag::kTransform2x3, mxx, mxy, mxt, myx, myy, myt);
+  }
+  void transform3x3(SkScalar mxx,
+                    SkScalar mxy,
+                    SkScalar mxt,
+                    SkScalar myx,
+                    SkScalar myy,
+                    SkScalar myt,
+                    SkScalar px,
+                    SkScalar py,
+                    SkScalar pt) override {
+    WriteRecord(RecordTag::kTransform3x3, mxx, mxy, mxt, myx, myy, myt, px, py,
+                pt);
+  }
+
+  void clipRect(const SkRect& rect, bool is_aa, SkClipOp clip_op) override {
+    WriteRecord(RecordTag::kClipRect, rect, Bool(is_aa), Enum(clip_op));
+  }
+  void clipRRect(const SkRRect& rrect, bool is_aa, SkClipOp clip_op) override {
+    WriteRecord(RecordTag::kClipRRect, rrect, Bool(is_aa), Enum(clip_op));
+  }
+  void clipPath(const SkPath& path, bool is_aa, SkClipOp clip_op) override {
+    WriteRecord(RecordTag::kClipPath, AddPath(path), Bool(is_aa),
+                Enum(clip_op));
+  }
+
+  void drawPaint() override { WriteRecord(RecordTag::kDrawPaint); }
+  void drawColor(SkColor color, SkBlendMode mode) override {
+    WriteRecord(RecordTag::kDrawColor, color, Enum(mode));
+  }
+  void drawLine(const SkPoint& p0, const SkPoint& p1) override {
+    WriteRecord(RecordTag::kDrawLine, p0, p1);
+  }
+  void drawRect(const SkRect& rect) override {
+    WriteRecord(RecordTag::kDrawRect, rect);
+  }
+  void drawOval(const SkRect& bounds) override {
+    WriteRecord(RecordTag::kDrawOval, bounds);
+  }
+  void drawCircle(const SkPoint& center, SkScalar radius) override {
+    WriteRecord(RecordTag::kDrawCircle, center, radius);
+  }
+  void drawRRect(const SkRRect& rrect) override {
+    WriteRecord(RecordTag::kDrawRRect, rrect);
+  }
+  void drawDRRect(const SkRRect& outer, const SkRRect& inner) override {
+    WriteRecord(RecordTag::kDrawDRRect, outer, inner);
+  }
+  void drawPath(const SkPath& path) override {
+    WriteRecord(RecordTag::kDrawPath, AddPath(path));
+  }
+  void drawArc(const SkRect& bounds,
+               SkScalar start,
+               SkScalar sweep,
+               bool use_center) override {
+    WriteRecord(RecordTag::kDrawArc, bounds, start, sweep, Bool(use_center));
+  }
+  void drawPoints(SkCanvas::PointMode mode,
+                  uint32_t count,
+                  const SkPoint pts[]) override {
+    WriteRecord(RecordTag::kDrawPoints, Enum(mode), count);
+    WriteArray(pts, count);
+  }
+  void drawVertices(const sk_sp<SkVertices> vertices,
+                    SkBlendMode mode) override {
+    ok_ = false;
+  }
+  void drawImage(const sk_sp<SkImage> image,
+                 const SkPoint point,
+                 const SkSamplingOptions& sampling) override {
+    WriteRecord(RecordTag::kDrawImage, AddImage(image.get()), point);
+    WriteSampling(sampling);
+  }
+  void drawImageRect(const sk_sp<SkImage> image,
+                     const SkRect& src,
+                     const SkRect& dst,
+                     const SkSamplingOptions& sampling,
+                     SkCanvas::SrcRectConstraint constraint) override {
+    WriteRecord(RecordTag::kDrawImageRect, AddImage(image.get()), src, dst,
+                Enum(constraint));
+    WriteSampling(sampling);
+  }
+  void drawImageNine(const sk_sp<SkImage> image,
+                     const SkIRect& center,
+                     const SkRect& dst,
+                     SkFilterMode filter) override {
+    WriteRecord(RecordTag::kDrawImageNine, AddImage(image.get()), center, dst,
+                Enum(filter));
+  }
+  void drawImageLattice(const sk_sp<SkImage> image,
+                        const SkCanvas::Lattice& lattice,
+                        const SkRect& dst,
+                        SkFilterMode filter,
+                        bool with_paint) override {
+    uint32_t x_count = lattice.fXCount;
+    uint32_t y_count = lattice.fYCount;
+    uint32_t cell_count = (x_count + 1) * (y_count + 1);
+    WriteRecord(RecordTag::kDrawImageLattice, AddImage(image.get()), dst,
+                Enum(filter), Bool(with_paint), x_count, y_count,
+                Bool(lattice.fRectTypes != nullptr),
+                Bool(lattice.fColors != nullptr),
+                Bool(lattice.fBounds != nullptr),
+                lattice.fBounds ? *lattice.fBounds : SkIRect::MakeEmpty());
+    WriteArray(lattice.fXDivs, x_count);
+    WriteArray(lattice.fYDivs, y_count);
+    if (lattice.fRectTypes) {
+      for (uint32_t i = 0; i < cell_count; i++) {
+        Write(Enum(lattice.fRectTypes[i]));
+      }
+    }
+    if (lattice.fColors) {
+      WriteArray(lattice.fColors, cell_count);
+    }
+  }
+  void drawAtlas(const sk_sp<SkImage> atlas,
+                 const SkRSXform xform[],
+                 const SkRect tex[],
+                 const SkColor colors[],
+                 int count,
+                 SkBlendMode mode,
+                 const SkSamplingOptions& sampling,
+                 const SkRect* cull_rect) override {
+    WriteRecord(RecordTag::kDrawAtlas, AddImage(atlas.get()),
+                static_cast<uint32_t>(count), Enum(mode),
+                Bool(colors != nullptr), Bool(cull_rect != nullptr),
+                cull_rect ? *cull_rect : SkRect::MakeEmpty());
+    WriteSampling(sampling);
+    WriteArray(xform, count);
+    WriteArray(tex, count);
+    if (colors) {
+      WriteArray(colors, count);
+    }
+  }
+  void drawPicture(const sk_sp<SkPicture> picture,
+                   const SkMatrix* matrix,
+                   bool with_save_layer) override {
+    SkScalar values[9];
+    (matrix ? *matrix : SkMatrix::I()).get9(values);
+    WriteRecord(RecordTag::kDrawPicture,
+                AddObject(ObjectType::kPicture, picture.get(),
+                          [&picture]() { return picture->serialize(); }),
+                Bool(matrix != nullptr), Bool(with_save_layer));
+    WriteArray(values, 9);
+  }
+  void drawDisplayList(const sk_sp<DisplayList> display_list) override {
+    WriteRecord(RecordTag::kDrawDisplayList,
+                AddObject(ObjectType::kDisplayList, display_list.get(),
+                          [&display_list]() {
+                            return DisplayListSerializer::Serialize(
+                                *display_list);
+                          }));
+  }
+  void drawTextBlob(const sk_sp<SkTextBlob> blob,
+                    SkScalar x,
+                    SkScalar y) override {
+    WriteRecord(RecordTag::kDrawTextBlob,
+                AddObject(ObjectType::kTextBlob, blob.get(),
+                          [&blob]() { return blob->serialize({}); }),
+                x, y);
+  }
+  void drawShadow(const SkPath& path,
+                  const SkColor color,
+                  const SkScalar elevation,
+                  bool occludes,
+                  SkScalar dpr) override {
+    WriteRecord(RecordTag::kDrawShadow, AddPath(path), color, elevation,
+                Bool(occludes), dpr);
+  }
+
+ private:
+  bool ok_ = true;
+  std::vector<uint8_t> ops_;
+  std::vector<ObjectEntry> objects_;
+  std::vector<sk_sp<SkData>> object_data_;
+  std::unordered_map<const void*, uint32_t> object_indices_;
+
+  static uint32_t Bool(bool value) { return value ? 1 : 0; }
+
+  template <typename E>
+  static uint32_t Enum(E value) {
+    return static_cast<uint32_t>(value);
+  }
+
+  template <typename T>
+  void Write(const T& value) {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Only plain values can be written directly.");
+    static_assert(sizeof(T) % 4 == 0, "Records must stay 4 byte aligned.");
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    ops_.insert(ops_.end(), bytes, bytes + sizeof(T));
+  }
+
+  void Write(const SkRRect& rrect) {
+    uint8_t buffer[SkRRect::kSizeInMemory];
+    rrect.writeToMemory(buffer);
+    static_assert(SkRRect::kSizeInMemory % 4 == 0,
+                  "Records must stay 4 byte aligned.");
+    ops_.insert(ops_.end(), buffer, buffer + sizeof(buffer));
+  }
+
+  template <typename T>
+  void WriteArray(const T* values, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+      Write(values[i]);
+    }
+  }
+
+  template <typename... Args>
+  void WriteRecord(RecordTag tag, const Args&... args) {
+    Write(Enum(tag));
+    (Write(args), ...);
+  }
+
+  void WriteSampling(const SkSamplingOptions& sampling) {
+    Write(Bool(sampling.useCubic));
+    Write(sampling.cubic.B);
+    Write(sampling.cubic.C);
+    Write(Enum(sampling.filter));
+    Write(Enum(sampling.mipmap));
+  }
+
+  // Adds an object to the table unless |key| is already in it and returns
+  // its index. |encode| is only called for objects not seen before.
+  template <typename Encoder>
+  uint32_t AddObject(ObjectType type, const void* key, const Encoder& encode) {
+    if (!key) {
+      return kNullObject;
+    }
+    auto found = object_indices_.find(key);
+    if (found != object_indices_.end()) {
+      return found->second;
+    }
+    sk_sp<SkData> data = encode();
+    if (!data) {
+      ok_ = false;
+      return kNullObject;
+    }
+    uint32_t index = objects_.size();
+    objects_.push_back({type, 0, static_cast<uint32_t>(data->size())});
+    object_data_.push_back(std::move(data));
+    object_indices_[key] = index;
+    return index;
+  }
+
+  uint32_t AddFlattenable(ObjectType type, SkFlattenable* flattenable) {
+    return AddObject(type, flattenable,
+                     [flattenable]() { return flattenable->serialize(); });
+  }
+
+  uint32_t AddImage(SkImage* image) {
+    return AddObject(ObjectType::kImage, image, [image]() {
+      sk_sp<SkData> encoded = image->refEncodedData();
+      if (encoded) {
+        return encoded;
+      }
+      // Texture backed images are read back before they are encoded.
+      sk_sp<SkImage> raster_image = image->makeRasterImage();
+      return raster_image ? raster_image->encodeToData() : nullptr;
+    });
+  }
+
+  uint32_t AddPath(const SkPath& path) {
+    // Paths are passed by value so they are not shared between records.
+    uint32_t index = objects_.size();
+    sk_sp<SkData> data = path.serialize();
+    objects_.push_back(
+        {ObjectType::kPath, 0, static_cast<uint32_t>(data->size())});
+    object_data_.push_back(std::move(data));
+    return index;
+  }
+};
+
+// Reads values out of a bounds checked range of bytes. Once a read fails
+// every later read fails too, so callers only need to check ok() once
+// they are done.
+class ByteReader {
+ public:
+  ByteReader(const uint8_t* ptr, size_t length)
+      : ptr_(ptr), end_(ptr + length) {}
+
+  bool ok() const { return ok_; }
+  bool at_end() const { return ptr_ == end_; }
+
+  template <typename T>
+  T Read() {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Only plain values can be read directly.");
+    T value;
+    if (!Check(sizeof(T))) {
+      memset(&value, 0, sizeof(T));
+      return value;
+    }
+    memcpy(&value, ptr_, sizeof(T));
+    ptr_ += sizeof(T);
+    return value;
+  }
+
+  bool ReadBool() { return Read<uint32_t>() != 0; }
+
+  template <typename E>
+  E ReadEnum(E max_value) {
+    uint32_t value = Read<uint32_t>();
+    if (value > static_cast<uint32_t>(max_value)) {
+      ok_ = false;
+      return static_cast<E>(0);
+    }
+    return static_cast<E>(value);
+  }
+
+  SkRRect ReadRRect() {
+    SkRRect rrect;
+    if (Check(SkRRect::kSizeInMemory) &&
+        rrect.readFromMemory(ptr_, SkRRect::kSizeInMemory) ==
+            SkRRect::kSizeInMemory) {
+      ptr_ += SkRRect::kSizeInMemory;
+    } else {
+      ok_ = false;
+    }
+    return rrect;
+  }
+
+  template <typename T>
+  std::vector<T> ReadArray(uint32_t count) {
+    std::vector<T> values;
+    if (!Check(static_cast<uint64_t>(count) * sizeof(T))) {
+      return values;
+    }
+    values.resize(count);
+    memcpy(values.data(), ptr_, count * sizeof(T));
+    ptr_ += count * sizeof(T);
+    return values;
+  }
+
+  SkSamplingOptions ReadSampling() {
+    bool use_cubic = ReadBool();
+    SkCubicResampler cubic{Read<float>(), Read<float>()};
+    SkFilterMode filter = ReadEnum(SkFilterMode::kLast);
+    SkMipmapMode mipmap = ReadEnum(SkMipmapMode::kLast);
+    return use_cubic ? SkSamplingOptions(cubic)
+                     : SkSamplingOptions(filter, mipmap);
+  }
+
+ private:
+  const uint8_t* ptr_;
+  const uint8_t* end_;
+  bool ok_ = true;
+
+  bool Check(uint64_t size) {
+    if (!ok_ || size > static_cast<uint64_t>(end_ - ptr_)) {
+      ok_ = false;
+      return false;
+    }
+    return true;
+  }
+};
+
+sk_sp<DisplayList> DeserializeAtDepth(const void* data,
+                                      size_t length,
+                                      int depth);
+
+// Decodes the objects of the object table on demand, at most once each.
+// |depth| is the nesting depth of the display list that owns the table.
+class ObjectTable {
+ public:
+  ObjectTable(const uint8_t* data,
+              const ObjectEntry* entries,
+              size_t count,
+              int depth)
+      : data_(data),
+        entries_(entries),
+        count_(count),
+        depth_(depth),
+        objects_(count) {}
+
+  bool ok() const { return ok_; }
+
+  template <typename T>
+  sk_sp<T> Get(uint32_t index, ObjectType type) {
+    if (index == kNullObject) {
+      return nullptr;
+    }
+    sk_sp<SkRefCnt>* slot = Find(index, type);
+    if (!slot) {
+      return nullptr;
+    }
+    if (!*slot) {
+      *slot = Decode(index, type);
+      if (!*slot) {
+        ok_ = false;
+        return nullptr;
+      }
+    }
+    return sk_ref_sp(static_cast<T*>(slot->get()));
+  }
+
+  // Text blobs are not SkRefCnt objects so they are cached separately.
+  sk_sp<SkTextBlob> GetTextBlob(uint32_t index) {
+    const ObjectEntry* entry = FindEntry(index, ObjectType::kTextBlob);
+    if (!entry) {
+      return nullptr;
+    }
+    sk_sp<SkTextBlob>& blob = text_blobs_[index];
+    if (!blob) {
+      blob = SkTextBlob::Deserialize(data_ + entry->offset, entry->length, {});
+      if (!blob) {
+        ok_ = false;
+      }
+    }
+    return blob;
+  }
+
+  SkPath GetPath(uint32_t index) {
+    SkPath path;
+    const ObjectEntry* entry = FindEntry(index, ObjectType::kPath);
+    if (!entry ||
+        path.readFromMemory(data_ + entry->offset, entry->length) == 0) {
+      ok_ = false;
+    }
+    return path;
+  }
+
+ private:
+  const uint8_t* data_;
+  const ObjectEntry* entries_;
+  size_t count_;
+  int depth_;
+  std::vector<sk_sp<SkRefCnt>> objects_;
+  std::unordered_map<uint32_t, sk_sp<SkTextBlob>> text_blobs_;
+  bool ok_ = true;
+
+  const ObjectEntry* FindEntry(uint32_t index, ObjectType type) {
+    if (index >= count_ || entries_[index].type != type) {
+      ok_ = false;
+      return nullptr;
+    }
+    return &entries_[index];
+  }
+
+  sk_sp<SkRefCnt>* Find(uint32_t index, ObjectType type) {
+    return FindEntry(index, type) ? &objects_[index] : nullptr;
+  }
+
+  sk_sp<SkRefCnt> Decode(uint32_t index, ObjectType type) {
+    const void* data = data_ + entries_[index].offset;
+    size_t length = entries_[index].length;
+    switch (type) {
+      case ObjectType::kImage:
+        // The image decodes lazily so it needs its own copy of the data.
+        return SkImage::MakeFromEncoded(SkData::MakeWithCopy(data, length));
+      case ObjectType::kPath:
+      case ObjectType::kTextBlob:
+        // Read with GetPath and GetTextBlob.
+        return nullptr;
+      case ObjectType::kPicture:
+        return SkPicture::MakeFromData(data, length);
+      case ObjectType::kDisplayList:
+        return DeserializeAtDepth(data, length, depth_ + 1);
+      case ObjectType::kBlender:
+        return SkFlattenable::Deserialize(SkFlattenable::kSkBlender_Type, data,
+                                          length);
+      case ObjectType::kShader:
+        return SkFlattenable::Deserialize(SkFlattenable::kSkShader_Type, data,
+                                          length);
+      case ObjectType::kImageFilter:
+        return SkFlattenable::Deserialize(SkFlattenable::kSkImageFilter_Type,
+                                          data, length);
+      case ObjectType::kColorFilter:
+        return SkFlattenable::Deserialize(SkFlattenable::kSkColorFilter_Type,
+                                          data, length);
+      case ObjectType::kPathEffect:
+        return SkFlattenable::Deserialize(SkFlattenable::kSkPathEffect_Type,
+                                          data, length);
+      case ObjectType::kMaskFilter:
+        return SkFlattenable::Deserialize(SkFlattenable::kSkMaskFilter_Type,
+                                          data, length);
+    }
+    return nullptr;
+  }
+};
+
+// Replays the records of |reader| into |builder|. Returns false if a record
+// is malformed or refers to an object that cannot be decoded.
+bool ReadRecords(ByteReader& reader,
+                 ObjectTable& objects,
+                 DisplayListBuilder& builder) {
+  while (reader.ok() && objects.ok() && !reader.at_end()) {
+    RecordTag tag = reader.ReadEnum(RecordTag::kLastTag);
+    if (!reader.ok()) {
+      return false;
+    }
+    switch (tag) {
+      case RecordTag::kSetAA:
+        builder.setAA(reader.ReadBool());
+        break;
+      case RecordTag::kSetDither:
+        builder.setDither(reader.ReadBool());
+        break;
+      case RecordTag::kSetInvertColors:
+        builder.setInvertColors(reader.ReadBool());
+        break;
+      case RecordTag::kSetCaps:
+        builder.setCaps(reader.ReadEnum(SkPaint::kLast_Cap));
+        break;
+      case RecordTag::kSetJoins:
+        builder.setJoins(reader.ReadEnum(SkPaint::kLast_Join));
+        break;
+      case RecordTag::kSetDrawStyle:
+        builder.setDrawStyle(reader.ReadEnum(SkPaint::kStrokeAndFill_Style));
+        break;
+      case RecordTag::kSetStrokeWidth:
+        builder.setStrokeWidth(reader.Read<SkScalar>());
+        break;
+      case RecordTag::kSetMiterLimit:
+        builder.setMiterLimit(reader.Read<SkScalar>());
+        break;
+      case RecordTag::kSetColor:
+        builder.setColor(reader.Read<SkColor>());
+        break;
+      case RecordTag::kSetBlendMode:
+        builder.setBlendMode(reader.ReadEnum(SkBlendMode::kLastMode));
+        break;
+      case RecordTag::kSetBlender:
+        builder.setBlender(objects.Get<SkBlender>(reader.Read<uint32_t>(),
+                                                  ObjectType::kBlender));
+        break;
+      case RecordTag::kSetShader:
+        builder.setShader(objects.Get<SkShader>(reader.Read<uint32_t>(),
+                                                ObjectType::kShader));
+        break;
+      case RecordTag::kSetImageFilter:
+        builder.setImageFilter(objects.Get<SkImageFilter>(
+            reader.Read<uint32_t>(), ObjectType::kImageFilter));
+        break;
+      case RecordTag::kSetColorFilter:
+        builder.setColorFilter(objects.Get<SkColorFilter>(
+            reader.Read<uint32_t>(), ObjectType::kColorFilter));
+        break;
+      case RecordTag::kSetPathEffect:
+        builder.setPathEffect(objects.Get<SkPathEffect>(
+            reader.Read<uint32_t>(), ObjectType::kPathEffect));
+        break;
+      case RecordTag::kSetMaskFilter:
+        builder.setMaskFilter(objects.Get<SkMaskFilter>(
+            reader.Read<uint32_t>(), ObjectType::kMaskFilter));
+        break;
+      case RecordTag::kSetMaskBlurFilter: {
+        SkBlurStyle style = reader.ReadEnum(kLastEnum_SkBlurStyle);
+        builder.setMaskBlurFilter(style, reader.Read<SkScalar>());
+        break;
+      }
+
+      case RecordTag::kSave:
+        builder.save();
+        break;
+      case RecordTag::kRestore:
+        builder.restore();
+        break;
+      case RecordTag::kSaveLayer: {
+        bool has_bounds = reader.ReadBool();
+        SkRect bounds = reader.Read<SkRect>();
+        bool with_paint = reader.ReadBool();
+        builder.saveLayer(has_bounds ? &bounds : nullptr, with_paint);
+        break;
+      }
+
+      case RecordTag::kTranslate: {
+        SkScalar tx = reader.Read<SkScalar>();
+        builder.translate(tx, reader.Read<SkScalar>());
+        break;
+      }
+      case RecordTag::kScale: {
+        SkScalar sx = reader.Read<SkScalar>();
+        builder.scale(sx, reader.Read<SkScalar>());
+        break;
+      }
+      case RecordTag::kRotate:
+        builder.rotate(reader.Read<SkScalar>());
+        break;
+      case RecordTag::kSkew: {
+        SkScalar sx = reader.Read<SkScalar>();
+        builder.skew(sx, reader.Read<SkScalar>());
+        break;
+      }
+      case RecordTag::kTransform2x3: {
+        std::vector<SkScalar> m = reader.ReadArray<SkScalar>(6);
+        if (reader.ok()) {
+          builder.transform2x3(m[0], m[1], m[2], m[3], m[4], m[5]);
+        }
+        break;
+      }
+      case RecordTag::kTransform3x3: {
+        std::vector<SkScalar> m = reader.ReadArray<SkScalar>(9);
+        if (reader.ok()) {
+          builder.transform3x3(m[0], m[1], m[2], m[3], m[4], m[5], m[6], m[7],
+                               m[8]);
+        }
+        break;
+      }
+
+      case RecordTag::kClipRect: {
+        SkRect rect = reader.Read<SkRect>();
+        bool is_aa = reader.ReadBool();
+        builder.clipRect(rect, is_aa,
+                         reader.ReadEnum(SkClipOp::kMax_EnumValue));
+        break;
+      }
+      case RecordTag::kClipRRect: {
+        SkRRect rrect = reader.ReadRRect();
+        bool is_aa = reader.ReadBool();
+        builder.clipRRect(rrect, is_aa,
+                          reader.ReadEnum(SkClipOp::kMax_EnumValue));
+        break;
+      }
+      case RecordTag::kClipPath: {
+        SkPath path = objects.GetPath(reader.Read<uint32_t>());
+        bool is_aa = reader.ReadBool();
+        builder.clipPath(path, is_aa,
+                         reader.ReadEnum(SkClipOp::kMax_EnumValue));
+        break;
+      }
+
+      case RecordTag::kDrawPaint:
+        builder.drawPaint();
+        break;
+      case RecordTag::kDrawColor: {
+        SkColor color = reader.Read<SkColor>();
+        builder.drawColor(color, reader.ReadEnum(SkBlendMode::kLastMode));
+        break;
+      }
+      case RecordTag::kDrawLine: {
+        SkPoint p0 = reader.Read<SkPoint>();
+        builder.drawLine(p0, reader.Read<SkPoint>());
+        break;
+      }
+      case RecordTag::kDrawRect:
+        builder.drawRect(reader.Read<SkRect>());
+        break;
+      case RecordTag::kDrawOval:
+        builder.drawOval(reader.Read<SkRect>());
+        break;
+      case RecordTag::kDrawCircle: {
+        SkPoint center = reader.Read<SkPoint>();
+        builder.drawCircle(center, reader.Read<SkScalar>());
+        break;
+      }
+      case RecordTag::kDrawRRect:
+        builder.drawRRect(reader.ReadRRect());
+        break;
+      case RecordTag::kDrawDRRect: {
+        SkRRect outer = reader.ReadRRect();
+        builder.drawDRRect(outer, reader.ReadRRect());
+        break;
+      }
+      case RecordTag::kDrawPath:
+        builder.drawPath(objects.GetPath(reader.Read<uint32_t>()));
+        break;
+      case RecordTag::kDrawArc: {
+        SkRect bounds = reader.Read<SkRect>();
+        SkScalar start = reader.Read<SkScalar>();
+        SkScalar sweep = reader.Read<SkScalar>();
+        builder.drawArc(bounds, start, sweep, reader.ReadBool());
+        break;
+      }
+      case RecordTag::kDrawPoints: {
+        SkCanvas::PointMode mode =
+            reader.ReadEnum(SkCanvas::PointMode::kPolygon_PointMode);
+        uint32_t count = reader.Read<uint32_t>();
+        std::vector<SkPoint> points = reader.ReadArray<SkPoint>(count);
+        if (reader.ok()) {
+          builder.drawPoints(mode, count, points.data());
+        }
+        break;
+      }
+      case RecordTag::kDrawImage: {
+        sk_sp<SkImage> image =
+            objects.Get<SkImage>(reader.Read<uint32_t>(), ObjectType::kImage);
+        SkPoint point = reader.Read<SkPoint>();
+        SkSamplingOptions sampling = reader.ReadSampling();
+        if (reader.ok() && objects.ok()) {
+          builder.drawImage(std::move(image), point, sampling);
+        }
+        break;
+      }
+      case RecordTag::kDrawImageRect: {
+        sk_sp<SkImage> image =
+            objects.Get<SkImage>(reader.Read<uint32_t>(), ObjectType::kImage);
+        SkRect src = reader.Read<SkRect>();
+        SkRect dst = reader.Read<SkRect>();
+        SkCanvas::SrcRectConstraint constraint =
+            reader.ReadEnum(SkCanvas::kFast_SrcRectConstraint);
+        SkSamplingOptions sampling = reader.ReadSampling();
+        if (reader.ok() && objects.ok()) {
+          builder.drawImageRect(std::move(image), src, dst, sampling,
+                                constraint);
+        }
+        break;
+      }
+      case RecordTag::kDrawImageNine: {
+        sk_sp<SkImage> image =
+            objects.Get<SkImage>(reader.Read<uint32_t>(), ObjectType::kImage);
+        SkIRect center = reader.Read<SkIRect>();
+        SkRect dst = reader.Read<SkRect>();
+        SkFilterMode filter = reader.ReadEnum(SkFilterMode::kLast);
+        if (reader.ok() && objects.ok()) {
+          builder.drawImageNine(std::move(image), center, dst, filter);
+        }
+        break;
+      }
+      case RecordTag::kDrawImageLattice: {
+        sk_sp<SkImage> image =
+            objects.Get<SkImage>(reader.Read<uint32_t>(), ObjectType::kImage);
+        SkRect dst = reader.Read<SkRect>();
+        SkFilterMode filter = reader.ReadEnum(SkFilterMode::kLast);
+        bool with_paint = reader.ReadBool();
+        uint32_t x_count = reader.Read<uint32_t>();
+        uint32_t y_count = reader.Read<uint32_t>();
+        bool has_rect_types = reader.ReadBool();
+        bool has_colors = reader.ReadBool();
+        bool has_bounds = reader.ReadBool();
+        SkIRect bounds = reader.Read<SkIRect>();
+        std::vector<int> x_divs = reader.ReadArray<int>(x_count);
+        std::vector<int> y_divs = reader.ReadArray<int>(y_count);
+        uint64_t cell_count =
+            (static_cast<uint64_t>(x_count) + 1) * (y_count + 1);
+        if (!reader.ok() || cell_count > UINT32_MAX) {
+          return false;
+        }
+        std::vector<SkCanvas::Lattice::RectType> rect_types;
+        if (has_rect_types) {
+          for (uint64_t i = 0; i < cell_count && reader.ok(); i++) {
+            rect_types.push_back(
+                reader.ReadEnum(SkCanvas::Lattice::RectType::kFixedColor));
+          }
+        }
+        std::vector<SkColor> colors;
+        if (has_colors) {
+          colors = reader.ReadArray<SkColor>(cell_count);
+        }
+        if (reader.ok() && objects.ok()) {
+          SkCanvas::Lattice lattice = {
+              x_divs.data(),
+              y_divs.data(),
+              has_rect_types ? rect_types.data() : nullptr,
+              static_cast<int>(x_count),
+              static_cast<int>(y_count),
+              has_bounds ? &bounds : nullptr,
+              has_colors ? colors.data() : nullptr,
+          };
+          builder.drawImageLattice(std::move(image), lattice, dst, filter,
+                                   with_paint);
+        }
+        break;
+      }
+      case RecordTag::kDrawAtlas: {
+        sk_sp<SkImage> atlas =
+            objects.Get<SkImage>(reader.Read<uint32_t>(), ObjectType::kImage);
+        uint32_t count = reader.Read<uint32_t>();
+        SkBlendMode mode = reader.ReadEnum(SkBlendMode::kLastMode);
+        bool has_colors = reader.ReadBool();
+        bool has_cull_rect = reader.ReadBool();
+        SkRect cull_rect = reader.Read<SkRect>();
+        SkSamplingOptions sampling = reader.ReadSampling();
+        std::vector<SkRSXform> xforms = reader.ReadArray<SkRSXform>(count);
+        std::vector<SkRect> tex = reader.ReadArray<SkRect>(count);
+        std::vector<SkColor> colors;
+        if (has_colors) {
+          colors = reader.ReadArray<SkColor>(count);
+        }
+        if (reader.ok() && objects.ok() && count <= INT32_MAX) {
+          builder.drawAtlas(std::move(atlas), xforms.data(), tex.data(),
+                            has_colors ? colors.data() : nullptr, count, mode,
+                            sampling, has_cull_rect ? &cull_rect : nullptr);
+        }
+        break;
+      }
+      case RecordTag::kDrawPicture: {
+        sk_sp<SkPicture> picture = objects.Get<SkPicture>(
+            reader.Read<uint32_t>(), ObjectType::kPicture);
+        bool has_matrix = reader.ReadBool();
+        bool with_save_layer = reader.ReadBool();
+        std::vector<SkScalar> values = reader.ReadArray<SkScalar>(9);
+        if (reader.ok() && objects.ok()) {
+          SkMatrix matrix;
+          matrix.set9(values.data());
+          builder.drawPicture(std::move(picture),
+                              has_matrix ? &matrix : nullptr, with_save_layer);
+        }
+        break;
+      }
+      case RecordTag::kDrawDisplayList: {
+        sk_sp<DisplayList> display_list = objects.Get<DisplayList>(
+            reader.Read<uint32_t>(), ObjectType::kDisplayList);
+        if (display_list) {
+          builder.drawDisplayList(std::move(display_list));
+        }
+        break;
+      }
+      case RecordTag::kDrawTextBlob: {
+        sk_sp<SkTextBlob> blob = objects.GetTextBlob(reader.Read<uint32_t>());
+        SkScalar x = reader.Read<SkScalar>();
+        SkScalar y = reader.Read<SkScalar>();
+        if (blob) {
+          builder.drawTextBlob(std::move(blob), x, y);
+        }
+        break;
+      }
+      case RecordTag::kDrawShadow: {
+        SkPath path = objects.GetPath(reader.Read<uint32_t>());
+        SkColor color = reader.Read<SkColor>();
+        SkScalar elevation = reader.Read<SkScalar>();
+        bool occludes = reader.ReadBool();
+        builder.drawShadow(path, color, elevation, occludes,
+                           reader.Read<SkScalar>());
+        break;
+      }
+    }
+  }
+  return reader.ok() && objects.ok();
+}
+
+sk_sp<DisplayList> DeserializeAtDepth(const void* data,
+                                      size_t length,
+                                      int depth) {
+  if (depth > DisplayListSerializer::kMaxNestingDepth) {
+    FML_LOG(ERROR) << "Too deeply nested display list encoding.";
+    return nullptr;
+  }
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  Header header;
+  if (!bytes || length < sizeof(header)) {
+    return nullptr;
+  }
+  memcpy(&header, bytes, sizeof(header));
+  if (header.magic != DisplayListSerializer::kMagic ||
+      header.version != DisplayListSerializer::kVersion) {
+    FML_LOG(ERROR) << "Unsupported display list encoding.";
+    return nullptr;
+  }
+  uint64_t ops_end = static_cast<uint64_t>(header.ops_offset) +
+                     header.ops_length;
+  uint64_t objects_end =
+      static_cast<uint64_t>(header.objects_offset) +
+      static_cast<uint64_t>(header.object_count) * sizeof(ObjectEntry);
+  // The sections follow each other in the order Serialize writes them.
+  if (header.ops_offset < sizeof(header) ||
+      header.objects_offset < ops_end || objects_end > length) {
+    return nullptr;
+  }
+
+  // The entries are copied out so that they are aligned whatever the
+  // alignment of |data| is.
+  std::vector<ObjectEntry> entries(header.object_count);
+  memcpy(entries.data(), bytes + header.objects_offset,
+         entries.size() * sizeof(ObjectEntry));
+  // The objects are stored after the object table, so a nested display list
+  // is always shorter than the list that contains it.
+  for (const ObjectEntry& entry : entries) {
+    if (entry.offset < objects_end ||
+        static_cast<uint64_t>(entry.offset) + entry.length > length ||
+        entry.type > ObjectType::kMaskFilter) {
+      return nullptr;
+    }
+  }
+
+  ObjectTable objects(bytes, entries.data(), entries.size(), depth);
+  ByteReader reader(bytes + header.ops_offset, header.ops_length);
+  DisplayListBuilder builder(header.cull_rect,
+                             (header.flags & kHasRTreeFlag) != 0);
+  if (!ReadRecords(reader, objects, builder)) {
+    FML_LOG(ERROR) << "Malformed display list encoding.";
+    return nullptr;
+  }
+  return builder.Build();
+}
+
+}  // namespace
+
+sk_sp<SkData> DisplayListSerializer::Serialize(
+    const DisplayList& display_list) {
+  TRACE_EVENT0("flutter", "DisplayListSerializer::Serialize");
+  DisplayListWriter writer;
+  display_list.Dispatch(writer);
+  return writer.Finish(display_list.bounds_cull_, display_list.has_rtree());
+}
+
+sk_sp<DisplayList> DisplayListSerializer::Deserialize(const void* data,
+                                                      size_t length) {
+  TRACE_EVENT0("flutter", "DisplayListSerializer::Deserialize");
+  return DeserializeAtDepth(data, length, 0);
+}
+
+}  // namespace flutter
@@ -0,0 +1,61 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FLUTTER_FLOW_DISPLAY_LIST_SERIALIZATION_H_
+#define FLUTTER_FLOW_DISPLAY_LIST_SERIALIZATION_H_
+
+#include "flutter/flow/display_list.h"
+#include "third_party/skia/include/core/SkData.h"
+
+// A versioned binary encoding of a DisplayList that can be written to disk
+// or sent to another process and turned back into an equivalent DisplayList
+// without access to the code that recorded it.
+//
+// The encoding contains no pointers, only offsets relative to its start,
+// so it can be read directly out of a memory mapped file. It is made of:
+//
+// - A fixed size header with a magic number, the format version, the
+//   cull rect of the list and the location of the other two sections.
+// - The operations of the list as a sequence of 4 byte aligned records,
+//   each a 32 bit tag followed by the arguments of the Dispatcher method
+//   it stands for.
+// - A table of the objects referenced by the operations: images, paths,
+//   text blobs, pictures, nested display lists and Skia effects such as
+//   shaders and filters. Each object is stored once, out of line, in a
+//   self contained Skia encoding (PNG for images) and operations refer to
+//   it by its index in the table.
+//
+// Values are stored in the byte order of the machine that wrote them. A
+// reader with the other byte order sees a different magic number and
+// rejects the data.
+//
+// Display lists containing drawVertices calls cannot be serialized since
+// Skia has no public encoding for SkVertices.
+
+namespace flutter {
+
+class DisplayListSerializer {
+ public:
+  static constexpr uint32_t kMagic = 0x4C444C46;  // "FLDL"
+  // Increment when the layout of the header, the records or the object
+  // table changes. Readers reject any other version.
+  static constexpr uint32_t kVersion = 1;
+  // The number of levels of nested display lists that Deserialize accepts.
+  // Deeper nesting is treated as malformed so that crafted data cannot
+  // exhaust the stack.
+  static constexpr int kMaxNestingDepth = 32;
+
+  // Returns the encoding of |display_list|, or nullptr if it contains an
+  // operation or an object that cannot be encoded.
+  static sk_sp<SkData> Serialize(const DisplayList& display_list);
+
+  // Rebuilds a DisplayList from data produced by Serialize. The data does
+  // not need to outlive the returned list. Returns nullptr if the data is
+  // malformed, truncated or was written by a different version.
+  static sk_sp<DisplayList> Deserialize(const void* data, size_t length);
+};
+
+}  // namespace flutter
+
+#endif  // FLUTTER_FLOW_DISPLAY_LIST_SERIALIZATION_H_
@@ -0,0 +1,202 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/flow/display_list_serialization.h"
+
+#include <cstring>
+
+#include "flutter/flow/display_list_canvas.h"
+#include "gtest/gtest.h"
+#include "third_party/skia/include/core/SkBitmap.h"
+#include "third_party/skia/include/core/SkPath.h"
+#include "third_party/skia/include/core/SkRRect.h"
+#include "third_party/skia/include/core/SkSurface.h"
+#include "third_party/skia/include/core/SkVertices.h"
+#include "third_party/skia/include/effects/SkGradientShader.h"
+
+namespace flutter {
+namespace testing {
+
+static sk_sp<DisplayList> MakePlainDisplayList() {
+  DisplayListBuilder builder(SkRect::MakeWH(100, 100), true);
+  builder.setAA(true);
+  builder.setColor(SK_ColorRED);
+  builder.setDrawStyle(SkPaint::kStroke_Style);
+  builder.setStrokeWidth(3);
+  builder.save();
+  builder.translate(10, 10);
+  builder.clipRRect(SkRRect::MakeRectXY({0, 0, 50, 50}, 5, 5), true,
+                    SkClipOp::kIntersect);
+  builder.drawRect({5, 5, 20, 20});
+  builder.drawPath(SkPath::Circle(30, 30, 10));
+  builder.restore();
+  builder.saveLayer(nullptr, false);
+  SkPoint points[] = {{1, 1}, {2, 2}, {3, 3}};
+  builder.drawPoints(SkCanvas::kPolygon_PointMode, 3, points);
+  builder.restore();
+  return builder.Build();
+}
+
+static SkBitmap Render(const DisplayList& display_list) {
+  sk_sp<SkSurface> surface = SkSurface::MakeRasterN32Premul(100, 100);
+  display_list.RenderTo(surface->getCanvas());
+  SkBitmap bitmap;
+  bitmap.allocN32Pixels(100, 100);
+  surface->readPixels(bitmap, 0, 0);
+  return bitmap;
+}
+
+static bool SamePixels(const SkBitmap& a, const SkBitmap& b) {
+  return a.computeByteSize() == b.computeByteSize() &&
+         memcmp(a.getPixels(), b.getPixels(), a.computeByteSize()) == 0;
+}
+
+TEST(DisplayListSerializer, RoundTripPreservesOps) {
+  sk_sp<DisplayList> display_list = MakePlainDisplayList();
+  sk_sp<SkData> data = DisplayListSerializer::Serialize(*display_list);
+  ASSERT_NE(data, nullptr);
+
+  sk_sp<DisplayList> copy =
+      DisplayListSerializer::Deserialize(data->data(), data->size());
+  ASSERT_NE(copy, nullptr);
+  EXPECT_EQ(copy->op_count(), display_list->op_count());
+  EXPECT_TRUE(copy->Equals(*display_list));
+  EXPECT_TRUE(copy->has_rtree());
+  EXPECT_EQ(copy->bounds(), display_list->bounds());
+}
+
+TEST(DisplayListSerializer, RoundTripPreservesReferencedObjects) {
+  SkPoint end_points[] = {{0, 0}, {100, 100}};
+  SkColor colors[] = {SK_ColorGREEN, SK_ColorBLUE};
+  sk_sp<SkShader> shader = SkGradientShader::MakeLinear(
+      end_points, colors, nullptr, 2, SkTileMode::kClamp);
+  sk_sp<SkSurface> image_surface = SkSurface::MakeRasterN32Premul(10, 10);
+  image_surface->getCanvas()->clear(SK_ColorYELLOW);
+  sk_sp<SkImage> image = image_surface->makeImageSnapshot();
+
+  DisplayListBuilder nested_builder;
+  nested_builder.drawCircle({50, 50}, 10);
+  sk_sp<DisplayList> nested = nested_builder.Build();
+
+  DisplayListBuilder builder;
+  builder.setShader(shader);
+  builder.drawRect({0, 0, 50, 50});
+  builder.setShader(nullptr);
+  builder.drawImage(image, {60, 60}, DisplayList::NearestSampling);
+  builder.drawImage(image, {80, 80}, DisplayList::LinearSampling);
+  builder.drawDisplayList(nested);
+  sk_sp<DisplayList> display_list = builder.Build();
+
+  sk_sp<SkData> data = DisplayListSerializer::Serialize(*display_list);
+  ASSERT_NE(data, nullptr);
+  sk_sp<DisplayList> copy =
+      DisplayListSerializer::Deserialize(data->data(), data->size());
+  ASSERT_NE(copy, nullptr);
+  EXPECT_EQ(copy->op_count(), display_list->op_count());
+  EXPECT_TRUE(SamePixels(Render(*copy), Render(*display_list)));
+
+  // A list that draws the image once more only grows by the size of the
+  // record since the image itself is already in the object table.
+  builder.setShader(shader);
+  builder.drawRect({0, 0, 50, 50});
+  builder.setShader(nullptr);
+  builder.drawImage(image, {60, 60}, DisplayList::NearestSampling);
+  builder.drawImage(image, {80, 80}, DisplayList::LinearSampling);
+  builder.drawImage(image, {0, 80}, DisplayList::LinearSampling);
+  builder.drawDisplayList(nested);
+  sk_sp<SkData> larger_data =
+      DisplayListSerializer::Serialize(*builder.Build());
+  ASSERT_NE(larger_data, nullptr);
+  EXPECT_LT(larger_data->size() - data->size(), 64u);
+}
+
+TEST(DisplayListSerializer, RejectsMalformedData) {
+  sk_sp<SkData> data =
+      DisplayListSerializer::Serialize(*MakePlainDisplayList());
+  ASSERT_NE(data, nullptr);
+
+  EXPECT_EQ(DisplayListSerializer::Deserialize(nullptr, 0), nullptr);
+  EXPECT_EQ(DisplayListSerializer::Deserialize(data->data(), 16), nullptr);
+  EXPECT_EQ(
+      DisplayListSerializer::Deserialize(data->data(), data->size() - 4),
+      nullptr);
+
+  sk_sp<SkData> wrong_version = SkData::MakeWithCopy(data->data(),
+                                                     data->size());
+  uint32_t version = DisplayListSerializer::kVersion + 1;
+  memcpy(static_cast<uint8_t*>(wrong_version->writable_data()) + 4, &version,
+         sizeof(version));
+  EXPECT_EQ(DisplayListSerializer::Deserialize(wrong_version->data(),
+                                               wrong_version->size()),
+            nullptr);
+}
+
+TEST(DisplayListSerializer, RejectsSelfReferencingNestedDisplayList) {
+  DisplayListBuilder nested_builder;
+  nested_builder.drawCircle({50, 50}, 10);
+  DisplayListBuilder builder;
+  builder.drawDisplayList(nested_builder.Build());
+  sk_sp<SkData> data = DisplayListSerializer::Serialize(*builder.Build());
+  ASSERT_NE(data, nullptr);
+
+  // Points the entry of the nested list, the only object, at the whole
+  // encoding. The object table location follows the magic, version, flags,
+  // cull rect, ops offset and ops length in the header, and each entry is
+  // a type, an offset and a length.
+  sk_sp<SkData> looping = SkData::MakeWithCopy(data->data(), data->size());
+  uint8_t* bytes = static_cast<uint8_t*>(looping->writable_data());
+  uint32_t objects_offset;
+  uint32_t object_count;
+  memcpy(&objects_offset, bytes + 36, sizeof(objects_offset));
+  memcpy(&object_count, bytes + 40, sizeof(object_count));
+  ASSERT_EQ(object_count, 1u);
+  uint32_t entry[3];
+  memcpy(entry, bytes + objects_offset, sizeof(entry));
+  entry[1] = 0;
+  entry[2] = looping->size();
+  memcpy(bytes + objects_offset, entry, sizeof(entry));
+
+  EXPECT_NE(DisplayListSerializer::Deserialize(data->data(), data->size()),
+            nullptr);
+  EXPECT_EQ(
+      DisplayListSerializer::Deserialize(looping->data(), looping->size()),
+      nullptr);
+}
+
+TEST(DisplayListSerializer, RejectsTooDeeplyNestedDisplayLists) {
+  auto nest = [](int depth) {
+    DisplayListBuilder innermost;
+    innermost.drawCircle({50, 50}, 10);
+    sk_sp<DisplayList> display_list = innermost.Build();
+    for (int i = 0; i < depth; i++) {
+      DisplayListBuilder builder;
+      builder.drawDisplayList(display_list);
+      display_list = builder.Build();
+    }
+    return DisplayListSerializer::Serialize(*display_list);
+  };
+  sk_sp<SkData> deepest = nest(DisplayListSerializer::kMaxNestingDepth);
+  ASSERT_NE(deepest, nullptr);
+  EXPECT_NE(DisplayListSerializer::Deserialize(deepest->data(),
+                                               deepest->size()),
+            nullptr);
+  sk_sp<SkData> too_deep = nest(DisplayListSerializer::kMaxNestingDepth + 1);
+  ASSERT_NE(too_deep, nullptr);
+  EXPECT_EQ(DisplayListSerializer::Deserialize(too_deep->data(),
+                                               too_deep->size()),
+            nullptr);
+}
+
+TEST(DisplayListSerializer, VerticesCannotBeSerialized) {
+  SkPoint points[] = {{0, 0}, {10, 0}, {0, 10}};
+  DisplayListBuilder builder;
+  builder.drawVertices(
+      SkVertices::MakeCopy(SkVertices::kTriangles_VertexMode, 3, points,
+                           nullptr, nullptr),
+      SkBlendMode::kSrcOver);
+  EXPECT_EQ(DisplayListSerializer::Serialize(*builder.Build()), nullptr);
+}
+
+}  // namespace testing
+}  // namespace flutter
@@ -251,22 +251,22 @@ struct DisplayListInvocationGroup {
 
 std::vector<DisplayListInvocationGroup> allGroups = {
   { "SetAA", {
-      {1, 8, 0, 0, [](DisplayListBuilder& b) {b.setAA(false);}},
+      {0, 0, 0, 0, [](DisplayListBuilder& b) {b.setAA(false);}},
       {1, 8, 0, 0, [](DisplayListBuilder& b) {b.setAA(true);}},
     }
   },
   { "SetDither", {
-      {1, 8, 0, 0, [](DisplayListBuilder& b) {b.setDither(false);}},
+      {0, 0, 0, 0, [](DisplayListBuilder& b) {b.setDither(false);}},
       {1, 8, 0, 0, [](DisplayListBuilder& b) {b.setDither(true);}},
     }
   },
   { "SetInvertColors", {
-      {1, 8, 0, 0, [](DisplayListBuilder& b) {b.setInvertColors(false);}},
+      {0, 0, 0, 0, [](DisplayListBuilder& b) {b.setInvertColors(false);}},
       {1, 8, 0, 0, [](DisplayListBuilder& b) {b.setInvertColors(true);}},
     }
   },
   { "SetStrokeCap", {
-      {1, 8, 0, 0, [](DisplayListBuilder& b) {b.setCaps(SkPaint::kButt_Cap);}},
+      {0, 0, 0, 0, [](DisplayListBuilder& b) {b.setCaps(SkPaint::kButt_Cap);}},
       {1, 8, 0, 0, [](DisplayListBuilder& b) {b.setCaps(SkPaint::kRound_Cap);}},
       {1, 8, 0, 0, [](DisplayListBuilder& b) {b.setCaps(SkPaint::kSquare_Cap);}},
     }
@@ -274,16 +274,16 @@ std::vector<DisplayListInvocationGroup> allGroups = {
   { "SetStrokeJoin", {
       {1, 8, 0, 0, [](DisplayListBuilder& b) {b.setJoins(SkPaint::kBevel_Join);}},
       {1, 8, 0, 0, [](DisplayListBuilder& b) {b.setJoins(SkPaint::kRound_Join);}},
-      {1, 8, 0, 0, [](DisplayListBuilder& b) {b.setJoins(SkPaint::kMiter_Join);}},
+      {0, 0, 0, 0, [](DisplayListBuilder& b) {b.setJoins(SkPaint::kMiter_Join);}},
     }
   },
   { "SetDrawStyle", {
-      {1, 8, 0, 0, [](DisplayListBuilder& b) {b.setDrawStyle(SkPaint::kFill_Style);}},
+      {0, 0, 0, 0, [](DisplayListBuilder& b) {b.setDrawStyle(SkPaint::kFill_Style);}},
       {1, 8, 0, 0, [](DisplayListBuilder& b) {b.setDrawStyle(SkPaint::kStroke_Style);}},
     }
   },
   { "SetStrokeWidth", {
-      {1, 8, 0, 0, [](DisplayListBuilder& b) {b.setStrokeWidth(0.0);}},
+      {0, 0, 0, 0, [](DisplayListBuilder& b) {b.setStrokeWidth(0.0);}},
       {1, 8, 0, 0, [](DisplayListBuilder& b) {b.setStrokeWidth(5.0);}},
     }
   },
@@ -297,45 +297,45 @@ std::vector<DisplayListInvocationGroup> allGroups = {
       {1, 8, 0, 0, [](DisplayListBuilder& b) {b.setColor(SK_ColorBLUE);}},
     }
   },
-  { "SetBlendMode", {
-      {1, 8, 0, 0, [](DisplayListBuilder& b) {b.setBlendMode(SkBlendMode::kSrcIn);}},
-      {1, 8, 0, 0, [](DisplayListBuilder& b) {b.setBlendMode(SkBlendMode::kDstIn);}},
-    }
-  },
   { "SetBlender", {
-      {1, 8, 0, 0, [](DisplayListBuilder& b) {b.setBlender(nullptr);}},
+      {0, 0, 0, 0, [](DisplayListBuilder& b) {b.setBlender(nullptr);}},
       {1, 16, 0, 0, [](DisplayListBuilder& b) {b.setBlender(TestBlender1);}},
       {1, 16, 0, 0, [](DisplayListBuilder& b) {b.setBlender(TestBlender2);}},
       {1, 16, 0, 0, [](DisplayListBuilder& b) {b.setBlender(TestBlender3);}},
     }
   },
+  { "SetBlendMode", {
+      {1, 8, 0, 0, [](DisplayListBuilder& b) {b.setBlendMode(SkBlendMode::kSrcIn);}},
+      {1, 8, 0, 0, [](DisplayListBuilder& b) {b.setBlendMode(SkBlendMode::kDstIn);}},
+    }
+  },
   { "SetShader", {
-      {1, 8, 0, 0, [](DisplayListBuilder& b) {b.setShader(nullptr);}},
+      {0, 0, 0, 0, [](DisplayListBuilder& b) {b.setShader(nullptr);}},
       {1, 16, 0, 0, [](DisplayListBuilder& b) {b.setShader(TestShader1);}},
       {1, 16, 0, 0, [](DisplayListBuilder& b) {b.setShader(TestShader2);}},
       {1, 16, 0, 0, [](DisplayListBuilder& b) {b.setShader(TestShader3);}},
     }
   },
   { "SetImageFilter", {
-      {1, 8, 0, 0, [](DisplayListBuilder& b) {b.setImageFilter(nullptr);}},
+      {0, 0, 0, 0, [](DisplayListBuilder& b) {b.setImageFilter(nullptr);}},
       {1, 16, 0, 0, [](DisplayListBuilder& b) {b.setImageFilter(TestImageFilter1);}},
       {1, 16, 0, 0, [](DisplayListBuilder& b) {b.setImageFilter(TestImageFilter2);}},
     }
   },
   { "SetColorFilter", {
-      {1, 8, 0, 0, [](DisplayListBuilder& b) {b.setColorFilter(nullptr);}},
+      {0, 0, 0, 0, [](DisplayListBuilder& b) {b.setColorFilter(nullptr);}},
       {1, 16, 0, 0, [](DisplayListBuilder& b) {b.setColorFilter(TestColorFilter1);}},
       {1, 16, 0, 0, [](DisplayListBuilder& b) {b.setColorFilter(TestColorFilter2);}},
     }
   },
   { "SetPathEffect", {
-      {1, 8, 0, 0, [](DisplayListBuilder& b) {b.setPathEffect(nullptr);}},
+      {0, 0, 0, 0, [](DisplayListBuilder& b) {b.setPathEffect(nullptr);}},
       {1, 16, 0, 0, [](DisplayListBuilder& b) {b.setPathEffect(TestPathEffect1);}},
       {1, 16, 0, 0, [](DisplayListBuilder& b) {b.setPathEffect(TestPathEffect2);}},
     }
   },
   { "SetMaskFilter", {
-      {1, 16, 0, 0, [](DisplayListBuilder& b) {b.setMaskFilter(nullptr);}},
+      {0, 0, 0, 0, [](DisplayListBuilder& b) {b.setMaskFilter(nullptr);}},
       {1, 16, 0, 0, [](DisplayListBuilder& b) {b.setMaskFilter(TestMaskFilter);}},
       {1, 8, 0, 0, [](DisplayListBuilder& b) {b.setMaskBlurFilter(kNormal_SkBlurStyle, 3.0);}},
       {1, 8, 0, 0, [](DisplayListBuilder& b) {b.setMaskBlurFilter(kNormal_SkBlurStyle, 5.0);}},
@@ -345,8 +345,8 @@ std::vector<DisplayListInvocationGroup> allGroups = {
     }
   },
   { "Save(Layer)+Restore", {
-      // cv.save/restore are ignored if there are no draw calls between them
-      {2, 16, 0, 0, [](DisplayListBuilder& b) {b.save(); b.restore();}},
+      // save/restore are ignored if there are no draw calls between them
+      {0, 0, 0, 0, [](DisplayListBuilder& b) {b.save(); b.restore();}},
       {2, 16, 2, 16, [](DisplayListBuilder& b) {b.saveLayer(nullptr, false); b.restore(); }},
       {2, 16, 2, 16, [](DisplayListBuilder& b) {b.saveLayer(nullptr, true); b.restore(); }},
       {2, 32, 2, 32, [](DisplayListBuilder& b) {b.saveLayer(&TestBounds, false); b.restore(); }},
@@ -354,45 +354,45 @@ std::vector<DisplayListInvocationGroup> allGroups = {
     }
   },
   { "Translate", {
-      // cv.translate(0, 0) is ignored
-      {1, 16, 0, 0, [](DisplayListBuilder& b) {b.translate(0, 0);}},
+      // translate(0, 0) is ignored
+      {0, 0, 0, 0, [](DisplayListBuilder& b) {b.translate(0, 0);}},
       {1, 16, 1, 16, [](DisplayListBuilder& b) {b.translate(10, 10);}},
       {1, 16, 1, 16, [](DisplayListBuilder& b) {b.translate(10, 15);}},
       {1, 16, 1, 16, [](DisplayListBuilder& b) {b.translate(15, 10);}},
     }
   },
   { "Scale", {
-      // cv.scale(1, 1) is ignored
-      {1, 16, 0, 0, [](DisplayListBuilder& b) {b.scale(1, 1);}},
+      // scale(1, 1) is ignored
+      {0, 0, 0, 0, [](DisplayListBuilder& b) {b.scale(1, 1);}},
       {1, 16, 1, 16, [](DisplayListBuilder& b) {b.scale(2, 2);}},
       {1, 16, 1, 16, [](DisplayListBuilder& b) {b.scale(2, 3);}},
       {1, 16, 1, 16, [](DisplayListBuilder& b) {b.scale(3, 2);}},
     }
   },
   { "Rotate", {
-      // cv.rotate(0) is ignored, otherwise expressed as concat(rotmatrix)
-      {1, 8, 0, 0, [](DisplayListBuilder& b) {b.rotate(0);}},
+      // rotate(0) is ignored, otherwise cv expresses it as concat(rotmatrix)
+      {0, 0, 0, 0, [](DisplayListBuilder& b) {b.rotate(0);}},
       {1, 8, 1, 32, [](DisplayListBuilder& b) {b.rotate(30);}},
       {1, 8, 1, 32, [](DisplayListBuilder& b) {b.rotate(45);}},
     }
   },
   { "Skew", {
-      // cv.skew(0, 0) is ignored, otherwise expressed as concat(skewmatrix)
-      {1, 16, 0, 0, [](DisplayListBuilder& b) {b.skew(0, 0);}},
+      // skew(0, 0) is ignored, otherwise cv expresses it as concat(skewmatrix)
+      {0, 0, 0, 0, [](DisplayListBuilder& b) {b.skew(0, 0);}},
       {1, 16, 1, 32, [](DisplayListBuilder& b) {b.skew(0.1, 0.1);}},
       {1, 16, 1, 32, [](DisplayListBuilder& b) {b.skew(0.1, 0.2);}},
       {1, 16, 1, 32, [](DisplayListBuilder& b) {b.skew(0.2, 0.1);}},
     }
   },
   { "Transform2x3", {
-      // cv.transform(identity) is ignored
-      {1, 32, 0, 0, [](DisplayListBuilder& b) {b.transform2x3(1, 0, 0, 0, 1, 0);}},
+      // transform(identity) is ignored
+      {0, 0, 0, 0, [](DisplayListBuilder& b) {b.transform2x3(1, 0, 0, 0, 1, 0);}},
       {1, 32, 1, 32, [](DisplayListBuilder& b) {b.transform2x3(0, 1, 12, 1, 0, 33);}},
     }
   },
   { "Transform3x3", {
-      // cv.transform(identity) is ignored
-      {1, 40, 0, 0, [](DisplayListBuilder& b) {b.transform3x3(1, 0, 0, 0, 1, 0, 0, 0, 1);}},
+      // transform(identity) is ignored
+      {0, 0, 0, 0, [](DisplayListBuilder& b) {b.transform3x3(1, 0, 0, 0, 1, 0, 0, 0, 1);}},
       {1, 40, 1, 40, [](DisplayListBuilder& b) {b.transform3x3(0, 1, 12, 1, 0, 33, 0, 0, 12);}},
     }
   },
@@ -704,6 +704,14 @@ TEST(DisplayList, SingleOpDisplayListsNotEqualEmpty) {
   for (auto& group : allGroups) {
     for (size_t i = 0; i < group.variants.size(); i++) {
       sk_sp<DisplayList> dl = group.variants[i].Build();
+      if (group.variants[i].op_count == 0) {
+        // The builder skips ops that would not change the rendering.
+        auto desc =
+            group.op_name + "(variant " + std::to_string(i + 1) + " == empty)";
+        ASSERT_TRUE(dl->Equals(*empty)) << desc;
+        ASSERT_TRUE(empty->Equals(*dl)) << desc;
+        continue;
+      }
       auto desc =
           group.op_name + "(variant " + std::to_string(i + 1) + " != empty)";
       ASSERT_FALSE(dl->Equals(*empty)) << desc;
@@ -843,8 +851,14 @@ TEST(DisplayList, DisplayListsWithVaryingOpComparisons) {
     sk_sp<DisplayList> missing_dl = Build(gi, group.variants.size());
     auto desc = "[Group " + std::to_string(gi + 1) + " omitted]";
     ASSERT_TRUE(missing_dl->Equals(*missing_dl)) << desc << " == itself";
-    ASSERT_FALSE(missing_dl->Equals(*default_dl)) << desc << " != Default";
-    ASSERT_FALSE(default_dl->Equals(*missing_dl)) << "Default != " << desc;
+    // Variants that record no ops leave the list as if they were omitted.
+    if (group.variants[0].op_count == 0) {
+      ASSERT_TRUE(missing_dl->Equals(*default_dl)) << desc << " == Default";
+      ASSERT_TRUE(default_dl->Equals(*missing_dl)) << "Default == " << desc;
+    } else {
+      ASSERT_FALSE(missing_dl->Equals(*default_dl)) << desc << " != Default";
+      ASSERT_FALSE(default_dl->Equals(*missing_dl)) << "Default != " << desc;
+    }
     for (size_t vi = 0; vi < group.variants.size(); vi++) {
       auto desc = "[Group " + std::to_string(gi + 1) + " variant " +
                   std::to_string(vi + 1) + "]";
@@ -857,11 +871,258 @@ TEST(DisplayList, DisplayListsWithVaryingOpComparisons) {
         ASSERT_FALSE(variant_dl->Equals(*default_dl)) << desc << " != Default";
         ASSERT_FALSE(default_dl->Equals(*variant_dl)) << "Default != " << desc;
       }
-      ASSERT_FALSE(variant_dl->Equals(*missing_dl)) << desc << " != omitted";
-      ASSERT_FALSE(missing_dl->Equals(*variant_dl)) << "omitted != " << desc;
+      if (group.variants[vi].op_count == 0) {
+        ASSERT_TRUE(variant_dl->Equals(*missing_dl)) << desc << " == omitted";
+        ASSERT_TRUE(missing_dl->Equals(*variant_dl)) << "omitted == " << desc;
+      } else {
+        ASSERT_FALSE(variant_dl->Equals(*missing_dl)) << desc << " != omitted";
+        ASSERT_FALSE(missing_dl->Equals(*variant_dl)) << "omitted != " << desc;
+      }
     }
   }
 }
 
+TEST(DisplayList, RTreeOnlyPreparedWhenRequested) {
+  SkRect cull = SkRect::MakeWH(100, 100);
+  DisplayListBuilder plain_builder(cull);
+  plain_builder.drawRect({10, 10, 20, 20});
+  EXPECT_FALSE(plain_builder.Build()->has_rtree());
+
+  DisplayListBuilder rtree_builder(cull, true);
+  rtree_builder.drawRect({10, 10, 20, 20});
+  EXPECT_TRUE(rtree_builder.Build()->has_rtree());
+}
+
+TEST(DisplayList, CulledDispatchSkipsOnlyRenderingOps) {
+  DisplayListBuilder builder(SkRect::MakeWH(1000, 1000), true);
+  builder.setColor(SK_ColorRED);
+  builder.drawRect({10, 10, 20, 20});
+  builder.setColor(SK_ColorBLUE);
+  builder.translate(5, 5);
+  builder.drawRect({500, 500, 520, 520});
+  builder.setColor(SK_ColorGREEN);
+  builder.drawRect({15, 15, 30, 30});
+  sk_sp<DisplayList> display_list = builder.Build();
+
+  DisplayListBuilder expected_builder;
+  expected_builder.setColor(SK_ColorRED);
+  expected_builder.drawRect({10, 10, 20, 20});
+  expected_builder.setColor(SK_ColorBLUE);
+  expected_builder.translate(5, 5);
+  expected_builder.setColor(SK_ColorGREEN);
+  expected_builder.drawRect({15, 15, 30, 30});
+  sk_sp<DisplayList> expected = expected_builder.Build();
+
+  DisplayListBuilder culled_builder;
+  display_list->Dispatch(culled_builder, SkRect::MakeLTRB(0, 0, 100, 100));
+  sk_sp<DisplayList> culled = culled_builder.Build();
+  EXPECT_TRUE(culled->Equals(*expected));
+
+  DisplayListBuilder unculled_builder;
+  display_list->Dispatch(unculled_builder, SkRect::MakeLTRB(0, 0, 1000, 1000));
+  sk_sp<DisplayList> unculled = unculled_builder.Build();
+  EXPECT_TRUE(unculled->Equals(*display_list));
+}
+
+TEST(DisplayList, CulledDispatchTreatsSaveLayerAsOneRange) {
+  DisplayListBuilder builder(SkRect::MakeWH(1000, 1000), true);
+  builder.drawRect({10, 10, 20, 20});
+  builder.saveLayer(nullptr, false);
+  builder.setColor(SK_ColorBLUE);
+  builder.translate(500, 500);
+  builder.drawRect({0, 0, 20, 20});
+  builder.restore();
+  builder.saveLayer(nullptr, false);
+  builder.drawRect({30, 30, 40, 40});
+  builder.drawRect({600, 600, 620, 620});
+  builder.restore();
+  sk_sp<DisplayList> display_list = builder.Build();
+
+  DisplayListBuilder expected_builder;
+  expected_builder.drawRect({10, 10, 20, 20});
+  expected_builder.setColor(SK_ColorBLUE);
+  expected_builder.saveLayer(nullptr, false);
+  expected_builder.drawRect({30, 30, 40, 40});
+  expected_builder.drawRect({600, 600, 620, 620});
+  expected_builder.restore();
+  sk_sp<DisplayList> expected = expected_builder.Build();
+
+  DisplayListBuilder culled_builder;
+  display_list->Dispatch(culled_builder, SkRect::MakeLTRB(0, 0, 100, 100));
+  sk_sp<DisplayList> culled = culled_builder.Build();
+  EXPECT_TRUE(culled->Equals(*expected));
+}
+
+TEST(DisplayList, RedundantAttributesAreSkipped) {
+  DisplayListBuilder builder;
+  builder.setColor(SK_ColorRED);
+  builder.drawRect({10, 10, 20, 20});
+  builder.setColor(SK_ColorRED);
+  builder.setStrokeWidth(0);
+  builder.setBlender(nullptr);
+  builder.drawRect({20, 20, 30, 30});
+  builder.setBlendMode(SkBlendMode::kSrcIn);
+  builder.setBlender(nullptr);
+  builder.drawRect({30, 30, 40, 40});
+  sk_sp<DisplayList> display_list = builder.Build();
+
+  DisplayListBuilder expected_builder;
+  expected_builder.setColor(SK_ColorRED);
+  expected_builder.drawRect({10, 10, 20, 20});
+  expected_builder.drawRect({20, 20, 30, 30});
+  expected_builder.setBlendMode(SkBlendMode::kSrcIn);
+  expected_builder.setBlender(nullptr);
+  expected_builder.drawRect({30, 30, 40, 40});
+  sk_sp<DisplayList> expected = expected_builder.Build();
+
+  EXPECT_EQ(display_list->op_count(), 6);
+  EXPECT_TRUE(display_list->Equals(*expected));
+}
+
+TEST(DisplayList, AdjacentTransformsAreFolded) {
+  DisplayListBuilder builder;
+  builder.translate(10, 20);
+  builder.translate(5, -20);
+  builder.scale(2, 3);
+  builder.scale(0.5, 2);
+  builder.drawRect({10, 10, 20, 20});
+  builder.translate(5, 5);
+  builder.translate(-5, -5);
+  builder.rotate(0);
+  builder.drawRect({20, 20, 30, 30});
+  sk_sp<DisplayList> display_list = builder.Build();
+
+  DisplayListBuilder expected_builder;
+  expected_builder.translate(15, 0);
+  expected_builder.scale(1, 6);
+  expected_builder.drawRect({10, 10, 20, 20});
+  expected_builder.drawRect({20, 20, 30, 30});
+  sk_sp<DisplayList> expected = expected_builder.Build();
+
+  EXPECT_EQ(display_list->op_count(), 4);
+  EXPECT_EQ(display_list->bytes(), expected->bytes());
+  EXPECT_TRUE(display_list->Equals(*expected));
+}
+
+TEST(DisplayList, EmptySaveRestorePairsAreRemoved) {
+  DisplayListBuilder builder;
+  builder.save();
+  builder.save();
+  builder.restore();
+  builder.restore();
+  builder.saveLayer(nullptr, false);
+  builder.save();
+  builder.restore();
+  builder.restore();
+  builder.save();
+  builder.drawRect({10, 10, 20, 20});
+  builder.restore();
+  sk_sp<DisplayList> display_list = builder.Build();
+
+  DisplayListBuilder expected_builder;
+  expected_builder.saveLayer(nullptr, false);
+  expected_builder.restore();
+  expected_builder.save();
+  expected_builder.drawRect({10, 10, 20, 20});
+  expected_builder.restore();
+  sk_sp<DisplayList> expected = expected_builder.Build();
+
+  EXPECT_EQ(display_list->op_count(), 5);
+  EXPECT_TRUE(display_list->Equals(*expected));
+}
+
+TEST(DisplayList, BuildResetsAttributeState) {
+  DisplayListBuilder builder;
+  builder.setColor(SK_ColorRED);
+  builder.drawRect({10, 10, 20, 20});
+  builder.Build();
+
+  builder.setColor(SK_ColorRED);
+  builder.drawRect({10, 10, 20, 20});
+  EXPECT_EQ(builder.Build()->op_count(), 2);
+}
+
+TEST(DisplayList, LargeListsRecordAllOps) {
+  DisplayListBuilder builder;
+  for (int i = 0; i < 10000; i++) {
+    builder.drawRect({0, 0, static_cast<SkScalar>(i), 10});
+  }
+  sk_sp<DisplayList> display_list = builder.Build();
+  EXPECT_EQ(display_list->op_count(), 10000);
+
+  DisplayListBuilder copy_builder;
+  display_list->Dispatch(copy_builder);
+  EXPECT_TRUE(copy_builder.Build()->Equals(*display_list));
+}
+
+TEST(DisplayList, StoragePoolBuffersAreReused) {
+  auto pool = sk_make_sp<DisplayListStoragePool>();
+  DisplayListBuilder builder(SkRect::MakeEmpty(), false, pool);
+  builder.drawRect({10, 10, 20, 20});
+  sk_sp<DisplayList> display_list = builder.Build();
+  EXPECT_EQ(pool->buffer_count(), 0u);
+
+  display_list.reset();
+  EXPECT_EQ(pool->buffer_count(), 1u);
+
+  // The builder can record again after Build and takes the pooled buffer.
+  builder.drawOval({10, 10, 20, 20});
+  EXPECT_EQ(pool->buffer_count(), 0u);
+  display_list = builder.Build();
+
+  DisplayListBuilder expected_builder;
+  expected_builder.drawOval({10, 10, 20, 20});
+  EXPECT_TRUE(display_list->Equals(*expected_builder.Build()));
+}
+
+TEST(DisplayList, StoragePoolHasBoundedSize) {
+  auto pool = sk_make_sp<DisplayListStoragePool>(1, 8192);
+  pool->Recycle(static_cast<uint8_t*>(sk_malloc_throw(4096)), 4096);
+  pool->Recycle(static_cast<uint8_t*>(sk_malloc_throw(4096)), 4096);
+  EXPECT_EQ(pool->buffer_count(), 1u);
+
+  size_t capacity;
+  EXPECT_EQ(pool->Acquire(8192, &capacity), nullptr);
+  uint8_t* buffer = pool->Acquire(4096, &capacity);
+  ASSERT_NE(buffer, nullptr);
+  EXPECT_EQ(capacity, 4096u);
+  EXPECT_EQ(pool->buffer_count(), 0u);
+
+  // Buffers larger than the limit are freed.
+  pool->Recycle(buffer, capacity);
+  pool->Recycle(static_cast<uint8_t*>(sk_malloc_throw(16384)), 16384);
+  EXPECT_EQ(pool->buffer_count(), 1u);
+}
+
+TEST(DisplayList, StoragePoolGivesSmallBuildersTheSmallestBuffer) {
+  auto pool = sk_make_sp<DisplayListStoragePool>();
+  pool->Recycle(static_cast<uint8_t*>(sk_malloc_throw(1 << 20)), 1 << 20);
+  pool->Recycle(static_cast<uint8_t*>(sk_malloc_throw(4096)), 4096);
+
+  DisplayListBuilder builder(SkRect::MakeEmpty(), false, pool);
+  builder.drawRect({10, 10, 20, 20});
+  EXPECT_EQ(pool->buffer_count(), 1u);
+  EXPECT_EQ(pool->bytes(), 1u << 20);
+
+  sk_sp<DisplayList> display_list = builder.Build();
+  DisplayListBuilder expected_builder;
+  expected_builder.drawRect({10, 10, 20, 20});
+  EXPECT_TRUE(display_list->Equals(*expected_builder.Build()));
+}
+
+TEST(DisplayList, BuildTrimsLargelyUnusedBuffers) {
+  auto pool = sk_make_sp<DisplayListStoragePool>();
+  pool->Recycle(static_cast<uint8_t*>(sk_malloc_throw(1 << 20)), 1 << 20);
+
+  DisplayListBuilder builder(SkRect::MakeEmpty(), false, pool);
+  builder.drawRect({10, 10, 20, 20});
+  sk_sp<DisplayList> display_list = builder.Build();
+  EXPECT_EQ(pool->buffer_count(), 0u);
+
+  display_list.reset();
+  EXPECT_EQ(pool->buffer_count(), 1u);
+  EXPECT_EQ(pool->bytes(), 4096u);
+}
+
 }  // namespace testing
 }  // namespace flutter
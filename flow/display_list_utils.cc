@@ -175,30 +175,38 @@ void DisplayListBoundsCalculator::saveLayer(const SkRect* bounds,
                                             bool with_paint) {
   SkMatrixDispatchHelper::save();
   ClipBoundsDispatchHelper::save();
-  SaveInfo info =
-      with_paint ? SaveLayerWithPaintInfo(this, accumulator_, matrix(), paint())
-                 : SaveLayerInfo(accumulator_, matrix());
-  saved_infos_.push_back(info);
-  accumulator_ = info.save();
+  if (with_paint) {
+    saved_infos_.push_back(std::make_unique<SaveLayerWithPaintInfo>(
+        this, accumulator_, matrix(), paint()));
+  } else {
+    saved_infos_.push_back(
+        std::make_unique<SaveLayerInfo>(accumulator_, matrix()));
+  }
+  accumulator_ = saved_infos_.back()->save();
   SkMatrixDispatchHelper::reset();
 }
 void DisplayListBoundsCalculator::save() {
   SkMatrixDispatchHelper::save();
   ClipBoundsDispatchHelper::save();
-  SaveInfo info = SaveInfo(accumulator_);
-  saved_infos_.push_back(info);
-  accumulator_ = info.save();
+  saved_infos_.push_back(std::make_unique<SaveInfo>(accumulator_));
+  accumulator_ = saved_infos_.back()->save();
 }
 void DisplayListBoundsCalculator::restore() {
   if (!saved_infos_.empty()) {
     SkMatrixDispatchHelper::restore();
     ClipBoundsDispatchHelper::restore();
-    SaveInfo info = saved_infos_.back();
+    accumulator_ = saved_infos_.back()->restore();
     saved_infos_.pop_back();
-    accumulator_ = info.restore();
   }
 }
 
+SkRect DisplayListBoundsCalculator::takeBounds() {
+  FML_DCHECK(accumulator_ == &root_accumulator_);
+  SkRect bounds = root_accumulator_.getBounds();
+  root_accumulator_ = BoundsAccumulator();
+  return bounds;
+}
+
 void DisplayListBoundsCalculator::drawPaint() {
   if (!bounds_cull_.isEmpty()) {
     root_accumulator_.accumulate(bounds_cull_);
@@ -5,6 +5,8 @@
 #ifndef FLUTTER_FLOW_DISPLAY_LIST_UTILS_H_
 #define FLUTTER_FLOW_DISPLAY_LIST_UTILS_H_
 
+#include <memory>
+
 #include "flutter/flow/display_list.h"
 
 #include "third_party/skia/include/core/SkMaskFilter.h"
@@ -315,6 +317,12 @@ class DisplayListBoundsCalculator final
 
   SkRect getBounds() { return accumulator_->getBounds(); }
 
+  // Returns the bounds accumulated since construction or since the
+  // previous call to this method and then resets them so that the
+  // bounds of successive runs of operations can be measured separately.
+  // This must not be called while a saveLayer is outstanding.
+  SkRect takeBounds();
+
  private:
   // current accumulator based on saveLayer history
   BoundsAccumulator* accumulator_;
@@ -365,7 +373,7 @@ class DisplayListBoundsCalculator final
     SkPaint paint_;
   };
 
-  std::vector<SaveInfo> saved_infos_;
+  std::vector<std::unique_ptr<SaveInfo>> saved_infos_;
 
   void accumulateRect(const SkRect& rect, bool force_stroke = false);
 };
@@ -125,6 +125,12 @@ FrameTiming FrameTimingsRecorder::RecordRasterEnd() {
   return timing_;
 }
 
+void FrameTimingsRecorder::RecordThreadMergeLatency(fml::TimeDelta latency) {
+  std::scoped_lock state_lock(state_mutex_);
+  FML_DCHECK(state_ == State::kRasterEnd);
+  timing_.SetThreadMergeLatency(latency);
+}
+
 FrameTiming FrameTimingsRecorder::GetRecordedTime() const {
   std::scoped_lock state_lock(state_mutex_);
   FML_DCHECK(state_ == State::kRasterEnd);
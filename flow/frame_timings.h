@@ -89,6 +89,10 @@ class FrameTimingsRecorder {
   /// the events. This summary is sent to the framework.
   FrameTiming RecordRasterEnd();
 
+  /// Records the time the frame waited for the raster and platform threads
+  /// to merge or un-merge. Must be called after `RecordRasterEnd`.
+  void RecordThreadMergeLatency(fml::TimeDelta latency);
+
   /// Returns the frame number. Frame number is unique per frame and a frame
   /// built earlier will have a frame number less than a frame that has been
   /// built at a later point of time.
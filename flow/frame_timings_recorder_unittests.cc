@@ -68,6 +68,23 @@ TEST(FrameTimingsRecorderTest, RecordRasterTimes) {
   ASSERT_EQ(recorder->GetFrameNumber(), timing.GetFrameNumber());
 }
 
+TEST(FrameTimingsRecorderTest, RecordThreadMergeLatency) {
+  auto recorder = std::make_unique<FrameTimingsRecorder>();
+
+  const auto st = fml::TimePoint::Now();
+  const auto en = st + fml::TimeDelta::FromMillisecondsF(16);
+  recorder->RecordVsync(st, en);
+  recorder->RecordBuildStart(fml::TimePoint::Now());
+  recorder->RecordBuildEnd(fml::TimePoint::Now());
+  recorder->RecordRasterStart(fml::TimePoint::Now());
+  const auto timing = recorder->RecordRasterEnd();
+  ASSERT_EQ(timing.GetThreadMergeLatency(), fml::TimeDelta::Zero());
+
+  const auto latency = fml::TimeDelta::FromMilliseconds(20);
+  recorder->RecordThreadMergeLatency(latency);
+  ASSERT_EQ(recorder->GetRecordedTime().GetThreadMergeLatency(), latency);
+}
+
 // Windows and Fuchsia don't allow testing with killed by signal.
 #if !defined(OS_FUCHSIA) && !defined(OS_WIN) && \
     (FLUTTER_RUNTIME_MODE == FLUTTER_RUNTIME_MODE_DEBUG)
@@ -4,10 +4,77 @@
 
 #include "flutter/flow/layers/container_layer.h"
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <optional>
 
+#include "flutter/fml/concurrent_message_loop.h"
+
 namespace flutter {
 
+namespace {
+
+// The state shared by the threads taking part in a concurrent preroll. It
+// is reference counted because workers that start after all the work has
+// been claimed still need to look at it.
+struct ConcurrentPreroll {
+  // A run of consecutive children prerolled by one thread with its own
+  // copy of the parent context.
+  struct Task {
+    size_t begin;
+    size_t end;
+    MutatorsStack mutators_stack;
+    std::optional<PrerollContext> context;
+    std::vector<fml::closure> deferred_tasks;
+    SkRect paint_bounds = SkRect::MakeEmpty();
+    bool has_platform_view = false;
+    // Set before |deferred_tasks| run.
+    bool has_preceding_texture_layer = false;
+  };
+
+  const std::vector<std::shared_ptr<Layer>>* layers;
+  SkMatrix child_matrix;
+  std::vector<std::unique_ptr<Task>> tasks;
+  std::atomic<size_t> next_task{0};
+
+  std::mutex mutex;
+  std::condition_variable done_condition;
+  size_t done_count = 0;
+
+  // Prerolls tasks until none are left to claim.
+  void Run() {
+    for (;;) {
+      size_t index = next_task.fetch_add(1);
+      if (index >= tasks.size()) {
+        return;
+      }
+      Task& task = *tasks[index];
+      PrerollContext* context = &task.context.value();
+      for (size_t i = task.begin; i < task.end; i++) {
+        Layer* layer = (*layers)[i].get();
+        context->has_platform_view = false;
+        layer->Preroll(context, child_matrix);
+        task.paint_bounds.join(layer->paint_bounds());
+        task.has_platform_view =
+            task.has_platform_view || context->has_platform_view;
+      }
+      std::scoped_lock lock(mutex);
+      if (++done_count == tasks.size()) {
+        done_condition.notify_all();
+      }
+    }
+  }
+
+  void WaitUntilDone() {
+    std::unique_lock lock(mutex);
+    done_condition.wait(lock, [this] { return done_count == tasks.size(); });
+  }
+};
+
+}  // namespace
+
 ContainerLayer::ContainerLayer() {}
 
 #ifdef FLUTTER_ENABLE_DIFF_CONTEXT
@@ -130,6 +197,12 @@ void ContainerLayer::PrerollChildren(PrerollContext* context,
   // Platform views have no children, so context->has_platform_view should
   // always be false.
   FML_DCHECK(!context->has_platform_view);
+  if (context->concurrent_task_runner && !context->deferred_tasks &&
+      layers_.size() >= kMinChildrenForConcurrentPreroll) {
+    PrerollChildrenConcurrently(context, child_matrix, child_paint_bounds);
+    return;
+  }
+
   bool child_has_platform_view = false;
   bool child_has_texture_layer = false;
   for (auto& layer : layers_) {
@@ -152,6 +225,77 @@ void ContainerLayer::PrerollChildren(PrerollContext* context,
   set_subtree_has_platform_view(child_has_platform_view);
 }
 
+void ContainerLayer::PrerollChildrenConcurrently(PrerollContext* context,
+                                                 const SkMatrix& child_matrix,
+                                                 SkRect* child_paint_bounds) {
+  TRACE_EVENT0("flutter", "ContainerLayer::PrerollChildrenConcurrently");
+
+  // One task for each worker and one for the calling thread.
+  size_t max_tasks = context->concurrent_task_runner->GetWorkerCount() + 1;
+  size_t task_count =
+      std::min(layers_.size() / kMinChildrenPerPrerollTask, max_tasks);
+
+  auto preroll = std::make_shared<ConcurrentPreroll>();
+  preroll->layers = &layers_;
+  preroll->child_matrix = child_matrix;
+  for (size_t i = 0; i < task_count; i++) {
+    auto task = std::make_unique<ConcurrentPreroll::Task>();
+    task->begin = layers_.size() * i / task_count;
+    task->end = layers_.size() * (i + 1) / task_count;
+    task->mutators_stack = context->mutators_stack;
+    task->context.emplace(PrerollContext{
+        context->raster_cache,
+        context->gr_context,
+        context->view_embedder,
+        task->mutators_stack,
+        context->dst_color_space,
+        context->cull_rect,
+        context->surface_needs_readback,
+        context->raster_time,
+        context->ui_time,
+        context->texture_registry,
+        context->checkerboard_offscreen_layers,
+        context->frame_device_pixel_ratio,
+        false,
+        context->has_texture_layer,
+        nullptr,
+        &task->deferred_tasks,
+        &task->has_preceding_texture_layer,
+    });
+    preroll->tasks.push_back(std::move(task));
+  }
+
+  // The frame is waiting on these, so they run ahead of background work.
+  for (size_t i = 1; i < task_count; i++) {
+    context->concurrent_task_runner->PostHighPriorityTask(
+        [preroll]() { preroll->Run(); });
+  }
+  // Work on the tasks too rather than idling until the workers pick them up.
+  preroll->Run();
+  preroll->WaitUntilDone();
+
+  // The tasks only saw the texture layers of their own run. The ones of the
+  // preceding runs are merged in before the deferred tasks of a run rely on
+  // them.
+  bool child_has_platform_view = false;
+  for (auto& task : preroll->tasks) {
+    child_paint_bounds->join(task->paint_bounds);
+    child_has_platform_view =
+        child_has_platform_view || task->has_platform_view;
+    task->has_preceding_texture_layer = context->has_texture_layer;
+    context->surface_needs_readback = context->surface_needs_readback ||
+                                      task->context->surface_needs_readback;
+    for (auto& deferred_task : task->deferred_tasks) {
+      deferred_task();
+    }
+    context->has_texture_layer =
+        context->has_texture_layer || task->context->has_texture_layer;
+  }
+
+  context->has_platform_view = child_has_platform_view;
+  set_subtree_has_platform_view(child_has_platform_view);
+}
+
 void ContainerLayer::PaintChildren(PaintContext& context) const {
   // We can no longer call FML_DCHECK here on the needs_painting(context)
   // condition as that test is only valid for the PaintContext that
@@ -174,7 +318,15 @@ void ContainerLayer::TryToPrepareRasterCache(PrerollContext* context,
   if (!context->has_platform_view && !context->has_texture_layer &&
       context->raster_cache &&
       SkRect::Intersects(context->cull_rect, layer->paint_bounds())) {
-    context->raster_cache->Prepare(context, layer, matrix);
+    // Rasterizing the layer reads the context, so the deferred task keeps
+    // a copy of it as it is now.
+    RunInTreeOrder(context, [context = *context, layer, matrix]() mutable {
+      if (context.has_preceding_texture_layer &&
+          *context.has_preceding_texture_layer) {
+        return;
+      }
+      context.raster_cache->Prepare(&context, layer, matrix);
+    });
   }
 }
 
@@ -13,6 +13,13 @@ namespace flutter {
 
 class ContainerLayer : public Layer {
  public:
+  // The minimum number of children a container must have for them to be
+  // prerolled concurrently when PrerollContext::concurrent_task_runner is
+  // set. Smaller containers are not worth the cost of the thread hops.
+  static constexpr size_t kMinChildrenForConcurrentPreroll = 32;
+  // The minimum number of consecutive children prerolled by each task.
+  static constexpr size_t kMinChildrenPerPrerollTask = 8;
+
   ContainerLayer();
 
 #ifdef FLUTTER_ENABLE_DIFF_CONTEXT
@@ -37,6 +44,15 @@ class ContainerLayer : public Layer {
 #endif  // FLUTTER_ENABLE_DIFF_CONTEXT
 
  protected:
+  // Prerolls the children in order and joins their paint bounds into
+  // |child_paint_bounds|.
+  //
+  // If |context| has a concurrent task runner and there are enough children,
+  // runs of consecutive children are prerolled on the workers of the runner
+  // and on the calling thread at the same time, each with a copy of
+  // |context|. The results are then merged and the tasks the children
+  // deferred with RunInTreeOrder are run, both in the order of the children.
+  // Only the outermost such container prerolls concurrently.
   void PrerollChildren(PrerollContext* context,
                        const SkMatrix& child_matrix,
                        SkRect* child_paint_bounds);
@@ -57,6 +73,10 @@ class ContainerLayer : public Layer {
                                       const SkMatrix& matrix);
 
  private:
+  void PrerollChildrenConcurrently(PrerollContext* context,
+                                   const SkMatrix& child_matrix,
+                                   SkRect* child_paint_bounds);
+
   std::vector<std::shared_ptr<Layer>> layers_;
 
   FML_DISALLOW_COPY_AND_ASSIGN(ContainerLayer);
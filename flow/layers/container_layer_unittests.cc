@@ -3,10 +3,13 @@
 // found in the LICENSE file.
 
 #include "flutter/flow/layers/container_layer.h"
+#include "flutter/flow/layers/opacity_layer.h"
+#include "flutter/flow/layers/texture_layer.h"
 
 #include "flutter/flow/testing/diff_context_test.h"
 #include "flutter/flow/testing/layer_test.h"
 #include "flutter/flow/testing/mock_layer.h"
+#include "flutter/fml/concurrent_message_loop.h"
 #include "flutter/fml/macros.h"
 #include "flutter/testing/mock_canvas.h"
 
@@ -186,6 +189,111 @@ TEST_F(ContainerLayerTest, NeedsSystemComposite) {
                                                child_path2, child_paint2}}}));
 }
 
+namespace {
+
+// Records the order in which the tasks it defers with RunInTreeOrder run.
+class OrderRecordingLayer : public Layer {
+ public:
+  OrderRecordingLayer(int index, std::vector<int>* order)
+      : index_(index), order_(order) {}
+
+  void Preroll(PrerollContext* context, const SkMatrix& matrix) override {
+    set_paint_bounds(SkRect::MakeXYWH(index_, 0, 1, 1));
+    RunInTreeOrder(context, [this] { order_->push_back(index_); });
+  }
+
+  void Paint(PaintContext& context) const override {}
+
+ private:
+  const int index_;
+  std::vector<int>* order_;
+};
+
+}  // namespace
+
+TEST_F(ContainerLayerTest, ConcurrentPrerollRunsDeferredTasksInOrder) {
+  auto loop = fml::ConcurrentMessageLoop::Create(4);
+  preroll_context()->concurrent_task_runner = loop->GetTaskRunner();
+
+  const int child_count = ContainerLayer::kMinChildrenForConcurrentPreroll * 2;
+  std::vector<int> order;
+  auto layer = std::make_shared<ContainerLayer>();
+  for (int i = 0; i < child_count; i++) {
+    layer->Add(std::make_shared<OrderRecordingLayer>(i, &order));
+  }
+
+  layer->Preroll(preroll_context(), SkMatrix());
+  EXPECT_EQ(layer->paint_bounds(), SkRect::MakeWH(child_count, 1));
+  ASSERT_EQ(order.size(), static_cast<size_t>(child_count));
+  for (int i = 0; i < child_count; i++) {
+    EXPECT_EQ(order[i], i);
+  }
+}
+
+TEST_F(ContainerLayerTest, ConcurrentPrerollMergesChildState) {
+  auto loop = fml::ConcurrentMessageLoop::Create(4);
+  preroll_context()->concurrent_task_runner = loop->GetTaskRunner();
+  const SkMatrix initial_transform = SkMatrix::Translate(3.0f, 4.0f);
+  preroll_context()->mutators_stack.PushTransform(initial_transform);
+
+  const size_t child_count = ContainerLayer::kMinChildrenForConcurrentPreroll;
+  std::vector<std::shared_ptr<MockLayer>> mock_layers;
+  auto layer = std::make_shared<ContainerLayer>();
+  SkRect expected_total_bounds = SkRect::MakeEmpty();
+  for (size_t i = 0; i < child_count; i++) {
+    SkPath child_path;
+    child_path.addRect(i, i, i + 10.0f, i + 10.0f);
+    expected_total_bounds.join(child_path.getBounds());
+    // Only the last child has a platform view and only the first reads
+    // from the surface, so both have to be carried across tasks.
+    auto mock_layer = std::make_shared<MockLayer>(
+        child_path, SkPaint(), i == child_count - 1 /* has_platform_view */,
+        i == 0 /* reads_surface */);
+    mock_layers.push_back(mock_layer);
+    layer->Add(mock_layer);
+  }
+
+  layer->Preroll(preroll_context(), initial_transform);
+  EXPECT_EQ(layer->paint_bounds(), expected_total_bounds);
+  EXPECT_TRUE(preroll_context()->has_platform_view);
+  EXPECT_TRUE(preroll_context()->surface_needs_readback);
+  EXPECT_TRUE(layer->subtree_has_platform_view());
+  for (auto& mock_layer : mock_layers) {
+    EXPECT_EQ(mock_layer->parent_matrix(), initial_transform);
+    EXPECT_EQ(mock_layer->parent_mutators(),
+              std::vector({Mutator(initial_transform)}));
+    EXPECT_FALSE(mock_layer->parent_has_platform_view());
+  }
+  preroll_context()->mutators_stack.Pop();
+}
+
+TEST_F(ContainerLayerTest, ConcurrentPrerollSeesPrecedingTextureLayers) {
+  use_mock_raster_cache();
+  auto loop = fml::ConcurrentMessageLoop::Create(4);
+  preroll_context()->concurrent_task_runner = loop->GetTaskRunner();
+
+  // The texture layer is prerolled by the first task. As when the children
+  // are prerolled in order, it keeps the opacity layers prerolled by the
+  // other tasks from being cached.
+  const size_t child_count = ContainerLayer::kMinChildrenForConcurrentPreroll;
+  auto layer = std::make_shared<ContainerLayer>();
+  layer->Add(std::make_shared<TextureLayer>(SkPoint::Make(0, 0),
+                                            SkSize::Make(8, 8), 0, false,
+                                            SkSamplingOptions()));
+  for (size_t i = 1; i < child_count; i++) {
+    SkPath child_path;
+    child_path.addRect(i, i, i + 10.0f, i + 10.0f);
+    auto opacity_layer =
+        std::make_shared<OpacityLayer>(128, SkPoint::Make(0, 0));
+    opacity_layer->Add(std::make_shared<MockLayer>(child_path));
+    layer->Add(opacity_layer);
+  }
+
+  layer->Preroll(preroll_context(), SkMatrix());
+  EXPECT_TRUE(preroll_context()->has_texture_layer);
+  EXPECT_EQ(raster_cache()->GetLayerCachedEntriesCount(), 0u);
+}
+
 TEST_F(ContainerLayerTest, MergedOneChild) {
   SkPath child_path;
   child_path.addRect(5.0f, 6.0f, 20.5f, 21.5f);
@@ -97,8 +97,14 @@ void DisplayListLayer::Preroll(PrerollContext* context,
 #ifndef SUPPORT_FRACTIONAL_TRANSLATION
     ctm = RasterCache::GetIntegralTransCTM(ctm);
 #endif
-    cache->Prepare(context->gr_context, disp_list, ctm,
-                   context->dst_color_space, is_complex_, will_change_);
+    RunInTreeOrder(context, [cache, gr_context = context->gr_context,
+                             disp_list, ctm,
+                             dst_color_space = context->dst_color_space,
+                             is_complex = is_complex_,
+                             will_change = will_change_]() {
+      cache->Prepare(gr_context, disp_list, ctm, dst_color_space, is_complex,
+                     will_change);
+    });
   }
 
   SkRect bounds = disp_list->bounds().makeOffset(offset_.x(), offset_.y());
@@ -6,6 +6,7 @@
 #define FLUTTER_FLOW_LAYERS_LAYER_H_
 
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "flutter/common/graphics/texture.h"
@@ -14,6 +15,7 @@
 #include "flutter/flow/instrumentation.h"
 #include "flutter/flow/raster_cache.h"
 #include "flutter/fml/build_config.h"
+#include "flutter/fml/closure.h"
 #include "flutter/fml/compiler_specific.h"
 #include "flutter/fml/logging.h"
 #include "flutter/fml/macros.h"
@@ -28,6 +30,10 @@
 #include "third_party/skia/include/core/SkRect.h"
 #include "third_party/skia/include/utils/SkNWayCanvas.h"
 
+namespace fml {
+class ConcurrentTaskRunner;
+}  // namespace fml
+
 namespace flutter {
 
 namespace testing {
@@ -61,6 +67,18 @@ struct PrerollContext {
   // These allow us to track properties like elevation, opacity, and the
   // prescence of a texture layer during Preroll.
   bool has_texture_layer = false;
+
+  // When set, containers with many children preroll them on the workers of
+  // this runner. See ContainerLayer::PrerollChildren.
+  std::shared_ptr<fml::ConcurrentTaskRunner> concurrent_task_runner;
+  // Set while a subtree is prerolled on a worker thread. Work with effects
+  // outside of the subtree is queued here and run on the raster thread once
+  // the subtree has been prerolled. See Layer::RunInTreeOrder.
+  std::vector<fml::closure>* deferred_tasks = nullptr;
+  // Set along with |deferred_tasks|. Whether a texture layer was prerolled
+  // before the subtree in tree order, which is only known by the time the
+  // deferred tasks run.
+  const bool* has_preceding_texture_layer = nullptr;
 };
 
 class PictureLayer;
@@ -104,6 +122,20 @@ class Layer {
 
   virtual void Preroll(PrerollContext* context, const SkMatrix& matrix);
 
+  // Runs |task|, which Preroll uses to update state shared by the whole
+  // tree such as the raster cache or the view embedder. When the layer is
+  // prerolled on a worker thread the task is queued instead, and the queued
+  // tasks of all the subtrees run on the raster thread in the order their
+  // layers would have been prerolled in.
+  template <typename Task>
+  static void RunInTreeOrder(PrerollContext* context, Task&& task) {
+    if (context->deferred_tasks) {
+      context->deferred_tasks->emplace_back(std::forward<Task>(task));
+    } else {
+      task();
+    }
+  }
+
   // Used during Preroll by layers that employ a saveLayer to manage the
   // PrerollContext settings with values affected by the saveLayer mechanism.
   // This object must be created before calling Preroll on the children to
@@ -49,6 +49,8 @@ bool LayerTree::Preroll(CompositorContext::ScopedFrame& frame,
       frame.context().texture_registry(),
       checkerboard_offscreen_layers_,
       device_pixel_ratio_};
+  context.concurrent_task_runner =
+      frame.context().concurrent_preroll_task_runner();
 
   root_layer_->Preroll(&context, frame.root_surface_transformation());
   return context.surface_needs_readback;
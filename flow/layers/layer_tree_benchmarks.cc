@@ -0,0 +1,129 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/flow/layers/layer_tree.h"
+
+#include "flutter/benchmarking/benchmarking.h"
+#include "flutter/flow/compositor_context.h"
+#include "flutter/flow/layers/clip_rect_layer.h"
+#include "flutter/flow/layers/container_layer.h"
+#include "flutter/flow/layers/display_list_layer.h"
+#include "flutter/flow/layers/opacity_layer.h"
+#include "flutter/flow/layers/transform_layer.h"
+#include "third_party/skia/include/core/SkSurface.h"
+
+namespace flutter {
+namespace benchmarking {
+
+static constexpr int kFrameWidth = 800;
+static constexpr int kFrameHeight = 600;
+
+static std::shared_ptr<Layer> MakeLeaf(int index) {
+  DisplayListBuilder builder;
+  builder.setColor(0xFF000000 | ((index % 256) * 0x0F1F2F));
+  builder.drawRect({0, 0, 80, 20});
+  builder.setColor(SK_ColorWHITE);
+  builder.drawCircle({10, 10}, 6);
+  return std::make_shared<DisplayListLayer>(SkPoint::Make(0, 0),
+                                            builder.Build(), false, false);
+}
+
+// A chain of |depth| transform, clip and opacity layers above one leaf, as
+// produced by deeply nested widgets.
+static std::shared_ptr<Layer> MakeDeepTree(int depth) {
+  auto root = std::make_shared<ContainerLayer>();
+  ContainerLayer* parent = root.get();
+  for (int i = 0; i < depth; i++) {
+    std::shared_ptr<ContainerLayer> layer;
+    switch (i % 3) {
+      case 0:
+        layer = std::make_shared<TransformLayer>(SkMatrix::Translate(1, 1));
+        break;
+      case 1:
+        layer = std::make_shared<ClipRectLayer>(
+            SkRect::MakeWH(kFrameWidth, kFrameHeight), Clip::hardEdge);
+        break;
+      default:
+        layer = std::make_shared<OpacityLayer>(0xF0, SkPoint::Make(0, 0));
+        break;
+    }
+    parent->Add(layer);
+    parent = layer.get();
+  }
+  parent->Add(MakeLeaf(0));
+  return root;
+}
+
+// A root with |width| translated leaves, as produced by a long list.
+static std::shared_ptr<Layer> MakeWideTree(int width) {
+  auto root = std::make_shared<ContainerLayer>();
+  for (int i = 0; i < width; i++) {
+    SkScalar x = (i % 10) * 80;
+    SkScalar y = (i / 10 % 30) * 20;
+    auto transform =
+        std::make_shared<TransformLayer>(SkMatrix::Translate(x, y));
+    transform->Add(MakeLeaf(i));
+    root->Add(transform);
+  }
+  return root;
+}
+
+// Prerolls and paints |root| with the software backend. The raster cache
+// is ignored so that only the traversal of the tree is measured.
+static void RunLayerTree(benchmark::State& state,
+                         std::shared_ptr<Layer> root,
+                         bool paint) {
+  sk_sp<SkSurface> surface =
+      SkSurface::MakeRasterN32Premul(kFrameWidth, kFrameHeight);
+  CompositorContext compositor_context;
+  SkMatrix root_transform = SkMatrix::I();
+  auto frame = compositor_context.AcquireFrame(
+      nullptr, surface->getCanvas(), nullptr, root_transform, false, true,
+      nullptr);
+  LayerTree layer_tree(SkISize::Make(kFrameWidth, kFrameHeight), 1.0f);
+  layer_tree.set_root_layer(std::move(root));
+
+  while (state.KeepRunning()) {
+    layer_tree.Preroll(*frame, true);
+    if (paint) {
+      layer_tree.Paint(*frame, true);
+    }
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+static void BM_LayerTreePrerollDeep(benchmark::State& state) {
+  RunLayerTree(state, MakeDeepTree(state.range(0)), false);
+}
+BENCHMARK(BM_LayerTreePrerollDeep)
+    ->RangeMultiplier(4)
+    ->Range(1 << 2, 1 << 8)
+    ->Complexity();
+
+static void BM_LayerTreePrerollWide(benchmark::State& state) {
+  RunLayerTree(state, MakeWideTree(state.range(0)), false);
+}
+BENCHMARK(BM_LayerTreePrerollWide)
+    ->RangeMultiplier(4)
+    ->Range(1 << 4, 1 << 12)
+    ->Complexity();
+
+static void BM_LayerTreePrerollAndPaintDeep(benchmark::State& state) {
+  RunLayerTree(state, MakeDeepTree(state.range(0)), true);
+}
+BENCHMARK(BM_LayerTreePrerollAndPaintDeep)
+    ->RangeMultiplier(4)
+    ->Range(1 << 2, 1 << 8)
+    ->Complexity();
+
+static void BM_LayerTreePrerollAndPaintWide(benchmark::State& state) {
+  RunLayerTree(state, MakeWideTree(state.range(0)), true);
+}
+BENCHMARK(BM_LayerTreePrerollAndPaintWide)
+    ->RangeMultiplier(4)
+    ->Range(1 << 4, 1 << 12)
+    ->Complexity();
+
+}  // namespace benchmarking
+}  // namespace flutter
@@ -6,6 +6,7 @@
 
 #include "flutter/flow/compositor_context.h"
 #include "flutter/flow/layers/container_layer.h"
+#include "flutter/flow/testing/diff_context_test.h"
 #include "flutter/flow/testing/mock_layer.h"
 #include "flutter/fml/macros.h"
 #include "flutter/testing/canvas_test.h"
@@ -193,5 +194,57 @@ TEST_F(LayerTreeTest, NeedsSystemComposite) {
                                                child_path2, child_paint2}}}));
 }
 
+#ifdef FLUTTER_ENABLE_DIFF_CONTEXT
+
+using FrameDamageTest = DiffContextTest;
+
+TEST_F(FrameDamageTest, ClipRectCoversDamageSincePreviousLayerTree) {
+  auto unchanged = CreatePictureLayer(
+      CreatePicture(SkRect::MakeXYWH(10, 10, 20, 20), 1));
+  auto changed1 = CreatePictureLayer(
+      CreatePicture(SkRect::MakeXYWH(50, 50, 20, 20), 1));
+  auto changed2 = CreatePictureLayer(
+      CreatePicture(SkRect::MakeXYWH(50, 50, 20, 20), 2));
+
+  LayerTree tree1(SkISize::Make(100, 100), 1.0f);
+  tree1.set_root_layer(CreateContainerLayer({unchanged, changed1}));
+
+  // Without a previous layer tree the whole frame is repainted.
+  FrameDamage damage1;
+  EXPECT_FALSE(damage1.ComputeClipRect(tree1, SkMatrix::I()).has_value());
+  EXPECT_FALSE(damage1.GetFrameDamage().has_value());
+  EXPECT_FALSE(damage1.GetBufferDamage().has_value());
+
+  LayerTree tree2(SkISize::Make(100, 100), 1.0f);
+  tree2.set_root_layer(CreateContainerLayer({unchanged, changed2}));
+
+  FrameDamage damage2;
+  damage2.SetPreviousLayerTree(&tree1);
+  damage2.AddAdditionalDamage(SkIRect::MakeXYWH(0, 0, 5, 5));
+  auto clip_rect = damage2.ComputeClipRect(tree2, SkMatrix::I());
+  ASSERT_TRUE(clip_rect.has_value());
+  EXPECT_EQ(*clip_rect, SkRect::MakeLTRB(0, 0, 70, 70));
+  EXPECT_EQ(*damage2.GetFrameDamage(), SkIRect::MakeXYWH(50, 50, 20, 20));
+  EXPECT_EQ(*damage2.GetBufferDamage(), SkIRect::MakeLTRB(0, 0, 70, 70));
+}
+
+TEST_F(FrameDamageTest, FrameSizeChangeRepaintsWholeFrame) {
+  auto picture = CreatePictureLayer(
+      CreatePicture(SkRect::MakeXYWH(10, 10, 20, 20), 1));
+
+  LayerTree tree1(SkISize::Make(100, 100), 1.0f);
+  tree1.set_root_layer(CreateContainerLayer(picture));
+  FrameDamage damage1;
+  damage1.ComputeClipRect(tree1, SkMatrix::I());
+
+  LayerTree tree2(SkISize::Make(200, 100), 1.0f);
+  tree2.set_root_layer(CreateContainerLayer(picture));
+  FrameDamage damage2;
+  damage2.SetPreviousLayerTree(&tree1);
+  EXPECT_FALSE(damage2.ComputeClipRect(tree2, SkMatrix::I()).has_value());
+}
+
+#endif  // FLUTTER_ENABLE_DIFF_CONTEXT
+
 }  // namespace testing
 }  // namespace flutter
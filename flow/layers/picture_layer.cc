@@ -119,8 +119,14 @@ void PictureLayer::Preroll(PrerollContext* context, const SkMatrix& matrix) {
 #ifndef SUPPORT_FRACTIONAL_TRANSLATION
     ctm = RasterCache::GetIntegralTransCTM(ctm);
 #endif
-    cache->Prepare(context->gr_context, sk_picture, ctm,
-                   context->dst_color_space, is_complex_, will_change_);
+    RunInTreeOrder(context, [cache, gr_context = context->gr_context,
+                             sk_picture, ctm,
+                             dst_color_space = context->dst_color_space,
+                             is_complex = is_complex_,
+                             will_change = will_change_]() {
+      cache->Prepare(gr_context, sk_picture, ctm, dst_color_space, is_complex,
+                     will_change);
+    });
   }
 
   SkRect bounds = sk_picture->cullRect().makeOffset(offset_.x(), offset_.y());
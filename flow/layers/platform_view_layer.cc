@@ -23,11 +23,13 @@ void PlatformViewLayer::Preroll(PrerollContext* context,
   }
   context->has_platform_view = true;
   set_subtree_has_platform_view(true);
-  std::unique_ptr<EmbeddedViewParams> params =
-      std::make_unique<EmbeddedViewParams>(matrix, size_,
-                                           context->mutators_stack);
-  context->view_embedder->PrerollCompositeEmbeddedView(view_id_,
-                                                       std::move(params));
+  RunInTreeOrder(context, [view_embedder = context->view_embedder,
+                           view_id = view_id_,
+                           params = EmbeddedViewParams(
+                               matrix, size_, context->mutators_stack)]() {
+    view_embedder->PrerollCompositeEmbeddedView(
+        view_id, std::make_unique<EmbeddedViewParams>(params));
+  });
 }
 
 void PlatformViewLayer::Paint(PaintContext& context) const {
@@ -4,12 +4,16 @@
 
 #include "flutter/flow/raster_cache.h"
 
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "flutter/common/constants.h"
 #include "flutter/flow/layers/layer.h"
 #include "flutter/flow/paint_utils.h"
 #include "flutter/fml/logging.h"
+#include "flutter/fml/time/time_point.h"
 #include "flutter/fml/trace_event.h"
 #include "third_party/skia/include/core/SkCanvas.h"
 #include "third_party/skia/include/core/SkImage.h"
@@ -36,6 +40,51 @@ void RasterCacheResult::draw(SkCanvas& canvas, const SkPaint* paint) const {
                    paint);
 }
 
+// A cached image stored in a region of a shared atlas page.
+class AtlasRasterCacheResult : public RasterCacheResult {
+ public:
+  AtlasRasterCacheResult(std::shared_ptr<RasterCacheAtlasPage> page,
+                         const SkIRect& region,
+                         const SkRect& logical_rect)
+      : RasterCacheResult(nullptr, logical_rect),
+        page_(std::move(page)),
+        region_(region),
+        logical_rect_(logical_rect) {}
+
+  ~AtlasRasterCacheResult() override { page_->Release(); }
+
+  void draw(SkCanvas& canvas, const SkPaint* paint) const override {
+    TRACE_EVENT0("flutter", "RasterCacheResult::draw");
+    SkAutoCanvasRestore auto_restore(&canvas, true);
+    SkIRect bounds =
+        RasterCache::GetDeviceBounds(logical_rect_, canvas.getTotalMatrix());
+    FML_DCHECK(std::abs(bounds.size().width() - region_.width()) <= 1 &&
+               std::abs(bounds.size().height() - region_.height()) <= 1);
+    canvas.resetMatrix();
+    // Draws of entries sharing a page sample the same texture, which allows
+    // the GPU backend to batch consecutive ones into a single draw.
+    canvas.drawImageRect(
+        page_->image(), SkRect::Make(region_),
+        SkRect::MakeXYWH(bounds.fLeft, bounds.fTop, region_.width(),
+                         region_.height()),
+        SkSamplingOptions(), paint, SkCanvas::kStrict_SrcRectConstraint);
+  }
+
+  SkISize image_dimensions() const override { return region_.size(); }
+
+  // The page is accounted for as a whole by the atlas.
+  int64_t image_bytes() const override { return 0; }
+
+  const RasterCacheAtlasPage* atlas_page() const override {
+    return page_.get();
+  }
+
+ private:
+  std::shared_ptr<RasterCacheAtlasPage> page_;
+  SkIRect region_;
+  SkRect logical_rect_;
+};
+
 RasterCache::RasterCache(size_t access_threshold,
                          size_t picture_cache_limit_per_frame)
     : access_threshold_(access_threshold),
@@ -142,11 +191,32 @@ static std::unique_ptr<RasterCacheResult> Rasterize(
     const SkMatrix& ctm,
     SkColorSpace* dst_color_space,
     bool checkerboard,
+    RasterCacheAtlas* atlas,
     const SkRect& logical_rect,
     const std::function<void(SkCanvas*)>& draw_function) {
   TRACE_EVENT0("flutter", "RasterCachePopulate");
   SkIRect cache_rect = RasterCache::GetDeviceBounds(logical_rect, ctm);
 
+  if (atlas && atlas->CanPack(cache_rect.size())) {
+    SkIRect region;
+    std::shared_ptr<RasterCacheAtlasPage> page = atlas->Allocate(
+        context, dst_color_space, cache_rect.size(), &region);
+    if (page) {
+      SkCanvas* canvas = page->BeginDrawing(region);
+      canvas->translate(-cache_rect.left(), -cache_rect.top());
+      canvas->concat(ctm);
+      draw_function(canvas);
+
+      if (checkerboard) {
+        DrawCheckerboard(canvas, logical_rect);
+      }
+      page->EndDrawing();
+
+      return std::make_unique<AtlasRasterCacheResult>(std::move(page), region,
+                                                      logical_rect);
+    }
+  }
+
   const SkImageInfo image_info = SkImageInfo::MakeN32Premul(
       cache_rect.width(), cache_rect.height(), sk_ref_sp(dst_color_space));
 
@@ -179,7 +249,7 @@ std::unique_ptr<RasterCacheResult> RasterCache::RasterizePicture(
     const SkMatrix& ctm,
     SkColorSpace* dst_color_space,
     bool checkerboard) const {
-  return Rasterize(context, ctm, dst_color_space, checkerboard,
+  return Rasterize(context, ctm, dst_color_space, checkerboard, atlas_.get(),
                    picture->cullRect(),
                    [=](SkCanvas* canvas) { canvas->drawPicture(picture); });
 }
@@ -190,7 +260,7 @@ std::unique_ptr<RasterCacheResult> RasterCache::RasterizeDisplayList(
     const SkMatrix& ctm,
     SkColorSpace* dst_color_space,
     bool checkerboard) const {
-  return Rasterize(context, ctm, dst_color_space, checkerboard,
+  return Rasterize(context, ctm, dst_color_space, checkerboard, atlas_.get(),
                    display_list->bounds(),
                    [=](SkCanvas* canvas) { display_list->RenderTo(canvas); });
 }
@@ -202,8 +272,11 @@ void RasterCache::Prepare(PrerollContext* context,
   Entry& entry = layer_cache_[cache_key];
   entry.access_count++;
   entry.used_this_frame = true;
-  if (!entry.image) {
-    entry.image = RasterizeLayer(context, layer, ctm, checkerboard_images_);
+  if (!entry.image &&
+      ReserveImageBytes(layer->paint_bounds(), ctm, context->gr_context,
+                        context->dst_color_space)) {
+    CacheImage(entry,
+               RasterizeLayer(context, layer, ctm, checkerboard_images_));
   }
 }
 
@@ -214,7 +287,7 @@ std::unique_ptr<RasterCacheResult> RasterCache::RasterizeLayer(
     bool checkerboard) const {
   return Rasterize(
       context->gr_context, ctm, context->dst_color_space, checkerboard,
-      layer->paint_bounds(), [layer, context](SkCanvas* canvas) {
+      atlas_.get(), layer->paint_bounds(), [layer, context](SkCanvas* canvas) {
         SkISize canvas_size = canvas->getBaseLayerSize();
         SkNWayCanvas internal_nodes_canvas(canvas_size.width(),
                                            canvas_size.height());
@@ -274,9 +347,27 @@ bool RasterCache::Prepare(GrDirectContext* context,
     return false;
   }
 
+  if (!entry.image && rasterize_asynchronously_) {
+    // Leave the rasterization to RasterizePendingEntries and keep drawing the
+    // picture directly in the meantime.
+    if (!entry.rasterization_pending) {
+      entry.rasterization_pending = true;
+      pending_rasterizations_.push_back({sk_ref_sp(picture), nullptr,
+                                         transformation_matrix,
+                                         sk_ref_sp(dst_color_space)});
+    }
+    return false;
+  }
+
   if (!entry.image) {
-    entry.image = RasterizePicture(picture, context, transformation_matrix,
-                                   dst_color_space, checkerboard_images_);
+    if (!ReserveImageBytes(picture->cullRect(), transformation_matrix,
+                           context, dst_color_space)) {
+      // The image would not fit in the cache.
+      return false;
+    }
+    CacheImage(entry,
+               RasterizePicture(picture, context, transformation_matrix,
+                                dst_color_space, checkerboard_images_));
     picture_cached_this_frame_++;
   }
   return true;
@@ -319,10 +410,28 @@ bool RasterCache::Prepare(GrDirectContext* context,
     return false;
   }
 
+  if (!entry.image && rasterize_asynchronously_) {
+    // Leave the rasterization to RasterizePendingEntries and keep drawing the
+    // display list directly in the meantime.
+    if (!entry.rasterization_pending) {
+      entry.rasterization_pending = true;
+      pending_rasterizations_.push_back({nullptr, sk_ref_sp(display_list),
+                                         transformation_matrix,
+                                         sk_ref_sp(dst_color_space)});
+    }
+    return false;
+  }
+
   if (!entry.image) {
-    entry.image =
-        RasterizeDisplayList(display_list, context, transformation_matrix,
-                             dst_color_space, checkerboard_images_);
+    if (!ReserveImageBytes(display_list->bounds(), transformation_matrix,
+                           context, dst_color_space)) {
+      // The image would not fit in the cache.
+      return false;
+    }
+    CacheImage(entry,
+               RasterizeDisplayList(display_list, context,
+                                    transformation_matrix, dst_color_space,
+                                    checkerboard_images_));
     picture_cached_this_frame_++;
   }
   return true;
@@ -393,14 +502,247 @@ void RasterCache::SweepAfterFrame() {
   SweepOneCacheAfterFrame(picture_cache_);
   SweepOneCacheAfterFrame(display_list_cache_);
   SweepOneCacheAfterFrame(layer_cache_);
+  // Release the pictures and display lists of the requests whose entry was
+  // just swept.
+  pending_rasterizations_.erase(
+      std::remove_if(pending_rasterizations_.begin(),
+                     pending_rasterizations_.end(),
+                     [this](const PendingRasterization& request) {
+                       return FindPendingEntry(request) == nullptr;
+                     }),
+      pending_rasterizations_.end());
+  RemoveEmptyAtlasPages(1);
+  // Trim the entries retained across frames in case the budget was lowered.
+  ReserveBytes(0);
   picture_cached_this_frame_ = 0;
   TraceStatsToTimeline();
+  evicted_entries_this_frame_ = 0;
+  evicted_bytes_this_frame_ = 0;
 }
 
 void RasterCache::Clear() {
   picture_cache_.clear();
   display_list_cache_.clear();
   layer_cache_.clear();
+  pending_rasterizations_.clear();
+  cached_bytes_ = 0;
+  if (atlas_) {
+    atlas_->Clear();
+  }
+}
+
+void RasterCache::SetRasterizeAsynchronously(bool rasterize_asynchronously) {
+  rasterize_asynchronously_ = rasterize_asynchronously;
+  if (rasterize_asynchronously_) {
+    return;
+  }
+  // Entries that were still pending will be rasterized synchronously by the
+  // next call to Prepare instead.
+  pending_rasterizations_.clear();
+  for (auto& item : picture_cache_) {
+    item.second.rasterization_pending = false;
+  }
+  for (auto& item : display_list_cache_) {
+    item.second.rasterization_pending = false;
+  }
+}
+
+void RasterCache::RasterizePendingEntries(GrDirectContext* context,
+                                          fml::TimeDelta budget) {
+  TRACE_EVENT0("flutter", "RasterCache::RasterizePendingEntries");
+  const fml::TimePoint deadline = fml::TimePoint::Now() + budget;
+  bool did_rasterize = false;
+  while (!pending_rasterizations_.empty()) {
+    if (did_rasterize && fml::TimePoint::Now() >= deadline) {
+      return;
+    }
+    PendingRasterization request = std::move(pending_rasterizations_.front());
+    pending_rasterizations_.pop_front();
+
+    Entry* entry = FindPendingEntry(request);
+    if (!entry) {
+      continue;
+    }
+    entry->rasterization_pending = false;
+    const SkRect logical_rect = request.picture
+                                    ? request.picture->cullRect()
+                                    : request.display_list->bounds();
+    if (entry->image ||
+        !ReserveImageBytes(logical_rect, request.matrix, context,
+                           request.dst_color_space.get())) {
+      continue;
+    }
+    did_rasterize = true;
+
+    if (request.picture) {
+      CacheImage(*entry, RasterizePicture(request.picture.get(), context,
+                                          request.matrix,
+                                          request.dst_color_space.get(),
+                                          checkerboard_images_));
+    } else {
+      CacheImage(*entry,
+                 RasterizeDisplayList(request.display_list.get(), context,
+                                      request.matrix,
+                                      request.dst_color_space.get(),
+                                      checkerboard_images_));
+    }
+  }
+}
+
+RasterCache::Entry* RasterCache::FindPendingEntry(
+    const PendingRasterization& request) {
+  Entry* entry = nullptr;
+  if (request.picture) {
+    auto it = picture_cache_.find(
+        PictureRasterCacheKey(request.picture->uniqueID(), request.matrix));
+    entry = it == picture_cache_.end() ? nullptr : &it->second;
+  } else {
+    auto it = display_list_cache_.find(DisplayListRasterCacheKey(
+        request.display_list->unique_id(), request.matrix));
+    entry = it == display_list_cache_.end() ? nullptr : &it->second;
+  }
+  if (!entry || !entry->rasterization_pending) {
+    return nullptr;
+  }
+  return entry;
+}
+
+void RasterCache::SetRetentionPolicy(size_t max_unused_frames,
+                                     size_t max_bytes) {
+  max_unused_frames_ = std::max<size_t>(max_unused_frames, 1);
+  max_bytes_ = max_bytes;
+}
+
+void RasterCache::CacheImage(Entry& entry,
+                             std::unique_ptr<RasterCacheResult> image) {
+  FML_DCHECK(!entry.image);
+  if (image) {
+    cached_bytes_ += image->image_bytes();
+  }
+  entry.image = std::move(image);
+}
+
+void RasterCache::EvictImage(Entry& entry) {
+  if (!entry.image) {
+    return;
+  }
+  size_t bytes = entry.image->image_bytes();
+  FML_DCHECK(bytes <= cached_bytes_);
+  cached_bytes_ -= std::min(bytes, cached_bytes_);
+  evicted_entries_this_frame_++;
+  evicted_bytes_this_frame_ += bytes;
+  entry.image.reset();
+}
+
+bool RasterCache::ReserveBytes(size_t bytes) {
+  if (max_bytes_ == 0 || GetCachedBytes() + bytes <= max_bytes_) {
+    return true;
+  }
+
+  // The empty page kept for the next entries goes first.
+  RemoveEmptyAtlasPages(0);
+
+  // Entries that have been used in this frame or the previous one are still
+  // part of the working set and are never evicted to make room. An entry in
+  // an atlas page only frees memory along with the rest of its page, so such
+  // entries are evicted a page at a time, and only from pages that hold no
+  // entry of the working set.
+  struct Candidate {
+    size_t unused_frames;
+    std::vector<Entry*> entries;
+  };
+  std::vector<Candidate> candidates;
+  std::unordered_map<const RasterCacheAtlasPage*, Candidate> pages;
+  std::unordered_set<const RasterCacheAtlasPage*> pages_in_use;
+  auto collect_candidates = [&](auto& cache) {
+    for (auto& item : cache) {
+      Entry& entry = item.second;
+      if (!entry.image) {
+        continue;
+      }
+      const bool evictable = !entry.used_this_frame && entry.unused_frames > 0;
+      const RasterCacheAtlasPage* page = entry.image->atlas_page();
+      if (!page) {
+        if (evictable) {
+          candidates.push_back({entry.unused_frames, {&entry}});
+        }
+      } else if (!evictable) {
+        pages_in_use.insert(page);
+      } else {
+        // A page is as recently used as its most recently used entry.
+        Candidate& candidate =
+            pages.try_emplace(page, Candidate{entry.unused_frames, {}})
+                .first->second;
+        candidate.unused_frames =
+            std::min(candidate.unused_frames, entry.unused_frames);
+        candidate.entries.push_back(&entry);
+      }
+    }
+  };
+  collect_candidates(picture_cache_);
+  collect_candidates(display_list_cache_);
+  collect_candidates(layer_cache_);
+  for (auto& item : pages) {
+    if (pages_in_use.find(item.first) == pages_in_use.end()) {
+      candidates.push_back(std::move(item.second));
+    }
+  }
+
+  // Evict the least recently used entries first.
+  std::sort(candidates.begin(), candidates.end(),
+            [](const Candidate& a, const Candidate& b) {
+              return a.unused_frames > b.unused_frames;
+            });
+  for (const Candidate& candidate : candidates) {
+    if (GetCachedBytes() + bytes <= max_bytes_) {
+      break;
+    }
+    for (Entry* entry : candidate.entries) {
+      EvictImage(*entry);
+    }
+    RemoveEmptyAtlasPages(0);
+  }
+  return GetCachedBytes() + bytes <= max_bytes_;
+}
+
+size_t RasterCache::EstimateImageBytes(const SkRect& logical_rect,
+                                       const SkMatrix& ctm,
+                                       GrDirectContext* context,
+                                       SkColorSpace* dst_color_space) const {
+  SkIRect cache_rect = GetDeviceBounds(logical_rect, ctm);
+  if (atlas_ && atlas_->CanPack(cache_rect.size())) {
+    return atlas_->HasRoomFor(context, dst_color_space, cache_rect.size())
+               ? 0
+               : atlas_->page_bytes();
+  }
+  return SkImageInfo::MakeN32Premul(cache_rect.width(), cache_rect.height())
+      .computeMinByteSize();
+}
+
+bool RasterCache::ReserveImageBytes(const SkRect& logical_rect,
+                                    const SkMatrix& ctm,
+                                    GrDirectContext* context,
+                                    SkColorSpace* dst_color_space) {
+  if (!ReserveBytes(
+          EstimateImageBytes(logical_rect, ctm, context, dst_color_space))) {
+    return false;
+  }
+  // Making room may have freed the empty page the image was going to use.
+  return ReserveBytes(
+      EstimateImageBytes(logical_rect, ctm, context, dst_color_space));
+}
+
+void RasterCache::RemoveEmptyAtlasPages(size_t pages_to_keep) {
+  if (!atlas_) {
+    return;
+  }
+  const size_t bytes = atlas_->GetByteSize();
+  atlas_->RemoveEmptyPages(pages_to_keep);
+  evicted_bytes_this_frame_ += bytes - atlas_->GetByteSize();
+}
+
+size_t RasterCache::GetCachedBytes() const {
+  return cached_bytes_ + EstimateAtlasByteSize();
 }
 
 size_t RasterCache::GetCachedEntriesCount() const {
@@ -420,6 +762,16 @@ size_t RasterCache::GetDisplayListCachedEntriesCount() const {
   return display_list_cache_.size();
 }
 
+void RasterCache::SetUseAtlas(bool use_atlas) {
+  if (use_atlas == static_cast<bool>(atlas_)) {
+    return;
+  }
+
+  // Clear all existing entries first so that no image outlives its page.
+  Clear();
+  atlas_ = use_atlas ? std::make_unique<RasterCacheAtlas>() : nullptr;
+}
+
 void RasterCache::SetCheckboardCacheImages(bool checkerboard) {
   if (checkerboard_images_ == checkerboard) {
     return;
@@ -441,7 +793,12 @@ void RasterCache::TraceStatsToTimeline() const {
                     EstimatePictureCacheByteSize() / kMegaByteSizeInBytes,
                     "DisplayListCount", display_list_cache_.size(),
                     "DisplayListMBytes",
-                    EstimateDisplayListCacheByteSize() / kMegaByteSizeInBytes);
+                    EstimateDisplayListCacheByteSize() / kMegaByteSizeInBytes,
+                    "AtlasPageCount", GetAtlasPageCount(), "AtlasMBytes",
+                    EstimateAtlasByteSize() / kMegaByteSizeInBytes,
+                    "EvictedCount", evicted_entries_this_frame_,
+                    "EvictedMBytes",
+                    evicted_bytes_this_frame_ / kMegaByteSizeInBytes);
 
 #endif  // !FLUTTER_RELEASE
 }
@@ -476,4 +833,8 @@ size_t RasterCache::EstimateDisplayListCacheByteSize() const {
   return display_list_cache_bytes;
 }
 
+size_t RasterCache::EstimateAtlasByteSize() const {
+  return atlas_ ? atlas_->GetByteSize() : 0;
+}
+
 }  // namespace flutter
@@ -5,13 +5,16 @@
 #ifndef FLUTTER_FLOW_RASTER_CACHE_H_
 #define FLUTTER_FLOW_RASTER_CACHE_H_
 
+#include <deque>
 #include <memory>
 #include <unordered_map>
 
 #include "flutter/flow/display_list.h"
+#include "flutter/flow/raster_cache_atlas.h"
 #include "flutter/flow/raster_cache_key.h"
 #include "flutter/fml/macros.h"
 #include "flutter/fml/memory/weak_ptr.h"
+#include "flutter/fml/time/time_delta.h"
 #include "third_party/skia/include/core/SkImage.h"
 #include "third_party/skia/include/core/SkSize.h"
 
@@ -33,6 +36,10 @@ class RasterCacheResult {
     return image_ ? image_->imageInfo().computeMinByteSize() : 0;
   };
 
+  // The atlas page the image is stored in, or null if it has a surface of its
+  // own.
+  virtual const RasterCacheAtlasPage* atlas_page() const { return nullptr; }
+
  private:
   sk_sp<SkImage> image_;
   SkRect logical_rect_;
@@ -48,6 +55,11 @@ class RasterCache {
   // multiple frames.
   static constexpr int kDefaultPictureCacheLimitPerFrame = 3;
 
+  // The default number of consecutive frames an entry may go unused before
+  // it is evicted. The default evicts any entry that was not used in the
+  // frame that was just drawn.
+  static constexpr size_t kDefaultMaxUnusedFrames = 1;
+
   explicit RasterCache(
       size_t access_threshold = 3,
       size_t picture_cache_limit_per_frame = kDefaultPictureCacheLimitPerFrame);
@@ -139,6 +151,10 @@ class RasterCache {
   // 3. The picture is accessed too few times
   // 4. There are too many pictures to be cached in the current frame.
   //    (See also kDefaultPictureCacheLimitPerFrame.)
+  // 5. The cache is rasterizing asynchronously and the picture has been
+  //    scheduled for rasterization instead. The picture should be drawn
+  //    directly until the cached image is ready.
+  //    (See also SetRasterizeAsynchronously.)
   bool Prepare(GrDirectContext* context,
                SkPicture* picture,
                const SkMatrix& transformation_matrix,
@@ -180,6 +196,69 @@ class RasterCache {
 
   void SetCheckboardCacheImages(bool checkerboard);
 
+  /**
+   * @brief Configure how long unused entries are retained and how much memory
+   * the cached images may use.
+   *
+   * @param max_unused_frames the number of consecutive frames an entry may go
+   *        unused before it is evicted. Values less than 1 are treated as 1.
+   * @param max_bytes the maximum number of bytes of cached images to retain,
+   *        or 0 for no limit. Atlas pages count in full, including the empty
+   *        page kept for the next entries. When the limit is reached, the
+   *        images of entries that were used in neither the current frame nor
+   *        the previous one are evicted in least recently used order, and new
+   *        images are not rasterized if the limit still cannot be met. Images
+   *        in an atlas page are only evicted together with the rest of the
+   *        page.
+   */
+  void SetRetentionPolicy(size_t max_unused_frames, size_t max_bytes);
+
+  /**
+   * @brief Enable or disable asynchronous rasterization of pictures and
+   * display lists.
+   *
+   * When enabled, Prepare schedules the rasterization of pictures and display
+   * lists that are ready to be cached instead of rasterizing them within the
+   * frame, and the live picture continues to be drawn until the scheduled
+   * work is performed by a call to RasterizePendingEntries. Layers are always
+   * rasterized synchronously.
+   */
+  void SetRasterizeAsynchronously(bool rasterize_asynchronously);
+
+  /**
+   * @brief Enable or disable packing small cached images into shared atlas
+   * pages.
+   *
+   * When enabled, images no larger than RasterCacheAtlas::kDefaultMaxEntrySize
+   * in either dimension are rasterized into a region of a shared page rather
+   * than into a surface of their own, and are drawn from that page. Changing
+   * the setting clears the cache.
+   *
+   * The memory used by the pages is reported by EstimateAtlasByteSize rather
+   * than by the estimates of the entries stored in them.
+   */
+  void SetUseAtlas(bool use_atlas);
+
+  size_t GetAtlasPageCount() const { return atlas_ ? atlas_->page_count() : 0; }
+
+  bool HasPendingRasterizations() const {
+    return !pending_rasterizations_.empty();
+  }
+
+  /**
+   * @brief Rasterize the pictures and display lists scheduled by Prepare
+   * while in asynchronous mode, in the order they were scheduled.
+   *
+   * At least one pending rasterization is performed, and then more are
+   * performed until the time budget has been used up. Requests whose entry
+   * was swept or already has an image are skipped without counting as work.
+   *
+   * @param context the GrDirectContext used for rendering, which must be the
+   *        same context used for the frames that will draw the results.
+   * @param budget the amount of time to spend rasterizing.
+   */
+  void RasterizePendingEntries(GrDirectContext* context, fml::TimeDelta budget);
+
   size_t GetCachedEntriesCount() const;
 
   size_t GetLayerCachedEntriesCount() const;
@@ -194,7 +273,8 @@ class RasterCache {
    *
    * Only SkImage's memory usage is counted as other objects are often much
    * smaller compared to SkImage. SkImageInfo::computeMinByteSize is used to
-   * estimate the SkImage memory usage.
+   * estimate the SkImage memory usage. Entries stored in atlas pages are
+   * counted by EstimateAtlasByteSize instead.
    */
   size_t EstimatePictureCacheByteSize() const;
 
@@ -204,7 +284,8 @@ class RasterCache {
    *
    * Only SkImage's memory usage is counted as other objects are often much
    * smaller compared to SkImage. SkImageInfo::computeMinByteSize is used to
-   * estimate the SkImage memory usage.
+   * estimate the SkImage memory usage. Entries stored in atlas pages are
+   * counted by EstimateAtlasByteSize instead.
    */
   size_t EstimateDisplayListCacheByteSize() const;
 
@@ -214,30 +295,54 @@ class RasterCache {
    *
    * Only SkImage's memory usage is counted as other objects are often much
    * smaller compared to SkImage. SkImageInfo::computeMinByteSize is used to
-   * estimate the SkImage memory usage.
+   * estimate the SkImage memory usage. Entries stored in atlas pages are
+   * counted by EstimateAtlasByteSize instead.
    */
   size_t EstimateLayerCacheByteSize() const;
 
+  /**
+   * @brief Estimate how much memory is used by the atlas pages in bytes.
+   *
+   * Every page is counted in full, whether or not it holds any entries.
+   */
+  size_t EstimateAtlasByteSize() const;
+
  private:
   struct Entry {
     bool used_this_frame = false;
     size_t access_count = 0;
+    // The number of consecutive frames, not counting the current frame, in
+    // which this entry was not used.
+    size_t unused_frames = 0;
+    bool rasterization_pending = false;
     std::unique_ptr<RasterCacheResult> image;
   };
 
+  // A picture or display list scheduled for asynchronous rasterization. Only
+  // one of |picture| and |display_list| is set.
+  struct PendingRasterization {
+    sk_sp<SkPicture> picture;
+    sk_sp<DisplayList> display_list;
+    SkMatrix matrix;
+    sk_sp<SkColorSpace> dst_color_space;
+  };
+
   template <class Cache>
-  static void SweepOneCacheAfterFrame(Cache& cache) {
+  void SweepOneCacheAfterFrame(Cache& cache) {
     std::vector<typename Cache::iterator> dead;
 
     for (auto it = cache.begin(); it != cache.end(); ++it) {
       Entry& entry = it->second;
-      if (!entry.used_this_frame) {
+      if (entry.used_this_frame) {
+        entry.unused_frames = 0;
+      } else if (++entry.unused_frames >= max_unused_frames_) {
         dead.push_back(it);
       }
       entry.used_this_frame = false;
     }
 
     for (auto it : dead) {
+      EvictImage(it->second);
       cache.erase(it);
     }
   }
@@ -245,10 +350,55 @@ class RasterCache {
   const size_t access_threshold_;
   const size_t picture_cache_limit_per_frame_;
   size_t picture_cached_this_frame_ = 0;
+  size_t max_unused_frames_ = kDefaultMaxUnusedFrames;
+  size_t max_bytes_ = 0;
+  size_t cached_bytes_ = 0;
+  size_t evicted_entries_this_frame_ = 0;
+  size_t evicted_bytes_this_frame_ = 0;
   mutable PictureRasterCacheKey::Map<Entry> picture_cache_;
   mutable DisplayListRasterCacheKey::Map<Entry> display_list_cache_;
   mutable LayerRasterCacheKey::Map<Entry> layer_cache_;
   bool checkerboard_images_;
+  bool rasterize_asynchronously_ = false;
+  // Set while small images are packed into shared pages.
+  std::unique_ptr<RasterCacheAtlas> atlas_;
+  std::deque<PendingRasterization> pending_rasterizations_;
+
+  // Stores the image in the entry and accounts for its bytes.
+  void CacheImage(Entry& entry, std::unique_ptr<RasterCacheResult> image);
+
+  // Releases the image of the entry, if any, and accounts for its bytes.
+  void EvictImage(Entry& entry);
+
+  // Returns true if an image of |bytes| bytes can be added to the cache
+  // without exceeding |max_bytes_|, evicting the images of entries that have
+  // not been used in the current frame as needed.
+  bool ReserveBytes(size_t bytes);
+
+  // Returns the number of bytes rasterizing |logical_rect| with |ctm| adds to
+  // the cache, which is a whole page for an image that goes into a new atlas
+  // page and nothing for one that fits in an existing page.
+  size_t EstimateImageBytes(const SkRect& logical_rect,
+                            const SkMatrix& ctm,
+                            GrDirectContext* context,
+                            SkColorSpace* dst_color_space) const;
+
+  // Reserves the bytes estimated by EstimateImageBytes.
+  bool ReserveImageBytes(const SkRect& logical_rect,
+                         const SkMatrix& ctm,
+                         GrDirectContext* context,
+                         SkColorSpace* dst_color_space);
+
+  // Frees the atlas pages that hold no entries beyond the first
+  // |pages_to_keep|, and accounts for their bytes.
+  void RemoveEmptyAtlasPages(size_t pages_to_keep);
+
+  // The bytes of the cached images and of the atlas pages.
+  size_t GetCachedBytes() const;
+
+  // Returns the entry |request| is for, or null if it was swept or no longer
+  // waits for its image.
+  Entry* FindPendingEntry(const PendingRasterization& request);
 
   void TraceStatsToTimeline() const;
 
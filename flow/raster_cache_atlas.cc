@@ -0,0 +1,214 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/flow/raster_cache_atlas.h"
+
+#include "flutter/fml/logging.h"
+#include "flutter/fml/trace_event.h"
+#include "third_party/skia/include/core/SkCanvas.h"
+#include "third_party/skia/include/gpu/GrDirectContext.h"
+
+namespace flutter {
+
+// Transparent pixels left between regions so that filtering at the edge of
+// one entry never samples its neighbours.
+static constexpr int kRegionPadding = 1;
+
+RasterCacheAtlasPacker::RasterCacheAtlasPacker(int width, int height)
+    : width_(width), height_(height) {}
+
+int RasterCacheAtlasPacker::FindShelf(const SkISize& size) const {
+  if (size.isEmpty() || size.width() > width_ || size.height() > height_) {
+    return -1;
+  }
+
+  int best = -1;
+  for (size_t i = 0; i < shelves_.size(); i++) {
+    const Shelf& shelf = shelves_[i];
+    if (shelf.height >= size.height() &&
+        width_ - shelf.used_width >= size.width() &&
+        (best < 0 || shelf.height < shelves_[best].height)) {
+      best = static_cast<int>(i);
+    }
+  }
+  if (best >= 0) {
+    return best;
+  }
+
+  int top = shelves_.empty() ? 0 : shelves_.back().top + shelves_.back().height;
+  if (height_ - top < size.height()) {
+    return -1;
+  }
+  return static_cast<int>(shelves_.size());
+}
+
+bool RasterCacheAtlasPacker::Pack(const SkISize& size, SkIRect* result) {
+  int index = FindShelf(size);
+  if (index < 0) {
+    return false;
+  }
+  if (static_cast<size_t>(index) == shelves_.size()) {
+    int top =
+        shelves_.empty() ? 0 : shelves_.back().top + shelves_.back().height;
+    shelves_.push_back({top, size.height(), 0});
+  }
+
+  Shelf& shelf = shelves_[index];
+  *result = SkIRect::MakeXYWH(shelf.used_width, shelf.top, size.width(),
+                              size.height());
+  shelf.used_width += size.width();
+  return true;
+}
+
+bool RasterCacheAtlasPacker::HasRoomFor(const SkISize& size) const {
+  return FindShelf(size) >= 0;
+}
+
+void RasterCacheAtlasPacker::Reset() {
+  shelves_.clear();
+}
+
+RasterCacheAtlasPage::RasterCacheAtlasPage(sk_sp<SkSurface> surface,
+                                           GrDirectContext* context,
+                                           sk_sp<SkColorSpace> color_space)
+    : surface_(std::move(surface)),
+      context_(context),
+      color_space_(std::move(color_space)),
+      packer_(surface_->width(), surface_->height()) {
+  surface_->getCanvas()->clear(SK_ColorTRANSPARENT);
+}
+
+bool RasterCacheAtlasPage::IsCompatible(GrDirectContext* context,
+                                        SkColorSpace* color_space) const {
+  return context_ == context &&
+         SkColorSpace::Equals(color_space_.get(), color_space);
+}
+
+bool RasterCacheAtlasPage::Allocate(const SkISize& size, SkIRect* region) {
+  SkIRect padded;
+  if (!packer_.Pack(SkISize::Make(size.width() + kRegionPadding,
+                                  size.height() + kRegionPadding),
+                    &padded)) {
+    return false;
+  }
+  *region = SkIRect::MakeXYWH(padded.left(), padded.top(), size.width(),
+                              size.height());
+  live_regions_++;
+  return true;
+}
+
+bool RasterCacheAtlasPage::HasRoomFor(const SkISize& size) const {
+  return packer_.HasRoomFor(SkISize::Make(size.width() + kRegionPadding,
+                                          size.height() + kRegionPadding));
+}
+
+void RasterCacheAtlasPage::Release() {
+  FML_DCHECK(live_regions_ > 0);
+  if (--live_regions_ == 0) {
+    packer_.Reset();
+  }
+}
+
+SkCanvas* RasterCacheAtlasPage::BeginDrawing(const SkIRect& region) {
+  // Dropping the snapshot first lets the surface reuse its backing store
+  // instead of copying it before the draw.
+  image_.reset();
+  SkCanvas* canvas = surface_->getCanvas();
+  canvas->save();
+  canvas->clipRect(SkRect::Make(region));
+  canvas->clear(SK_ColorTRANSPARENT);
+  canvas->translate(region.left(), region.top());
+  return canvas;
+}
+
+void RasterCacheAtlasPage::EndDrawing() {
+  surface_->getCanvas()->restore();
+}
+
+const sk_sp<SkImage>& RasterCacheAtlasPage::image() {
+  if (!image_) {
+    image_ = surface_->makeImageSnapshot();
+  }
+  return image_;
+}
+
+RasterCacheAtlas::RasterCacheAtlas(int page_size, int max_entry_size)
+    : page_size_(page_size), max_entry_size_(max_entry_size) {
+  FML_DCHECK(max_entry_size_ + kRegionPadding <= page_size_);
+}
+
+bool RasterCacheAtlas::CanPack(const SkISize& size) const {
+  return !size.isEmpty() && size.width() <= max_entry_size_ &&
+         size.height() <= max_entry_size_;
+}
+
+std::shared_ptr<RasterCacheAtlasPage> RasterCacheAtlas::Allocate(
+    GrDirectContext* context,
+    SkColorSpace* color_space,
+    const SkISize& size,
+    SkIRect* region) {
+  FML_DCHECK(CanPack(size));
+  for (const auto& page : pages_) {
+    if (page->IsCompatible(context, color_space) &&
+        page->Allocate(size, region)) {
+      return page;
+    }
+  }
+
+  TRACE_EVENT0("flutter", "RasterCacheAtlas::AddPage");
+  const SkImageInfo image_info = SkImageInfo::MakeN32Premul(
+      page_size_, page_size_, sk_ref_sp(color_space));
+  sk_sp<SkSurface> surface =
+      context
+          ? SkSurface::MakeRenderTarget(context, SkBudgeted::kYes, image_info)
+          : SkSurface::MakeRaster(image_info);
+  if (!surface) {
+    return nullptr;
+  }
+
+  auto page = std::make_shared<RasterCacheAtlasPage>(
+      std::move(surface), context, sk_ref_sp(color_space));
+  if (!page->Allocate(size, region)) {
+    return nullptr;
+  }
+  pages_.push_back(page);
+  return page;
+}
+
+bool RasterCacheAtlas::HasRoomFor(GrDirectContext* context,
+                                  SkColorSpace* color_space,
+                                  const SkISize& size) const {
+  for (const auto& page : pages_) {
+    if (page->IsCompatible(context, color_space) && page->HasRoomFor(size)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void RasterCacheAtlas::RemoveEmptyPages(size_t pages_to_keep) {
+  size_t kept_empty_pages = 0;
+  auto it = pages_.begin();
+  while (it != pages_.end()) {
+    if ((*it)->is_empty()) {
+      if (kept_empty_pages >= pages_to_keep) {
+        it = pages_.erase(it);
+        continue;
+      }
+      kept_empty_pages++;
+    }
+    ++it;
+  }
+}
+
+size_t RasterCacheAtlas::page_bytes() const {
+  return SkImageInfo::MakeN32Premul(page_size_, page_size_)
+      .computeMinByteSize();
+}
+
+void RasterCacheAtlas::Clear() {
+  pages_.clear();
+}
+
+}  // namespace flutter
@@ -0,0 +1,161 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FLUTTER_FLOW_RASTER_CACHE_ATLAS_H_
+#define FLUTTER_FLOW_RASTER_CACHE_ATLAS_H_
+
+#include <memory>
+#include <vector>
+
+#include "flutter/fml/macros.h"
+#include "third_party/skia/include/core/SkColorSpace.h"
+#include "third_party/skia/include/core/SkImage.h"
+#include "third_party/skia/include/core/SkRect.h"
+#include "third_party/skia/include/core/SkSurface.h"
+
+class GrDirectContext;
+
+namespace flutter {
+
+// Packs rectangles into a fixed size area using horizontal shelves.
+//
+// Each shelf is as tall as the first rectangle placed on it and rectangles
+// are placed left to right. A rectangle goes on the shortest shelf it fits
+// on, and a new shelf is opened below the last one when none fit. Space is
+// only reclaimed all at once by Reset, which suits cache pages whose entries
+// tend to expire together.
+class RasterCacheAtlasPacker {
+ public:
+  RasterCacheAtlasPacker(int width, int height);
+
+  // Finds room for a rectangle of |size| and returns its location in
+  // |result|. Returns false if there is no room left.
+  bool Pack(const SkISize& size, SkIRect* result);
+
+  // Whether Pack would find room for a rectangle of |size|.
+  bool HasRoomFor(const SkISize& size) const;
+
+  void Reset();
+
+  bool is_empty() const { return shelves_.empty(); }
+
+ private:
+  struct Shelf {
+    int top;
+    int height;
+    int used_width;
+  };
+
+  // Returns the index of the shelf a rectangle of |size| goes on, which is
+  // the number of shelves if a new one has to be opened, or -1 if there is no
+  // room left.
+  int FindShelf(const SkISize& size) const;
+
+  const int width_;
+  const int height_;
+  std::vector<Shelf> shelves_;
+
+  FML_DISALLOW_COPY_AND_ASSIGN(RasterCacheAtlasPacker);
+};
+
+// A single surface shared by many small raster cache entries.
+class RasterCacheAtlasPage {
+ public:
+  RasterCacheAtlasPage(sk_sp<SkSurface> surface,
+                       GrDirectContext* context,
+                       sk_sp<SkColorSpace> color_space);
+
+  bool IsCompatible(GrDirectContext* context,
+                    SkColorSpace* color_space) const;
+
+  // Reserves a region of |size| pixels, or returns false if the page is full.
+  bool Allocate(const SkISize& size, SkIRect* region);
+
+  // Whether Allocate would find room for a region of |size| pixels.
+  bool HasRoomFor(const SkISize& size) const;
+
+  // Returns a region obtained from Allocate to the page. Once every region
+  // has been released the whole page becomes available again.
+  void Release();
+
+  bool is_empty() const { return live_regions_ == 0; }
+
+  // Returns a canvas for drawing into |region|. The region is cleared and
+  // clipped, and the canvas is translated so that the origin is at the top
+  // left corner of the region.
+  SkCanvas* BeginDrawing(const SkIRect& region);
+  void EndDrawing();
+
+  // The current contents of the page.
+  const sk_sp<SkImage>& image();
+
+ private:
+  sk_sp<SkSurface> surface_;
+  GrDirectContext* context_;
+  sk_sp<SkColorSpace> color_space_;
+  RasterCacheAtlasPacker packer_;
+  size_t live_regions_ = 0;
+  // A snapshot of |surface_| that is kept until the surface is drawn into
+  // again, so that all the entries drawn in a frame share one image.
+  sk_sp<SkImage> image_;
+
+  FML_DISALLOW_COPY_AND_ASSIGN(RasterCacheAtlasPage);
+};
+
+// Allocates regions of shared pages for raster cache entries that are small
+// enough to be packed together, so that they do not each need a surface of
+// their own and so that consecutive draws of cached entries sample from the
+// same texture, which lets the GPU backend batch them.
+class RasterCacheAtlas {
+ public:
+  static constexpr int kDefaultPageSize = 1024;
+  static constexpr int kDefaultMaxEntrySize = 256;
+
+  explicit RasterCacheAtlas(int page_size = kDefaultPageSize,
+                            int max_entry_size = kDefaultMaxEntrySize);
+
+  // Whether an image of |size| pixels should be placed in the atlas.
+  bool CanPack(const SkISize& size) const;
+
+  // Reserves a region of |size| pixels in a page created with |context|, or
+  // a raster page if |context| is null. Returns nullptr if no page could be
+  // allocated.
+  std::shared_ptr<RasterCacheAtlasPage> Allocate(GrDirectContext* context,
+                                                 SkColorSpace* color_space,
+                                                 const SkISize& size,
+                                                 SkIRect* region);
+
+  // Whether Allocate would place a region of |size| pixels in an existing
+  // page rather than add a page.
+  bool HasRoomFor(GrDirectContext* context,
+                  SkColorSpace* color_space,
+                  const SkISize& size) const;
+
+  // Frees the pages that no longer hold any entries, keeping up to
+  // |pages_to_keep| of them around for the entries of the next frames.
+  void RemoveEmptyPages(size_t pages_to_keep = 1);
+
+  // Drops the references of the atlas to its pages. Pages that still hold
+  // entries are released once those entries are.
+  void Clear();
+
+  size_t page_count() const { return pages_.size(); }
+
+  // The memory used by each page, whether or not it holds any entries.
+  size_t page_bytes() const;
+
+  // The memory used by all the pages of the atlas.
+  size_t GetByteSize() const { return pages_.size() * page_bytes(); }
+
+ private:
+  const int page_size_;
+  const int max_entry_size_;
+  std::vector<std::shared_ptr<RasterCacheAtlasPage>> pages_;
+
+  FML_DISALLOW_COPY_AND_ASSIGN(RasterCacheAtlas);
+};
+
+}  // namespace flutter
+
+#endif  // FLUTTER_FLOW_RASTER_CACHE_ATLAS_H_
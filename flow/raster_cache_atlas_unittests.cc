@@ -0,0 +1,135 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/flow/raster_cache_atlas.h"
+
+#include "gtest/gtest.h"
+#include "third_party/skia/include/core/SkBitmap.h"
+#include "third_party/skia/include/core/SkCanvas.h"
+
+namespace flutter {
+namespace testing {
+
+TEST(RasterCacheAtlasPacker, PacksRectanglesOnShelves) {
+  RasterCacheAtlasPacker packer(100, 100);
+  SkIRect result;
+
+  ASSERT_TRUE(packer.Pack(SkISize::Make(60, 20), &result));
+  ASSERT_EQ(result, SkIRect::MakeXYWH(0, 0, 60, 20));
+
+  // Fits next to the first rectangle on the same shelf.
+  ASSERT_TRUE(packer.Pack(SkISize::Make(40, 10), &result));
+  ASSERT_EQ(result, SkIRect::MakeXYWH(60, 0, 40, 10));
+
+  // Too tall for the first shelf, so a second one is opened.
+  ASSERT_TRUE(packer.Pack(SkISize::Make(30, 50), &result));
+  ASSERT_EQ(result, SkIRect::MakeXYWH(0, 20, 30, 50));
+
+  // Goes on the shortest shelf with room for it.
+  ASSERT_TRUE(packer.Pack(SkISize::Make(10, 10), &result));
+  ASSERT_EQ(result, SkIRect::MakeXYWH(30, 20, 10, 10));
+}
+
+TEST(RasterCacheAtlasPacker, FailsWhenFullAndReusesSpaceAfterReset) {
+  RasterCacheAtlasPacker packer(100, 100);
+  SkIRect result;
+
+  ASSERT_TRUE(packer.Pack(SkISize::Make(100, 60), &result));
+  ASSERT_TRUE(packer.HasRoomFor(SkISize::Make(10, 40)));
+  ASSERT_FALSE(packer.HasRoomFor(SkISize::Make(10, 50)));
+  ASSERT_FALSE(packer.Pack(SkISize::Make(10, 50), &result));
+  ASSERT_FALSE(packer.Pack(SkISize::Make(101, 1), &result));
+  ASSERT_FALSE(packer.Pack(SkISize::Make(0, 0), &result));
+
+  packer.Reset();
+  ASSERT_TRUE(packer.is_empty());
+  ASSERT_TRUE(packer.Pack(SkISize::Make(10, 50), &result));
+  ASSERT_EQ(result, SkIRect::MakeXYWH(0, 0, 10, 50));
+}
+
+TEST(RasterCacheAtlas, SmallImagesShareAPage) {
+  RasterCacheAtlas atlas(256, 64);
+  sk_sp<SkColorSpace> srgb = SkColorSpace::MakeSRGB();
+
+  ASSERT_TRUE(atlas.CanPack(SkISize::Make(64, 64)));
+  ASSERT_FALSE(atlas.CanPack(SkISize::Make(65, 10)));
+  ASSERT_FALSE(atlas.CanPack(SkISize::Make(0, 10)));
+
+  SkIRect region1;
+  SkIRect region2;
+  auto page1 =
+      atlas.Allocate(nullptr, srgb.get(), SkISize::Make(32, 32), &region1);
+  auto page2 =
+      atlas.Allocate(nullptr, srgb.get(), SkISize::Make(32, 32), &region2);
+  ASSERT_NE(page1, nullptr);
+  ASSERT_EQ(page1, page2);
+  ASSERT_EQ(atlas.page_count(), 1u);
+  ASSERT_FALSE(SkIRect::Intersects(region1, region2));
+  ASSERT_EQ(atlas.GetByteSize(), atlas.page_bytes());
+  ASSERT_EQ(atlas.page_bytes(), 256u * 256 * 4);
+  ASSERT_TRUE(atlas.HasRoomFor(nullptr, srgb.get(), SkISize::Make(32, 32)));
+  ASSERT_FALSE(atlas.HasRoomFor(nullptr, nullptr, SkISize::Make(32, 32)));
+
+  // A page with a different color space cannot be shared.
+  SkIRect region3;
+  auto page3 = atlas.Allocate(nullptr, nullptr, SkISize::Make(32, 32),
+                              &region3);
+  ASSERT_NE(page3, page1);
+  ASSERT_EQ(atlas.page_count(), 2u);
+}
+
+TEST(RasterCacheAtlas, EmptyPagesAreRemovedButOneIsKept) {
+  // Only one padded 32x32 region fits in each page.
+  RasterCacheAtlas atlas(64, 32);
+  sk_sp<SkColorSpace> srgb = SkColorSpace::MakeSRGB();
+
+  std::vector<std::shared_ptr<RasterCacheAtlasPage>> pages;
+  for (int i = 0; i < 3; i++) {
+    SkIRect region;
+    pages.push_back(
+        atlas.Allocate(nullptr, srgb.get(), SkISize::Make(32, 32), &region));
+    ASSERT_NE(pages.back(), nullptr);
+  }
+  ASSERT_EQ(atlas.page_count(), 3u);
+
+  for (auto& page : pages) {
+    page->Release();
+    ASSERT_TRUE(page->is_empty());
+  }
+  atlas.RemoveEmptyPages();
+  ASSERT_EQ(atlas.page_count(), 1u);
+  ASSERT_EQ(atlas.GetByteSize(), atlas.page_bytes());
+
+  atlas.RemoveEmptyPages(/*pages_to_keep=*/0);
+  ASSERT_EQ(atlas.page_count(), 0u);
+  ASSERT_EQ(atlas.GetByteSize(), 0u);
+}
+
+TEST(RasterCacheAtlasPage, DrawingIsConfinedToTheRegion) {
+  RasterCacheAtlas atlas(64, 32);
+  sk_sp<SkColorSpace> srgb = SkColorSpace::MakeSRGB();
+
+  SkIRect region;
+  auto page =
+      atlas.Allocate(nullptr, srgb.get(), SkISize::Make(10, 10), &region);
+  ASSERT_NE(page, nullptr);
+
+  SkCanvas* canvas = page->BeginDrawing(region);
+  canvas->drawColor(SK_ColorRED);
+  page->EndDrawing();
+
+  sk_sp<SkImage> image = page->image();
+  ASSERT_NE(image, nullptr);
+  SkBitmap bitmap;
+  ASSERT_TRUE(bitmap.tryAllocPixels(image->imageInfo()));
+  ASSERT_TRUE(image->readPixels(nullptr, bitmap.pixmap(), 0, 0));
+  ASSERT_EQ(bitmap.getColor(region.left(), region.top()), SK_ColorRED);
+  ASSERT_EQ(bitmap.getColor(region.right() - 1, region.bottom() - 1),
+            SK_ColorRED);
+  ASSERT_EQ(bitmap.getColor(region.right(), region.bottom()),
+            SK_ColorTRANSPARENT);
+}
+
+}  // namespace testing
+}  // namespace flutter
@@ -0,0 +1,105 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/flow/raster_cache.h"
+
+#include <vector>
+
+#include "flutter/benchmarking/benchmarking.h"
+#include "flutter/flow/display_list.h"
+#include "third_party/skia/include/core/SkSurface.h"
+
+namespace flutter {
+namespace benchmarking {
+
+static std::vector<sk_sp<DisplayList>> MakeDisplayLists(int count) {
+  std::vector<sk_sp<DisplayList>> display_lists;
+  for (int i = 0; i < count; i++) {
+    DisplayListBuilder builder;
+    for (int j = 0; j < 8; j++) {
+      builder.setColor(0xFF000000 | ((i + j) * 0x102030));
+      builder.drawCircle({16.0f + j, 16.0f + j}, 12);
+    }
+    display_lists.push_back(builder.Build());
+  }
+  return display_lists;
+}
+
+// Runs one frame of the raster cache: every display list is prepared and
+// then drawn from the cache, and the unused entries are swept.
+static void RunFrame(RasterCache& cache,
+                     const std::vector<sk_sp<DisplayList>>& display_lists,
+                     SkCanvas* canvas) {
+  for (auto& display_list : display_lists) {
+    cache.Prepare(nullptr, display_list.get(), SkMatrix::I(), nullptr, true,
+                  false);
+  }
+  for (auto& display_list : display_lists) {
+    cache.Draw(*display_list, *canvas);
+  }
+  cache.SweepAfterFrame();
+}
+
+// Measures frames in which every entry is already cached, which is the
+// steady state of a static scene.
+static void BM_RasterCachePrepareDrawSweep(benchmark::State& state) {
+  auto display_lists = MakeDisplayLists(state.range(0));
+  sk_sp<SkSurface> surface = SkSurface::MakeRasterN32Premul(64, 64);
+  RasterCache cache(3, state.range(0));
+  // Reach the access threshold and rasterize every entry before measuring.
+  for (int i = 0; i < 4; i++) {
+    RunFrame(cache, display_lists, surface->getCanvas());
+  }
+  while (state.KeepRunning()) {
+    RunFrame(cache, display_lists, surface->getCanvas());
+  }
+  state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_RasterCachePrepareDrawSweep)
+    ->RangeMultiplier(4)
+    ->Range(1 << 2, 1 << 8)
+    ->Complexity();
+
+// Measures the frame in which the entries are first rasterized.
+static void BM_RasterCacheRasterize(benchmark::State& state) {
+  auto display_lists = MakeDisplayLists(state.range(0));
+  sk_sp<SkSurface> surface = SkSurface::MakeRasterN32Premul(64, 64);
+  while (state.KeepRunning()) {
+    RasterCache cache(1, state.range(0));
+    {
+      ::benchmarking::ScopedPauseTiming pause(state);
+      RunFrame(cache, display_lists, surface->getCanvas());
+    }
+    RunFrame(cache, display_lists, surface->getCanvas());
+  }
+  state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_RasterCacheRasterize)
+    ->RangeMultiplier(4)
+    ->Range(1 << 2, 1 << 8)
+    ->Complexity();
+
+// Measures the eviction of entries that were not used in the last frame.
+static void BM_RasterCacheSweepUnused(benchmark::State& state) {
+  auto display_lists = MakeDisplayLists(state.range(0));
+  sk_sp<SkSurface> surface = SkSurface::MakeRasterN32Premul(64, 64);
+  while (state.KeepRunning()) {
+    RasterCache cache(1, state.range(0));
+    {
+      ::benchmarking::ScopedPauseTiming pause(state);
+      RunFrame(cache, display_lists, surface->getCanvas());
+      RunFrame(cache, display_lists, surface->getCanvas());
+    }
+    // Nothing is used in this frame, so every entry is evicted.
+    cache.SweepAfterFrame();
+  }
+  state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_RasterCacheSweepUnused)
+    ->RangeMultiplier(4)
+    ->Range(1 << 2, 1 << 8)
+    ->Complexity();
+
+}  // namespace benchmarking
+}  // namespace flutter
@@ -24,6 +24,9 @@ sk_sp<SkPicture> GetSamplePicture() {
   return recorder.finishRecordingAsPicture();
 }
 
+constexpr size_t kAtlasPageBytes = RasterCacheAtlas::kDefaultPageSize *
+                                   RasterCacheAtlas::kDefaultPageSize * 4;
+
 }  // namespace
 
 TEST(RasterCache, SimpleInitialization) {
@@ -132,6 +135,400 @@ TEST(RasterCache, SweepsRemoveUnusedFrames) {
   ASSERT_FALSE(cache.Draw(*picture, dummy_canvas));
 }
 
+TEST(RasterCache, UnusedEntriesAreRetainedForMaxUnusedFrames) {
+  size_t threshold = 1;
+  flutter::RasterCache cache(threshold);
+  cache.SetRetentionPolicy(3, 0);
+
+  SkMatrix matrix = SkMatrix::I();
+
+  auto picture = GetSamplePicture();
+
+  SkCanvas dummy_canvas;
+
+  sk_sp<SkColorSpace> srgb = SkColorSpace::MakeSRGB();
+  ASSERT_FALSE(
+      cache.Prepare(NULL, picture.get(), matrix, srgb.get(), true, false));
+  ASSERT_FALSE(cache.Draw(*picture, dummy_canvas));
+  cache.SweepAfterFrame();
+
+  ASSERT_TRUE(
+      cache.Prepare(NULL, picture.get(), matrix, srgb.get(), true, false));
+  ASSERT_TRUE(cache.Draw(*picture, dummy_canvas));
+  cache.SweepAfterFrame();
+
+  // Two frames without any access are within the retention policy.
+  cache.SweepAfterFrame();
+  cache.SweepAfterFrame();
+  ASSERT_TRUE(cache.Draw(*picture, dummy_canvas));
+  cache.SweepAfterFrame();
+
+  // The third consecutive frame without any access evicts the entry.
+  cache.SweepAfterFrame();
+  cache.SweepAfterFrame();
+  cache.SweepAfterFrame();
+  ASSERT_FALSE(cache.Draw(*picture, dummy_canvas));
+  ASSERT_EQ(cache.GetPictureCachedEntriesCount(), 0u);
+}
+
+TEST(RasterCache, MaxBytesEvictsLeastRecentlyUsedEntries) {
+  size_t threshold = 1;
+  flutter::RasterCache cache(threshold);
+
+  SkMatrix matrix = SkMatrix::I();
+
+  auto picture1 = GetSamplePicture();
+  auto picture2 = GetSamplePicture();
+
+  SkCanvas dummy_canvas;
+
+  // Room for one 150x100 N32 image, but not two.
+  size_t image_bytes = 150 * 100 * 4;
+  cache.SetRetentionPolicy(10, image_bytes * 3 / 2);
+
+  sk_sp<SkColorSpace> srgb = SkColorSpace::MakeSRGB();
+  ASSERT_FALSE(
+      cache.Prepare(NULL, picture1.get(), matrix, srgb.get(), true, false));
+  ASSERT_FALSE(cache.Draw(*picture1, dummy_canvas));
+  cache.SweepAfterFrame();
+
+  ASSERT_TRUE(
+      cache.Prepare(NULL, picture1.get(), matrix, srgb.get(), true, false));
+  ASSERT_TRUE(cache.Draw(*picture1, dummy_canvas));
+  ASSERT_EQ(cache.EstimatePictureCacheByteSize(), image_bytes);
+  cache.SweepAfterFrame();
+
+  ASSERT_FALSE(
+      cache.Prepare(NULL, picture2.get(), matrix, srgb.get(), true, false));
+  ASSERT_FALSE(cache.Draw(*picture2, dummy_canvas));
+  cache.SweepAfterFrame();
+
+  // picture1 went unused in the previous frame so it is evicted to make room.
+  ASSERT_TRUE(
+      cache.Prepare(NULL, picture2.get(), matrix, srgb.get(), true, false));
+  ASSERT_TRUE(cache.Draw(*picture2, dummy_canvas));
+  ASSERT_FALSE(cache.Draw(*picture1, dummy_canvas));
+  ASSERT_EQ(cache.EstimatePictureCacheByteSize(), image_bytes);
+}
+
+TEST(RasterCache, MaxBytesDoesNotEvictEntriesInUse) {
+  size_t threshold = 1;
+  flutter::RasterCache cache(threshold);
+
+  SkMatrix matrix = SkMatrix::I();
+
+  auto picture1 = GetSamplePicture();
+  auto picture2 = GetSamplePicture();
+
+  SkCanvas dummy_canvas;
+
+  size_t image_bytes = 150 * 100 * 4;
+  cache.SetRetentionPolicy(10, image_bytes * 3 / 2);
+
+  sk_sp<SkColorSpace> srgb = SkColorSpace::MakeSRGB();
+  ASSERT_FALSE(
+      cache.Prepare(NULL, picture1.get(), matrix, srgb.get(), true, false));
+  ASSERT_FALSE(cache.Draw(*picture1, dummy_canvas));
+  ASSERT_FALSE(
+      cache.Prepare(NULL, picture2.get(), matrix, srgb.get(), true, false));
+  ASSERT_FALSE(cache.Draw(*picture2, dummy_canvas));
+  cache.SweepAfterFrame();
+
+  // Only one of the two images fits within the budget.
+  ASSERT_TRUE(
+      cache.Prepare(NULL, picture1.get(), matrix, srgb.get(), true, false));
+  ASSERT_TRUE(cache.Draw(*picture1, dummy_canvas));
+  ASSERT_FALSE(
+      cache.Prepare(NULL, picture2.get(), matrix, srgb.get(), true, false));
+  ASSERT_FALSE(cache.Draw(*picture2, dummy_canvas));
+  ASSERT_TRUE(cache.Draw(*picture1, dummy_canvas));
+}
+
+TEST(RasterCache, MaxBytesKeepsEntriesUsedInThePreviousFrame) {
+  size_t threshold = 1;
+  flutter::RasterCache cache(threshold);
+
+  SkMatrix matrix = SkMatrix::I();
+
+  auto picture1 = GetSamplePicture();
+  auto picture2 = GetSamplePicture();
+
+  SkCanvas dummy_canvas;
+
+  size_t image_bytes = 150 * 100 * 4;
+  cache.SetRetentionPolicy(10, image_bytes * 3 / 2);
+
+  sk_sp<SkColorSpace> srgb = SkColorSpace::MakeSRGB();
+  ASSERT_FALSE(
+      cache.Prepare(NULL, picture1.get(), matrix, srgb.get(), true, false));
+  ASSERT_FALSE(
+      cache.Prepare(NULL, picture2.get(), matrix, srgb.get(), true, false));
+  cache.SweepAfterFrame();
+
+  ASSERT_TRUE(
+      cache.Prepare(NULL, picture1.get(), matrix, srgb.get(), true, false));
+  cache.SweepAfterFrame();
+
+  // picture1 is not used in this frame but was used in the previous one, so
+  // it is kept and picture2 does not fit.
+  ASSERT_FALSE(
+      cache.Prepare(NULL, picture2.get(), matrix, srgb.get(), true, false));
+  ASSERT_EQ(cache.EstimatePictureCacheByteSize(), image_bytes);
+  cache.SweepAfterFrame();
+
+  // picture1 has now been unused for exactly one frame, so it is evicted.
+  ASSERT_TRUE(
+      cache.Prepare(NULL, picture2.get(), matrix, srgb.get(), true, false));
+  ASSERT_TRUE(cache.Draw(*picture2, dummy_canvas));
+  ASSERT_FALSE(cache.Draw(*picture1, dummy_canvas));
+}
+
+TEST(RasterCache, AsynchronousRasterizationDefersImageCreation) {
+  size_t threshold = 1;
+  flutter::RasterCache cache(threshold);
+  cache.SetRasterizeAsynchronously(true);
+
+  SkMatrix matrix = SkMatrix::I();
+
+  auto picture = GetSamplePicture();
+
+  SkCanvas dummy_canvas;
+
+  sk_sp<SkColorSpace> srgb = SkColorSpace::MakeSRGB();
+  ASSERT_FALSE(
+      cache.Prepare(NULL, picture.get(), matrix, srgb.get(), true, false));
+  ASSERT_FALSE(cache.Draw(*picture, dummy_canvas));
+  ASSERT_FALSE(cache.HasPendingRasterizations());
+  cache.SweepAfterFrame();
+
+  // The picture is scheduled for rasterization instead of being rasterized.
+  ASSERT_FALSE(
+      cache.Prepare(NULL, picture.get(), matrix, srgb.get(), true, false));
+  ASSERT_FALSE(cache.Draw(*picture, dummy_canvas));
+  ASSERT_TRUE(cache.HasPendingRasterizations());
+  cache.SweepAfterFrame();
+
+  cache.RasterizePendingEntries(NULL, fml::TimeDelta::FromMilliseconds(100));
+  ASSERT_FALSE(cache.HasPendingRasterizations());
+
+  ASSERT_TRUE(
+      cache.Prepare(NULL, picture.get(), matrix, srgb.get(), true, false));
+  ASSERT_TRUE(cache.Draw(*picture, dummy_canvas));
+}
+
+TEST(RasterCache, SweepDropsPendingRasterizationsOfSweptEntries) {
+  size_t threshold = 1;
+  flutter::RasterCache cache(threshold);
+  cache.SetRasterizeAsynchronously(true);
+
+  SkMatrix matrix = SkMatrix::I();
+
+  auto picture = GetSamplePicture();
+
+  sk_sp<SkColorSpace> srgb = SkColorSpace::MakeSRGB();
+  ASSERT_FALSE(
+      cache.Prepare(NULL, picture.get(), matrix, srgb.get(), true, false));
+  cache.SweepAfterFrame();
+  ASSERT_FALSE(
+      cache.Prepare(NULL, picture.get(), matrix, srgb.get(), true, false));
+  ASSERT_TRUE(cache.HasPendingRasterizations());
+  cache.SweepAfterFrame();
+  ASSERT_TRUE(cache.HasPendingRasterizations());
+
+  // The entry goes unused for a frame and is swept along with its request.
+  cache.SweepAfterFrame();
+  ASSERT_EQ(cache.GetPictureCachedEntriesCount(), 0u);
+  ASSERT_FALSE(cache.HasPendingRasterizations());
+}
+
+TEST(RasterCache, AtlasPacksSmallImagesIntoOnePage) {
+  size_t threshold = 1;
+  flutter::RasterCache cache(threshold);
+  cache.SetUseAtlas(true);
+
+  SkMatrix matrix = SkMatrix::I();
+
+  auto picture1 = GetSamplePicture();
+  auto picture2 = GetSamplePicture();
+
+  SkCanvas dummy_canvas;
+
+  sk_sp<SkColorSpace> srgb = SkColorSpace::MakeSRGB();
+  ASSERT_FALSE(
+      cache.Prepare(NULL, picture1.get(), matrix, srgb.get(), true, false));
+  ASSERT_FALSE(
+      cache.Prepare(NULL, picture2.get(), matrix, srgb.get(), true, false));
+  ASSERT_FALSE(cache.Draw(*picture1, dummy_canvas));
+  ASSERT_FALSE(cache.Draw(*picture2, dummy_canvas));
+  cache.SweepAfterFrame();
+
+  ASSERT_TRUE(
+      cache.Prepare(NULL, picture1.get(), matrix, srgb.get(), true, false));
+  ASSERT_TRUE(
+      cache.Prepare(NULL, picture2.get(), matrix, srgb.get(), true, false));
+  ASSERT_TRUE(cache.Draw(*picture1, dummy_canvas));
+  ASSERT_TRUE(cache.Draw(*picture2, dummy_canvas));
+  ASSERT_EQ(cache.GetAtlasPageCount(), 1u);
+  // The page is counted in full, and only once.
+  ASSERT_EQ(cache.EstimatePictureCacheByteSize(), 0u);
+  ASSERT_EQ(cache.EstimateAtlasByteSize(), kAtlasPageBytes);
+
+  cache.SetUseAtlas(false);
+  ASSERT_EQ(cache.GetAtlasPageCount(), 0u);
+  ASSERT_EQ(cache.GetPictureCachedEntriesCount(), 0u);
+  ASSERT_EQ(cache.EstimateAtlasByteSize(), 0u);
+}
+
+TEST(RasterCache, MaxBytesChargesWholeAtlasPages) {
+  size_t threshold = 1;
+  flutter::RasterCache cache(threshold);
+  cache.SetUseAtlas(true);
+
+  SkMatrix matrix = SkMatrix::I();
+
+  auto picture1 = GetSamplePicture();
+  auto picture2 = GetSamplePicture();
+
+  SkCanvas dummy_canvas;
+
+  // Room for one page, but not two.
+  cache.SetRetentionPolicy(10, kAtlasPageBytes * 3 / 2);
+
+  // The pictures are drawn into different color spaces, so they cannot share
+  // a page.
+  sk_sp<SkColorSpace> srgb = SkColorSpace::MakeSRGB();
+  ASSERT_FALSE(
+      cache.Prepare(NULL, picture1.get(), matrix, srgb.get(), true, false));
+  ASSERT_FALSE(cache.Draw(*picture1, dummy_canvas));
+  cache.SweepAfterFrame();
+
+  ASSERT_TRUE(
+      cache.Prepare(NULL, picture1.get(), matrix, srgb.get(), true, false));
+  ASSERT_TRUE(cache.Draw(*picture1, dummy_canvas));
+  ASSERT_FALSE(
+      cache.Prepare(NULL, picture2.get(), matrix, nullptr, true, false));
+  ASSERT_FALSE(cache.Draw(*picture2, dummy_canvas));
+  cache.SweepAfterFrame();
+
+  // picture1 was used in the previous frame, so its page is kept and there is
+  // no room for a second one.
+  ASSERT_FALSE(
+      cache.Prepare(NULL, picture2.get(), matrix, nullptr, true, false));
+  ASSERT_EQ(cache.GetAtlasPageCount(), 1u);
+  cache.SweepAfterFrame();
+
+  // picture1 has now been unused for a frame, so its page is freed.
+  ASSERT_TRUE(
+      cache.Prepare(NULL, picture2.get(), matrix, nullptr, true, false));
+  ASSERT_TRUE(cache.Draw(*picture2, dummy_canvas));
+  ASSERT_FALSE(cache.Draw(*picture1, dummy_canvas));
+  ASSERT_EQ(cache.GetAtlasPageCount(), 1u);
+  ASSERT_EQ(cache.EstimateAtlasByteSize(), kAtlasPageBytes);
+}
+
+TEST(RasterCache, MaxBytesOnlyEvictsWholeAtlasPages) {
+  size_t threshold = 1;
+  flutter::RasterCache cache(threshold);
+  cache.SetUseAtlas(true);
+
+  SkMatrix matrix = SkMatrix::I();
+
+  auto picture1 = GetSamplePicture();
+  auto picture2 = GetSamplePicture();
+  auto picture3 = GetSamplePicture();
+
+  SkCanvas dummy_canvas;
+
+  cache.SetRetentionPolicy(10, kAtlasPageBytes * 3 / 2);
+
+  sk_sp<SkColorSpace> srgb = SkColorSpace::MakeSRGB();
+  ASSERT_FALSE(
+      cache.Prepare(NULL, picture1.get(), matrix, srgb.get(), true, false));
+  ASSERT_FALSE(cache.Draw(*picture1, dummy_canvas));
+  ASSERT_FALSE(
+      cache.Prepare(NULL, picture3.get(), matrix, srgb.get(), true, false));
+  ASSERT_FALSE(cache.Draw(*picture3, dummy_canvas));
+  ASSERT_FALSE(
+      cache.Prepare(NULL, picture2.get(), matrix, nullptr, true, false));
+  ASSERT_FALSE(cache.Draw(*picture2, dummy_canvas));
+  cache.SweepAfterFrame();
+
+  // picture1 and picture3 share a page.
+  ASSERT_TRUE(
+      cache.Prepare(NULL, picture1.get(), matrix, srgb.get(), true, false));
+  ASSERT_TRUE(
+      cache.Prepare(NULL, picture3.get(), matrix, srgb.get(), true, false));
+  ASSERT_TRUE(cache.Draw(*picture1, dummy_canvas));
+  ASSERT_TRUE(cache.Draw(*picture3, dummy_canvas));
+  ASSERT_EQ(cache.GetAtlasPageCount(), 1u);
+  cache.SweepAfterFrame();
+
+  ASSERT_TRUE(cache.Draw(*picture3, dummy_canvas));
+  cache.SweepAfterFrame();
+
+  // Evicting picture1 would not free its page while picture3 is in use, so
+  // it is kept and picture2 does not fit.
+  ASSERT_TRUE(cache.Draw(*picture3, dummy_canvas));
+  ASSERT_FALSE(
+      cache.Prepare(NULL, picture2.get(), matrix, nullptr, true, false));
+  ASSERT_TRUE(cache.Draw(*picture1, dummy_canvas));
+  ASSERT_EQ(cache.GetAtlasPageCount(), 1u);
+}
+
+TEST(RasterCache, MaxBytesCountsTheEmptyAtlasPageThatIsKept) {
+  size_t threshold = 1;
+  flutter::RasterCache cache(threshold);
+  cache.SetUseAtlas(true);
+
+  SkMatrix matrix = SkMatrix::I();
+
+  auto picture = GetSamplePicture();
+  // Too large for the atlas.
+  SkPictureRecorder recorder;
+  recorder.beginRecording(SkRect::MakeWH(300, 300));
+  SkPaint paint;
+  paint.setColor(SK_ColorRED);
+  recorder.getRecordingCanvas()->drawRect(SkRect::MakeXYWH(10, 10, 280, 280),
+                                          paint);
+  auto large_picture = recorder.finishRecordingAsPicture();
+
+  SkCanvas dummy_canvas;
+
+  size_t large_image_bytes = 300 * 300 * 4;
+  cache.SetRetentionPolicy(1, kAtlasPageBytes + large_image_bytes / 2);
+
+  sk_sp<SkColorSpace> srgb = SkColorSpace::MakeSRGB();
+  ASSERT_FALSE(
+      cache.Prepare(NULL, picture.get(), matrix, srgb.get(), true, false));
+  ASSERT_FALSE(cache.Draw(*picture, dummy_canvas));
+  cache.SweepAfterFrame();
+
+  ASSERT_TRUE(
+      cache.Prepare(NULL, picture.get(), matrix, srgb.get(), true, false));
+  ASSERT_TRUE(cache.Draw(*picture, dummy_canvas));
+  ASSERT_FALSE(cache.Prepare(NULL, large_picture.get(), matrix, srgb.get(),
+                             true, false));
+  ASSERT_FALSE(cache.Draw(*large_picture, dummy_canvas));
+  cache.SweepAfterFrame();
+
+  ASSERT_FALSE(cache.Draw(*large_picture, dummy_canvas));
+  cache.SweepAfterFrame();
+
+  // The entry of picture is swept, but its page is kept for the next entries
+  // and still counts.
+  ASSERT_EQ(cache.GetPictureCachedEntriesCount(), 1u);
+  ASSERT_EQ(cache.GetAtlasPageCount(), 1u);
+  ASSERT_EQ(cache.EstimateAtlasByteSize(), kAtlasPageBytes);
+
+  // The empty page is freed to make room for an image that does not go into
+  // the atlas.
+  ASSERT_TRUE(cache.Prepare(NULL, large_picture.get(), matrix, srgb.get(),
+                            true, false));
+  ASSERT_EQ(cache.GetAtlasPageCount(), 0u);
+  ASSERT_EQ(cache.EstimateAtlasByteSize(), 0u);
+  ASSERT_EQ(cache.EstimatePictureCacheByteSize(), large_image_bytes);
+}
+
 // Construct a cache result whose device target rectangle rounds out to be one
 // pixel wider than the cached image.  Verify that it can be drawn without
 // triggering any assertions.
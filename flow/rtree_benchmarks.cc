@@ -0,0 +1,62 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/flow/rtree.h"
+
+#include <vector>
+
+#include "flutter/benchmarking/benchmarking.h"
+
+namespace flutter {
+namespace benchmarking {
+
+// Builds a tree of |count| 40x40 rects laid out on a grid that is 25 rects
+// wide, with every rect marked as a drawing operation.
+static sk_sp<RTree> MakeGridTree(int count) {
+  std::vector<SkRect> rects;
+  std::vector<SkBBoxHierarchy::Metadata> metadata;
+  for (int i = 0; i < count; i++) {
+    SkScalar x = (i % 25) * 40;
+    SkScalar y = (i / 25) * 40;
+    rects.push_back(SkRect::MakeXYWH(x, y, 40, 40));
+    metadata.push_back({true});
+  }
+  sk_sp<RTree> rtree = sk_make_sp<RTree>();
+  rtree->insert(rects.data(), metadata.data(), count);
+  return rtree;
+}
+
+static void BM_RTreeSearch(benchmark::State& state) {
+  sk_sp<RTree> rtree = MakeGridTree(state.range(0));
+  std::vector<int> results;
+  int query = 0;
+  while (state.KeepRunning()) {
+    // Slide a screen sized query over the grid.
+    SkScalar y = (query++ % 64) * 40;
+    results.clear();
+    rtree->search(SkRect::MakeXYWH(0, y, 1000, 800), &results);
+    benchmark::DoNotOptimize(results.data());
+  }
+  state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_RTreeSearch)
+    ->RangeMultiplier(4)
+    ->Range(1 << 6, 1 << 14)
+    ->Complexity();
+
+static void BM_RTreeSearchNonOverlappingDrawnRects(benchmark::State& state) {
+  sk_sp<RTree> rtree = MakeGridTree(state.range(0));
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(rtree->searchNonOverlappingDrawnRects(
+        SkRect::MakeXYWH(100, 100, 400, 400)));
+  }
+  state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_RTreeSearchNonOverlappingDrawnRects)
+    ->RangeMultiplier(4)
+    ->Range(1 << 6, 1 << 14)
+    ->Complexity();
+
+}  // namespace benchmarking
+}  // namespace flutter
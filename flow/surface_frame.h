@@ -6,6 +6,7 @@
 #define FLUTTER_FLOW_SURFACE_FRAME_H_
 
 #include <memory>
+#include <optional>
 
 #include "flutter/common/graphics/gl_context_switch.h"
 #include "flutter/fml/macros.h"
@@ -21,6 +22,32 @@ class SurfaceFrame {
   using SubmitCallback =
       std::function<bool(const SurfaceFrame& surface_frame, SkCanvas* canvas)>;
 
+  // Information about the buffer backing the frame, provided by the surface.
+  struct FramebufferInfo {
+    // Whether the surface can repaint and present only the part of the frame
+    // that changed since the previous frame.
+    bool supports_partial_repaint = false;
+
+    // The area of the buffer that is out of date relative to the frame that
+    // was presented last, in device pixels. For a buffer that was presented
+    // in the previous frame this is empty. If the contents of the buffer are
+    // unknown, for example because it was just allocated, this is not set
+    // and the whole frame is repainted.
+    std::optional<SkIRect> existing_damage;
+  };
+
+  // Information about the painted frame, provided to the surface on submit.
+  struct SubmitInfo {
+    // The area of the frame that changed since the previous frame, in device
+    // pixels. Not set if the whole frame must be presented.
+    std::optional<SkIRect> frame_damage;
+
+    // The area of the buffer that was painted, in device pixels. This is the
+    // frame damage plus the existing damage of the buffer. Not set if the
+    // whole buffer was painted.
+    std::optional<SkIRect> buffer_damage;
+  };
+
   SurfaceFrame(sk_sp<SkSurface> surface,
                bool supports_readback,
                const SubmitCallback& submit_callback);
@@ -42,10 +69,22 @@ class SurfaceFrame {
 
   bool supports_readback() { return supports_readback_; }
 
+  void set_framebuffer_info(const FramebufferInfo& framebuffer_info) {
+    framebuffer_info_ = framebuffer_info;
+  }
+  const FramebufferInfo& framebuffer_info() const { return framebuffer_info_; }
+
+  void set_submit_info(const SubmitInfo& submit_info) {
+    submit_info_ = submit_info;
+  }
+  const SubmitInfo& submit_info() const { return submit_info_; }
+
  private:
   bool submitted_ = false;
   sk_sp<SkSurface> surface_;
   bool supports_readback_;
+  FramebufferInfo framebuffer_info_;
+  SubmitInfo submit_info_;
   SubmitCallback submit_callback_;
   std::unique_ptr<GLContextResult> context_result_;
 
@@ -0,0 +1,135 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/fml/async_file.h"
+
+#include <algorithm>
+#include <thread>
+
+#include "flutter/fml/concurrent_message_loop.h"
+#include "flutter/fml/file.h"
+#include "flutter/fml/trace_event.h"
+
+namespace fml {
+
+namespace {
+
+// Reading blocks on the disk rather than the CPU, so there can be more
+// threads than cores, but flash storage does not benefit from many more
+// requests in flight than this.
+constexpr size_t kMaxIOThreads = 4;
+
+std::shared_ptr<ConcurrentTaskRunner> GetIOTaskRunner() {
+  // Leaked so that reads may be posted while the process exits.
+  static auto* loop = new std::shared_ptr<ConcurrentMessageLoop>(
+      ConcurrentMessageLoop::Create(std::clamp<size_t>(
+          std::thread::hardware_concurrency(), 1, kMaxIOThreads)));
+  return (*loop)->GetTaskRunner();
+}
+
+std::unique_ptr<Mapping> ReadFile(const fml::UniqueFD& file) {
+  TRACE_EVENT0("fml", "ReadFileAsync");
+  if (!file.is_valid()) {
+    return nullptr;
+  }
+  auto mapping = std::make_unique<FileMapping>(file);
+  if (!mapping->IsValid()) {
+    return nullptr;
+  }
+  // Fault the pages in here, so that the caller does not block on the disk
+  // when it first touches them.
+  mapping->Advise(Mapping::Advice::kWillNeed);
+  mapping->Prefault();
+  return mapping;
+}
+
+}  // namespace
+
+void ReadFileAsync(fml::UniqueFD file, ReadFileCallback callback) {
+  GetIOTaskRunner()->PostTask(
+      [file = std::move(file), callback = std::move(callback)]() {
+        callback(ReadFile(file));
+      });
+}
+
+std::future<std::unique_ptr<Mapping>> ReadFileAsync(fml::UniqueFD file) {
+  std::promise<std::unique_ptr<Mapping>> promise;
+  auto future = promise.get_future();
+  ReadFileAsync(std::move(file),
+                [promise = std::move(promise)](
+                    std::unique_ptr<Mapping> mapping) mutable {
+                  promise.set_value(std::move(mapping));
+                });
+  return future;
+}
+
+void ReadFileAsync(const fml::UniqueFD& base_directory,
+                   const char* path,
+                   ReadFileCallback callback) {
+  ReadFileAsync(fml::OpenFileReadOnly(base_directory, path),
+                std::move(callback));
+}
+
+std::future<std::unique_ptr<Mapping>> ReadFileAsync(
+    const fml::UniqueFD& base_directory,
+    const char* path) {
+  return ReadFileAsync(fml::OpenFileReadOnly(base_directory, path));
+}
+
+std::vector<std::unique_ptr<Mapping>> ReadFilesInParallel(
+    const fml::UniqueFD& base_directory,
+    const std::vector<std::string>& paths) {
+  TRACE_EVENT1("fml", "ReadFilesInParallel", "count",
+               std::to_string(paths.size()).c_str());
+  std::vector<std::future<std::unique_ptr<Mapping>>> futures;
+  futures.reserve(paths.size());
+  for (const auto& path : paths) {
+    futures.push_back(ReadFileAsync(base_directory, path.c_str()));
+  }
+  std::vector<std::unique_ptr<Mapping>> mappings;
+  mappings.reserve(paths.size());
+  for (auto& future : futures) {
+    mappings.push_back(future.get());
+  }
+  return mappings;
+}
+
+void PrefaultAsync(std::shared_ptr<const Mapping> mapping,
+                   size_t offset,
+                   size_t length,
+                   fml::UniqueClosure callback) {
+  if (!mapping) {
+    return;
+  }
+  // Readahead starts right away, and the pool waits for it.
+  mapping->Advise(Mapping::Advice::kWillNeed, offset, length);
+  GetIOTaskRunner()->PostTask([mapping = std::move(mapping), offset, length,
+                               callback = std::move(callback)]() {
+    TRACE_EVENT0("fml", "PrefaultAsync");
+    mapping->Prefault(offset, length);
+    if (callback) {
+      callback();
+    }
+  });
+}
+
+void WriteAtomicallyAsync(const fml::UniqueFD& base_directory,
+                          std::string file_name,
+                          std::unique_ptr<Mapping> mapping,
+                          WriteFileCallback callback) {
+  GetIOTaskRunner()->PostTask(
+      [directory = fml::Duplicate(base_directory.get()),
+       file_name = std::move(file_name), mapping = std::move(mapping),
+       callback = std::move(callback)]() {
+        TRACE_EVENT0("fml", "WriteAtomicallyAsync");
+        const bool success =
+            directory.is_valid() && mapping &&
+            fml::WriteAtomically(directory, file_name.c_str(), *mapping);
+        if (callback) {
+          callback(success);
+        }
+      });
+}
+
+}  // namespace fml
@@ -0,0 +1,72 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FLUTTER_FML_ASYNC_FILE_H_
+#define FLUTTER_FML_ASYNC_FILE_H_
+
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "flutter/fml/closure.h"
+#include "flutter/fml/mapping.h"
+#include "flutter/fml/unique_fd.h"
+#include "flutter/fml/unique_function.h"
+
+namespace fml {
+
+//------------------------------------------------------------------------------
+/// Asynchronous counterparts of the file primitives in `flutter/fml/file.h`.
+///
+/// The I/O happens on a small pool of threads shared by the process, so that
+/// many files can be read in parallel without blocking the calling thread on
+/// the disk. Callbacks are invoked on one of the threads of the pool and
+/// should hand the result off to another thread rather than do much work.
+///
+
+using ReadFileCallback = UniqueFunction<void(std::unique_ptr<Mapping>)>;
+
+using WriteFileCallback = UniqueFunction<void(bool)>;
+
+/// Maps `file` and reads its contents into memory. The callback receives
+/// `nullptr` if the file could not be mapped.
+void ReadFileAsync(fml::UniqueFD file, ReadFileCallback callback);
+
+std::future<std::unique_ptr<Mapping>> ReadFileAsync(fml::UniqueFD file);
+
+/// Same as above for the file at `path` relative to `base_directory`, which
+/// only needs to remain valid until this returns.
+void ReadFileAsync(const fml::UniqueFD& base_directory,
+                   const char* path,
+                   ReadFileCallback callback);
+
+std::future<std::unique_ptr<Mapping>> ReadFileAsync(
+    const fml::UniqueFD& base_directory,
+    const char* path);
+
+/// Reads the files at `paths` relative to `base_directory` in parallel and
+/// waits for all of them. The result holds the mappings in the order of
+/// `paths`, with `nullptr` for the files that could not be read.
+std::vector<std::unique_ptr<Mapping>> ReadFilesInParallel(
+    const fml::UniqueFD& base_directory,
+    const std::vector<std::string>& paths);
+
+/// Calls `Mapping::Prefault` on the pool, holding on to the mapping until
+/// the pages are resident, then invokes the optional callback.
+void PrefaultAsync(std::shared_ptr<const Mapping> mapping,
+                   size_t offset = 0,
+                   size_t length = Mapping::kToEnd,
+                   fml::UniqueClosure callback = nullptr);
+
+/// Calls `WriteAtomically` on the pool and reports whether it succeeded.
+/// `base_directory` only needs to remain valid until this returns.
+void WriteAtomicallyAsync(const fml::UniqueFD& base_directory,
+                          std::string file_name,
+                          std::unique_ptr<Mapping> mapping,
+                          WriteFileCallback callback);
+
+}  // namespace fml
+
+#endif  // FLUTTER_FML_ASYNC_FILE_H_
@@ -0,0 +1,94 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/fml/async_file.h"
+
+#include <string>
+#include <vector>
+
+#include "flutter/fml/file.h"
+#include "flutter/fml/synchronization/waitable_event.h"
+#include "gtest/gtest.h"
+
+namespace fml {
+namespace testing {
+
+static std::string ToString(const Mapping& mapping) {
+  return {reinterpret_cast<const char*>(mapping.GetMapping()),
+          mapping.GetSize()};
+}
+
+TEST(AsyncFileTest, ReadsFileWithCallback) {
+  fml::ScopedTemporaryDirectory dir;
+  ASSERT_TRUE(
+      fml::WriteAtomically(dir.fd(), "file", fml::DataMapping("contents")));
+
+  fml::AutoResetWaitableEvent latch;
+  std::unique_ptr<Mapping> mapping;
+  ReadFileAsync(dir.fd(), "file",
+                [&mapping, &latch](std::unique_ptr<Mapping> result) {
+                  mapping = std::move(result);
+                  latch.Signal();
+                });
+  latch.Wait();
+  ASSERT_TRUE(mapping);
+  ASSERT_EQ(ToString(*mapping), "contents");
+}
+
+TEST(AsyncFileTest, ReadsMissingFileAsNull) {
+  fml::ScopedTemporaryDirectory dir;
+  ASSERT_EQ(ReadFileAsync(dir.fd(), "missing").get(), nullptr);
+}
+
+TEST(AsyncFileTest, ReadsFilesInParallelInOrder) {
+  fml::ScopedTemporaryDirectory dir;
+  std::vector<std::string> paths;
+  for (int i = 0; i < 20; i++) {
+    const std::string name = "file_" + std::to_string(i);
+    ASSERT_TRUE(fml::WriteAtomically(dir.fd(), name.c_str(),
+                                     fml::DataMapping(std::string(
+                                         5000 * (i + 1), 'a' + i % 26))));
+    paths.push_back(name);
+  }
+  paths.push_back("missing");
+
+  auto mappings = ReadFilesInParallel(dir.fd(), paths);
+  ASSERT_EQ(mappings.size(), paths.size());
+  for (int i = 0; i < 20; i++) {
+    ASSERT_TRUE(mappings[i]);
+    ASSERT_EQ(ToString(*mappings[i]),
+              std::string(5000 * (i + 1), 'a' + i % 26));
+  }
+  ASSERT_EQ(mappings.back(), nullptr);
+}
+
+TEST(AsyncFileTest, WritesFileAtomically) {
+  fml::ScopedTemporaryDirectory dir;
+  fml::AutoResetWaitableEvent latch;
+  bool written = false;
+  WriteAtomicallyAsync(dir.fd(), "file",
+                       std::make_unique<fml::DataMapping>("contents"),
+                       [&written, &latch](bool success) {
+                         written = success;
+                         latch.Signal();
+                       });
+  latch.Wait();
+  ASSERT_TRUE(written);
+  auto mapping = ReadFileAsync(dir.fd(), "file").get();
+  ASSERT_TRUE(mapping);
+  ASSERT_EQ(ToString(*mapping), "contents");
+}
+
+TEST(AsyncFileTest, PrefaultsOnPool) {
+  const std::string contents(100000, 'a');
+  auto mapping = std::make_shared<fml::DataMapping>(contents);
+  fml::AutoResetWaitableEvent latch;
+  PrefaultAsync(mapping, 0, Mapping::kToEnd, [&latch]() { latch.Signal(); });
+  latch.Wait();
+  // The pool is done with the mapping once the callback has run.
+  mapping.reset();
+}
+
+}  // namespace testing
+}  // namespace fml
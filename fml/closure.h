@@ -8,11 +8,16 @@
 #include <functional>
 
 #include "flutter/fml/macros.h"
+#include "flutter/fml/unique_function.h"
 
 namespace fml {
 
 using closure = std::function<void()>;
 
+/// A move-only closure that does not allocate for small captures. Tasks are
+/// posted as these, see \p fml::UniqueFunction.
+using UniqueClosure = UniqueFunction<void()>;
+
 //------------------------------------------------------------------------------
 /// @brief      Wraps a closure that is invoked in the destructor unless
 ///             released by the caller.
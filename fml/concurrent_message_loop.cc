@@ -7,10 +7,22 @@
 #include <algorithm>
 
 #include "flutter/fml/thread.h"
+#include "flutter/fml/thread_local.h"
 #include "flutter/fml/trace_event.h"
 
 namespace fml {
 
+namespace {
+
+struct CurrentWorker {
+  const ConcurrentMessageLoop* loop;
+  size_t index;
+};
+
+}  // namespace
+
+FML_THREAD_LOCAL ThreadLocalUniquePtr<CurrentWorker> tls_current_worker;
+
 std::shared_ptr<ConcurrentMessageLoop> ConcurrentMessageLoop::Create(
     size_t worker_count) {
   return std::shared_ptr<ConcurrentMessageLoop>{
@@ -19,11 +31,15 @@ std::shared_ptr<ConcurrentMessageLoop> ConcurrentMessageLoop::Create(
 
 ConcurrentMessageLoop::ConcurrentMessageLoop(size_t worker_count)
     : worker_count_(std::max<size_t>(worker_count, 1ul)) {
+  for (size_t i = 0; i < worker_count_; ++i) {
+    worker_tasks_.emplace_back(std::make_unique<WorkerTasks>());
+  }
+
   for (size_t i = 0; i < worker_count_; ++i) {
     workers_.emplace_back([i, this]() {
       fml::Thread::SetCurrentThreadName(
           std::string{"io.worker." + std::to_string(i + 1)});
-      WorkerMain();
+      WorkerMain(i);
     });
   }
 
@@ -47,24 +63,63 @@ std::shared_ptr<ConcurrentTaskRunner> ConcurrentMessageLoop::GetTaskRunner() {
   return std::make_shared<ConcurrentTaskRunner>(weak_from_this());
 }
 
-void ConcurrentMessageLoop::PostTask(const fml::closure& task) {
-  if (!task) {
+void ConcurrentMessageLoop::PostTask(fml::UniqueClosure task) {
+  if (!task || RunIfShutDown(task)) {
     return;
   }
 
-  std::unique_lock lock(tasks_mutex_);
+  // Keep the tasks posted by a worker on that worker, they are likely to
+  // work on the same data as the task that posts them.
+  const CurrentWorker* current_worker = tls_current_worker.get();
+  const size_t worker_index = current_worker && current_worker->loop == this
+                                  ? current_worker->index
+                                  : next_worker_++ % worker_count_;
+  {
+    WorkerTasks& worker = *worker_tasks_[worker_index];
+    std::scoped_lock lock(worker.mutex);
+    worker.tasks.push_back(std::move(task));
+    pending_task_count_++;
+  }
+
+  WakeUpIdleWorker();
+}
+
+void ConcurrentMessageLoop::PostHighPriorityTask(fml::UniqueClosure task) {
+  if (!task || RunIfShutDown(task)) {
+    return;
+  }
+
+  {
+    std::scoped_lock lock(priority_tasks_mutex_);
+    priority_tasks_.push_back(std::move(task));
+    priority_task_count_++;
+    pending_task_count_++;
+  }
 
+  WakeUpIdleWorker();
+}
+
+bool ConcurrentMessageLoop::RunIfShutDown(const fml::UniqueClosure& task) {
   // Don't just drop tasks on the floor in case of shutdown.
-  if (shutdown_) {
-    FML_DLOG(WARNING)
-        << "Tried to post a task to shutdown concurrent message "
-           "loop. The task will be executed on the callers thread.";
-    lock.unlock();
-    task();
+  if (!shutdown_) {
+    return false;
+  }
+  FML_DLOG(WARNING) << "Tried to post a task to shutdown concurrent message "
+                       "loop. The task will be executed on the callers thread.";
+  task();
+  return true;
+}
+
+void ConcurrentMessageLoop::WakeUpIdleWorker() {
+  // Workers count themselves as idle before they check for pending tasks, so
+  // either the new task is seen by the worker or the worker is seen here.
+  if (idle_worker_count_ == 0) {
     return;
   }
 
-  tasks_.push(task);
+  // The mutex is held by the idle worker until it waits on the condition
+  // variable, acquiring it ensures the notification is not missed.
+  std::unique_lock lock(tasks_mutex_);
 
   // Unlock the mutex before notifying the condition variable because that mutex
   // has to be acquired on the other thread anyway. Waiting in this scope till
@@ -74,47 +129,88 @@ void ConcurrentMessageLoop::PostTask(const fml::closure& task) {
   tasks_condition_.notify_one();
 }
 
-void ConcurrentMessageLoop::WorkerMain() {
-  while (true) {
-    std::unique_lock lock(tasks_mutex_);
-    tasks_condition_.wait(lock, [&]() {
-      return tasks_.size() > 0 || shutdown_ || HasThreadTasksLocked();
-    });
-
-    // Shutdown cannot be read with the task mutex unlocked.
-    bool shutdown_now = shutdown_;
-    fml::closure task;
-    std::vector<fml::closure> thread_tasks;
+fml::UniqueClosure ConcurrentMessageLoop::TakeTask(size_t worker_index) {
+  if (pending_task_count_ == 0) {
+    return nullptr;
+  }
 
-    if (tasks_.size() != 0) {
-      task = tasks_.front();
-      tasks_.pop();
+  fml::UniqueClosure task;
+  if (priority_task_count_ > 0) {
+    std::scoped_lock lock(priority_tasks_mutex_);
+    if (!priority_tasks_.empty()) {
+      task = std::move(priority_tasks_.front());
+      priority_tasks_.pop_front();
+      priority_task_count_--;
+      pending_task_count_--;
+      return task;
     }
+  }
 
-    if (HasThreadTasksLocked()) {
-      thread_tasks = GetThreadTasksLocked();
-      FML_DCHECK(!HasThreadTasksLocked());
+  // Take the oldest task of this worker, or steal the oldest task of the
+  // next worker that has one.
+  for (size_t i = 0; i < worker_count_; ++i) {
+    WorkerTasks& worker = *worker_tasks_[(worker_index + i) % worker_count_];
+    std::scoped_lock lock(worker.mutex);
+    if (worker.tasks.empty()) {
+      continue;
     }
+    task = std::move(worker.tasks.front());
+    worker.tasks.pop_front();
+    pending_task_count_--;
+    return task;
+  }
+
+  return nullptr;
+}
+
+void ConcurrentMessageLoop::WorkerMain(size_t worker_index) {
+  tls_current_worker.reset(new CurrentWorker{this, worker_index});
 
-    // Don't hold onto the mutex while tasks are being executed as they could
-    // themselves try to post more tasks to the message loop.
-    lock.unlock();
+  while (true) {
+    fml::UniqueClosure task = TakeTask(worker_index);
+    bool shutdown_now = false;
+    std::vector<fml::closure> thread_tasks;
 
-    TRACE_EVENT0("flutter", "ConcurrentWorkerWake");
-    // Execute the primary task we woke up for.
-    if (task) {
-      task();
+    if (!task || thread_task_count_ > 0 || shutdown_) {
+      std::unique_lock lock(tasks_mutex_);
+      if (!task) {
+        idle_worker_count_++;
+        tasks_condition_.wait(lock, [&]() {
+          return pending_task_count_ > 0 || shutdown_ || HasThreadTasksLocked();
+        });
+        idle_worker_count_--;
+      }
+
+      shutdown_now = shutdown_;
+
+      if (HasThreadTasksLocked()) {
+        thread_tasks = GetThreadTasksLocked();
+        FML_DCHECK(!HasThreadTasksLocked());
+      }
+
+      // Don't hold onto the mutex while tasks are being executed as they
+      // could themselves try to post more tasks to the message loop.
     }
 
-    // Execute any thread tasks.
-    for (const auto& thread_task : thread_tasks) {
-      thread_task();
+    if (task || !thread_tasks.empty()) {
+      TRACE_EVENT0("flutter", "ConcurrentWorkerWake");
+      // Execute the primary task we woke up for.
+      if (task) {
+        task();
+      }
+
+      // Execute any thread tasks.
+      for (const auto& thread_task : thread_tasks) {
+        thread_task();
+      }
     }
 
     if (shutdown_now) {
       break;
     }
   }
+
+  tls_current_worker.reset(nullptr);
 }
 
 void ConcurrentMessageLoop::Terminate() {
@@ -132,6 +228,7 @@ void ConcurrentMessageLoop::PostTaskToAllWorkers(fml::closure task) {
   for (const auto& worker_thread_id : worker_thread_ids_) {
     thread_tasks_[worker_thread_id].emplace_back(task);
   }
+  thread_task_count_ = thread_tasks_.size();
   tasks_condition_.notify_all();
 }
 
@@ -145,6 +242,7 @@ std::vector<fml::closure> ConcurrentMessageLoop::GetThreadTasksLocked() {
   std::vector<fml::closure> pending_tasks;
   std::swap(pending_tasks, found->second);
   thread_tasks_.erase(found);
+  thread_task_count_ = thread_tasks_.size();
   return pending_tasks;
 }
 
@@ -154,13 +252,29 @@ ConcurrentTaskRunner::ConcurrentTaskRunner(
 
 ConcurrentTaskRunner::~ConcurrentTaskRunner() = default;
 
-void ConcurrentTaskRunner::PostTask(const fml::closure& task) {
+void ConcurrentTaskRunner::PostTask(fml::UniqueClosure task) {
+  if (!task) {
+    return;
+  }
+
+  if (auto loop = weak_loop_.lock()) {
+    loop->PostTask(std::move(task));
+    return;
+  }
+
+  FML_DLOG(WARNING)
+      << "Tried to post to a concurrent message loop that has already died. "
+         "Executing the task on the callers thread.";
+  task();
+}
+
+void ConcurrentTaskRunner::PostHighPriorityTask(fml::UniqueClosure task) {
   if (!task) {
     return;
   }
 
   if (auto loop = weak_loop_.lock()) {
-    loop->PostTask(task);
+    loop->PostHighPriorityTask(std::move(task));
     return;
   }
 
@@ -170,4 +284,11 @@ void ConcurrentTaskRunner::PostTask(const fml::closure& task) {
   task();
 }
 
+size_t ConcurrentTaskRunner::GetWorkerCount() const {
+  if (auto loop = weak_loop_.lock()) {
+    return loop->GetWorkerCount();
+  }
+  return 0;
+}
+
 }  // namespace fml
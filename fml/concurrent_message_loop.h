@@ -5,10 +5,14 @@
 #ifndef FLUTTER_FML_CONCURRENT_MESSAGE_LOOP_H_
 #define FLUTTER_FML_CONCURRENT_MESSAGE_LOOP_H_
 
+#include <atomic>
 #include <condition_variable>
+#include <deque>
 #include <map>
-#include <queue>
+#include <memory>
+#include <mutex>
 #include <thread>
+#include <vector>
 
 #include "flutter/fml/closure.h"
 #include "flutter/fml/macros.h"
@@ -18,6 +22,13 @@ namespace fml {
 
 class ConcurrentTaskRunner;
 
+/// A pool of worker threads.
+///
+/// Each worker has a deque of its own. Tasks posted from a worker are added
+/// to the deque of that worker, tasks posted from other threads are spread
+/// over the workers. Workers run the tasks of their own deque in order and
+/// steal from the other workers once their own deque is empty. High
+/// priority tasks are kept apart and run before any other task.
 class ConcurrentMessageLoop
     : public std::enable_shared_from_this<ConcurrentMessageLoop> {
  public:
@@ -37,20 +48,45 @@ class ConcurrentMessageLoop
  private:
   friend ConcurrentTaskRunner;
 
+  struct WorkerTasks {
+    std::mutex mutex;
+    std::deque<fml::UniqueClosure> tasks;
+  };
+
   size_t worker_count_ = 0;
   std::vector<std::thread> workers_;
+  std::vector<std::unique_ptr<WorkerTasks>> worker_tasks_;
+  std::mutex priority_tasks_mutex_;
+  std::deque<fml::UniqueClosure> priority_tasks_;
+  std::atomic<size_t> priority_task_count_ = {0};
+  // The number of tasks in all deques, including the high priority tasks.
+  std::atomic<size_t> pending_task_count_ = {0};
+  // The worker that receives the next task posted from outside the pool.
+  std::atomic<size_t> next_worker_ = {0};
+  // The mutex the idle workers wait on. Also guards |thread_tasks_|.
   std::mutex tasks_mutex_;
   std::condition_variable tasks_condition_;
-  std::queue<fml::closure> tasks_;
+  std::atomic<size_t> idle_worker_count_ = {0};
   std::vector<std::thread::id> worker_thread_ids_;
   std::map<std::thread::id, std::vector<fml::closure>> thread_tasks_;
-  bool shutdown_ = false;
+  std::atomic<size_t> thread_task_count_ = {0};
+  std::atomic<bool> shutdown_ = {false};
 
   ConcurrentMessageLoop(size_t worker_count);
 
-  void WorkerMain();
+  void WorkerMain(size_t worker_index);
+
+  void PostTask(fml::UniqueClosure task);
+
+  void PostHighPriorityTask(fml::UniqueClosure task);
+
+  // Runs the task on the calling thread if the loop has been shut down.
+  // Returns true if the task was run.
+  bool RunIfShutDown(const fml::UniqueClosure& task);
 
-  void PostTask(const fml::closure& task);
+  void WakeUpIdleWorker();
+
+  fml::UniqueClosure TakeTask(size_t worker_index);
 
   bool HasThreadTasksLocked() const;
 
@@ -65,7 +101,14 @@ class ConcurrentTaskRunner : public BasicTaskRunner {
 
   virtual ~ConcurrentTaskRunner();
 
-  void PostTask(const fml::closure& task) override;
+  void PostTask(fml::UniqueClosure task) override;
+
+  /// Posts a task that runs ahead of the tasks posted with |PostTask|, for
+  /// work that a frame is waiting on.
+  void PostHighPriorityTask(fml::UniqueClosure task);
+
+  /// The number of workers of the loop, or zero if it has already died.
+  size_t GetWorkerCount() const;
 
  private:
   friend ConcurrentMessageLoop;
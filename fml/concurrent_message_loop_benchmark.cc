@@ -0,0 +1,108 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/fml/concurrent_message_loop.h"
+
+#include <cmath>
+
+#include "flutter/benchmarking/benchmarking.h"
+#include "flutter/fml/synchronization/count_down_latch.h"
+
+namespace fml {
+namespace benchmarking {
+
+// Work that takes a few microseconds, about as long as decoding a small
+// image tile.
+static void DoWork() {
+  double value = 0;
+  for (int i = 0; i < 2000; i++) {
+    value += std::sqrt(static_cast<double>(i));
+  }
+  benchmark::DoNotOptimize(value);
+}
+
+// Posts tasks from outside of the pool with |state.range(0)| workers.
+static void BM_ConcurrentMessageLoopPostTasks(benchmark::State& state) {
+  auto loop = ConcurrentMessageLoop::Create(state.range(0));
+  auto task_runner = loop->GetTaskRunner();
+  const int num_tasks = 1000;
+  while (state.KeepRunning()) {
+    CountDownLatch latch(num_tasks);
+    for (int i = 0; i < num_tasks; i++) {
+      task_runner->PostTask([&latch]() {
+        DoWork();
+        latch.CountDown();
+      });
+    }
+    latch.Wait();
+  }
+  state.SetItemsProcessed(state.iterations() * num_tasks);
+}
+BENCHMARK(BM_ConcurrentMessageLoopPostTasks)
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->UseRealTime();
+
+// Posts tasks from within the pool, as done by tasks that split up their
+// work, so that the tasks have to be stolen by the other workers.
+static void BM_ConcurrentMessageLoopPostNestedTasks(benchmark::State& state) {
+  auto loop = ConcurrentMessageLoop::Create(state.range(0));
+  auto task_runner = loop->GetTaskRunner();
+  const int num_parents = 10;
+  const int num_children = 100;
+  while (state.KeepRunning()) {
+    // The parents count down too so that they are done posting when the
+    // loop is destroyed.
+    CountDownLatch latch(num_parents * (num_children + 1));
+    for (int i = 0; i < num_parents; i++) {
+      task_runner->PostTask([&task_runner, &latch]() {
+        for (int j = 0; j < num_children; j++) {
+          task_runner->PostTask([&latch]() {
+            DoWork();
+            latch.CountDown();
+          });
+        }
+        latch.CountDown();
+      });
+    }
+    latch.Wait();
+  }
+  state.SetItemsProcessed(state.iterations() * num_parents * num_children);
+}
+BENCHMARK(BM_ConcurrentMessageLoopPostNestedTasks)
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->UseRealTime();
+
+// Measures the latency of a high priority task posted behind a backlog of
+// normal tasks.
+static void BM_ConcurrentMessageLoopHighPriorityLatency(
+    benchmark::State& state) {
+  auto loop = ConcurrentMessageLoop::Create(state.range(0));
+  auto task_runner = loop->GetTaskRunner();
+  const int num_tasks = 1000;
+  while (state.KeepRunning()) {
+    CountDownLatch backlog(num_tasks);
+    for (int i = 0; i < num_tasks; i++) {
+      task_runner->PostTask([&backlog]() {
+        DoWork();
+        backlog.CountDown();
+      });
+    }
+    CountDownLatch latch(1);
+    task_runner->PostHighPriorityTask([&latch]() { latch.CountDown(); });
+    latch.Wait();
+    {
+      ::benchmarking::ScopedPauseTiming pause(state);
+      backlog.Wait();
+    }
+  }
+}
+BENCHMARK(BM_ConcurrentMessageLoopHighPriorityLatency)
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->UseRealTime();
+
+}  // namespace benchmarking
+}  // namespace fml
@@ -8,6 +8,7 @@
 #include <queue>
 
 #include "flutter/fml/closure.h"
+#include "flutter/fml/macros.h"
 #include "flutter/fml/task_source_grade.h"
 #include "flutter/fml/time/time_point.h"
 
@@ -16,15 +17,21 @@ namespace fml {
 class DelayedTask {
  public:
   DelayedTask(size_t order,
-              const fml::closure& task,
+              fml::UniqueClosure task,
               fml::TimePoint target_time,
               fml::TaskSourceGrade task_source_grade);
 
-  DelayedTask(const DelayedTask& other);
+  DelayedTask(DelayedTask&& other);
+
+  DelayedTask& operator=(DelayedTask&& other);
 
   ~DelayedTask();
 
-  const fml::closure& GetTask() const;
+  const fml::UniqueClosure& GetTask() const;
+
+  /// Moves the task out, leaving an empty closure behind. The ordering of
+  /// the delayed task is not affected.
+  fml::UniqueClosure TakeTask();
 
   fml::TimePoint GetTargetTime() const;
 
@@ -34,9 +41,11 @@ class DelayedTask {
 
  private:
   size_t order_;
-  fml::closure task_;
+  fml::UniqueClosure task_;
   fml::TimePoint target_time_;
   fml::TaskSourceGrade task_source_grade_;
+
+  FML_DISALLOW_COPY_AND_ASSIGN(DelayedTask);
 };
 
 using DelayedTaskQueue = std::priority_queue<DelayedTask,
@@ -90,6 +90,10 @@ bool WriteAtomically(const fml::UniqueFD& base_directory,
                      const char* file_name,
                      const Mapping& mapping);
 
+/// Writes the contents of |mapping| at the end of |file|. The file is not
+/// flushed, and is left with a partial write if this fails.
+bool AppendToFile(const fml::UniqueFD& file, const Mapping& mapping);
+
 /// Signature of a callback on a file in `directory` with `filename` (relative
 /// to `directory`). The returned bool should be false if and only if further
 /// traversal should be stopped. For example, a file-search visitor may return
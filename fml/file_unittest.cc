@@ -253,6 +253,27 @@ TEST(FileTest, AtomicWriteTest) {
   ASSERT_TRUE(fml::UnlinkFile(dir.fd(), "precious_data"));
 }
 
+TEST(FileTest, AppendToFileTest) {
+  fml::ScopedTemporaryDirectory dir;
+
+  fml::DataMapping first(std::string("These are "));
+  ASSERT_TRUE(fml::WriteAtomically(dir.fd(), "appended_data", first));
+
+  {
+    auto file = fml::OpenFile(dir.fd(), "appended_data", false,
+                              fml::FilePermission::kReadWrite);
+    fml::DataMapping second(std::string("my contents."));
+    ASSERT_TRUE(fml::AppendToFile(file, second));
+  }
+
+  ASSERT_EQ("These are my contents.",
+            ReadStringFromFile(fml::OpenFile(dir.fd(), "appended_data", false,
+                                             fml::FilePermission::kRead)));
+
+  // Cleanup.
+  ASSERT_TRUE(fml::UnlinkFile(dir.fd(), "appended_data"));
+}
+
 TEST(FileTest, EmptyMappingTest) {
   fml::ScopedTemporaryDirectory dir;
 
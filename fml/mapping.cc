@@ -9,6 +9,36 @@
 
 namespace fml {
 
+// Mapping
+
+bool Mapping::Advise(Advice advice, size_t offset, size_t length) const {
+  return false;
+}
+
+std::optional<size_t> Mapping::GetResidentSize(size_t offset,
+                                               size_t length) const {
+  return std::nullopt;
+}
+
+void Mapping::Prefault(size_t offset, size_t length) const {
+  // The smallest page size of the supported platforms. Touching every byte
+  // at this stride faults in every page on platforms with larger pages too.
+  constexpr size_t kPageSize = 4096;
+
+  const size_t size = GetSize();
+  const volatile uint8_t* data = GetMapping();
+  if (data == nullptr || offset >= size) {
+    return;
+  }
+  const size_t end = offset + std::min(length, size - offset);
+  uint8_t sum = 0;
+  for (size_t position = offset; position < end; position += kPageSize) {
+    sum += data[position];
+  }
+  sum += data[end - 1];
+  (void)sum;
+}
+
 // FileMapping
 
 uint8_t* FileMapping::GetMutableMapping() {
@@ -6,7 +6,9 @@
 #define FLUTTER_FML_MAPPING_H_
 
 #include <initializer_list>
+#include <limits>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -20,6 +22,22 @@ namespace fml {
 
 class Mapping {
  public:
+  /// How a range of a mapping is going to be accessed.
+  enum class Advice {
+    kNormal,
+    /// The range is read in order, so it can be read ahead aggressively and
+    /// freed soon after it has been read.
+    kSequential,
+    /// The range is read in no particular order, so reading ahead would be
+    /// wasted.
+    kRandom,
+    /// The range is read soon, so reading it in can start now.
+    kWillNeed,
+  };
+
+  /// A length that extends a range to the end of the mapping.
+  static constexpr size_t kToEnd = std::numeric_limits<size_t>::max();
+
   Mapping();
 
   virtual ~Mapping();
@@ -28,6 +46,25 @@ class Mapping {
 
   virtual const uint8_t* GetMapping() const = 0;
 
+  /// Tells the platform how the given range of the mapping is going to be
+  /// accessed, so that it can page it in or out accordingly. Returns false
+  /// if the advice was not taken, which only affects performance. Only
+  /// mappings of files take advice, the others ignore it.
+  virtual bool Advise(Advice advice,
+                      size_t offset = 0,
+                      size_t length = kToEnd) const;
+
+  /// Returns the number of bytes of the given range that are resident in
+  /// memory, rounded to whole pages, or nothing if this is not known for the
+  /// mapping or on the platform. Only known for mappings of files.
+  virtual std::optional<size_t> GetResidentSize(size_t offset = 0,
+                                                size_t length = kToEnd) const;
+
+  /// Touches every page of the given range so that it is resident. This
+  /// blocks on the disk for mappings of files. See `fml::PrefaultAsync` to
+  /// do this on another thread.
+  void Prefault(size_t offset = 0, size_t length = kToEnd) const;
+
  private:
   FML_DISALLOW_COPY_AND_ASSIGN(Mapping);
 };
@@ -65,6 +102,15 @@ class FileMapping final : public Mapping {
   // |Mapping|
   const uint8_t* GetMapping() const override;
 
+  // |Mapping|
+  bool Advise(Advice advice,
+              size_t offset = 0,
+              size_t length = kToEnd) const override;
+
+  // |Mapping|
+  std::optional<size_t> GetResidentSize(size_t offset = 0,
+                                        size_t length = kToEnd) const override;
+
   uint8_t* GetMutableMapping();
 
   bool IsValid() const;
@@ -3,6 +3,8 @@
 // found in the LICENSE file.
 
 #include "flutter/fml/mapping.h"
+
+#include "flutter/fml/file.h"
 #include "flutter/testing/testing.h"
 
 namespace fml {
@@ -52,4 +54,34 @@ TEST(MallocMapping, Release) {
   ASSERT_EQ(0u, mapping.GetSize());
 }
 
+TEST(DataMapping, IgnoresAdvice) {
+  const std::string contents(100000, 'a');
+  DataMapping mapping(contents);
+  ASSERT_FALSE(mapping.Advise(Mapping::Advice::kSequential));
+  ASSERT_FALSE(mapping.Advise(Mapping::Advice::kWillNeed, 0, 4096));
+  ASSERT_FALSE(mapping.GetResidentSize().has_value());
+  ASSERT_EQ(std::string(reinterpret_cast<const char*>(mapping.GetMapping()),
+                        mapping.GetSize()),
+            contents);
+}
+
+TEST(FileMapping, PrefaultMakesPagesResident) {
+  fml::ScopedTemporaryDirectory dir;
+  const std::string contents(100000, 'a');
+  ASSERT_TRUE(
+      fml::WriteAtomically(dir.fd(), "file", fml::DataMapping(contents)));
+  auto mapping = FileMapping::CreateReadOnly(dir.fd(), "file");
+  ASSERT_TRUE(mapping && mapping->IsValid());
+
+  mapping->Advise(Mapping::Advice::kSequential);
+  mapping->Prefault();
+  auto resident_size = mapping->GetResidentSize();
+  if (resident_size.has_value()) {
+    ASSERT_GE(resident_size.value(), contents.size());
+  }
+  // Ranges past the end are empty.
+  ASSERT_FALSE(mapping->Advise(Mapping::Advice::kWillNeed, contents.size()));
+  ASSERT_EQ(mapping->GetResidentSize(contents.size()).value_or(0), 0u);
+}
+
 }  // namespace fml
@@ -82,7 +82,7 @@ class WeakPtr {
 
   explicit operator bool() const {
     CheckThreadSafety();
-    return flag_ && flag_->is_valid();
+    return flag_.is_valid();
   }
 
   T* get() const {
@@ -99,7 +99,7 @@ class WeakPtr {
     // We still check the flag_ to determine if the pointer is valid
     // but callees should note that this WeakPtr could have been
     // invalidated on another thread.
-    return flag_ && flag_->is_valid() ? ptr_ : nullptr;
+    return flag_.is_valid() ? ptr_ : nullptr;
   }
 
   T& operator*() const {
@@ -115,7 +115,7 @@ class WeakPtr {
   }
 
  protected:
-  explicit WeakPtr(T* ptr, fml::RefPtr<fml::internal::WeakPtrFlag>&& flag)
+  explicit WeakPtr(T* ptr, fml::internal::WeakPtrFlagRef flag)
       : ptr_(ptr), flag_(std::move(flag)) {}
 
   virtual void CheckThreadSafety() const {
@@ -129,11 +129,11 @@ class WeakPtr {
   friend class WeakPtrFactory<T>;
 
   explicit WeakPtr(T* ptr,
-                   fml::RefPtr<fml::internal::WeakPtrFlag>&& flag,
+                   fml::internal::WeakPtrFlagRef flag,
                    DebugThreadChecker checker)
       : ptr_(ptr), flag_(std::move(flag)), checker_(checker) {}
   T* ptr_;
-  fml::RefPtr<fml::internal::WeakPtrFlag> flag_;
+  fml::internal::WeakPtrFlagRef flag_;
   DebugThreadChecker checker_;
 
   // Copy/move construction/assignment supported.
@@ -182,10 +182,9 @@ class TaskRunnerAffineWeakPtr : public WeakPtr<T> {
   friend class TaskRunnerAffineWeakPtr;
   friend class TaskRunnerAffineWeakPtrFactory<T>;
 
-  explicit TaskRunnerAffineWeakPtr(
-      T* ptr,
-      fml::RefPtr<fml::internal::WeakPtrFlag>&& flag,
-      DebugTaskRunnerChecker checker)
+  explicit TaskRunnerAffineWeakPtr(T* ptr,
+                                   fml::internal::WeakPtrFlagRef flag,
+                                   DebugTaskRunnerChecker checker)
       : WeakPtr<T>(ptr, std::move(flag)), checker_(checker) {}
 
   DebugTaskRunnerChecker checker_;
@@ -237,26 +236,26 @@ template <typename T>
 class WeakPtrFactory {
  public:
   explicit WeakPtrFactory(T* ptr)
-      : ptr_(ptr), flag_(fml::MakeRefCounted<fml::internal::WeakPtrFlag>()) {
+      : ptr_(ptr), flag_(fml::internal::WeakPtrFlag::Acquire()) {
     FML_DCHECK(ptr_);
   }
 
   ~WeakPtrFactory() {
     CheckThreadSafety();
-    flag_->Invalidate();
+    flag_->InvalidateAndRelease();
   }
 
   // Gets a new weak pointer, which will be valid until either
   // |InvalidateWeakPtrs()| is called or this object is destroyed.
   WeakPtr<T> GetWeakPtr() const {
-    return WeakPtr<T>(ptr_, flag_.Clone(), checker_);
+    return WeakPtr<T>(ptr_, fml::internal::WeakPtrFlagRef(flag_), checker_);
   }
 
  private:
   // Note: See weak_ptr_internal.h for an explanation of why we store the
   // pointer here, instead of in the "flag".
   T* const ptr_;
-  fml::RefPtr<fml::internal::WeakPtrFlag> flag_;
+  fml::internal::WeakPtrFlag* const flag_;
 
   void CheckThreadSafety() const {
     FML_DCHECK_CREATION_THREAD_IS_CURRENT(checker_.checker);
@@ -273,26 +272,27 @@ template <typename T>
 class TaskRunnerAffineWeakPtrFactory {
  public:
   explicit TaskRunnerAffineWeakPtrFactory(T* ptr)
-      : ptr_(ptr), flag_(fml::MakeRefCounted<fml::internal::WeakPtrFlag>()) {
+      : ptr_(ptr), flag_(fml::internal::WeakPtrFlag::Acquire()) {
     FML_DCHECK(ptr_);
   }
 
   ~TaskRunnerAffineWeakPtrFactory() {
     CheckThreadSafety();
-    flag_->Invalidate();
+    flag_->InvalidateAndRelease();
   }
 
   // Gets a new weak pointer, which will be valid until either
   // |InvalidateWeakPtrs()| is called or this object is destroyed.
   TaskRunnerAffineWeakPtr<T> GetWeakPtr() const {
-    return TaskRunnerAffineWeakPtr<T>(ptr_, flag_.Clone(), checker_);
+    return TaskRunnerAffineWeakPtr<T>(
+        ptr_, fml::internal::WeakPtrFlagRef(flag_), checker_);
   }
 
  private:
   // Note: See weak_ptr_internal.h for an explanation of why we store the
   // pointer here, instead of in the "flag".
   T* const ptr_;
-  fml::RefPtr<fml::internal::WeakPtrFlag> flag_;
+  fml::internal::WeakPtrFlag* const flag_;
 
   void CheckThreadSafety() const {
     FML_DCHECK_TASK_RUNNER_IS_CURRENT(checker_.checker);
@@ -0,0 +1,98 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/fml/memory/weak_ptr.h"
+
+#include <memory>
+#include <vector>
+
+#include "flutter/benchmarking/benchmarking.h"
+#include "flutter/fml/synchronization/count_down_latch.h"
+#include "flutter/fml/thread.h"
+
+namespace fml {
+namespace benchmarking {
+
+// Creates and destroys factories, as done by short-lived objects such as
+// layers and platform views.
+static void BM_WeakPtrFactoryChurn(benchmark::State& state) {
+  int data = 0;
+  while (state.KeepRunning()) {
+    WeakPtrFactory<int> factory(&data);
+    WeakPtr<int> ptr = factory.GetWeakPtr();
+    benchmark::DoNotOptimize(ptr);
+  }
+}
+BENCHMARK(BM_WeakPtrFactoryChurn);
+
+// Copies weak pointers, as done whenever one is captured by a task.
+static void BM_WeakPtrCopy(benchmark::State& state) {
+  int data = 0;
+  WeakPtrFactory<int> factory(&data);
+  WeakPtr<int> ptr = factory.GetWeakPtr();
+  while (state.KeepRunning()) {
+    WeakPtr<int> copy(ptr);
+    benchmark::DoNotOptimize(copy);
+  }
+}
+BENCHMARK(BM_WeakPtrCopy);
+
+// Copies weak pointers on several threads at once, which used to contend on
+// the reference count of the shared flag.
+static void BM_WeakPtrCopyContended(benchmark::State& state) {
+  static int data = 0;
+  static WeakPtrFactory<int>* factory = new WeakPtrFactory<int>(&data);
+  static WeakPtr<int> ptr = factory->GetWeakPtr();
+  while (state.KeepRunning()) {
+    WeakPtr<int> copy(ptr);
+    benchmark::DoNotOptimize(copy);
+  }
+}
+BENCHMARK(BM_WeakPtrCopyContended)->Threads(1)->Threads(4);
+
+// Posts tasks capturing weak pointers back and forth between two threads,
+// as the UI and raster threads do for every frame.
+static void BM_WeakPtrRoundTrip(benchmark::State& state) {
+  fml::Thread ui("ui");
+  fml::Thread raster("raster");
+  auto ui_runner = ui.GetTaskRunner();
+  auto raster_runner = raster.GetTaskRunner();
+  const int num_tasks = 100;
+
+  int data = 0;
+  std::unique_ptr<WeakPtrFactory<int>> factory;
+  CountDownLatch created(1);
+  ui_runner->PostTask([&]() {
+    factory = std::make_unique<WeakPtrFactory<int>>(&data);
+    created.CountDown();
+  });
+  created.Wait();
+
+  while (state.KeepRunning()) {
+    CountDownLatch latch(num_tasks);
+    ui_runner->PostTask([&]() {
+      for (int i = 0; i < num_tasks; i++) {
+        raster_runner->PostTask([&, weak = factory->GetWeakPtr()]() {
+          ui_runner->PostTask([&latch, weak]() {
+            benchmark::DoNotOptimize(weak.get());
+            latch.CountDown();
+          });
+        });
+      }
+    });
+    latch.Wait();
+  }
+
+  CountDownLatch destroyed(1);
+  ui_runner->PostTask([&]() {
+    factory.reset();
+    destroyed.CountDown();
+  });
+  destroyed.Wait();
+  state.SetItemsProcessed(state.iterations() * num_tasks);
+}
+BENCHMARK(BM_WeakPtrRoundTrip)->UseRealTime();
+
+}  // namespace benchmarking
+}  // namespace fml
@@ -4,22 +4,150 @@
 
 #include "flutter/fml/memory/weak_ptr_internal.h"
 
-#include "flutter/fml/logging.h"
+#include <limits>
+#include <mutex>
+
+#include "flutter/fml/thread_local.h"
 
 namespace fml {
 namespace internal {
 
-WeakPtrFlag::WeakPtrFlag() : is_valid_(true) {}
+namespace {
+
+// The number of flags allocated at once.
+constexpr size_t kFlagsPerBlock = 64;
+
+// The number of free flags a thread keeps before it hands half of them to
+// the other threads.
+constexpr size_t kMaxThreadFlags = 128;
+
+// Flags that reach this generation are not reused, so that the generation
+// never wraps around to one that weak pointers may still hold.
+constexpr uint32_t kLastGeneration = std::numeric_limits<uint32_t>::max();
+
+}  // namespace
+
+// The free flags of a thread.
+class WeakPtrFlagPool {
+ public:
+  WeakPtrFlagPool() = default;
+
+  ~WeakPtrFlagPool() { GetShared().Receive(list_, list_.count); }
+
+  static WeakPtrFlagPool& GetForCurrentThread();
+
+  WeakPtrFlag* Pop() {
+    if (list_.head == nullptr) {
+      if (GetShared().Refill(list_, kMaxThreadFlags / 2) == 0) {
+        Allocate();
+      }
+    }
+    WeakPtrFlag* flag = list_.head;
+    list_.head = flag->next_free_;
+    list_.count--;
+    flag->next_free_ = nullptr;
+    return flag;
+  }
+
+  void Push(WeakPtrFlag* flag) {
+    flag->next_free_ = list_.head;
+    list_.head = flag;
+    list_.count++;
+    if (list_.count > kMaxThreadFlags) {
+      GetShared().Receive(list_, kMaxThreadFlags / 2);
+    }
+  }
+
+ private:
+  // A singly linked list of free flags.
+  struct List {
+    WeakPtrFlag* head = nullptr;
+    size_t count = 0;
+  };
+
+  // The flags released by threads with too many of them, or by threads
+  // that have exited.
+  class Shared {
+   public:
+    // Moves up to |count| flags from |list| to the shared list.
+    void Receive(List& list, size_t count) {
+      std::scoped_lock lock(mutex_);
+      Move(list, list_, count);
+    }
+
+    // Moves up to |count| flags from the shared list to |list| and returns
+    // how many were moved.
+    size_t Refill(List& list, size_t count) {
+      std::scoped_lock lock(mutex_);
+      return Move(list_, list, count);
+    }
+
+   private:
+    std::mutex mutex_;
+    List list_;
+  };
+
+  List list_;
+
+  static Shared& GetShared() {
+    // Leaked so that flags can be released at any point during shutdown.
+    static Shared* shared = new Shared();
+    return *shared;
+  }
+
+  static size_t Move(List& from, List& to, size_t count) {
+    size_t moved = 0;
+    while (moved < count && from.head != nullptr) {
+      WeakPtrFlag* flag = from.head;
+      from.head = flag->next_free_;
+      flag->next_free_ = to.head;
+      to.head = flag;
+      moved++;
+    }
+    from.count -= moved;
+    to.count += moved;
+    return moved;
+  }
+
+  void Allocate() {
+    // The flags are never freed, since weak pointers may outlive their
+    // factories.
+    WeakPtrFlag* block = new WeakPtrFlag[kFlagsPerBlock];
+    for (size_t i = 0; i < kFlagsPerBlock; i++) {
+      block[i].next_free_ = list_.head;
+      list_.head = &block[i];
+    }
+    list_.count += kFlagsPerBlock;
+  }
+
+  FML_DISALLOW_COPY_AND_ASSIGN(WeakPtrFlagPool);
+};
+
+WeakPtrFlagPool& WeakPtrFlagPool::GetForCurrentThread() {
+#if FML_THREAD_LOCAL_PTHREADS
+  // Leaked so that factories destroyed during static destruction can still
+  // release their flags.
+  static auto* tls_pool = new ThreadLocalUniquePtr<WeakPtrFlagPool>();
+  ThreadLocalUniquePtr<WeakPtrFlagPool>& pool = *tls_pool;
+#else   // FML_THREAD_LOCAL_PTHREADS
+  FML_THREAD_LOCAL ThreadLocalUniquePtr<WeakPtrFlagPool> pool;
+#endif  // FML_THREAD_LOCAL_PTHREADS
+  if (pool.get() == nullptr) {
+    pool.reset(new WeakPtrFlagPool());
+  }
+  return *pool.get();
+}
 
-WeakPtrFlag::~WeakPtrFlag() {
-  // Should be invalidated before destruction.
-  FML_DCHECK(!is_valid_);
+WeakPtrFlag* WeakPtrFlag::Acquire() {
+  return WeakPtrFlagPool::GetForCurrentThread().Pop();
 }
 
-void WeakPtrFlag::Invalidate() {
-  // Invalidation should happen exactly once.
-  FML_DCHECK(is_valid_);
-  is_valid_ = false;
+void WeakPtrFlag::InvalidateAndRelease() {
+  const uint32_t generation = generation_.load(std::memory_order_relaxed) + 1;
+  generation_.store(generation, std::memory_order_relaxed);
+  if (generation != kLastGeneration) {
+    WeakPtrFlagPool::GetForCurrentThread().Push(this);
+  }
 }
 
 }  // namespace internal
@@ -5,8 +5,11 @@
 #ifndef FLUTTER_FML_MEMORY_WEAK_PTR_INTERNAL_H_
 #define FLUTTER_FML_MEMORY_WEAK_PTR_INTERNAL_H_
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
 #include "flutter/fml/macros.h"
-#include "flutter/fml/memory/ref_counted.h"
 
 namespace fml {
 namespace internal {
@@ -16,25 +19,81 @@ namespace internal {
 // there may also be |WeakPtr<U>|s to the same object, where |U| is a superclass
 // of |T|.
 //
-// This class in not thread-safe, though references may be released on any
-// thread (allowing weak pointers to be destroyed/reset/reassigned on any
-// thread).
-class WeakPtrFlag : public fml::RefCountedThreadSafe<WeakPtrFlag> {
+// Flags are never freed. Each factory takes a flag from a pool and returns
+// it once it has invalidated its weak pointers, which it does by bumping the
+// generation of the flag. Weak pointers remember the generation they were
+// handed out for, so copying them does not touch the flag at all and a
+// reused flag does not make them valid again.
+//
+// This class in not thread-safe, though weak pointers may be destroyed,
+// reset or reassigned on any thread.
+class WeakPtrFlag {
  public:
-  WeakPtrFlag();
+  // Takes a flag from the pool of the calling thread.
+  static WeakPtrFlag* Acquire();
 
-  ~WeakPtrFlag();
+  uint32_t generation() const {
+    return generation_.load(std::memory_order_relaxed);
+  }
 
-  bool is_valid() const { return is_valid_; }
+  bool IsValid(uint32_t generation) const {
+    return generation_.load(std::memory_order_relaxed) == generation;
+  }
 
-  void Invalidate();
+  // Invalidates the weak pointers handed out for the current generation and
+  // returns the flag to the pool of the calling thread.
+  void InvalidateAndRelease();
 
  private:
-  bool is_valid_;
+  friend class WeakPtrFlagPool;
+
+  std::atomic<uint32_t> generation_ = {0};
+  WeakPtrFlag* next_free_ = nullptr;
+
+  WeakPtrFlag() = default;
 
   FML_DISALLOW_COPY_AND_ASSIGN(WeakPtrFlag);
 };
 
+// A reference to a |WeakPtrFlag| for the generation it was taken in. Null
+// references are invalid. Moving a reference leaves the source null.
+class WeakPtrFlagRef {
+ public:
+  WeakPtrFlagRef() = default;
+
+  explicit WeakPtrFlagRef(const WeakPtrFlag* flag)
+      : flag_(flag), generation_(flag->generation()) {}
+
+  WeakPtrFlagRef(const WeakPtrFlagRef& other) = default;
+
+  WeakPtrFlagRef(WeakPtrFlagRef&& other)
+      : flag_(other.flag_), generation_(other.generation_) {
+    other.flag_ = nullptr;
+  }
+
+  WeakPtrFlagRef& operator=(const WeakPtrFlagRef& other) = default;
+
+  WeakPtrFlagRef& operator=(WeakPtrFlagRef&& other) {
+    if (this != &other) {
+      flag_ = other.flag_;
+      generation_ = other.generation_;
+      other.flag_ = nullptr;
+    }
+    return *this;
+  }
+
+  WeakPtrFlagRef& operator=(std::nullptr_t) {
+    flag_ = nullptr;
+    return *this;
+  }
+
+  bool is_valid() const { return flag_ && flag_->IsValid(generation_); }
+
+ private:
+  const WeakPtrFlag* flag_ = nullptr;
+  uint32_t generation_ = 0;
+};
+
 }  // namespace internal
 }  // namespace fml
 
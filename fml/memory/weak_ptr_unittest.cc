@@ -6,8 +6,10 @@
 
 #include "flutter/fml/memory/weak_ptr.h"
 
+#include <memory>
 #include <thread>
 #include <utility>
+#include <vector>
 
 #include "flutter/fml/message_loop.h"
 #include "flutter/fml/raster_thread_merger.h"
@@ -172,6 +174,48 @@ TEST(WeakPtrTest, UpcastMoveAssignment) {
   EXPECT_EQ(&data, ptr2.get());
 }
 
+TEST(WeakPtrTest, ReusedFlagDoesNotRevalidate) {
+  // Flags are pooled, so the factories below are likely to share one.
+  std::vector<WeakPtr<int>> ptrs;
+  int data = 0;
+  for (int i = 0; i < 1000; i++) {
+    WeakPtrFactory<int> factory(&data);
+    for (const auto& ptr : ptrs) {
+      ASSERT_EQ(nullptr, ptr.get());
+    }
+    ptrs.push_back(factory.GetWeakPtr());
+    ASSERT_EQ(&data, ptrs.back().get());
+  }
+  for (const auto& ptr : ptrs) {
+    ASSERT_EQ(nullptr, ptr.get());
+  }
+}
+
+TEST(WeakPtrTest, OutlivesThreadOfFactory) {
+  // The thread hands its flags back to the other threads when it exits. The
+  // weak pointers are only checked with |getUnsafe| since they belong to it.
+  int data = 0;
+  std::vector<WeakPtr<int>> ptrs;
+  std::thread thread([&data, &ptrs]() {
+    std::vector<std::unique_ptr<WeakPtrFactory<int>>> factories;
+    for (int i = 0; i < 500; i++) {
+      factories.push_back(std::make_unique<WeakPtrFactory<int>>(&data));
+      ptrs.push_back(factories.back()->GetWeakPtr());
+    }
+  });
+  thread.join();
+  for (const auto& ptr : ptrs) {
+    ASSERT_EQ(nullptr, ptr.getUnsafe());
+  }
+  for (int i = 0; i < 500; i++) {
+    WeakPtrFactory<int> factory(&data);
+    ASSERT_EQ(&data, factory.GetWeakPtr().get());
+    for (const auto& ptr : ptrs) {
+      ASSERT_EQ(nullptr, ptr.getUnsafe());
+    }
+  }
+}
+
 TEST(TaskRunnerAffineWeakPtrTest, ShouldNotCrashIfRunningOnTheSameTaskRunner) {
   fml::MessageLoop* loop1 = nullptr;
   fml::AutoResetWaitableEvent latch1;
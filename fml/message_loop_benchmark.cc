@@ -0,0 +1,98 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/fml/message_loop.h"
+
+#include "flutter/benchmarking/benchmarking.h"
+#include "flutter/fml/build_config.h"
+#include "flutter/fml/synchronization/count_down_latch.h"
+#include "flutter/fml/task_runner.h"
+#include "flutter/fml/thread.h"
+
+#if defined(OS_LINUX)
+#include <sys/resource.h>
+
+#include "flutter/fml/platform/linux/message_loop_linux.h"
+#endif  // defined(OS_LINUX)
+
+namespace fml {
+namespace benchmarking {
+
+// Returns the number of times the thread of |task_runner| has blocked so
+// far, which is the number of times its loop has been woken up, or zero if
+// this is not known on the platform.
+static int64_t GetWakeUpCount(const fml::RefPtr<fml::TaskRunner>& task_runner) {
+  int64_t count = 0;
+#if defined(OS_LINUX)
+  CountDownLatch latch(1);
+  task_runner->PostTask([&count, &latch]() {
+    struct rusage usage = {};
+    ::getrusage(RUSAGE_THREAD, &usage);
+    count = usage.ru_nvcsw;
+    latch.CountDown();
+  });
+  latch.Wait();
+#endif  // defined(OS_LINUX)
+  return count;
+}
+
+// Posts bursts of |state.range(0)| tasks from another thread, as done by
+// the platform thread when it forwards a batch of messages.
+static void BM_MessageLoopPostTaskBursts(benchmark::State& state) {
+  fml::Thread thread;
+  auto task_runner = thread.GetTaskRunner();
+  const int num_tasks = state.range(0);
+  const int64_t wake_ups = GetWakeUpCount(task_runner);
+  while (state.KeepRunning()) {
+    CountDownLatch latch(num_tasks);
+    for (int i = 0; i < num_tasks; i++) {
+      task_runner->PostTask([&latch]() { latch.CountDown(); });
+    }
+    latch.Wait();
+  }
+  const int64_t total_tasks = state.iterations() * num_tasks;
+  state.counters["wake_ups_per_task"] =
+      static_cast<double>(GetWakeUpCount(task_runner) - wake_ups) /
+      total_tasks;
+  state.SetItemsProcessed(total_tasks);
+}
+BENCHMARK(BM_MessageLoopPostTaskBursts)
+    ->RangeMultiplier(10)
+    ->Range(1, 1000)
+    ->UseRealTime();
+
+// Posts 100 tasks delayed by 1 to 2 milliseconds, like animation and
+// debounce timers, with a timer slack of |state.range(0)| microseconds.
+static void BM_MessageLoopPostDelayedTasks(benchmark::State& state) {
+#if defined(OS_LINUX)
+  MessageLoopLinux::SetTimerSlack(
+      fml::TimeDelta::FromMicroseconds(state.range(0)));
+#endif  // defined(OS_LINUX)
+  fml::Thread thread;
+  auto task_runner = thread.GetTaskRunner();
+  const int num_tasks = 100;
+  const int64_t wake_ups = GetWakeUpCount(task_runner);
+  while (state.KeepRunning()) {
+    CountDownLatch latch(num_tasks);
+    const auto now = fml::TimePoint::Now();
+    for (int i = 0; i < num_tasks; i++) {
+      task_runner->PostTaskForTime(
+          [&latch]() { latch.CountDown(); },
+          now + fml::TimeDelta::FromMicroseconds(1000 + 10 * i));
+    }
+    latch.Wait();
+  }
+  const int64_t total_tasks = state.iterations() * num_tasks;
+  state.counters["wake_ups_per_task"] =
+      static_cast<double>(GetWakeUpCount(task_runner) - wake_ups) /
+      total_tasks;
+  state.SetItemsProcessed(total_tasks);
+#if defined(OS_LINUX)
+  MessageLoopLinux::SetTimerSlack(fml::TimeDelta::Zero());
+#endif  // defined(OS_LINUX)
+}
+BENCHMARK(BM_MessageLoopPostDelayedTasks)->Arg(0)->Arg(500)->UseRealTime();
+
+}  // namespace benchmarking
+}  // namespace fml
@@ -36,19 +36,144 @@ class TaskSourceGradeHolder {
 };
 }  // namespace
 
-// Guarded by creation_mutex_.
+// Only accessed from the thread it belongs to.
 FML_THREAD_LOCAL ThreadLocalUniquePtr<TaskSourceGradeHolder>
     tls_task_source_grade;
 
+struct TaskQueueEntry::ImmediateTask {
+  DelayedTask task;
+  ImmediateTask* next;
+};
+
 TaskQueueEntry::TaskQueueEntry(TaskQueueId created_for_arg)
     : owner_of(_kUnmerged),
       subsumed_by(_kUnmerged),
-      created_for(created_for_arg) {
+      created_for(created_for_arg),
+      immediate_tasks_(nullptr) {
   wakeable = NULL;
   task_observers = TaskObservers();
   task_source = std::make_unique<TaskSource>(created_for);
 }
 
+TaskQueueEntry::~TaskQueueEntry() {
+  ImmediateTask* node = immediate_tasks_.exchange(nullptr);
+  while (node) {
+    ImmediateTask* next = node->next;
+    delete node;
+    node = next;
+  }
+}
+
+bool TaskQueueEntry::PushImmediateTask(DelayedTask task) {
+  auto node = new ImmediateTask{std::move(task), immediate_tasks_.load()};
+  while (!immediate_tasks_.compare_exchange_weak(node->next, node)) {
+  }
+  return node->next == nullptr;
+}
+
+void TaskQueueEntry::DrainImmediateTasks() {
+  // The list is in the reverse order of registration, which does not matter
+  // since the task source orders the tasks by their order number.
+  ImmediateTask* node = immediate_tasks_.exchange(nullptr);
+  while (node) {
+    ImmediateTask* next = node->next;
+    task_source->RegisterTask(std::move(node->task));
+    delete node;
+    node = next;
+  }
+}
+
+bool TaskQueueEntry::HasImmediateTasks() const {
+  return immediate_tasks_.load() != nullptr;
+}
+
+// Holds the mutexes of a queue and of the queue it is merged with, if any,
+// and drains their immediate tasks. Since the merge relationship is only
+// changed with both mutexes held, it is stable for the lifetime of this
+// object.
+class MessageLoopTaskQueues::LockedQueues {
+ public:
+  LockedQueues(const MessageLoopTaskQueues& queues, TaskQueueId queue_id)
+      : entry_(queues.GetEntry(queue_id)) {
+    while (true) {
+      const TaskQueueId merged_with = MergedWith(entry_.get());
+      if (merged_with == _kUnmerged) {
+        other_.reset();
+        entry_lock_ = std::unique_lock(entry_->mutex);
+      } else {
+        other_ = queues.GetEntry(merged_with);
+        LockBoth();
+      }
+      // The queue may have been merged or unmerged before the mutexes were
+      // acquired.
+      if (MergedWith(entry_.get()) == merged_with) {
+        break;
+      }
+      entry_lock_.unlock();
+      if (other_lock_.owns_lock()) {
+        other_lock_.unlock();
+      }
+    }
+    DrainImmediateTasks();
+  }
+
+  // Locks two queues regardless of whether they are merged, for merging
+  // them.
+  LockedQueues(std::shared_ptr<TaskQueueEntry> entry,
+               std::shared_ptr<TaskQueueEntry> other)
+      : entry_(std::move(entry)), other_(std::move(other)) {
+    LockBoth();
+    DrainImmediateTasks();
+  }
+
+  // The queue these locks were taken for.
+  TaskQueueEntry* entry() const { return entry_.get(); }
+
+  bool is_subsumed() const { return entry_->subsumed_by.load() != _kUnmerged; }
+
+  // The queue whose loop services both queues.
+  TaskQueueEntry* owner() const {
+    return is_subsumed() ? other_.get() : entry_.get();
+  }
+
+  // The queue subsumed by |owner|, or null if the queues are not merged.
+  TaskQueueEntry* subsumed() const {
+    if (is_subsumed()) {
+      return entry_.get();
+    }
+    if (entry_->owner_of.load() != _kUnmerged) {
+      return other_.get();
+    }
+    return nullptr;
+  }
+
+  void DrainImmediateTasks() const {
+    entry_->DrainImmediateTasks();
+    if (other_) {
+      other_->DrainImmediateTasks();
+    }
+  }
+
+ private:
+  std::shared_ptr<TaskQueueEntry> entry_;
+  std::shared_ptr<TaskQueueEntry> other_;
+  std::unique_lock<std::mutex> entry_lock_;
+  std::unique_lock<std::mutex> other_lock_;
+
+  static TaskQueueId MergedWith(const TaskQueueEntry* entry) {
+    const TaskQueueId owner = entry->subsumed_by.load();
+    return owner != _kUnmerged ? owner : entry->owner_of.load();
+  }
+
+  void LockBoth() {
+    entry_lock_ = std::unique_lock(entry_->mutex, std::defer_lock);
+    other_lock_ = std::unique_lock(other_->mutex, std::defer_lock);
+    std::lock(entry_lock_, other_lock_);
+  }
+
+  FML_DISALLOW_COPY_ASSIGN_AND_MOVE(LockedQueues);
+};
+
 fml::RefPtr<MessageLoopTaskQueues> MessageLoopTaskQueues::GetInstance() {
   std::scoped_lock creation(creation_mutex_);
   if (!instance_) {
@@ -60,120 +185,177 @@ fml::RefPtr<MessageLoopTaskQueues> MessageLoopTaskQueues::GetInstance() {
 }
 
 TaskQueueId MessageLoopTaskQueues::CreateTaskQueue() {
-  std::lock_guard guard(queue_mutex_);
+  fml::UniqueLock lock(*entries_mutex_);
   TaskQueueId loop_id = TaskQueueId(task_queue_id_counter_);
   ++task_queue_id_counter_;
-  queue_entries_[loop_id] = std::make_unique<TaskQueueEntry>(loop_id);
+  queue_entries_[loop_id] = std::make_shared<TaskQueueEntry>(loop_id);
   return loop_id;
 }
 
 MessageLoopTaskQueues::MessageLoopTaskQueues()
-    : task_queue_id_counter_(0), order_(0) {}
+    : entries_mutex_(fml::SharedMutex::Create()),
+      task_queue_id_counter_(0),
+      order_(0) {}
 
 MessageLoopTaskQueues::~MessageLoopTaskQueues() = default;
 
+std::shared_ptr<TaskQueueEntry> MessageLoopTaskQueues::GetEntry(
+    TaskQueueId queue_id) const {
+  fml::SharedLock lock(*entries_mutex_);
+  return queue_entries_.at(queue_id);
+}
+
 void MessageLoopTaskQueues::Dispose(TaskQueueId queue_id) {
-  std::lock_guard guard(queue_mutex_);
-  const auto& queue_entry = queue_entries_.at(queue_id);
-  FML_DCHECK(queue_entry->subsumed_by == _kUnmerged);
-  TaskQueueId subsumed = queue_entry->owner_of;
-  queue_entries_.erase(queue_id);
-  if (subsumed != _kUnmerged) {
-    queue_entries_.erase(subsumed);
+  std::vector<std::shared_ptr<TaskQueueEntry>> entries;
+  entries.push_back(GetEntry(queue_id));
+  {
+    LockedQueues queues(*this, queue_id);
+    FML_DCHECK(!queues.is_subsumed());
+    if (queues.subsumed()) {
+      entries.push_back(GetEntry(queues.subsumed()->created_for));
+    }
+  }
+
+  // Tasks registered by threads that looked up the entries before they are
+  // erased must not wake up the loops anymore.
+  for (const auto& entry : entries) {
+    std::scoped_lock lock(entry->wakeable_mutex);
+    entry->wakeable = nullptr;
+  }
+
+  fml::UniqueLock lock(*entries_mutex_);
+  for (const auto& entry : entries) {
+    queue_entries_.erase(entry->created_for);
   }
 }
 
 void MessageLoopTaskQueues::DisposeTasks(TaskQueueId queue_id) {
-  std::lock_guard guard(queue_mutex_);
-  const auto& queue_entry = queue_entries_.at(queue_id);
-  FML_DCHECK(queue_entry->subsumed_by == _kUnmerged);
-  TaskQueueId subsumed = queue_entry->owner_of;
-  queue_entry->task_source->ShutDown();
-  if (subsumed != _kUnmerged) {
-    queue_entries_.at(subsumed)->task_source->ShutDown();
+  LockedQueues queues(*this, queue_id);
+  FML_DCHECK(!queues.is_subsumed());
+  queues.entry()->task_source->ShutDown();
+  if (queues.subsumed()) {
+    queues.subsumed()->task_source->ShutDown();
   }
 }
 
 TaskSourceGrade MessageLoopTaskQueues::GetCurrentTaskSourceGrade() {
-  std::scoped_lock creation(creation_mutex_);
   return tls_task_source_grade.get()->task_source_grade;
 }
 
 void MessageLoopTaskQueues::RegisterTask(
     TaskQueueId queue_id,
-    const fml::closure& task,
+    fml::UniqueClosure task,
     fml::TimePoint target_time,
     fml::TaskSourceGrade task_source_grade) {
-  std::lock_guard guard(queue_mutex_);
   size_t order = order_++;
-  const auto& queue_entry = queue_entries_.at(queue_id);
-  queue_entry->task_source->RegisterTask(
-      {order, task, target_time, task_source_grade});
-  TaskQueueId loop_to_wake = queue_id;
-  if (queue_entry->subsumed_by != _kUnmerged) {
-    loop_to_wake = queue_entry->subsumed_by;
+  DelayedTask delayed_task(order, std::move(task), target_time,
+                           task_source_grade);
+
+  // Tasks that are already due skip the queue mutex and are moved into the
+  // task source by the next thread that takes it. Microtasks go to the
+  // secondary task heap, which may be paused, and idle tasks may be deferred,
+  // so they always take the mutex.
+  if (task_source_grade != fml::TaskSourceGrade::kDartMicroTasks &&
+      task_source_grade != fml::TaskSourceGrade::kIdle &&
+      target_time <= fml::TimePoint::Now()) {
+    std::shared_ptr<TaskQueueEntry> entry = GetEntry(queue_id);
+    if (!entry->PushImmediateTask(std::move(delayed_task))) {
+      // The loop was already woken up for the tasks ahead of this one.
+      return;
+    }
+    const TaskQueueId owner = entry->subsumed_by.load();
+    std::shared_ptr<TaskQueueEntry> loop_entry =
+        owner == _kUnmerged ? entry : GetEntry(owner);
+    std::scoped_lock lock(loop_entry->wakeable_mutex);
+    if (loop_entry->wakeable) {
+      loop_entry->wakeable->WakeUp(target_time);
+    }
+    return;
   }
 
+  LockedQueues queues(*this, queue_id);
+  queues.entry()->task_source->RegisterTask(std::move(delayed_task));
   // This can happen when the secondary tasks are paused.
-  if (HasPendingTasksUnlocked(loop_to_wake)) {
-    WakeUpUnlocked(loop_to_wake, GetNextWakeTimeUnlocked(loop_to_wake));
-  }
+  WakeUpIfPendingLocked(queues.owner(), queues.subsumed());
 }
 
 bool MessageLoopTaskQueues::HasPendingTasks(TaskQueueId queue_id) const {
-  std::lock_guard guard(queue_mutex_);
-  return HasPendingTasksUnlocked(queue_id);
+  LockedQueues queues(*this, queue_id);
+  // Subsumed queues will never have pending tasks.
+  if (queues.is_subsumed()) {
+    return false;
+  }
+  return HasPendingTasksLocked(queues.owner(), queues.subsumed());
 }
 
-fml::closure MessageLoopTaskQueues::GetNextTaskToRun(TaskQueueId queue_id,
-                                                     fml::TimePoint from_time) {
-  std::lock_guard guard(queue_mutex_);
-  if (!HasPendingTasksUnlocked(queue_id)) {
+fml::UniqueClosure MessageLoopTaskQueues::GetNextTaskToRun(
+    TaskQueueId queue_id,
+    fml::TimePoint from_time) {
+  LockedQueues queues(*this, queue_id);
+  if (queues.is_subsumed()) {
+    return nullptr;
+  }
+  TaskQueueEntry* owner = queues.owner();
+  TaskQueueEntry* subsumed = queues.subsumed();
+  if (!HasPendingTasksLocked(owner, subsumed)) {
     return nullptr;
   }
-  TaskSource::TopTask top = PeekNextTaskUnlocked(queue_id);
+  TaskSource::TopTask top = PeekNextTaskLocked(owner, subsumed, from_time);
 
-  if (!HasPendingTasksUnlocked(queue_id)) {
-    WakeUpUnlocked(queue_id, fml::TimePoint::Max());
+  if (!HasPendingTasksLocked(owner, subsumed)) {
+    WakeUpLocked(owner, subsumed, fml::TimePoint::Max());
   } else {
-    WakeUpUnlocked(queue_id, GetNextWakeTimeUnlocked(queue_id));
+    WakeUpLocked(owner, subsumed, GetNextWakeTimeLocked(owner, subsumed));
   }
 
-  if (top.task.GetTargetTime() > from_time) {
+  if (top.run_time > from_time) {
     return nullptr;
   }
-  fml::closure invocation = top.task.GetTask();
-  queue_entries_.at(top.task_queue_id)
-      ->task_source->PopTask(top.task.GetTaskSourceGrade());
-  {
-    std::scoped_lock creation(creation_mutex_);
-    const auto task_source_grade = top.task.GetTaskSourceGrade();
+  const auto task_source_grade = top.task.GetTaskSourceGrade();
+  TaskQueueEntry* top_entry =
+      top.task_queue_id == owner->created_for ? owner : subsumed;
+  fml::UniqueClosure invocation =
+      top_entry->task_source->PopTask(task_source_grade);
+
+  TaskSourceGradeHolder* holder = tls_task_source_grade.get();
+  if (holder) {
+    holder->task_source_grade = task_source_grade;
+  } else {
     tls_task_source_grade.reset(new TaskSourceGradeHolder{task_source_grade});
   }
   return invocation;
 }
 
-void MessageLoopTaskQueues::WakeUpUnlocked(TaskQueueId queue_id,
-                                           fml::TimePoint time) const {
-  if (queue_entries_.at(queue_id)->wakeable) {
-    queue_entries_.at(queue_id)->wakeable->WakeUp(time);
+void MessageLoopTaskQueues::WakeUpLocked(TaskQueueEntry* owner,
+                                         TaskQueueEntry* subsumed,
+                                         fml::TimePoint time) {
+  std::scoped_lock lock(owner->wakeable_mutex);
+  if (!owner->wakeable) {
+    return;
+  }
+  // Immediate tasks pushed since the queues were drained only woke up the
+  // loop if they were the first ones. This wake up must not postpone them.
+  if (owner->HasImmediateTasks() ||
+      (subsumed && subsumed->HasImmediateTasks())) {
+    const fml::TimePoint now = fml::TimePoint::Now();
+    if (now < time) {
+      time = now;
+    }
   }
+  owner->wakeable->WakeUp(time);
 }
 
 size_t MessageLoopTaskQueues::GetNumPendingTasks(TaskQueueId queue_id) const {
-  std::lock_guard guard(queue_mutex_);
-  const auto& queue_entry = queue_entries_.at(queue_id);
-  if (queue_entry->subsumed_by != _kUnmerged) {
+  LockedQueues queues(*this, queue_id);
+  if (queues.is_subsumed()) {
     return 0;
   }
 
   size_t total_tasks = 0;
-  total_tasks += queue_entry->task_source->GetNumPendingTasks();
+  total_tasks += queues.entry()->task_source->GetNumPendingTasks();
 
-  TaskQueueId subsumed = queue_entry->owner_of;
-  if (subsumed != _kUnmerged) {
-    const auto& subsumed_entry = queue_entries_.at(subsumed);
-    total_tasks += subsumed_entry->task_source->GetNumPendingTasks();
+  if (queues.subsumed()) {
+    total_tasks += queues.subsumed()->task_source->GetNumPendingTasks();
   }
   return total_tasks;
 }
@@ -181,33 +363,34 @@ size_t MessageLoopTaskQueues::GetNumPendingTasks(TaskQueueId queue_id) const {
 void MessageLoopTaskQueues::AddTaskObserver(TaskQueueId queue_id,
                                             intptr_t key,
                                             const fml::closure& callback) {
-  std::lock_guard guard(queue_mutex_);
   FML_DCHECK(callback != nullptr) << "Observer callback must be non-null.";
-  queue_entries_.at(queue_id)->task_observers[key] = callback;
+  std::shared_ptr<TaskQueueEntry> entry = GetEntry(queue_id);
+  std::scoped_lock lock(entry->mutex);
+  entry->task_observers[key] = callback;
 }
 
 void MessageLoopTaskQueues::RemoveTaskObserver(TaskQueueId queue_id,
                                                intptr_t key) {
-  std::lock_guard guard(queue_mutex_);
-  queue_entries_.at(queue_id)->task_observers.erase(key);
+  std::shared_ptr<TaskQueueEntry> entry = GetEntry(queue_id);
+  std::scoped_lock lock(entry->mutex);
+  entry->task_observers.erase(key);
 }
 
 std::vector<fml::closure> MessageLoopTaskQueues::GetObserversToNotify(
     TaskQueueId queue_id) const {
-  std::lock_guard guard(queue_mutex_);
+  LockedQueues queues(*this, queue_id);
   std::vector<fml::closure> observers;
 
-  if (queue_entries_.at(queue_id)->subsumed_by != _kUnmerged) {
+  if (queues.is_subsumed()) {
     return observers;
   }
 
-  for (const auto& observer : queue_entries_.at(queue_id)->task_observers) {
+  for (const auto& observer : queues.entry()->task_observers) {
     observers.push_back(observer.second);
   }
 
-  TaskQueueId subsumed = queue_entries_.at(queue_id)->owner_of;
-  if (subsumed != _kUnmerged) {
-    for (const auto& observer : queue_entries_.at(subsumed)->task_observers) {
+  if (queues.subsumed()) {
+    for (const auto& observer : queues.subsumed()->task_observers) {
       observers.push_back(observer.second);
     }
   }
@@ -217,27 +400,27 @@ std::vector<fml::closure> MessageLoopTaskQueues::GetObserversToNotify(
 
 void MessageLoopTaskQueues::SetWakeable(TaskQueueId queue_id,
                                         fml::Wakeable* wakeable) {
-  std::lock_guard guard(queue_mutex_);
-  FML_CHECK(!queue_entries_.at(queue_id)->wakeable)
-      << "Wakeable can only be set once.";
-  queue_entries_.at(queue_id)->wakeable = wakeable;
+  std::shared_ptr<TaskQueueEntry> entry = GetEntry(queue_id);
+  std::scoped_lock lock(entry->wakeable_mutex);
+  FML_CHECK(!entry->wakeable) << "Wakeable can only be set once.";
+  entry->wakeable = wakeable;
 }
 
 bool MessageLoopTaskQueues::Merge(TaskQueueId owner, TaskQueueId subsumed) {
   if (owner == subsumed) {
     return true;
   }
-  std::lock_guard guard(queue_mutex_);
-  auto& owner_entry = queue_entries_.at(owner);
-  auto& subsumed_entry = queue_entries_.at(subsumed);
+  std::shared_ptr<TaskQueueEntry> owner_entry = GetEntry(owner);
+  std::shared_ptr<TaskQueueEntry> subsumed_entry = GetEntry(subsumed);
+  LockedQueues queues(owner_entry, subsumed_entry);
 
-  if (owner_entry->owner_of == subsumed) {
+  if (owner_entry->owner_of.load() == subsumed) {
     return true;
   }
 
   std::vector<TaskQueueId> owner_subsumed_keys = {
-      owner_entry->owner_of, owner_entry->subsumed_by, subsumed_entry->owner_of,
-      subsumed_entry->subsumed_by};
+      owner_entry->owner_of.load(), owner_entry->subsumed_by.load(),
+      subsumed_entry->owner_of.load(), subsumed_entry->subsumed_by.load()};
 
   for (auto key : owner_subsumed_keys) {
     if (key != _kUnmerged) {
@@ -248,120 +431,122 @@ bool MessageLoopTaskQueues::Merge(TaskQueueId owner, TaskQueueId subsumed) {
   owner_entry->owner_of = subsumed;
   subsumed_entry->subsumed_by = owner;
 
-  if (HasPendingTasksUnlocked(owner)) {
-    WakeUpUnlocked(owner, GetNextWakeTimeUnlocked(owner));
-  }
+  // Immediate tasks pushed while the mutexes were being acquired woke up the
+  // loop of the subsumed queue instead of the owner.
+  queues.DrainImmediateTasks();
+  WakeUpIfPendingLocked(owner_entry.get(), subsumed_entry.get());
 
   return true;
 }
 
 bool MessageLoopTaskQueues::Unmerge(TaskQueueId owner) {
-  std::lock_guard guard(queue_mutex_);
-  const auto& owner_entry = queue_entries_.at(owner);
-  const TaskQueueId subsumed = owner_entry->owner_of;
-  if (subsumed == _kUnmerged) {
+  LockedQueues queues(*this, owner);
+  TaskQueueEntry* owner_entry = queues.entry();
+  TaskQueueEntry* subsumed_entry = queues.subsumed();
+  if (queues.is_subsumed() || !subsumed_entry) {
     return false;
   }
 
-  queue_entries_.at(subsumed)->subsumed_by = _kUnmerged;
+  subsumed_entry->subsumed_by = _kUnmerged;
   owner_entry->owner_of = _kUnmerged;
 
-  if (HasPendingTasksUnlocked(owner)) {
-    WakeUpUnlocked(owner, GetNextWakeTimeUnlocked(owner));
-  }
-
-  if (HasPendingTasksUnlocked(subsumed)) {
-    WakeUpUnlocked(subsumed, GetNextWakeTimeUnlocked(subsumed));
-  }
+  // Immediate tasks pushed while the mutexes were being acquired woke up the
+  // owner instead of the loop of the formerly subsumed queue.
+  queues.DrainImmediateTasks();
+  WakeUpIfPendingLocked(owner_entry, nullptr);
+  WakeUpIfPendingLocked(subsumed_entry, nullptr);
 
   return true;
 }
 
 bool MessageLoopTaskQueues::Owns(TaskQueueId owner,
                                  TaskQueueId subsumed) const {
-  std::lock_guard guard(queue_mutex_);
   return owner != _kUnmerged && subsumed != _kUnmerged &&
-         subsumed == queue_entries_.at(owner)->owner_of;
+         subsumed == GetEntry(owner)->owner_of.load();
 }
 
 TaskQueueId MessageLoopTaskQueues::GetSubsumedTaskQueueId(
     TaskQueueId owner) const {
-  std::lock_guard guard(queue_mutex_);
-  return queue_entries_.at(owner)->owner_of;
+  return GetEntry(owner)->owner_of.load();
 }
 
 void MessageLoopTaskQueues::PauseSecondarySource(TaskQueueId queue_id) {
-  std::lock_guard guard(queue_mutex_);
-  queue_entries_.at(queue_id)->task_source->PauseSecondary();
+  std::shared_ptr<TaskQueueEntry> entry = GetEntry(queue_id);
+  std::scoped_lock lock(entry->mutex);
+  entry->task_source->PauseSecondary();
 }
 
 void MessageLoopTaskQueues::ResumeSecondarySource(TaskQueueId queue_id) {
-  std::lock_guard guard(queue_mutex_);
-  queue_entries_.at(queue_id)->task_source->ResumeSecondary();
+  LockedQueues queues(*this, queue_id);
+  queues.entry()->task_source->ResumeSecondary();
   // Schedule a wake as needed.
-  if (HasPendingTasksUnlocked(queue_id)) {
-    WakeUpUnlocked(queue_id, GetNextWakeTimeUnlocked(queue_id));
+  if (!queues.is_subsumed()) {
+    WakeUpIfPendingLocked(queues.owner(), queues.subsumed());
   }
 }
 
-// Subsumed queues will never have pending tasks.
-// Owning queues will consider both their and their subsumed tasks.
-bool MessageLoopTaskQueues::HasPendingTasksUnlocked(
-    TaskQueueId queue_id) const {
-  const auto& entry = queue_entries_.at(queue_id);
-  bool is_subsumed = entry->subsumed_by != _kUnmerged;
-  if (is_subsumed) {
-    return false;
+void MessageLoopTaskQueues::SetIdleDeadline(TaskQueueId queue_id,
+                                            fml::TimePoint deadline) {
+  LockedQueues queues(*this, queue_id);
+  queues.entry()->task_source->SetIdleDeadline(deadline);
+  // The idle tasks may be able to run earlier now.
+  if (!queues.is_subsumed()) {
+    WakeUpIfPendingLocked(queues.owner(), queues.subsumed());
   }
+}
 
-  if (!entry->task_source->IsEmpty()) {
-    return true;
+void MessageLoopTaskQueues::WakeUpIfPendingLocked(TaskQueueEntry* owner,
+                                                  TaskQueueEntry* subsumed) {
+  if (HasPendingTasksLocked(owner, subsumed)) {
+    WakeUpLocked(owner, subsumed, GetNextWakeTimeLocked(owner, subsumed));
   }
+}
 
-  const TaskQueueId subsumed = entry->owner_of;
-  if (subsumed == _kUnmerged) {
-    // this is not an owner and queue is empty.
-    return false;
-  } else {
-    return !queue_entries_.at(subsumed)->task_source->IsEmpty();
+// Owning queues will consider both their and their subsumed tasks.
+bool MessageLoopTaskQueues::HasPendingTasksLocked(
+    const TaskQueueEntry* owner,
+    const TaskQueueEntry* subsumed) {
+  if (!owner->task_source->IsEmpty()) {
+    return true;
   }
+  // this is not an owner and queue is empty.
+  return subsumed && !subsumed->task_source->IsEmpty();
 }
 
-fml::TimePoint MessageLoopTaskQueues::GetNextWakeTimeUnlocked(
-    TaskQueueId queue_id) const {
-  return PeekNextTaskUnlocked(queue_id).task.GetTargetTime();
+fml::TimePoint MessageLoopTaskQueues::GetNextWakeTimeLocked(
+    const TaskQueueEntry* owner,
+    const TaskQueueEntry* subsumed) {
+  return PeekNextTaskLocked(owner, subsumed, fml::TimePoint::Now()).run_time;
 }
 
-TaskSource::TopTask MessageLoopTaskQueues::PeekNextTaskUnlocked(
-    TaskQueueId owner) const {
-  FML_DCHECK(HasPendingTasksUnlocked(owner));
-  const auto& entry = queue_entries_.at(owner);
-  const TaskQueueId subsumed = entry->owner_of;
-  if (subsumed == _kUnmerged) {
-    return entry->task_source->Top();
+TaskSource::TopTask MessageLoopTaskQueues::PeekNextTaskLocked(
+    const TaskQueueEntry* owner,
+    const TaskQueueEntry* subsumed,
+    fml::TimePoint now) {
+  FML_DCHECK(HasPendingTasksLocked(owner, subsumed));
+  if (!subsumed) {
+    return owner->task_source->Top(now);
   }
 
-  TaskSource* owner_tasks = entry->task_source.get();
-  TaskSource* subsumed_tasks = queue_entries_.at(subsumed)->task_source.get();
+  TaskSource* owner_tasks = owner->task_source.get();
+  TaskSource* subsumed_tasks = subsumed->task_source.get();
 
   // we are owning another task queue
   const bool subsumed_has_task = !subsumed_tasks->IsEmpty();
   const bool owner_has_task = !owner_tasks->IsEmpty();
-  fml::TaskQueueId top_queue_id = owner;
   if (owner_has_task && subsumed_has_task) {
-    const auto owner_task = owner_tasks->Top();
-    const auto subsumed_task = subsumed_tasks->Top();
-    if (owner_task.task > subsumed_task.task) {
-      top_queue_id = subsumed;
+    const auto owner_task = owner_tasks->Top(now);
+    const auto subsumed_task = subsumed_tasks->Top(now);
+    if (TaskSource::RunsBefore(subsumed_task, owner_task, now)) {
+      return subsumed_task;
     } else {
-      top_queue_id = owner;
+      return owner_task;
     }
   } else if (owner_has_task) {
-    top_queue_id = owner;
+    return owner_tasks->Top(now);
   } else {
-    top_queue_id = subsumed;
+    return subsumed_tasks->Top(now);
   }
-  return queue_entries_.at(top_queue_id)->task_source->Top();
 }
 
 }  // namespace fml
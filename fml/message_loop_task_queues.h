@@ -5,7 +5,9 @@
 #ifndef FLUTTER_FML_MESSAGE_LOOP_TASK_QUEUES_H_
 #define FLUTTER_FML_MESSAGE_LOOP_TASK_QUEUES_H_
 
+#include <atomic>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <vector>
 
@@ -27,10 +29,17 @@ static const TaskQueueId _kUnmerged = TaskQueueId(TaskQueueId::kUnmerged);
 /// Often a TaskQueue has a one-to-one relationship with a fml::MessageLoop,
 /// this isn't the case when TaskQueues are merged via
 /// \p fml::MessageLoopTaskQueues::Merge.
+///
+/// Each entry is guarded by its own \p mutex so that threads working with
+/// different queues do not contend. Tasks that are due immediately can also
+/// be registered without the mutex, see \p PushImmediateTask.
 class TaskQueueEntry {
  public:
   using TaskObservers = std::map<intptr_t, fml::closure>;
-  Wakeable* wakeable;
+
+  // Guards the members below unless noted otherwise.
+  std::mutex mutex;
+
   TaskObservers task_observers;
   std::unique_ptr<TaskSource> task_source;
 
@@ -38,14 +47,42 @@ class TaskQueueEntry {
   // this queue has not been merged or subsumed. OR exactly one
   // of these will be _kUnmerged, if owner_of is _kUnmerged, it means
   // that the queue has been subsumed or else it owns another queue.
-  TaskQueueId owner_of;
-  TaskQueueId subsumed_by;
+  //
+  // Only written with the mutexes of both merged entries held, but may be
+  // read without them.
+  std::atomic<TaskQueueId> owner_of;
+  std::atomic<TaskQueueId> subsumed_by;
 
   TaskQueueId created_for;
 
+  // Guards |wakeable| and serializes the calls to it. Taken after |mutex|
+  // when both are needed.
+  std::mutex wakeable_mutex;
+  Wakeable* wakeable;
+
   explicit TaskQueueEntry(TaskQueueId created_for);
 
+  ~TaskQueueEntry();
+
+  /// Adds a task to the lock-free list of immediate tasks. Safe to call
+  /// from any thread without holding \p mutex. Returns true if the list
+  /// was empty, in which case the caller is responsible for waking up the
+  /// loop servicing this queue.
+  bool PushImmediateTask(DelayedTask task);
+
+  /// Moves the immediate tasks into \p task_source. Requires \p mutex.
+  void DrainImmediateTasks();
+
+  /// Whether immediate tasks have been pushed since the last drain.
+  bool HasImmediateTasks() const;
+
  private:
+  struct ImmediateTask;
+
+  // A lock-free multiple producer, single consumer stack. The holder of
+  // |mutex| is the consumer.
+  std::atomic<ImmediateTask*> immediate_tasks_;
+
   FML_DISALLOW_COPY_ASSIGN_AND_MOVE(TaskQueueEntry);
 };
 
@@ -76,14 +113,15 @@ class MessageLoopTaskQueues
   // Tasks methods.
 
   void RegisterTask(TaskQueueId queue_id,
-                    const fml::closure& task,
+                    fml::UniqueClosure task,
                     fml::TimePoint target_time,
                     fml::TaskSourceGrade task_source_grade =
                         fml::TaskSourceGrade::kUnspecified);
 
   bool HasPendingTasks(TaskQueueId queue_id) const;
 
-  fml::closure GetNextTaskToRun(TaskQueueId queue_id, fml::TimePoint from_time);
+  fml::UniqueClosure GetNextTaskToRun(TaskQueueId queue_id,
+                                      fml::TimePoint from_time);
 
   size_t GetNumPendingTasks(TaskQueueId queue_id) const;
 
@@ -132,30 +170,52 @@ class MessageLoopTaskQueues
 
   void ResumeSecondarySource(TaskQueueId queue_id);
 
+  /// Lets the tasks of \p queue_id graded \p TaskSourceGrade::kIdle run
+  /// until \p deadline. Any previous idle window is replaced.
+  void SetIdleDeadline(TaskQueueId queue_id, fml::TimePoint deadline);
+
  private:
-  class MergedQueuesRunner;
+  class LockedQueues;
 
   MessageLoopTaskQueues();
 
   ~MessageLoopTaskQueues();
 
-  void WakeUpUnlocked(TaskQueueId queue_id, fml::TimePoint time) const;
+  std::shared_ptr<TaskQueueEntry> GetEntry(TaskQueueId queue_id) const;
+
+  // The methods below take the owner of a group of merged queues and the
+  // queue it subsumes, if any, and require the mutexes of both to be held.
+  // Subsumed queues are serviced by the loop of their owner.
+
+  static void WakeUpLocked(TaskQueueEntry* owner,
+                           TaskQueueEntry* subsumed,
+                           fml::TimePoint time);
+
+  static bool HasPendingTasksLocked(const TaskQueueEntry* owner,
+                                    const TaskQueueEntry* subsumed);
 
-  bool HasPendingTasksUnlocked(TaskQueueId queue_id) const;
+  static TaskSource::TopTask PeekNextTaskLocked(const TaskQueueEntry* owner,
+                                                const TaskQueueEntry* subsumed,
+                                                fml::TimePoint now);
 
-  TaskSource::TopTask PeekNextTaskUnlocked(TaskQueueId owner) const;
+  static fml::TimePoint GetNextWakeTimeLocked(const TaskQueueEntry* owner,
+                                              const TaskQueueEntry* subsumed);
 
-  fml::TimePoint GetNextWakeTimeUnlocked(TaskQueueId queue_id) const;
+  static void WakeUpIfPendingLocked(TaskQueueEntry* owner,
+                                    TaskQueueEntry* subsumed);
 
   static std::mutex creation_mutex_;
   static fml::RefPtr<MessageLoopTaskQueues> instance_;
 
-  mutable std::mutex queue_mutex_;
-  std::map<TaskQueueId, std::unique_ptr<TaskQueueEntry>> queue_entries_;
+  // Guards the map of entries but not the entries themselves, which have
+  // mutexes of their own. Only taken exclusively to create and dispose of
+  // queues.
+  std::unique_ptr<fml::SharedMutex> entries_mutex_;
+  std::map<TaskQueueId, std::shared_ptr<TaskQueueEntry>> queue_entries_;
 
   size_t task_queue_id_counter_;
 
-  std::atomic_int order_;
+  std::atomic<size_t> order_;
 
   FML_FRIEND_MAKE_REF_COUNTED(MessageLoopTaskQueues);
   FML_FRIEND_REF_COUNTED_THREAD_SAFE(MessageLoopTaskQueues);
@@ -44,7 +44,7 @@ static void BM_RegisterAndGetTasks(benchmark::State& state) {  // NOLINT
         const auto now = fml::TimePoint::Now();
         int num_invocations = 0;
         for (;;) {
-          fml::closure invocation =
+          fml::UniqueClosure invocation =
               task_queue->GetNextTaskToRun(TaskQueueId(task_runner_id), now);
           if (!invocation) {
             break;
@@ -66,5 +66,64 @@ static void BM_RegisterAndGetTasks(benchmark::State& state) {  // NOLINT
 
 BENCHMARK(BM_RegisterAndGetTasks);
 
+// Registers tasks from |state.range(0)| threads, either each to a queue of
+// its own or all to the same queue.
+static void RegisterTasksConcurrently(benchmark::State& state,
+                                      bool shared_queue) {
+  auto task_queue = fml::MessageLoopTaskQueues::GetInstance();
+  const int num_threads = state.range(0);
+  const int num_tasks_per_thread = 1000;
+
+  while (state.KeepRunning()) {
+    std::vector<TaskQueueId> queue_ids;
+    {
+      ::benchmarking::ScopedPauseTiming pause(state);
+      for (int i = 0; i < (shared_queue ? 1 : num_threads); i++) {
+        queue_ids.push_back(task_queue->CreateTaskQueue());
+      }
+    }
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; i++) {
+      TaskQueueId queue_id = queue_ids[shared_queue ? 0 : i];
+      threads.emplace_back([&task_queue, queue_id]() {
+        const auto now = fml::TimePoint::Now();
+        for (int j = 0; j < num_tasks_per_thread; j++) {
+          task_queue->RegisterTask(
+              queue_id, [] {}, now);
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    {
+      ::benchmarking::ScopedPauseTiming pause(state);
+      for (auto queue_id : queue_ids) {
+        task_queue->Dispose(queue_id);
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * num_threads *
+                          num_tasks_per_thread);
+}
+
+static void BM_RegisterTasksToSeparateQueues(benchmark::State& state) {
+  RegisterTasksConcurrently(state, false);
+}
+BENCHMARK(BM_RegisterTasksToSeparateQueues)
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->UseRealTime();
+
+static void BM_RegisterTasksToSharedQueue(benchmark::State& state) {
+  RegisterTasksConcurrently(state, true);
+}
+BENCHMARK(BM_RegisterTasksToSharedQueue)
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->UseRealTime();
+
 }  // namespace benchmarking
 }  // namespace fml
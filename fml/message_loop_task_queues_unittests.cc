@@ -78,7 +78,8 @@ TEST(MessageLoopTaskQueue, PreserveTaskOrdering) {
   const auto now = fml::TimePoint::Now();
   int expected_value = 1;
   for (;;) {
-    fml::closure invocation = task_queue->GetNextTaskToRun(queue_id, now);
+    fml::UniqueClosure invocation =
+        task_queue->GetNextTaskToRun(queue_id, now);
     if (!invocation) {
       break;
     }
@@ -292,5 +293,123 @@ TEST(MessageLoopTaskQueue, RegisterTaskWakesUpOwnerQueue) {
   ASSERT_EQ(time1, wakes[2]);
 }
 
+TEST(MessageLoopTaskQueue, IdleTasksRunInIdleWindow) {
+  auto task_queue = fml::MessageLoopTaskQueues::GetInstance();
+  auto queue_id = task_queue->CreateTaskQueue();
+
+  std::vector<fml::TimePoint> wakes;
+  task_queue->SetWakeable(queue_id,
+                          new TestWakeable([&wakes](fml::TimePoint wake_time) {
+                            wakes.push_back(wake_time);
+                          }));
+
+  const auto time = fml::TimePoint::Now();
+  bool ran = false;
+  task_queue->RegisterTask(
+      queue_id, [&ran]() { ran = true; }, time, fml::TaskSourceGrade::kIdle);
+  ASSERT_EQ(1UL, wakes.size());
+  ASSERT_EQ(time + TaskSource::kMaxIdleTaskDelay, wakes[0]);
+  ASSERT_FALSE(task_queue->GetNextTaskToRun(queue_id, time));
+
+  task_queue->SetIdleDeadline(queue_id, time + fml::TimeDelta::FromSeconds(10));
+  ASSERT_EQ(time, wakes.back());
+  fml::UniqueClosure task = task_queue->GetNextTaskToRun(queue_id, time);
+  ASSERT_TRUE(task);
+  task();
+  ASSERT_TRUE(ran);
+}
+
+TEST(MessageLoopTaskQueue, UserInteractionTasksRunFirstOnMergedQueues) {
+  auto task_queue = fml::MessageLoopTaskQueues::GetInstance();
+  auto platform_queue = task_queue->CreateTaskQueue();
+  auto raster_queue = task_queue->CreateTaskQueue();
+  task_queue->Merge(platform_queue, raster_queue);
+
+  int test_val = 0;
+  task_queue->RegisterTask(
+      platform_queue, [&test_val]() { test_val = 1; }, fml::TimePoint::Now());
+  task_queue->RegisterTask(
+      raster_queue, [&test_val]() { test_val = 2; }, fml::TimePoint::Now(),
+      fml::TaskSourceGrade::kUserInteraction);
+
+  const auto now = fml::TimePoint::Now();
+  task_queue->GetNextTaskToRun(platform_queue, now)();
+  ASSERT_EQ(test_val, 2);
+  task_queue->GetNextTaskToRun(platform_queue, now)();
+  ASSERT_EQ(test_val, 1);
+}
+
+TEST(MessageLoopTaskQueue, ImmediateTasksWakeUpOnce) {
+  auto task_queue = fml::MessageLoopTaskQueues::GetInstance();
+  auto queue_id = task_queue->CreateTaskQueue();
+
+  std::vector<fml::TimePoint> wakes;
+  task_queue->SetWakeable(queue_id,
+                          new TestWakeable([&wakes](fml::TimePoint wake_time) {
+                            wakes.push_back(wake_time);
+                          }));
+
+  const auto past = fml::TimePoint::Now();
+  task_queue->RegisterTask(
+      queue_id, [] {}, past);
+  task_queue->RegisterTask(
+      queue_id, [] {}, past);
+
+  // The loop is already woken up for the first task.
+  ASSERT_EQ(1UL, wakes.size());
+  ASSERT_EQ(past, wakes[0]);
+
+  // Counting the tasks moves them into the queue, so the next one wakes up
+  // the loop again.
+  ASSERT_EQ(2UL, task_queue->GetNumPendingTasks(queue_id));
+  task_queue->RegisterTask(
+      queue_id, [] {}, past);
+  ASSERT_EQ(2UL, wakes.size());
+}
+
+//------------------------------------------------------------------------------
+/// Verifies that immediate tasks posted concurrently to a subsumed queue are
+/// run by the owner in the order they were posted by each thread.
+///
+TEST(MessageLoopTaskQueue, ConcurrentImmediateTasksOnMergedQueues) {
+  auto task_queues = fml::MessageLoopTaskQueues::GetInstance();
+  auto owner = task_queues->CreateTaskQueue();
+  auto subsumed = task_queues->CreateTaskQueue();
+  ASSERT_TRUE(task_queues->Merge(owner, subsumed));
+
+  constexpr size_t kThreadCount = 4;
+  constexpr size_t kThreadTaskCount = 500;
+
+  std::vector<std::vector<size_t>> runs(kThreadCount);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < kThreadCount; i++) {
+    threads.emplace_back([&, thread_index = i]() {
+      for (size_t j = 0; j < kThreadTaskCount; j++) {
+        task_queues->RegisterTask(
+            j % 2 ? owner : subsumed,
+            [&runs, thread_index, j]() { runs[thread_index].push_back(j); },
+            fml::TimePoint::Now());
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_EQ(0UL, task_queues->GetNumPendingTasks(subsumed));
+  ASSERT_EQ(kThreadCount * kThreadTaskCount,
+            task_queues->GetNumPendingTasks(owner));
+
+  const auto now = fml::TimePoint::Now();
+  while (fml::UniqueClosure task = task_queues->GetNextTaskToRun(owner, now)) {
+    task();
+  }
+  for (const auto& run : runs) {
+    ASSERT_EQ(kThreadTaskCount, run.size());
+    ASSERT_TRUE(std::is_sorted(run.begin(), run.end()));
+  }
+  ASSERT_FALSE(task_queues->HasPendingTasks(owner));
+}
+
 }  // namespace testing
 }  // namespace fml
@@ -7,7 +7,9 @@
 #include "flutter/fml/message_loop.h"
 
 #include <iostream>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include "flutter/fml/build_config.h"
 #include "flutter/fml/concurrent_message_loop.h"
@@ -316,3 +318,53 @@ TEST(MessageLoop, CanCreateConcurrentMessageLoop) {
   latch.Wait();
   ASSERT_GE(thread_ids.size(), 1u);
 }
+
+TEST(MessageLoop, ConcurrentMessageLoopRunsHighPriorityTasksFirst) {
+  auto loop = fml::ConcurrentMessageLoop::Create(1u);
+  auto task_runner = loop->GetTaskRunner();
+  fml::AutoResetWaitableEvent started;
+  fml::ManualResetWaitableEvent release;
+  // Keep the only worker busy until all tasks are posted.
+  task_runner->PostTask([&]() {
+    started.Signal();
+    release.Wait();
+  });
+  started.Wait();
+
+  const size_t kCount = 3;
+  fml::CountDownLatch latch(2 * kCount);
+  std::vector<std::string> runs;
+  for (size_t i = 0; i < kCount; ++i) {
+    task_runner->PostTask([&runs, &latch, i]() {
+      runs.push_back("normal" + std::to_string(i));
+      latch.CountDown();
+    });
+    task_runner->PostHighPriorityTask([&runs, &latch, i]() {
+      runs.push_back("high" + std::to_string(i));
+      latch.CountDown();
+    });
+  }
+  release.Signal();
+  latch.Wait();
+
+  std::vector<std::string> expected = {"high0",   "high1",   "high2",
+                                       "normal0", "normal1", "normal2"};
+  ASSERT_EQ(runs, expected);
+}
+
+TEST(MessageLoop, ConcurrentMessageLoopWorkersStealTasks) {
+  auto loop = fml::ConcurrentMessageLoop::Create(2u);
+  auto task_runner = loop->GetTaskRunner();
+  fml::AutoResetWaitableEvent done;
+  bool stolen = false;
+  task_runner->PostTask([&]() {
+    // Tasks posted from a worker are queued on that worker, which is blocked
+    // until the task has been run by the other worker.
+    fml::AutoResetWaitableEvent ran;
+    task_runner->PostTask([&ran]() { ran.Signal(); });
+    stolen = !ran.WaitWithTimeout(fml::TimeDelta::FromSeconds(10));
+    done.Signal();
+  });
+  done.Wait();
+  ASSERT_TRUE(stolen);
+}
@@ -5,8 +5,12 @@
 #include "flutter/fml/platform/linux/message_loop_linux.h"
 
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <limits>
+
 #include "flutter/fml/eintr_wrapper.h"
 #include "flutter/fml/platform/linux/timerfd.h"
 
@@ -14,32 +18,48 @@ namespace fml {
 
 static constexpr int kClockType = CLOCK_MONOTONIC;
 
+static constexpr int64_t kTimerDisarmed = std::numeric_limits<int64_t>::max();
+
+static std::atomic<int64_t> gTimerSlackNanoseconds;
+
+void MessageLoopLinux::SetTimerSlack(fml::TimeDelta slack) {
+  gTimerSlackNanoseconds.store(std::max<int64_t>(slack.ToNanoseconds(), 0),
+                               std::memory_order_relaxed);
+}
+
 MessageLoopLinux::MessageLoopLinux()
     : epoll_fd_(FML_HANDLE_EINTR(::epoll_create(1 /* unused */))),
       timer_fd_(::timerfd_create(kClockType, TFD_NONBLOCK | TFD_CLOEXEC)),
-      running_(false) {
+      wake_fd_(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+      running_(false),
+      armed_time_(kTimerDisarmed),
+      wake_pending_(false) {
   FML_CHECK(epoll_fd_.is_valid());
   FML_CHECK(timer_fd_.is_valid());
-  bool added_source = AddOrRemoveTimerSource(true);
+  FML_CHECK(wake_fd_.is_valid());
+  bool added_source = AddOrRemoveSource(timer_fd_.get(), true);
+  FML_CHECK(added_source);
+  added_source = AddOrRemoveSource(wake_fd_.get(), true);
   FML_CHECK(added_source);
 }
 
 MessageLoopLinux::~MessageLoopLinux() {
-  bool removed_source = AddOrRemoveTimerSource(false);
+  bool removed_source = AddOrRemoveSource(wake_fd_.get(), false);
+  FML_CHECK(removed_source);
+  removed_source = AddOrRemoveSource(timer_fd_.get(), false);
   FML_CHECK(removed_source);
 }
 
-bool MessageLoopLinux::AddOrRemoveTimerSource(bool add) {
+bool MessageLoopLinux::AddOrRemoveSource(int fd, bool add) {
   struct epoll_event event = {};
 
   event.events = EPOLLIN;
   // The data is just for informational purposes so we know when we were worken
   // by the FD.
-  event.data.fd = timer_fd_.get();
+  event.data.fd = fd;
 
-  int ctl_result =
-      ::epoll_ctl(epoll_fd_.get(), add ? EPOLL_CTL_ADD : EPOLL_CTL_DEL,
-                  timer_fd_.get(), &event);
+  int ctl_result = ::epoll_ctl(
+      epoll_fd_.get(), add ? EPOLL_CTL_ADD : EPOLL_CTL_DEL, fd, &event);
   return ctl_result == 0;
 }
 
@@ -48,26 +68,46 @@ void MessageLoopLinux::Run() {
   running_ = true;
 
   while (running_) {
-    struct epoll_event event = {};
+    // Both sources may be ready at once, in which case the expired tasks are
+    // only run once.
+    struct epoll_event events[2] = {};
 
     int epoll_result = FML_HANDLE_EINTR(
-        ::epoll_wait(epoll_fd_.get(), &event, 1, -1 /* timeout */));
+        ::epoll_wait(epoll_fd_.get(), events, 2, -1 /* timeout */));
 
-    // Errors are fatal.
-    if (event.events & (EPOLLERR | EPOLLHUP)) {
+    // Timeouts are fatal since we specified an infinite timeout already.
+    if (epoll_result < 1) {
       running_ = false;
       continue;
     }
 
-    // Timeouts are fatal since we specified an infinite timeout already.
-    // Likewise, > 1 is not possible since we waited for one result.
-    if (epoll_result != 1) {
-      running_ = false;
+    bool timer_fired = false;
+    bool wake_fd_signaled = false;
+    for (int i = 0; i < epoll_result; i++) {
+      // Errors are fatal.
+      if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+        running_ = false;
+      } else if (events[i].data.fd == timer_fd_.get()) {
+        timer_fired = true;
+      } else if (events[i].data.fd == wake_fd_.get()) {
+        wake_fd_signaled = true;
+      }
+    }
+    if (!running_) {
       continue;
     }
 
-    if (event.data.fd == timer_fd_.get()) {
-      OnEventFired();
+    bool run_tasks = false;
+    if (wake_fd_signaled) {
+      OnWakeFdSignaled();
+      run_tasks = true;
+    }
+    if (timer_fired && TimerDrain(timer_fd_.get())) {
+      OnTimerFired(fml::TimePoint::Now());
+      run_tasks = true;
+    }
+    if (run_tasks) {
+      RunExpiredTasksNow();
     }
   }
 }
@@ -80,14 +120,52 @@ void MessageLoopLinux::Terminate() {
 
 // |fml::MessageLoopImpl|
 void MessageLoopLinux::WakeUp(fml::TimePoint time_point) {
+  if (time_point <= fml::TimePoint::Now()) {
+    // Bursts of immediate wake ups only signal the loop once.
+    if (!wake_pending_.exchange(true, std::memory_order_acq_rel)) {
+      uint64_t value = 1;
+      ssize_t result =
+          FML_HANDLE_EINTR(::write(wake_fd_.get(), &value, sizeof(value)));
+      FML_DCHECK(result == sizeof(value));
+    }
+    return;
+  }
+
+  // Waking up at the armed time is fine even if it is earlier than needed
+  // since the loop asks for its next wake up after running tasks. Only the
+  // calls serialized by the task queues race here, and the loop only
+  // replaces times that have passed, so this never postpones a pending wake
+  // up by more than the slack.
+  const int64_t time = time_point.ToEpochDelta().ToNanoseconds();
+  const int64_t slack = gTimerSlackNanoseconds.load(std::memory_order_relaxed);
+  if (time >= armed_time_.load(std::memory_order_acquire) - slack) {
+    return;
+  }
+  armed_time_.store(time, std::memory_order_release);
   bool result = TimerRearm(timer_fd_.get(), time_point);
   FML_DCHECK(result);
 }
 
-void MessageLoopLinux::OnEventFired() {
-  if (TimerDrain(timer_fd_.get())) {
-    RunExpiredTasksNow();
+void MessageLoopLinux::OnTimerFired(fml::TimePoint now) {
+  // The timer is no longer armed unless it was rearmed for a later time in
+  // the meantime.
+  const int64_t now_ticks = now.ToEpochDelta().ToNanoseconds();
+  int64_t armed_time = armed_time_.load(std::memory_order_acquire);
+  while (armed_time <= now_ticks &&
+         !armed_time_.compare_exchange_weak(armed_time, kTimerDisarmed,
+                                            std::memory_order_acq_rel)) {
   }
 }
 
+void MessageLoopLinux::OnWakeFdSignaled() {
+  // Drain before clearing the flag. A wake up that comes in between sees the
+  // flag set and skips signaling, which is fine since its task was queued
+  // before the tasks are run. Clearing first would let the drain consume the
+  // signal of a wake up that set the flag again, leaving it set for good.
+  // Wake ups that come in while the tasks run signal the loop again.
+  uint64_t value = 0;
+  FML_HANDLE_EINTR(::read(wake_fd_.get(), &value, sizeof(value)));
+  wake_pending_.store(false, std::memory_order_release);
+}
+
 }  // namespace fml
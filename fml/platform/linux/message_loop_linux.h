@@ -13,11 +13,31 @@
 
 namespace fml {
 
+namespace testing {
+class MessageLoopLinuxTest;
+}  // namespace testing
+
 class MessageLoopLinux : public MessageLoopImpl {
+ public:
+  /// Lets the loops postpone a wake up by up to \p slack so that it can be
+  /// served by a timer that is already armed, instead of rearming the timer
+  /// for every delayed task. Immediate wake ups are never postponed. There
+  /// is no slack by default. Shells set it from
+  /// |flutter::Settings::message_loop_timer_slack_us|.
+  static void SetTimerSlack(fml::TimeDelta slack);
+
  private:
   fml::UniqueFD epoll_fd_;
   fml::UniqueFD timer_fd_;
+  // Signaled for wake ups that are due immediately, which is cheaper than
+  // rearming the timer.
+  fml::UniqueFD wake_fd_;
   bool running_;
+  // The time the timer is armed for, in ticks of |fml::TimePoint|, or the
+  // maximum value if it is not armed.
+  std::atomic<int64_t> armed_time_;
+  // Whether |wake_fd_| has been signaled and not drained yet.
+  std::atomic<bool> wake_pending_;
 
   MessageLoopLinux();
 
@@ -32,10 +52,13 @@ class MessageLoopLinux : public MessageLoopImpl {
   // |fml::MessageLoopImpl|
   void WakeUp(fml::TimePoint time_point) override;
 
-  void OnEventFired();
+  void OnTimerFired(fml::TimePoint now);
+
+  void OnWakeFdSignaled();
 
-  bool AddOrRemoveTimerSource(bool add);
+  bool AddOrRemoveSource(int fd, bool add);
 
+  friend class testing::MessageLoopLinuxTest;
   FML_FRIEND_MAKE_REF_COUNTED(MessageLoopLinux);
   FML_FRIEND_REF_COUNTED_THREAD_SAFE(MessageLoopLinux);
   FML_DISALLOW_COPY_AND_ASSIGN(MessageLoopLinux);
@@ -0,0 +1,148 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/fml/platform/linux/message_loop_linux.h"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "flutter/fml/eintr_wrapper.h"
+#include "flutter/fml/platform/linux/timerfd.h"
+#include "flutter/fml/synchronization/waitable_event.h"
+#include "flutter/fml/thread.h"
+#include "gtest/gtest.h"
+
+namespace fml {
+namespace testing {
+
+class MessageLoopLinuxTest : public ::testing::Test {
+ public:
+  MessageLoopLinuxTest() : loop_(fml::MakeRefCounted<MessageLoopLinux>()) {}
+
+  ~MessageLoopLinuxTest() override {
+    MessageLoopLinux::SetTimerSlack(fml::TimeDelta::Zero());
+  }
+
+ protected:
+  void WakeUp(fml::TimePoint time_point) { loop_->WakeUp(time_point); }
+
+  void OnWakeFdSignaled() { loop_->OnWakeFdSignaled(); }
+
+  // Returns the time the timer is armed for according to the loop, or
+  // |fml::TimePoint::Max| if it is not armed.
+  fml::TimePoint GetArmedTime() const {
+    const int64_t armed_time = loop_->armed_time_.load();
+    if (armed_time == fml::TimePoint::Max().ToEpochDelta().ToNanoseconds()) {
+      return fml::TimePoint::Max();
+    }
+    return fml::TimePoint::FromEpochDelta(
+        fml::TimeDelta::FromNanoseconds(armed_time));
+  }
+
+  // Returns the time until the timer fires according to the kernel.
+  fml::TimeDelta GetTimerRemainingTime() const {
+    struct itimerspec spec = {};
+    ::timerfd_gettime(loop_->timer_fd_.get(), &spec);
+    return fml::TimeDelta::FromTimespec(spec.it_value);
+  }
+
+  // Returns the number of times the wake fd was signaled since it was last
+  // drained, and drains it.
+  uint64_t DrainWakeFd() {
+    uint64_t value = 0;
+    FML_HANDLE_EINTR(::read(loop_->wake_fd_.get(), &value, sizeof(value)));
+    return value;
+  }
+
+ private:
+  fml::RefPtr<MessageLoopLinux> loop_;
+};
+
+TEST_F(MessageLoopLinuxTest, ImmediateWakeUpsSignalOnceUntilDrained) {
+  WakeUp(fml::TimePoint::Now());
+  WakeUp(fml::TimePoint::Now());
+  WakeUp(fml::TimePoint::Now());
+  OnWakeFdSignaled();
+  ASSERT_EQ(DrainWakeFd(), 0u);
+
+  WakeUp(fml::TimePoint::Now());
+  ASSERT_EQ(DrainWakeFd(), 1u);
+  // Immediate wake ups do not arm the timer.
+  ASSERT_EQ(GetArmedTime(), fml::TimePoint::Max());
+}
+
+TEST_F(MessageLoopLinuxTest, OnlyRearmsForEarlierWakeUps) {
+  const auto now = fml::TimePoint::Now();
+  const auto first = now + fml::TimeDelta::FromSeconds(10);
+  WakeUp(first);
+  ASSERT_EQ(GetArmedTime(), first);
+
+  WakeUp(now + fml::TimeDelta::FromSeconds(20));
+  ASSERT_EQ(GetArmedTime(), first);
+  ASSERT_GT(GetTimerRemainingTime(), fml::TimeDelta::FromSeconds(5));
+  ASSERT_LE(GetTimerRemainingTime(), fml::TimeDelta::FromSeconds(10));
+
+  const auto earlier = now + fml::TimeDelta::FromSeconds(5);
+  WakeUp(earlier);
+  ASSERT_EQ(GetArmedTime(), earlier);
+  ASSERT_LE(GetTimerRemainingTime(), fml::TimeDelta::FromSeconds(5));
+}
+
+TEST_F(MessageLoopLinuxTest, ServesWakeUpsWithinTheSlackWithTheArmedTimer) {
+  MessageLoopLinux::SetTimerSlack(fml::TimeDelta::FromSeconds(1));
+  const auto now = fml::TimePoint::Now();
+  const auto armed = now + fml::TimeDelta::FromSeconds(10);
+  WakeUp(armed);
+  ASSERT_EQ(GetArmedTime(), armed);
+
+  WakeUp(armed - fml::TimeDelta::FromMilliseconds(500));
+  ASSERT_EQ(GetArmedTime(), armed);
+
+  const auto outside_slack = armed - fml::TimeDelta::FromSeconds(2);
+  WakeUp(outside_slack);
+  ASSERT_EQ(GetArmedTime(), outside_slack);
+
+  // Immediate wake ups are never postponed.
+  WakeUp(fml::TimePoint::Now());
+  ASSERT_EQ(DrainWakeFd(), 1u);
+}
+
+TEST(MessageLoopLinux, NoTaskPostedFromManyThreadsIsLost) {
+  constexpr int kRounds = 10;
+  constexpr int kPosters = 4;
+  constexpr int kTasksPerPoster = 2000;
+  fml::Thread loop_thread;
+  auto task_runner = loop_thread.GetTaskRunner();
+  for (int round = 0; round < kRounds; round++) {
+    std::atomic<int> remaining = kPosters * kTasksPerPoster;
+    fml::ManualResetWaitableEvent done;
+    std::vector<std::thread> posters;
+    for (int i = 0; i < kPosters; i++) {
+      // Posting one task at a time keeps the loop waking up while the other
+      // threads post.
+      posters.emplace_back([&]() {
+        for (int j = 0; j < kTasksPerPoster; j++) {
+          task_runner->PostTask([&remaining, &done]() {
+            if (--remaining == 0) {
+              done.Signal();
+            }
+          });
+          std::this_thread::yield();
+        }
+      });
+    }
+    for (auto& poster : posters) {
+      poster.join();
+    }
+    // No timer is armed, so a lost wake up leaves the tasks pending.
+    ASSERT_FALSE(done.WaitWithTimeout(fml::TimeDelta::FromSeconds(5)))
+        << "Tasks were lost in round " << round;
+  }
+}
+
+}  // namespace testing
+}  // namespace fml
@@ -232,6 +232,29 @@ bool WriteAtomically(const fml::UniqueFD& base_directory,
                     base_directory.get(), file_name) == 0;
 }
 
+bool AppendToFile(const fml::UniqueFD& file, const Mapping& mapping) {
+  if (!file.is_valid() || mapping.GetMapping() == nullptr) {
+    return false;
+  }
+
+  if (::lseek(file.get(), 0, SEEK_END) == -1) {
+    return false;
+  }
+
+  ssize_t remaining = mapping.GetSize();
+  ssize_t offset = 0;
+  while (remaining > 0) {
+    ssize_t written = FML_HANDLE_EINTR(
+        ::write(file.get(), mapping.GetMapping() + offset, remaining));
+    if (written == -1) {
+      return false;
+    }
+    remaining -= written;
+    offset += written;
+  }
+  return true;
+}
+
 bool VisitFiles(const fml::UniqueFD& directory, const FileVisitor& visitor) {
   fml::UniqueFD dup_fd(dup(directory.get()));
   if (!dup_fd.is_valid()) {
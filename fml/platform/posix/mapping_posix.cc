@@ -9,7 +9,9 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <type_traits>
+#include <vector>
 
 #include "flutter/fml/build_config.h"
 #include "flutter/fml/eintr_wrapper.h"
@@ -50,6 +52,79 @@ Mapping::Mapping() = default;
 
 Mapping::~Mapping() = default;
 
+// Returns the page aligned bounds of the given range of |mapping|, or false
+// if the range is empty.
+static bool GetPageRange(const FileMapping& mapping,
+                         size_t offset,
+                         size_t length,
+                         uintptr_t* begin,
+                         uintptr_t* end) {
+  const size_t size = mapping.GetSize();
+  const uint8_t* data = mapping.GetMapping();
+  if (data == nullptr || offset >= size) {
+    return false;
+  }
+  const uintptr_t page_size = ::sysconf(_SC_PAGESIZE);
+  const uintptr_t start = reinterpret_cast<uintptr_t>(data) + offset;
+  *begin = start & ~(page_size - 1);
+  *end = (start + std::min(length, size - offset) + page_size - 1) &
+         ~(page_size - 1);
+  return true;
+}
+
+bool FileMapping::Advise(Advice advice, size_t offset, size_t length) const {
+  uintptr_t begin = 0;
+  uintptr_t end = 0;
+  if (!GetPageRange(*this, offset, length, &begin, &end)) {
+    return false;
+  }
+  int posix_advice = MADV_NORMAL;
+  switch (advice) {
+    case Advice::kNormal:
+      posix_advice = MADV_NORMAL;
+      break;
+    case Advice::kSequential:
+      posix_advice = MADV_SEQUENTIAL;
+      break;
+    case Advice::kRandom:
+      posix_advice = MADV_RANDOM;
+      break;
+    case Advice::kWillNeed:
+      posix_advice = MADV_WILLNEED;
+      break;
+  }
+  return ::madvise(reinterpret_cast<void*>(begin), end - begin,
+                   posix_advice) == 0;
+}
+
+std::optional<size_t> FileMapping::GetResidentSize(size_t offset,
+                                                   size_t length) const {
+#if OS_FUCHSIA
+  return std::nullopt;
+#else   // OS_FUCHSIA
+  uintptr_t begin = 0;
+  uintptr_t end = 0;
+  if (!GetPageRange(*this, offset, length, &begin, &end)) {
+    return 0;
+  }
+  const size_t page_size = ::sysconf(_SC_PAGESIZE);
+  const size_t page_count = (end - begin) / page_size;
+#if OS_MACOSX
+  std::vector<char> residency(page_count);
+#else   // OS_MACOSX
+  std::vector<unsigned char> residency(page_count);
+#endif  // OS_MACOSX
+  if (::mincore(reinterpret_cast<void*>(begin), end - begin,
+                residency.data()) != 0) {
+    return std::nullopt;
+  }
+  const size_t resident_pages =
+      std::count_if(residency.begin(), residency.end(),
+                    [](auto page) { return (page & 1) != 0; });
+  return resident_pages * page_size;
+#endif  // OS_FUCHSIA
+}
+
 FileMapping::FileMapping(const fml::UniqueFD& handle,
                          std::initializer_list<Protection> protection)
     : size_(0), mapping_(nullptr) {
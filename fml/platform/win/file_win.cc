@@ -97,16 +97,18 @@ static DWORD GetDesiredAccessFlags(FilePermission permission) {
   return GENERIC_READ;
 }
 
+// Open files can be deleted or replaced, as with WriteAtomically, like they
+// can on POSIX.
 static DWORD GetShareFlags(FilePermission permission) {
   switch (permission) {
     case FilePermission::kRead:
-      return FILE_SHARE_READ;
+      return FILE_SHARE_READ | FILE_SHARE_DELETE;
     case FilePermission::kWrite:
-      return FILE_SHARE_WRITE;
+      return FILE_SHARE_WRITE | FILE_SHARE_DELETE;
     case FilePermission::kReadWrite:
-      return FILE_SHARE_READ | FILE_SHARE_WRITE;
+      return FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE;
   }
-  return FILE_SHARE_READ;
+  return FILE_SHARE_READ | FILE_SHARE_DELETE;
 }
 
 static DWORD GetFileAttributesForUtf8Path(const char* absolute_path) {
@@ -444,8 +446,9 @@ bool WriteAtomically(const fml::UniqueFD& base_directory,
 
   temp_file.reset();
 
-  if (!::MoveFile(StringToWideString(temp_file_path).c_str(),
-                  StringToWideString(file_path).c_str())) {
+  if (!::MoveFileEx(StringToWideString(temp_file_path).c_str(),
+                    StringToWideString(file_path).c_str(),
+                    MOVEFILE_REPLACE_EXISTING)) {
     FML_DLOG(ERROR)
         << "Could not replace temp file at correct path. File path: "
         << file_path << ". Temp file path: " << temp_file_path << " "
@@ -456,6 +459,35 @@ bool WriteAtomically(const fml::UniqueFD& base_directory,
   return true;
 }
 
+bool AppendToFile(const fml::UniqueFD& file, const Mapping& mapping) {
+  if (!file.is_valid() || mapping.GetMapping() == nullptr) {
+    return false;
+  }
+
+  LARGE_INTEGER distance = {};
+  if (!::SetFilePointerEx(file.get(), distance, nullptr, FILE_END)) {
+    FML_DLOG(ERROR) << "Could not seek to the end of the file. "
+                    << GetLastErrorMessage();
+    return false;
+  }
+
+  const uint8_t* data = mapping.GetMapping();
+  size_t remaining = mapping.GetSize();
+  while (remaining > 0) {
+    DWORD written = 0;
+    DWORD to_write =
+        static_cast<DWORD>(std::min<size_t>(remaining, MAXDWORD));
+    if (!::WriteFile(file.get(), data, to_write, &written, nullptr)) {
+      FML_DLOG(ERROR) << "Could not write to the file. "
+                      << GetLastErrorMessage();
+      return false;
+    }
+    data += written;
+    remaining -= written;
+  }
+  return true;
+}
+
 bool VisitFiles(const fml::UniqueFD& directory, const FileVisitor& visitor) {
   std::string search_pattern = GetFullHandlePath(directory) + "\\*";
   WIN32_FIND_DATA find_file_data;
@@ -20,6 +20,17 @@ Mapping::Mapping() = default;
 
 Mapping::~Mapping() = default;
 
+bool FileMapping::Advise(Advice advice, size_t offset, size_t length) const {
+  // Not supported.
+  return false;
+}
+
+std::optional<size_t> FileMapping::GetResidentSize(size_t offset,
+                                                   size_t length) const {
+  // Not supported.
+  return std::nullopt;
+}
+
 static bool IsWritable(
     std::initializer_list<FileMapping::Protection> protection_flags) {
   for (auto protection : protection_flags) {
@@ -6,12 +6,19 @@
 
 #include "flutter/fml/raster_thread_merger.h"
 
+#include <algorithm>
+
 #include "flutter/fml/message_loop_impl.h"
+#include "flutter/fml/trace_event.h"
 
 namespace fml {
 
 const int RasterThreadMerger::kLeaseNotSet = -1;
 
+const size_t RasterThreadMerger::kMaxPredictedLeaseTerm = 60;
+
+const size_t RasterThreadMerger::kMinGapsToPredict = 2;
+
 RasterThreadMerger::RasterThreadMerger(fml::TaskQueueId platform_queue_id,
                                        fml::TaskQueueId gpu_queue_id)
     : platform_queue_id_(platform_queue_id),
@@ -35,18 +42,23 @@ void RasterThreadMerger::MergeWithLease(size_t lease_term) {
     return;
   }
   FML_DCHECK(lease_term > 0) << "lease_term should be positive.";
+  frame_has_platform_views_ = true;
 
   if (IsMergedUnSafe()) {
     merged_condition_.notify_one();
     return;
   }
 
+  const fml::TimePoint request_time = fml::TimePoint::Now();
   bool success = task_queues_->Merge(platform_queue_id_, gpu_queue_id_);
   if (success && merge_unmerge_callback_ != nullptr) {
     merge_unmerge_callback_();
   }
   FML_CHECK(success) << "Unable to merge the raster and platform threads.";
-  lease_term_ = lease_term;
+  lease_term_ = PredictLeaseTermUnSafe(lease_term);
+  metrics_.merge_count++;
+  metrics_.last_lease_term = lease_term_;
+  merge_request_time_ = request_time;
 
   merged_condition_.notify_one();
 }
@@ -60,11 +72,20 @@ void RasterThreadMerger::UnMergeNow() {
     return;
   }
   lease_term_ = 0;
+  const fml::TimePoint start = fml::TimePoint::Now();
   bool success = task_queues_->Unmerge(platform_queue_id_);
   if (success && merge_unmerge_callback_ != nullptr) {
     merge_unmerge_callback_();
   }
   FML_CHECK(success) << "Unable to un-merge the raster and platform threads.";
+  const fml::TimeDelta latency = fml::TimePoint::Now() - start;
+  // The threads un-merged before the first frame on the platform thread
+  // ended, so there is no merge latency to report.
+  merge_request_time_ = fml::TimePoint();
+  pending_unmerge_latency_ = pending_unmerge_latency_ + latency;
+  metrics_.unmerge_count++;
+  metrics_.last_unmerge_latency = latency;
+  TraceMetricsUnSafe();
 }
 
 bool RasterThreadMerger::IsOnPlatformThread() const {
@@ -85,9 +106,12 @@ void RasterThreadMerger::ExtendLeaseTo(size_t lease_term) {
   }
   std::scoped_lock lock(lease_term_mutex_);
   FML_DCHECK(IsMergedUnSafe()) << "lease_term should be positive.";
+  frame_has_platform_views_ = true;
+  lease_term = PredictLeaseTermUnSafe(lease_term);
   if (lease_term_ != kLeaseNotSet &&
       static_cast<int>(lease_term) > lease_term_) {
     lease_term_ = lease_term;
+    metrics_.last_lease_term = lease_term;
   }
 }
 
@@ -137,6 +161,9 @@ RasterThreadStatus RasterThreadMerger::DecrementLease() {
     return RasterThreadStatus::kRemainsMerged;
   }
   std::unique_lock<std::mutex> lock(lease_term_mutex_);
+  platform_view_history_ =
+      (platform_view_history_ << 1) | (frame_has_platform_views_ ? 1 : 0);
+  frame_has_platform_views_ = false;
   if (!IsMergedUnSafe()) {
     return RasterThreadStatus::kRemainsUnmerged;
   }
@@ -156,4 +183,66 @@ RasterThreadStatus RasterThreadMerger::DecrementLease() {
   return RasterThreadStatus::kRemainsMerged;
 }
 
+RasterThreadMerger::Metrics RasterThreadMerger::GetMetrics() {
+  std::scoped_lock lock(lease_term_mutex_);
+  return metrics_;
+}
+
+fml::TimeDelta RasterThreadMerger::TakeTransitionLatency() {
+  if (TaskQueuesAreSame()) {
+    return fml::TimeDelta::Zero();
+  }
+  std::scoped_lock lock(lease_term_mutex_);
+  fml::TimeDelta latency = pending_unmerge_latency_;
+  pending_unmerge_latency_ = fml::TimeDelta::Zero();
+  if (merge_request_time_ != fml::TimePoint() && IsMergedUnSafe()) {
+    metrics_.last_merge_latency = fml::TimePoint::Now() - merge_request_time_;
+    merge_request_time_ = fml::TimePoint();
+    latency = latency + metrics_.last_merge_latency;
+    TraceMetricsUnSafe();
+  }
+  return latency;
+}
+
+size_t RasterThreadMerger::PredictLeaseTermUnSafe(size_t lease_term) const {
+  // Walks the frames from the most recent, the current frame included, and
+  // measures the runs of frames without platform views that ended with
+  // platform views coming back.
+  const uint64_t history =
+      (platform_view_history_ << 1) | (frame_has_platform_views_ ? 1 : 0);
+  size_t gaps = 0;
+  size_t longest_gap = 0;
+  size_t run = 0;
+  bool seen_platform_views = false;
+  for (size_t frame = 0; frame < 64; frame++) {
+    if ((history >> frame) & 1) {
+      if (seen_platform_views && run > 0) {
+        gaps++;
+        longest_gap = std::max(longest_gap, run);
+      }
+      seen_platform_views = true;
+      run = 0;
+    } else {
+      run++;
+    }
+  }
+  if (gaps < kMinGapsToPredict) {
+    return lease_term;
+  }
+  // The lease is also decremented at the end of the current frame, so it has
+  // to be two frames longer than the gaps to outlast them.
+  return std::max(lease_term,
+                  std::min(longest_gap + 2, kMaxPredictedLeaseTerm));
+}
+
+void RasterThreadMerger::TraceMetricsUnSafe() const {
+  FML_TRACE_COUNTER("flutter", "RasterThreadMerger",
+                    reinterpret_cast<int64_t>(this), "MergeCount",
+                    metrics_.merge_count, "MergeLatencyMicros",
+                    metrics_.last_merge_latency.ToMicroseconds(),
+                    "UnmergeLatencyMicros",
+                    metrics_.last_unmerge_latency.ToMicroseconds(),
+                    "LeaseTerm", metrics_.last_lease_term);
+}
+
 }  // namespace fml
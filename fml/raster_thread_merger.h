@@ -6,11 +6,14 @@
 #define FML_SHELL_COMMON_TASK_RUNNER_MERGER_H_
 
 #include <condition_variable>
+#include <cstdint>
 #include <mutex>
 
 #include "flutter/fml/macros.h"
 #include "flutter/fml/memory/ref_counted.h"
 #include "flutter/fml/message_loop_task_queues.h"
+#include "flutter/fml/time/time_delta.h"
+#include "flutter/fml/time/time_point.h"
 
 namespace fml {
 
@@ -25,6 +28,23 @@ enum class RasterThreadStatus {
 class RasterThreadMerger
     : public fml::RefCountedThreadSafe<RasterThreadMerger> {
  public:
+  // The statistics of the transitions between the merged and the un-merged
+  // configurations.
+  struct Metrics {
+    size_t merge_count = 0;
+    size_t unmerge_count = 0;
+    // The time from the request that merged the threads to the end of the
+    // first frame rasterized on the platform thread. This includes the
+    // frame that is dropped and retried when the threads merge.
+    fml::TimeDelta last_merge_latency;
+    // The time it took to un-merge the threads, including the callback set
+    // with |SetMergeUnmergeCallback|.
+    fml::TimeDelta last_unmerge_latency;
+    // The lease term last granted, which may be longer than requested, see
+    // |MergeWithLease|.
+    size_t last_lease_term = 0;
+  };
+
   // Merges the raster thread into platform thread for the duration of
   // the lease term. Lease is managed by the caller by either calling
   // |ExtendLeaseTo| or |DecrementLease|.
@@ -32,6 +52,12 @@ class RasterThreadMerger
   // are going to remain merged until 2 invocations of |DecreaseLease|,
   // unless an |ExtendLeaseTo| gets called.
   //
+  // Each call to |DecrementLease| counts as a frame, and frames in which
+  // this method or |ExtendLeaseTo| is called as frames with platform views.
+  // When the recent frames show platform views disappearing and coming
+  // back, the lease is extended to outlast the gaps in between, so that
+  // the threads do not un-merge only to merge again a few frames later.
+  //
   // If the task queues are the same, we consider them statically merged.
   // When task queues are statically merged this method becomes no-op.
   void MergeWithLease(size_t lease_term);
@@ -52,6 +78,8 @@ class RasterThreadMerger
   // Returns |RasterThreadStatus::kUnmergedNow| if this call resulted in
   // splitting the raster and platform threads. Reduces the lease term by 1.
   //
+  // Must be called once per frame, whether the threads are merged or not.
+  //
   // If the task queues are the same, we consider them statically merged.
   // When task queues are statically merged this method becomes no-op.
   RasterThreadStatus DecrementLease();
@@ -93,8 +121,22 @@ class RasterThreadMerger
   // the next task from a different thread.
   void SetMergeUnmergeCallback(const fml::closure& callback);
 
+  Metrics GetMetrics();
+
+  // Returns the time the current frame spent waiting for the threads to
+  // merge or un-merge since the last call, or zero if the configuration did
+  // not change. Called once per frame by the rasterizer after it finished
+  // rasterizing.
+  fml::TimeDelta TakeTransitionLatency();
+
  private:
   static const int kLeaseNotSet;
+  // The longest lease granted to outlast the gaps between frames with
+  // platform views.
+  static const size_t kMaxPredictedLeaseTerm;
+  // The number of gaps between frames with platform views that must be seen
+  // in the recent frames before leases are extended.
+  static const size_t kMinGapsToPredict;
   fml::TaskQueueId platform_queue_id_;
   fml::TaskQueueId gpu_queue_id_;
   fml::RefPtr<fml::MessageLoopTaskQueues> task_queues_;
@@ -104,6 +146,23 @@ class RasterThreadMerger
   fml::closure merge_unmerge_callback_;
   bool enabled_;
 
+  // One bit per frame, the most recent frame in the lowest bit, set for
+  // the frames with platform views.
+  uint64_t platform_view_history_ = 0;
+  bool frame_has_platform_views_ = false;
+
+  Metrics metrics_;
+  // Set when the threads are merged until the end of the first frame
+  // rasterized on the platform thread.
+  fml::TimePoint merge_request_time_;
+  fml::TimeDelta pending_unmerge_latency_;
+
+  // Returns |lease_term| or a longer lease if the recent frames show gaps
+  // between platform views that are longer than it.
+  size_t PredictLeaseTermUnSafe(size_t lease_term) const;
+
+  void TraceMetricsUnSafe() const;
+
   bool IsMergedUnSafe() const;
 
   bool IsEnabledUnSafe() const;
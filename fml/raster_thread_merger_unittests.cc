@@ -7,6 +7,7 @@
 #include "flutter/fml/raster_thread_merger.h"
 
 #include <atomic>
+#include <chrono>
 #include <thread>
 
 #include "flutter/fml/memory/ref_ptr.h"
@@ -623,5 +624,136 @@ TEST(RasterThreadMerger, SetMergeUnmergeCallback) {
   thread2.join();
 }
 
+TEST(RasterThreadMerger, ReportsTransitionMetrics) {
+  fml::MessageLoop* loop1 = nullptr;
+  fml::AutoResetWaitableEvent latch1;
+  fml::AutoResetWaitableEvent term1;
+  std::thread thread1([&loop1, &latch1, &term1]() {
+    fml::MessageLoop::EnsureInitializedForCurrentThread();
+    loop1 = &fml::MessageLoop::GetCurrent();
+    latch1.Signal();
+    term1.Wait();
+  });
+
+  fml::MessageLoop* loop2 = nullptr;
+  fml::AutoResetWaitableEvent latch2;
+  fml::AutoResetWaitableEvent term2;
+  std::thread thread2([&loop2, &latch2, &term2]() {
+    fml::MessageLoop::EnsureInitializedForCurrentThread();
+    loop2 = &fml::MessageLoop::GetCurrent();
+    latch2.Signal();
+    term2.Wait();
+  });
+
+  latch1.Wait();
+  latch2.Wait();
+
+  fml::TaskQueueId qid1 = loop1->GetTaskRunner()->GetTaskQueueId();
+  fml::TaskQueueId qid2 = loop2->GetTaskRunner()->GetTaskQueueId();
+  const auto raster_thread_merger =
+      fml::MakeRefCounted<fml::RasterThreadMerger>(qid1, qid2);
+
+  ASSERT_EQ(raster_thread_merger->TakeTransitionLatency(),
+            fml::TimeDelta::Zero());
+
+  raster_thread_merger->MergeWithLease(1);
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  ASSERT_GE(raster_thread_merger->TakeTransitionLatency(),
+            fml::TimeDelta::FromMilliseconds(2));
+  ASSERT_EQ(raster_thread_merger->TakeTransitionLatency(),
+            fml::TimeDelta::Zero());
+
+  ASSERT_EQ(raster_thread_merger->DecrementLease(),
+            fml::RasterThreadStatus::kUnmergedNow);
+  fml::RasterThreadMerger::Metrics metrics =
+      raster_thread_merger->GetMetrics();
+  ASSERT_EQ(metrics.merge_count, 1u);
+  ASSERT_EQ(metrics.unmerge_count, 1u);
+  ASSERT_GE(metrics.last_merge_latency, fml::TimeDelta::FromMilliseconds(2));
+  ASSERT_EQ(metrics.last_lease_term, 1u);
+  // The un-merge is reported with the next frame.
+  ASSERT_EQ(raster_thread_merger->TakeTransitionLatency(),
+            metrics.last_unmerge_latency);
+  ASSERT_EQ(raster_thread_merger->TakeTransitionLatency(),
+            fml::TimeDelta::Zero());
+
+  term1.Signal();
+  term2.Signal();
+  thread1.join();
+  thread2.join();
+}
+
+TEST(RasterThreadMerger, PredictiveLeaseOutlastsFlickeringPlatformViews) {
+  fml::MessageLoop* loop1 = nullptr;
+  fml::AutoResetWaitableEvent latch1;
+  fml::AutoResetWaitableEvent term1;
+  std::thread thread1([&loop1, &latch1, &term1]() {
+    fml::MessageLoop::EnsureInitializedForCurrentThread();
+    loop1 = &fml::MessageLoop::GetCurrent();
+    latch1.Signal();
+    term1.Wait();
+  });
+
+  fml::MessageLoop* loop2 = nullptr;
+  fml::AutoResetWaitableEvent latch2;
+  fml::AutoResetWaitableEvent term2;
+  std::thread thread2([&loop2, &latch2, &term2]() {
+    fml::MessageLoop::EnsureInitializedForCurrentThread();
+    loop2 = &fml::MessageLoop::GetCurrent();
+    latch2.Signal();
+    term2.Wait();
+  });
+
+  latch1.Wait();
+  latch2.Wait();
+
+  fml::TaskQueueId qid1 = loop1->GetTaskRunner()->GetTaskQueueId();
+  fml::TaskQueueId qid2 = loop2->GetTaskRunner()->GetTaskQueueId();
+  const auto raster_thread_merger =
+      fml::MakeRefCounted<fml::RasterThreadMerger>(qid1, qid2);
+
+  const size_t kLeaseTerm = 2;
+  const int kGap = 4;
+  auto frame_with_platform_views = [&]() {
+    if (raster_thread_merger->IsMerged()) {
+      raster_thread_merger->ExtendLeaseTo(kLeaseTerm);
+    } else {
+      raster_thread_merger->MergeWithLease(kLeaseTerm);
+    }
+    raster_thread_merger->DecrementLease();
+  };
+
+  // The platform views disappear for longer than the lease, so the threads
+  // un-merge during each gap until the gaps become predictable.
+  for (int i = 0; i < 2; i++) {
+    frame_with_platform_views();
+    for (int j = 0; j < kGap; j++) {
+      raster_thread_merger->DecrementLease();
+    }
+    ASSERT_FALSE(raster_thread_merger->IsMerged());
+  }
+
+  frame_with_platform_views();
+  ASSERT_EQ(raster_thread_merger->GetMetrics().last_lease_term,
+            static_cast<size_t>(kGap + 2));
+  for (int j = 0; j < kGap; j++) {
+    raster_thread_merger->DecrementLease();
+    ASSERT_TRUE(raster_thread_merger->IsMerged());
+  }
+  frame_with_platform_views();
+  ASSERT_EQ(raster_thread_merger->GetMetrics().merge_count, 3u);
+
+  // Once the platform views are gone for good, the threads un-merge.
+  for (int j = 0; j < kGap + 1; j++) {
+    raster_thread_merger->DecrementLease();
+  }
+  ASSERT_FALSE(raster_thread_merger->IsMerged());
+
+  term1.Signal();
+  term2.Signal();
+  thread1.join();
+  thread2.join();
+}
+
 }  // namespace testing
 }  // namespace fml
@@ -21,7 +21,7 @@ class BasicTaskRunner {
  public:
   /// Schedules \p task to be executed on the TaskRunner's associated event
   /// loop.
-  virtual void PostTask(const fml::closure& task) = 0;
+  virtual void PostTask(fml::UniqueClosure task) = 0;
 };
 
 /// The object for scheduling tasks on a \p fml::MessageLoop.
@@ -36,9 +36,9 @@ class TaskRunner : public fml::RefCountedThreadSafe<TaskRunner>,
  public:
   virtual ~TaskRunner();
 
-  virtual void PostTask(const fml::closure& task) override;
+  virtual void PostTask(fml::UniqueClosure task) override;
 
-  virtual void PostTaskForTime(const fml::closure& task,
+  virtual void PostTaskForTime(fml::UniqueClosure task,
                                fml::TimePoint target_time);
 
   /// Schedules a task to be run on the MessageLoop after the time \p delay has
@@ -47,7 +47,16 @@ class TaskRunner : public fml::RefCountedThreadSafe<TaskRunner>,
   /// executed so that the actual execution time is: now + delay +
   /// message_loop_latency, where message_loop_latency is undefined and could be
   /// tens of milliseconds.
-  virtual void PostDelayedTask(const fml::closure& task, fml::TimeDelta delay);
+  virtual void PostDelayedTask(fml::UniqueClosure task, fml::TimeDelta delay);
+
+  /// Schedules \p task like \p PostTaskForTime. The \p task_source_grade
+  /// decides how urgently the task runs compared to the other tasks that are
+  /// due. Task runners that are not backed by a \p fml::MessageLoop ignore
+  /// the grade.
+  /// \see fml::TaskSourceGrade
+  virtual void PostTaskWithGrade(fml::UniqueClosure task,
+                                 fml::TimePoint target_time,
+                                 fml::TaskSourceGrade task_source_grade);
 
   /// Returns \p true when the current executing thread's TaskRunner matches
   /// this instance.
@@ -60,7 +69,7 @@ class TaskRunner : public fml::RefCountedThreadSafe<TaskRunner>,
   /// Executes the \p task directly if the TaskRunner \p runner is the
   /// TaskRunner associated with the current executing thread.
   static void RunNowOrPostTask(fml::RefPtr<fml::TaskRunner> runner,
-                               const fml::closure& task);
+                               fml::UniqueClosure task);
 
  protected:
   TaskRunner(fml::RefPtr<MessageLoopImpl> loop);
@@ -16,40 +16,55 @@ TaskSource::~TaskSource() {
 }
 
 void TaskSource::ShutDown() {
+  urgent_task_queue_ = {};
   primary_task_queue_ = {};
   secondary_task_queue_ = {};
+  idle_task_queue_ = {};
 }
 
-void TaskSource::RegisterTask(const DelayedTask& task) {
+void TaskSource::RegisterTask(DelayedTask task) {
   switch (task.GetTaskSourceGrade()) {
     case TaskSourceGrade::kUserInteraction:
-      primary_task_queue_.push(task);
+      urgent_task_queue_.push(std::move(task));
       break;
     case TaskSourceGrade::kUnspecified:
-      primary_task_queue_.push(task);
+      primary_task_queue_.push(std::move(task));
       break;
     case TaskSourceGrade::kDartMicroTasks:
-      secondary_task_queue_.push(task);
+      secondary_task_queue_.push(std::move(task));
+      break;
+    case TaskSourceGrade::kIdle:
+      idle_task_queue_.push(std::move(task));
       break;
   }
 }
 
-void TaskSource::PopTask(TaskSourceGrade grade) {
+// The heaps only hand out const references to their top, the task is moved
+// out of it nonetheless. This is safe since the task does not take part in
+// the ordering of the heap.
+static fml::UniqueClosure PopTopTask(DelayedTaskQueue& queue) {
+  fml::UniqueClosure task = const_cast<DelayedTask&>(queue.top()).TakeTask();
+  queue.pop();
+  return task;
+}
+
+fml::UniqueClosure TaskSource::PopTask(TaskSourceGrade grade) {
   switch (grade) {
     case TaskSourceGrade::kUserInteraction:
-      primary_task_queue_.pop();
-      break;
+      return PopTopTask(urgent_task_queue_);
     case TaskSourceGrade::kUnspecified:
-      primary_task_queue_.pop();
-      break;
+      return PopTopTask(primary_task_queue_);
     case TaskSourceGrade::kDartMicroTasks:
-      secondary_task_queue_.pop();
-      break;
+      return PopTopTask(secondary_task_queue_);
+    case TaskSourceGrade::kIdle:
+      return PopTopTask(idle_task_queue_);
   }
+  return nullptr;
 }
 
 size_t TaskSource::GetNumPendingTasks() const {
-  size_t size = primary_task_queue_.size();
+  size_t size = urgent_task_queue_.size() + primary_task_queue_.size() +
+                idle_task_queue_.size();
   if (secondary_pause_requests_ == 0) {
     size += secondary_task_queue_.size();
   }
@@ -60,35 +75,78 @@ bool TaskSource::IsEmpty() const {
   return GetNumPendingTasks() == 0;
 }
 
-TaskSource::TopTask TaskSource::Top() const {
+TaskSource::TopTask TaskSource::Top(fml::TimePoint now) const {
   FML_CHECK(!IsEmpty());
-  if (secondary_pause_requests_ > 0 || secondary_task_queue_.empty()) {
-    const auto& primary_top = primary_task_queue_.top();
-    return {
-        .task_queue_id = task_queue_id_,
-        .task = primary_top,
-    };
-  } else if (primary_task_queue_.empty()) {
-    const auto& secondary_top = secondary_task_queue_.top();
-    return {
-        .task_queue_id = task_queue_id_,
-        .task = secondary_top,
-    };
-  } else {
-    const auto& primary_top = primary_task_queue_.top();
-    const auto& secondary_top = secondary_task_queue_.top();
-    if (primary_top > secondary_top) {
-      return {
-          .task_queue_id = task_queue_id_,
-          .task = secondary_top,
-      };
-    } else {
-      return {
-          .task_queue_id = task_queue_id_,
-          .task = primary_top,
-      };
+  const DelayedTaskQueue* queues[] = {
+      &urgent_task_queue_,
+      &primary_task_queue_,
+      secondary_pause_requests_ > 0 ? nullptr : &secondary_task_queue_,
+      &idle_task_queue_,
+  };
+  const DelayedTaskQueue* top_queue = nullptr;
+  for (const DelayedTaskQueue* queue : queues) {
+    if (queue == nullptr || queue->empty()) {
+      continue;
     }
+    if (top_queue == nullptr ||
+        RunsBefore(MakeTopTask(queue->top(), now),
+                   MakeTopTask(top_queue->top(), now), now)) {
+      top_queue = queue;
+    }
+  }
+  return MakeTopTask(top_queue->top(), now);
+}
+
+static int GetUrgency(TaskSourceGrade grade) {
+  switch (grade) {
+    case TaskSourceGrade::kUserInteraction:
+      return 2;
+    case TaskSourceGrade::kUnspecified:
+    case TaskSourceGrade::kDartMicroTasks:
+      return 1;
+    case TaskSourceGrade::kIdle:
+      return 0;
+  }
+  return 1;
+}
+
+bool TaskSource::RunsBefore(const TopTask& task,
+                            const TopTask& other,
+                            fml::TimePoint now) {
+  const bool task_is_due = task.run_time <= now;
+  const bool other_is_due = other.run_time <= now;
+  if (task_is_due != other_is_due) {
+    return task_is_due;
+  }
+  // Of the tasks that cannot run yet, the one that can run the soonest
+  // determines when the loop has to wake up.
+  if (!task_is_due && task.run_time != other.run_time) {
+    return task.run_time < other.run_time;
+  }
+  const int task_urgency = GetUrgency(task.task.GetTaskSourceGrade());
+  const int other_urgency = GetUrgency(other.task.GetTaskSourceGrade());
+  if (task_urgency != other_urgency) {
+    return task_urgency > other_urgency;
+  }
+  return other.task > task.task;
+}
+
+void TaskSource::SetIdleDeadline(fml::TimePoint deadline) {
+  idle_deadline_ = deadline;
+}
+
+TaskSource::TopTask TaskSource::MakeTopTask(const DelayedTask& task,
+                                            fml::TimePoint now) const {
+  fml::TimePoint run_time = task.GetTargetTime();
+  if (task.GetTaskSourceGrade() == TaskSourceGrade::kIdle &&
+      now >= idle_deadline_) {
+    run_time = run_time + kMaxIdleTaskDelay;
   }
+  return {
+      .task_queue_id = task_queue_id_,
+      .task = task,
+      .run_time = run_time,
+  };
 }
 
 void TaskSource::PauseSecondary() {
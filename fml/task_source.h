@@ -8,6 +8,8 @@
 #include "flutter/fml/delayed_task.h"
 #include "flutter/fml/task_queue_id.h"
 #include "flutter/fml/task_source_grade.h"
+#include "flutter/fml/time/time_delta.h"
+#include "flutter/fml/time/time_point.h"
 
 namespace fml {
 
@@ -31,14 +33,25 @@ class MessageLoopTaskQueues;
  * Task dispatcher provides the event loop a way to acquire tasks to run via
  * `GetNextTaskToRun`. Task dispatcher asks the underlying `TaskSource` for the
  * next task.
+ *
+ * Of the tasks that are due, the ones graded `kUserInteraction` run first and
+ * the ones graded `kIdle` run last. Tasks of the same urgency run in the order
+ * of their target times.
  */
 class TaskSource {
  public:
   struct TopTask {
     TaskQueueId task_queue_id;
     const DelayedTask& task;
+    /// The time from which the task may run. This is later than the target
+    /// time of idle tasks that are deferred to the next idle window.
+    fml::TimePoint run_time;
   };
 
+  /// How long idle tasks wait for an idle window before they run regardless.
+  static constexpr fml::TimeDelta kMaxIdleTaskDelay =
+      fml::TimeDelta::FromMilliseconds(500);
+
   /// Construts a TaskSource with the given `task_queue_id`.
   explicit TaskSource(TaskQueueId task_queue_id);
 
@@ -49,10 +62,11 @@ class TaskSource {
 
   /// Adds a task to the corresponding task heap as dictated by the
   /// `TaskSourceGrade` of the `DelayedTask`.
-  void RegisterTask(const DelayedTask& task);
+  void RegisterTask(DelayedTask task);
 
-  /// Pops the task heap corresponding to the `TaskSourceGrade`.
-  void PopTask(TaskSourceGrade grade);
+  /// Pops the task heap corresponding to the `TaskSourceGrade` and returns
+  /// the task that was on top of it.
+  fml::UniqueClosure PopTask(TaskSourceGrade grade);
 
   /// Returns the number of pending tasks. Excludes the tasks from the secondary
   /// heap if it's paused.
@@ -61,9 +75,20 @@ class TaskSource {
   /// Returns true if `GetNumPendingTasks` is zero.
   bool IsEmpty() const;
 
-  /// Returns the top task based on scheduled time, taking into account whether
-  /// the secondary heap has been paused or not.
-  TopTask Top() const;
+  /// Returns the task to run next at `now` based on the urgency and the
+  /// scheduled time of the tasks, taking into account whether the secondary
+  /// heap has been paused or not. If no task may run at `now`, this is the
+  /// task that may run the soonest.
+  TopTask Top(fml::TimePoint now) const;
+
+  /// Whether `task` should run before `other` at `now`. Also used to pick
+  /// between the tasks of merged task queues.
+  static bool RunsBefore(const TopTask& task,
+                         const TopTask& other,
+                         fml::TimePoint now);
+
+  /// Lets the idle tasks run until `deadline`.
+  void SetIdleDeadline(fml::TimePoint deadline);
 
   /// Pause providing tasks from secondary task heap.
   void PauseSecondary();
@@ -73,9 +98,14 @@ class TaskSource {
 
  private:
   const fml::TaskQueueId task_queue_id_;
+  fml::DelayedTaskQueue urgent_task_queue_;
   fml::DelayedTaskQueue primary_task_queue_;
   fml::DelayedTaskQueue secondary_task_queue_;
+  fml::DelayedTaskQueue idle_task_queue_;
   int secondary_pause_requests_ = 0;
+  fml::TimePoint idle_deadline_;
+
+  TopTask MakeTopTask(const DelayedTask& task, fml::TimePoint now) const;
 
   FML_DISALLOW_COPY_ASSIGN_AND_MOVE(TaskSource);
 };
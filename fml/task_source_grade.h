@@ -14,13 +14,18 @@ namespace fml {
  */
 enum class TaskSourceGrade {
   /// This `TaskSourceGrade` indicates that a task is critical to user
-  /// interaction.
+  /// interaction. Such tasks run ahead of the other tasks that are due.
   kUserInteraction,
   /// This `TaskSourceGrade` indicates that a task corresponds to servicing a
   /// dart micro task. These aren't critical to user interaction.
   kDartMicroTasks,
   /// The absence of a specialized `TaskSourceGrade`.
   kUnspecified,
+  /// This `TaskSourceGrade` indicates that a task can wait until the loop is
+  /// idle. Such tasks only run in the windows opened by
+  /// `MessageLoopTaskQueues::SetIdleDeadline` or once they are overdue by
+  /// `TaskSource::kMaxIdleTaskDelay`.
+  kIdle,
 };
 
 }  // namespace fml
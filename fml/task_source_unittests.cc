@@ -41,10 +41,10 @@ TEST(TaskSourceTests, SimpleOrdering) {
   task_source.RegisterTask({2, [&] { value = 7; },
                             time_stamp + fml::TimeDelta::FromMilliseconds(1),
                             TaskSourceGrade::kUnspecified});
-  task_source.Top().task.GetTask()();
+  task_source.Top(time_stamp).task.GetTask()();
   task_source.PopTask(TaskSourceGrade::kUnspecified);
   ASSERT_EQ(value, 1);
-  task_source.Top().task.GetTask()();
+  task_source.Top(time_stamp).task.GetTask()();
   task_source.PopTask(TaskSourceGrade::kUnspecified);
   ASSERT_EQ(value, 7);
 }
@@ -58,12 +58,12 @@ TEST(TaskSourceTests, SimpleOrderingMultiTaskHeaps) {
   task_source.RegisterTask({2, [&] { value = 7; },
                             time_stamp + fml::TimeDelta::FromMilliseconds(1),
                             TaskSourceGrade::kUserInteraction});
-  auto top_task = task_source.Top();
+  auto top_task = task_source.Top(time_stamp);
   top_task.task.GetTask()();
   task_source.PopTask(top_task.task.GetTaskSourceGrade());
   ASSERT_EQ(value, 1);
 
-  auto second_task = task_source.Top();
+  auto second_task = task_source.Top(time_stamp);
   second_task.task.GetTask()();
   task_source.PopTask(second_task.task.GetTaskSourceGrade());
   ASSERT_EQ(value, 7);
@@ -81,7 +81,7 @@ TEST(TaskSourceTests, OrderingMultiTaskHeapsSecondaryPaused) {
 
   task_source.PauseSecondary();
 
-  auto top_task = task_source.Top();
+  auto top_task = task_source.Top(time_stamp);
   top_task.task.GetTask()();
   task_source.PopTask(top_task.task.GetTaskSourceGrade());
   ASSERT_EQ(value, 7);
@@ -90,11 +90,62 @@ TEST(TaskSourceTests, OrderingMultiTaskHeapsSecondaryPaused) {
 
   task_source.ResumeSecondary();
 
-  auto second_task = task_source.Top();
+  auto second_task = task_source.Top(time_stamp);
   second_task.task.GetTask()();
   task_source.PopTask(second_task.task.GetTaskSourceGrade());
   ASSERT_EQ(value, 1);
 }
 
+TEST(TaskSourceTests, UserInteractionTasksRunAheadOfDueTasks) {
+  TaskSource task_source = TaskSource(TaskQueueId(1));
+  auto time_stamp = fml::TimePoint::Now();
+  const auto later = time_stamp + fml::TimeDelta::FromMilliseconds(1);
+  task_source.RegisterTask(
+      {1, [] {}, time_stamp, TaskSourceGrade::kUnspecified});
+  task_source.RegisterTask(
+      {2, [] {}, time_stamp, TaskSourceGrade::kDartMicroTasks});
+  task_source.RegisterTask({3, [] {}, later, TaskSourceGrade::kUserInteraction});
+
+  // The user interaction task is not due yet.
+  ASSERT_EQ(task_source.Top(time_stamp).task.GetTaskSourceGrade(),
+            TaskSourceGrade::kUnspecified);
+
+  // Once it is due, it runs ahead of the tasks that were due earlier.
+  auto top_task = task_source.Top(later);
+  ASSERT_EQ(top_task.task.GetTaskSourceGrade(),
+            TaskSourceGrade::kUserInteraction);
+  task_source.PopTask(top_task.task.GetTaskSourceGrade());
+  ASSERT_EQ(task_source.Top(later).task.GetTaskSourceGrade(),
+            TaskSourceGrade::kUnspecified);
+}
+
+TEST(TaskSourceTests, IdleTasksWaitForIdleWindow) {
+  TaskSource task_source = TaskSource(TaskQueueId(1));
+  auto time_stamp = fml::TimePoint::Now();
+  const auto later = time_stamp + fml::TimeDelta::FromMilliseconds(1);
+  task_source.RegisterTask({1, [] {}, time_stamp, TaskSourceGrade::kIdle});
+  task_source.RegisterTask({2, [] {}, later, TaskSourceGrade::kUnspecified});
+
+  // Without an idle window, the idle task is deferred past the other task.
+  auto top_task = task_source.Top(time_stamp);
+  ASSERT_EQ(top_task.task.GetTaskSourceGrade(), TaskSourceGrade::kUnspecified);
+  ASSERT_EQ(top_task.run_time, later);
+
+  // In an idle window, it runs as soon as nothing more urgent is due.
+  task_source.SetIdleDeadline(later);
+  auto idle_task = task_source.Top(time_stamp);
+  ASSERT_EQ(idle_task.task.GetTaskSourceGrade(), TaskSourceGrade::kIdle);
+  ASSERT_EQ(idle_task.run_time, time_stamp);
+  ASSERT_EQ(task_source.Top(later).task.GetTaskSourceGrade(),
+            TaskSourceGrade::kUnspecified);
+
+  // Once the window has closed, it waits until it is overdue.
+  task_source.PopTask(TaskSourceGrade::kUnspecified);
+  auto deferred_task = task_source.Top(later);
+  ASSERT_EQ(deferred_task.task.GetTaskSourceGrade(), TaskSourceGrade::kIdle);
+  ASSERT_EQ(deferred_task.run_time,
+            time_stamp + TaskSource::kMaxIdleTaskDelay);
+}
+
 }  // namespace testing
 }  // namespace fml
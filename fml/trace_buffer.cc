@@ -0,0 +1,625 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/fml/trace_buffer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+#include "flutter/fml/build_config.h"
+#include "flutter/fml/file.h"
+#include "flutter/fml/macros.h"
+#include "flutter/fml/mapping.h"
+#include "flutter/fml/paths.h"
+#include "flutter/fml/thread_local.h"
+
+#if !defined(OS_WIN)
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <csignal>
+#endif
+
+namespace fml {
+namespace tracing {
+
+namespace {
+
+constexpr size_t kTextWords = (kTraceBufferMaxTextSize + 1) / sizeof(uint64_t);
+static_assert(kTextWords * sizeof(uint64_t) == kTraceBufferMaxTextSize + 1,
+              "The text of an event must fill whole words.");
+
+constexpr size_t kMaxThreadBuffers = 256;
+
+constexpr int kHeaderTypeBits = 8;
+constexpr int kHeaderArgumentCountBits = 8;
+constexpr int kHeaderThreadIdShift = kHeaderTypeBits + kHeaderArgumentCountBits;
+
+// A recorded event. Readers may copy a slot while its thread overwrites it,
+// so the fields are atomics accessed with relaxed ordering and the sequence
+// number tells whether the copy is consistent.
+struct Slot {
+  // Odd while the slot is being written. Otherwise zero or two more than
+  // twice the index of the event in the slot.
+  std::atomic<uint64_t> sequence;
+  std::atomic<int64_t> timestamp0;
+  std::atomic<int64_t> timestamp1_or_async_id;
+  // The thread id, the argument count and the type, from high to low bits.
+  std::atomic<uint64_t> header;
+  // The label followed by the names and values of the arguments, each
+  // terminated by a null character.
+  std::atomic<uint64_t> text[kTextWords];
+};
+
+// A plain copy of a slot.
+struct Event {
+  int64_t thread_id;
+  Dart_Timeline_Event_Type type;
+  size_t argument_count;
+  int64_t timestamp0;
+  int64_t timestamp1_or_async_id;
+  char text[kTraceBufferMaxTextSize + 1];
+};
+
+// A ring buffer written by one thread at a time and read by any thread.
+class ThreadBuffer {
+ public:
+  explicit ThreadBuffer(size_t capacity)
+      : capacity_(capacity), slots_(new Slot[capacity]()) {}
+
+  // Whether a thread currently writes to this buffer.
+  std::atomic<bool> in_use = true;
+
+  size_t capacity() const { return capacity_; }
+
+  void Add(int64_t thread_id,
+           Dart_Timeline_Event_Type type,
+           size_t argument_count,
+           int64_t timestamp0,
+           int64_t timestamp1_or_async_id,
+           const char (&text)[kTraceBufferMaxTextSize + 1]) {
+    const uint64_t index = next_index_.load(std::memory_order_relaxed);
+    Slot& slot = slots_[index & (capacity_ - 1)];
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.timestamp0.store(timestamp0, std::memory_order_relaxed);
+    slot.timestamp1_or_async_id.store(timestamp1_or_async_id,
+                                      std::memory_order_relaxed);
+    slot.header.store(
+        (static_cast<uint64_t>(thread_id) << kHeaderThreadIdShift) |
+            (argument_count << kHeaderTypeBits) | static_cast<uint64_t>(type),
+        std::memory_order_relaxed);
+    uint64_t words[kTextWords];
+    std::memcpy(words, text, sizeof(words));
+    for (size_t i = 0; i < kTextWords; i++) {
+      slot.text[i].store(words[i], std::memory_order_relaxed);
+    }
+
+    slot.sequence.store(2 * index + 2, std::memory_order_release);
+    next_index_.store(index + 1, std::memory_order_release);
+  }
+
+  // Invokes |callback| with the events of the buffer, oldest first. Events
+  // that are overwritten while being read are skipped.
+  template <typename Callback>
+  void ForEach(Callback& callback) const {
+    const uint64_t end = next_index_.load(std::memory_order_acquire);
+    const uint64_t begin = end > capacity_ ? end - capacity_ : 0;
+    for (uint64_t index = begin; index < end; index++) {
+      const Slot& slot = slots_[index & (capacity_ - 1)];
+      const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+      if (sequence != 2 * index + 2) {
+        continue;
+      }
+
+      Event event;
+      event.timestamp0 = slot.timestamp0.load(std::memory_order_relaxed);
+      event.timestamp1_or_async_id =
+          slot.timestamp1_or_async_id.load(std::memory_order_relaxed);
+      const uint64_t header = slot.header.load(std::memory_order_relaxed);
+      uint64_t words[kTextWords];
+      for (size_t i = 0; i < kTextWords; i++) {
+        words[i] = slot.text[i].load(std::memory_order_relaxed);
+      }
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.sequence.load(std::memory_order_relaxed) != sequence) {
+        continue;
+      }
+
+      event.thread_id = static_cast<int64_t>(header >> kHeaderThreadIdShift);
+      event.argument_count =
+          (header >> kHeaderTypeBits) & ((1 << kHeaderArgumentCountBits) - 1);
+      event.type = static_cast<Dart_Timeline_Event_Type>(
+          header & ((1 << kHeaderTypeBits) - 1));
+      std::memcpy(event.text, words, sizeof(words));
+      event.text[kTraceBufferMaxTextSize] = '\0';
+      callback(event);
+    }
+  }
+
+ private:
+  const size_t capacity_;
+  std::unique_ptr<Slot[]> slots_;
+  std::atomic<uint64_t> next_index_ = 0;
+
+  FML_DISALLOW_COPY_AND_ASSIGN(ThreadBuffer);
+};
+
+// The buffers are never freed so that they can be read at any time.
+std::atomic<ThreadBuffer*> gThreadBuffers[kMaxThreadBuffers];
+std::atomic<size_t> gThreadBufferCount;
+// Zero unless recording.
+std::atomic<size_t> gEventsPerThread;
+std::atomic<int64_t> gLastThreadId;
+
+struct ThreadState {
+  ThreadBuffer* buffer;
+  int64_t thread_id;
+
+  ~ThreadState() {
+    if (buffer) {
+      buffer->in_use.store(false, std::memory_order_release);
+    }
+  }
+};
+
+FML_THREAD_LOCAL ThreadLocalUniquePtr<ThreadState> tls_thread_state;
+
+// Reuses a buffer of the same capacity from a thread that has exited if
+// possible.
+ThreadBuffer* AcquireThreadBuffer(size_t capacity) {
+  const size_t count = std::min(
+      gThreadBufferCount.load(std::memory_order_acquire), kMaxThreadBuffers);
+  for (size_t i = 0; i < count; i++) {
+    ThreadBuffer* buffer = gThreadBuffers[i].load(std::memory_order_acquire);
+    bool in_use = false;
+    if (buffer && buffer->capacity() == capacity &&
+        buffer->in_use.compare_exchange_strong(
+                      in_use, true, std::memory_order_acquire)) {
+      return buffer;
+    }
+  }
+  const size_t index = gThreadBufferCount.fetch_add(1);
+  if (index >= kMaxThreadBuffers) {
+    return nullptr;
+  }
+  ThreadBuffer* buffer = new ThreadBuffer(capacity);
+  gThreadBuffers[index].store(buffer, std::memory_order_release);
+  return buffer;
+}
+
+template <typename Callback>
+void ForEachEvent(Callback& callback) {
+  const size_t count = std::min(
+      gThreadBufferCount.load(std::memory_order_acquire), kMaxThreadBuffers);
+  for (size_t i = 0; i < count; i++) {
+    ThreadBuffer* buffer = gThreadBuffers[i].load(std::memory_order_acquire);
+    if (buffer) {
+      buffer->ForEach(callback);
+    }
+  }
+}
+
+// Invokes |callback| with the name and value of each argument stored after
+// the label in |event|. Arguments that were truncated away are skipped.
+template <typename Callback>
+void ForEachArgument(const Event& event, Callback callback) {
+  size_t offset = std::strlen(event.text) + 1;
+  for (size_t i = 0; i < event.argument_count; i++) {
+    if (offset >= kTraceBufferMaxTextSize) {
+      return;
+    }
+    const char* name = event.text + offset;
+    offset += std::strlen(name) + 1;
+    if (offset >= kTraceBufferMaxTextSize) {
+      return;
+    }
+    const char* value = event.text + offset;
+    offset += std::strlen(value) + 1;
+    callback(name, value);
+  }
+}
+
+// Formats JSON into a fixed buffer that is handed to a sink when full. This
+// does not allocate, so that it can be used from a signal handler.
+class JSONWriter {
+ public:
+  using Sink = void (*)(void* context, const char* data, size_t size);
+
+  JSONWriter(Sink sink, void* context) : sink_(sink), context_(context) {}
+
+  ~JSONWriter() { Flush(); }
+
+  void Raw(const char* string) {
+    for (; *string != '\0'; string++) {
+      Put(*string);
+    }
+  }
+
+  void String(const char* string) {
+    static constexpr char kHexDigits[] = "0123456789abcdef";
+    Put('"');
+    for (; *string != '\0'; string++) {
+      const unsigned char c = *string;
+      if (c == '"' || c == '\\') {
+        Put('\\');
+        Put(c);
+      } else if (c < 0x20) {
+        Raw("\\u00");
+        Put(kHexDigits[c >> 4]);
+        Put(kHexDigits[c & 0xf]);
+      } else {
+        Put(c);
+      }
+    }
+    Put('"');
+  }
+
+  void Int(int64_t value) {
+    uint64_t magnitude = static_cast<uint64_t>(value);
+    if (value < 0) {
+      Put('-');
+      magnitude = ~magnitude + 1;
+    }
+    char digits[20];
+    size_t count = 0;
+    do {
+      digits[count++] = '0' + magnitude % 10;
+      magnitude /= 10;
+    } while (magnitude != 0);
+    while (count > 0) {
+      Put(digits[--count]);
+    }
+  }
+
+  void Flush() {
+    if (size_ > 0) {
+      sink_(context_, buffer_, size_);
+      size_ = 0;
+    }
+  }
+
+ private:
+  Sink sink_;
+  void* context_;
+  char buffer_[4096];
+  size_t size_ = 0;
+
+  void Put(char c) {
+    if (size_ == sizeof(buffer_)) {
+      Flush();
+    }
+    buffer_[size_++] = c;
+  }
+
+  FML_DISALLOW_COPY_AND_ASSIGN(JSONWriter);
+};
+
+// Counter values must be numbers in the Chrome trace event format.
+bool IsNumber(const char* string) {
+  if (*string == '-') {
+    string++;
+  }
+  if (*string < '0' || *string > '9') {
+    return false;
+  }
+  for (; *string != '\0'; string++) {
+    if ((*string < '0' || *string > '9') && *string != '.') {
+      return false;
+    }
+  }
+  return true;
+}
+
+const char* GetChromePhase(Dart_Timeline_Event_Type type) {
+  switch (type) {
+    case Dart_Timeline_Event_Begin:
+      return "B";
+    case Dart_Timeline_Event_End:
+      return "E";
+    case Dart_Timeline_Event_Instant:
+      return "i";
+    case Dart_Timeline_Event_Duration:
+      return "X";
+    case Dart_Timeline_Event_Async_Begin:
+      return "b";
+    case Dart_Timeline_Event_Async_End:
+      return "e";
+    case Dart_Timeline_Event_Async_Instant:
+      return "n";
+    case Dart_Timeline_Event_Counter:
+      return "C";
+    case Dart_Timeline_Event_Flow_Begin:
+      return "s";
+    case Dart_Timeline_Event_Flow_Step:
+      return "t";
+    case Dart_Timeline_Event_Flow_End:
+      return "f";
+  }
+  return "i";
+}
+
+bool HasAsyncId(Dart_Timeline_Event_Type type) {
+  switch (type) {
+    case Dart_Timeline_Event_Async_Begin:
+    case Dart_Timeline_Event_Async_End:
+    case Dart_Timeline_Event_Async_Instant:
+    case Dart_Timeline_Event_Flow_Begin:
+    case Dart_Timeline_Event_Flow_Step:
+    case Dart_Timeline_Event_Flow_End:
+      return true;
+    default:
+      return false;
+  }
+}
+
+void WriteChromeEvent(JSONWriter& writer, const Event& event) {
+  writer.Raw("{\"name\":");
+  writer.String(event.text);
+  writer.Raw(",\"cat\":\"flutter\",\"ph\":\"");
+  writer.Raw(GetChromePhase(event.type));
+  writer.Raw("\",\"pid\":1,\"tid\":");
+  writer.Int(event.thread_id);
+  writer.Raw(",\"ts\":");
+  writer.Int(event.timestamp0);
+  if (event.type == Dart_Timeline_Event_Duration) {
+    writer.Raw(",\"dur\":");
+    writer.Int(event.timestamp1_or_async_id - event.timestamp0);
+  } else if (HasAsyncId(event.type)) {
+    writer.Raw(",\"id\":\"");
+    writer.Int(event.timestamp1_or_async_id);
+    writer.Raw("\"");
+  }
+  if (event.type == Dart_Timeline_Event_Instant) {
+    writer.Raw(",\"s\":\"t\"");
+  } else if (event.type == Dart_Timeline_Event_Flow_End) {
+    writer.Raw(",\"bp\":\"e\"");
+  }
+  writer.Raw(",\"args\":{");
+  bool first = true;
+  ForEachArgument(event, [&](const char* name, const char* value) {
+    if (!first) {
+      writer.Raw(",");
+    }
+    first = false;
+    writer.String(name);
+    writer.Raw(":");
+    if (event.type == Dart_Timeline_Event_Counter && IsNumber(value)) {
+      writer.Raw(value);
+    } else {
+      writer.String(value);
+    }
+  });
+  writer.Raw("}}");
+}
+
+void WriteChromeJSON(JSONWriter& writer) {
+  writer.Raw("{\"traceEvents\":[");
+  bool first = true;
+  auto write_event = [&](const Event& event) {
+    if (!first) {
+      writer.Raw(",\n");
+    }
+    first = false;
+    WriteChromeEvent(writer, event);
+  };
+  ForEachEvent(write_event);
+  writer.Raw("],\"displayTimeUnit\":\"ms\"}\n");
+  writer.Flush();
+}
+
+size_t RoundUpToPowerOfTwo(size_t value) {
+  size_t result = 1;
+  while (result < value) {
+    result <<= 1;
+  }
+  return result;
+}
+
+}  // namespace
+
+void TraceBufferStart(size_t events_per_thread) {
+  const size_t capacity =
+      RoundUpToPowerOfTwo(std::max<size_t>(events_per_thread, 1));
+  gEventsPerThread.store(capacity, std::memory_order_relaxed);
+}
+
+void TraceBufferStop() {
+  gEventsPerThread.store(0, std::memory_order_relaxed);
+}
+
+bool TraceBufferIsRecording() {
+  return gEventsPerThread.load(std::memory_order_relaxed) != 0;
+}
+
+void TraceBufferAddEvent(const char* label,
+                         int64_t timestamp0,
+                         int64_t timestamp1_or_async_id,
+                         Dart_Timeline_Event_Type type,
+                         intptr_t argument_count,
+                         const char** argument_names,
+                         const char** argument_values) {
+  const size_t events_per_thread =
+      gEventsPerThread.load(std::memory_order_relaxed);
+  if (events_per_thread == 0) {
+    return;
+  }
+  ThreadState* state = tls_thread_state.get();
+  if (state == nullptr) {
+    state = new ThreadState{AcquireThreadBuffer(events_per_thread),
+                            ++gLastThreadId};
+    tls_thread_state.reset(state);
+  }
+  if (state->buffer == nullptr) {
+    // All the buffers are taken.
+    return;
+  }
+
+  char text[kTraceBufferMaxTextSize + 1] = {};
+  size_t size = 0;
+  auto append = [&text, &size](const char* string) {
+    if (string == nullptr || size >= kTraceBufferMaxTextSize) {
+      return;
+    }
+    const size_t length = strnlen(string, kTraceBufferMaxTextSize - size);
+    std::memcpy(text + size, string, length);
+    // Skip the terminating null character, which is already in place.
+    size += length + 1;
+  };
+  append(label);
+  argument_count = std::clamp<intptr_t>(argument_count, 0,
+                                        (1 << kHeaderArgumentCountBits) - 1);
+  for (intptr_t i = 0; i < argument_count; i++) {
+    append(argument_names[i]);
+    append(argument_values[i]);
+  }
+
+  state->buffer->Add(state->thread_id, type, argument_count, timestamp0,
+                     timestamp1_or_async_id, text);
+}
+
+std::vector<TraceBufferEvent> TraceBufferGetEvents() {
+  std::vector<TraceBufferEvent> events;
+  auto collect = [&events](const Event& event) {
+    TraceBufferEvent& result = events.emplace_back();
+    result.thread_id = event.thread_id;
+    result.type = event.type;
+    result.timestamp0 = event.timestamp0;
+    result.timestamp1_or_async_id = event.timestamp1_or_async_id;
+    result.label = event.text;
+    ForEachArgument(event, [&result](const char* name, const char* value) {
+      result.arguments.emplace_back(name, value);
+    });
+  };
+  ForEachEvent(collect);
+  return events;
+}
+
+std::string TraceBufferToChromeJSON() {
+  std::string json;
+  JSONWriter writer(
+      [](void* context, const char* data, size_t size) {
+        static_cast<std::string*>(context)->append(data, size);
+      },
+      &json);
+  WriteChromeJSON(writer);
+  return json;
+}
+
+bool TraceBufferWriteChromeJSON(const fml::UniqueFD& base_directory,
+                                const char* file_name) {
+  fml::DataMapping mapping(TraceBufferToChromeJSON());
+  return fml::WriteAtomically(base_directory, file_name, mapping);
+}
+
+bool TraceBufferWriteChromeJSON(const std::string& path) {
+  std::string directory_path = fml::paths::GetDirectoryName(path);
+  std::string file_name = path.substr(directory_path.size());
+  file_name.erase(0, file_name.find_first_not_of("/\\"));
+  if (file_name.empty()) {
+    return false;
+  }
+  fml::UniqueFD directory =
+      fml::OpenDirectory(directory_path.empty() ? "." : directory_path.c_str(),
+                         false, fml::FilePermission::kReadWrite);
+  if (!directory.is_valid()) {
+    return false;
+  }
+  return TraceBufferWriteChromeJSON(directory, file_name.c_str());
+}
+
+#if defined(OS_WIN)
+
+bool TraceBufferDumpOnCrash(const std::string& path) {
+  // Not supported.
+  return false;
+}
+
+#else  // defined(OS_WIN)
+
+namespace {
+
+constexpr int kCrashSignals[] = {SIGABRT, SIGBUS, SIGFPE, SIGILL, SIGSEGV};
+constexpr size_t kCrashSignalCount =
+    sizeof(kCrashSignals) / sizeof(kCrashSignals[0]);
+
+char gCrashDumpPath[1024];
+struct sigaction gPreviousSignalActions[kCrashSignalCount];
+std::once_flag gCrashHandlersInstalled;
+
+void WriteToFileDescriptor(void* context, const char* data, size_t size) {
+  const int fd = *static_cast<int*>(context);
+  while (size > 0) {
+    const ssize_t written = ::write(fd, data, size);
+    if (written <= 0) {
+      return;
+    }
+    data += written;
+    size -= written;
+  }
+}
+
+void CrashSignalHandler(int signal, siginfo_t* info, void* ucontext) {
+  // Restore the previous actions before anything else so that a crash while
+  // dumping does not recurse.
+  const struct sigaction* previous = nullptr;
+  for (size_t i = 0; i < kCrashSignalCount; i++) {
+    ::sigaction(kCrashSignals[i], &gPreviousSignalActions[i], nullptr);
+    if (kCrashSignals[i] == signal) {
+      previous = &gPreviousSignalActions[i];
+    }
+  }
+  TraceBufferStop();
+  int fd = ::open(gCrashDumpPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd >= 0) {
+    JSONWriter writer(&WriteToFileDescriptor, &fd);
+    WriteChromeJSON(writer);
+    ::close(fd);
+  }
+
+  // Hand the signal over to the previous action along with its original
+  // information, as crash reporters rely on it.
+  if (previous && (previous->sa_flags & SA_SIGINFO) &&
+      previous->sa_sigaction) {
+    previous->sa_sigaction(signal, info, ucontext);
+  } else if (previous && previous->sa_handler != SIG_DFL &&
+             previous->sa_handler != SIG_IGN) {
+    previous->sa_handler(signal);
+  } else {
+    ::raise(signal);
+  }
+}
+
+}  // namespace
+
+bool TraceBufferDumpOnCrash(const std::string& path) {
+  if (path.size() >= sizeof(gCrashDumpPath)) {
+    return false;
+  }
+  std::memcpy(gCrashDumpPath, path.c_str(), path.size() + 1);
+  std::call_once(gCrashHandlersInstalled, [] {
+    struct sigaction action = {};
+    action.sa_sigaction = &CrashSignalHandler;
+    action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+    sigemptyset(&action.sa_mask);
+    for (size_t i = 0; i < kCrashSignalCount; i++) {
+      if (::sigaction(kCrashSignals[i], &action,
+                      &gPreviousSignalActions[i]) != 0) {
+        // Restoring leaves the current action in place.
+        ::sigaction(kCrashSignals[i], nullptr, &gPreviousSignalActions[i]);
+      }
+    }
+  });
+  return true;
+}
+
+#endif  // defined(OS_WIN)
+
+}  // namespace tracing
+}  // namespace fml
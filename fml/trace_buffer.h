@@ -0,0 +1,90 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FLUTTER_FML_TRACE_BUFFER_H_
+#define FLUTTER_FML_TRACE_BUFFER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "flutter/fml/unique_fd.h"
+#include "third_party/dart/runtime/include/dart_tools_api.h"
+
+namespace fml {
+namespace tracing {
+
+//------------------------------------------------------------------------------
+/// The trace buffer records the trace events of the engine independently of
+/// the Dart VM timeline, so that they can be collected from release builds in
+/// the field.
+///
+/// Each thread writes its events to a ring buffer of its own without taking
+/// locks. Once full, the oldest events of the thread are overwritten. The
+/// buffers are never freed, so that they can be dumped at any time, including
+/// from a crash signal handler.
+///
+
+/// The number of events kept for each thread by default.
+constexpr size_t kTraceBufferDefaultEventsPerThread = 4096;
+
+/// Labels and arguments longer than this, in total, are truncated.
+constexpr size_t kTraceBufferMaxTextSize = 95;
+
+/// A trace event read back from the trace buffer.
+struct TraceBufferEvent {
+  int64_t thread_id;
+  Dart_Timeline_Event_Type type;
+  int64_t timestamp0;
+  int64_t timestamp1_or_async_id;
+  std::string label;
+  std::vector<std::pair<std::string, std::string>> arguments;
+};
+
+/// Starts recording trace events. The buffers of the threads are allocated
+/// lazily, with room for the given number of events, which is rounded up to
+/// a power of two. Threads that started recording before keep their buffer.
+void TraceBufferStart(
+    size_t events_per_thread = kTraceBufferDefaultEventsPerThread);
+
+/// Stops recording trace events. The recorded events are kept.
+void TraceBufferStop();
+
+bool TraceBufferIsRecording();
+
+/// Records an event to the buffer of the calling thread if recording. This
+/// takes the same arguments as `Dart_TimelineEvent`.
+void TraceBufferAddEvent(const char* label,
+                         int64_t timestamp0,
+                         int64_t timestamp1_or_async_id,
+                         Dart_Timeline_Event_Type type,
+                         intptr_t argument_count,
+                         const char** argument_names,
+                         const char** argument_values);
+
+/// Returns the recorded events of all threads, oldest first for each thread.
+std::vector<TraceBufferEvent> TraceBufferGetEvents();
+
+/// Returns the recorded events as a trace in the Chrome JSON trace event
+/// format, which is understood by both chrome://tracing and the Perfetto UI.
+std::string TraceBufferToChromeJSON();
+
+/// Writes the result of `TraceBufferToChromeJSON` to a file.
+bool TraceBufferWriteChromeJSON(const fml::UniqueFD& base_directory,
+                                const char* file_name);
+
+/// Writes the result of `TraceBufferToChromeJSON` to the file at `path`.
+bool TraceBufferWriteChromeJSON(const std::string& path);
+
+/// Writes the recorded events as Chrome JSON to the file at `path` if the
+/// process receives a crash signal. The previous signal handlers are invoked
+/// afterwards. Returns false if this is not supported on the platform.
+bool TraceBufferDumpOnCrash(const std::string& path);
+
+}  // namespace tracing
+}  // namespace fml
+
+#endif  // FLUTTER_FML_TRACE_BUFFER_H_
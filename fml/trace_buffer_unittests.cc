@@ -0,0 +1,208 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/fml/trace_buffer.h"
+
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "flutter/fml/build_config.h"
+#include "flutter/fml/file.h"
+#include "flutter/fml/paths.h"
+#include "gtest/gtest.h"
+
+#if !defined(OS_WIN)
+#include <unistd.h>
+
+#include <csignal>
+#endif  // !defined(OS_WIN)
+
+namespace fml {
+namespace tracing {
+namespace testing {
+
+namespace {
+
+// The buffers outlive the tests, so each test records to a thread of its
+// own and only looks at the events of that thread.
+std::vector<TraceBufferEvent> RecordOnThread(
+    const std::function<void()>& record) {
+  std::vector<TraceBufferEvent> before = TraceBufferGetEvents();
+  std::thread thread(record);
+  thread.join();
+  std::vector<TraceBufferEvent> events = TraceBufferGetEvents();
+  std::vector<TraceBufferEvent> result;
+  for (auto& event : events) {
+    bool seen = false;
+    for (const auto& previous : before) {
+      seen |= previous.thread_id == event.thread_id;
+    }
+    if (!seen) {
+      result.push_back(std::move(event));
+    }
+  }
+  return result;
+}
+
+void AddEvent(const char* label,
+              int64_t timestamp,
+              Dart_Timeline_Event_Type type = Dart_Timeline_Event_Instant,
+              std::vector<const char*> names = {},
+              std::vector<const char*> values = {}) {
+  TraceBufferAddEvent(label, timestamp, 0, type, names.size(), names.data(),
+                      values.data());
+}
+
+}  // namespace
+
+TEST(TraceBufferTest, RecordsEventsWithArguments) {
+  TraceBufferStart(16);
+  auto events = RecordOnThread([] {
+    AddEvent("Frame", 10, Dart_Timeline_Event_Begin, {"id", "kind"},
+             {"7", "raster"});
+    AddEvent("Frame", 20, Dart_Timeline_Event_End);
+  });
+  TraceBufferStop();
+
+  ASSERT_EQ(events.size(), 2u);
+  ASSERT_EQ(events[0].label, "Frame");
+  ASSERT_EQ(events[0].type, Dart_Timeline_Event_Begin);
+  ASSERT_EQ(events[0].timestamp0, 10);
+  ASSERT_EQ(events[0].arguments.size(), 2u);
+  ASSERT_EQ(events[0].arguments[0].first, "id");
+  ASSERT_EQ(events[0].arguments[0].second, "7");
+  ASSERT_EQ(events[0].arguments[1].first, "kind");
+  ASSERT_EQ(events[0].arguments[1].second, "raster");
+  ASSERT_EQ(events[1].type, Dart_Timeline_Event_End);
+  ASSERT_EQ(events[1].timestamp0, 20);
+  ASSERT_EQ(events[0].thread_id, events[1].thread_id);
+}
+
+TEST(TraceBufferTest, DoesNotRecordWhenStopped) {
+  TraceBufferStop();
+  auto events = RecordOnThread([] { AddEvent("Ignored", 1); });
+  ASSERT_TRUE(events.empty());
+}
+
+TEST(TraceBufferTest, KeepsNewestEventsWhenFull) {
+  // Rounded up to 8.
+  TraceBufferStart(5);
+  auto events = RecordOnThread([] {
+    for (int64_t i = 0; i < 20; i++) {
+      AddEvent("Event", i);
+    }
+  });
+  TraceBufferStop();
+
+  ASSERT_EQ(events.size(), 8u);
+  for (size_t i = 0; i < events.size(); i++) {
+    ASSERT_EQ(events[i].timestamp0, static_cast<int64_t>(12 + i));
+  }
+}
+
+TEST(TraceBufferTest, TruncatesLongText) {
+  TraceBufferStart(16);
+  const std::string label(200, 'a');
+  auto events = RecordOnThread([&label] {
+    AddEvent(label.c_str(), 1, Dart_Timeline_Event_Instant, {"name"},
+             {"value"});
+  });
+  TraceBufferStop();
+
+  ASSERT_EQ(events.size(), 1u);
+  ASSERT_EQ(events[0].label, std::string(kTraceBufferMaxTextSize, 'a'));
+  ASSERT_TRUE(events[0].arguments.empty());
+}
+
+TEST(TraceBufferTest, WritesChromeJSON) {
+  TraceBufferStart(16);
+  RecordOnThread([] {
+    AddEvent("Quoted \"label\"", 1, Dart_Timeline_Event_Begin);
+    TraceBufferAddEvent("Work", 2, 5, Dart_Timeline_Event_Duration, 0,
+                        nullptr, nullptr);
+    TraceBufferAddEvent("Load", 3, 42, Dart_Timeline_Event_Async_Begin, 0,
+                        nullptr, nullptr);
+    AddEvent("Memory", 4, Dart_Timeline_Event_Counter, {"bytes"}, {"1024"});
+  });
+  TraceBufferStop();
+
+  const std::string json = TraceBufferToChromeJSON();
+  ASSERT_EQ(json.find("{\"traceEvents\":["), 0u);
+  ASSERT_NE(json.find("\"name\":\"Quoted \\\"label\\\"\""), std::string::npos);
+  ASSERT_NE(json.find("\"ph\":\"X\""), std::string::npos);
+  ASSERT_NE(json.find("\"ts\":2,\"dur\":3"), std::string::npos);
+  ASSERT_NE(json.find("\"ph\":\"b\""), std::string::npos);
+  ASSERT_NE(json.find("\"id\":\"42\""), std::string::npos);
+  ASSERT_NE(json.find("\"args\":{\"bytes\":1024}"), std::string::npos);
+}
+
+TEST(TraceBufferTest, CanReadWhileThreadsRecord) {
+  TraceBufferStart(64);
+  std::vector<std::thread> writers;
+  for (int i = 0; i < 4; i++) {
+    writers.emplace_back([] {
+      for (int64_t j = 0; j < 1000; j++) {
+        AddEvent("Concurrent", j, Dart_Timeline_Event_Instant, {"index"},
+                 {"value"});
+      }
+    });
+  }
+  for (int i = 0; i < 10; i++) {
+    for (const auto& event : TraceBufferGetEvents()) {
+      if (event.label == "Concurrent") {
+        ASSERT_EQ(event.arguments.size(), 1u);
+        ASSERT_EQ(event.arguments[0].second, "value");
+      }
+    }
+  }
+  for (auto& writer : writers) {
+    writer.join();
+  }
+  TraceBufferStop();
+}
+
+TEST(TraceBufferTest, WritesChromeJSONToPath) {
+  fml::ScopedTemporaryDirectory temp_dir;
+  EXPECT_TRUE(TraceBufferWriteChromeJSON(
+      fml::paths::JoinPaths({temp_dir.path(), "trace.json"})));
+  EXPECT_TRUE(fml::FileExists(temp_dir.fd(), "trace.json"));
+  EXPECT_FALSE(TraceBufferWriteChromeJSON(temp_dir.path() + "/"));
+}
+
+#if !defined(OS_WIN)
+
+namespace {
+
+void ExitWithSignalInfo(int signal, siginfo_t* info, void* ucontext) {
+  ::_exit(info && info->si_signo == signal ? 42 : 1);
+}
+
+}  // namespace
+
+TEST(TraceBufferTest, DumpOnCrashWritesTheTraceAndChainsToThePreviousAction) {
+  fml::ScopedTemporaryDirectory temp_dir;
+  const std::string path =
+      fml::paths::JoinPaths({temp_dir.path(), "trace.json"});
+  EXPECT_EXIT(
+      {
+        struct sigaction action = {};
+        action.sa_sigaction = &ExitWithSignalInfo;
+        action.sa_flags = SA_SIGINFO;
+        sigemptyset(&action.sa_mask);
+        ::sigaction(SIGABRT, &action, nullptr);
+        TraceBufferStart();
+        TraceBufferDumpOnCrash(path);
+        ::raise(SIGABRT);
+      },
+      ::testing::ExitedWithCode(42), "");
+  EXPECT_TRUE(fml::FileExists(temp_dir.fd(), "trace.json"));
+}
+
+#endif  // !defined(OS_WIN)
+
+}  // namespace testing
+}  // namespace tracing
+}  // namespace fml
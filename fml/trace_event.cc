@@ -11,6 +11,7 @@
 #include "flutter/fml/ascii_trie.h"
 #include "flutter/fml/build_config.h"
 #include "flutter/fml/logging.h"
+#include "flutter/fml/trace_buffer.h"
 
 namespace fml {
 namespace tracing {
@@ -28,10 +29,19 @@ inline void FlutterTimelineEvent(const char* label,
                                  intptr_t argument_count,
                                  const char** argument_names,
                                  const char** argument_values) {
-  if (gTimelineEventHandler && gAllowlist.Query(label)) {
+  const bool buffer_recording = TraceBufferIsRecording();
+  if (!(gTimelineEventHandler || buffer_recording) ||
+      !gAllowlist.Query(label)) {
+    return;
+  }
+  if (gTimelineEventHandler) {
     gTimelineEventHandler(label, timestamp0, timestamp1_or_async_id, type,
                           argument_count, argument_names, argument_values);
   }
+  if (buffer_recording) {
+    TraceBufferAddEvent(label, timestamp0, timestamp1_or_async_id, type,
+                        argument_count, argument_names, argument_values);
+  }
 }
 }  // namespace
 
@@ -47,7 +47,9 @@
 #include "flutter/fml/time/time_point.h"
 #include "third_party/dart/runtime/include/dart_tools_api.h"
 
-#if (FLUTTER_RELEASE && !defined(OS_FUCHSIA))
+// Release builds only trace when the trace buffer is compiled in, see
+// `flutter/fml/trace_buffer.h`.
+#if (FLUTTER_RELEASE && !defined(OS_FUCHSIA) && !FLUTTER_TRACE_BUFFER)
 #define FLUTTER_TIMELINE_ENABLED 0
 #else
 #define FLUTTER_TIMELINE_ENABLED 1
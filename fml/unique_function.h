@@ -0,0 +1,152 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FLUTTER_FML_UNIQUE_FUNCTION_H_
+#define FLUTTER_FML_UNIQUE_FUNCTION_H_
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "flutter/fml/logging.h"
+
+namespace fml {
+
+template <typename Signature>
+class UniqueFunction;
+
+//------------------------------------------------------------------------------
+/// @brief      A move-only alternative to `std::function`.
+///
+///             Callables of up to `kInlineSize` bytes that can be moved
+///             without throwing are stored inline, so wrapping them does not
+///             allocate. Larger callables are stored on the heap. Since the
+///             wrapper is never copied, the callable may capture move-only
+///             state such as a `std::unique_ptr` without `fml::MakeCopyable`.
+///
+///             Wrapping an empty `std::function` or a null function pointer
+///             yields an empty `UniqueFunction`.
+///
+template <typename R, typename... Args>
+class UniqueFunction<R(Args...)> {
+ public:
+  static constexpr size_t kInlineSize = 48;
+
+  UniqueFunction() = default;
+
+  UniqueFunction(std::nullptr_t) {}
+
+  template <typename F,
+            typename Callable = std::decay_t<F>,
+            typename = std::enable_if_t<
+                !std::is_same_v<Callable, UniqueFunction> &&
+                std::is_invocable_r_v<R, Callable&, Args...>>>
+  UniqueFunction(F&& function) {
+    if constexpr (std::is_constructible_v<bool, const Callable&>) {
+      if (!static_cast<bool>(function)) {
+        return;
+      }
+    }
+    if constexpr (kStoredInline<Callable>) {
+      new (&storage_) Callable(std::forward<F>(function));
+      ops_ = &kInlineOps<Callable>;
+    } else {
+      *reinterpret_cast<Callable**>(&storage_) =
+          new Callable(std::forward<F>(function));
+      ops_ = &kHeapOps<Callable>;
+    }
+  }
+
+  UniqueFunction(UniqueFunction&& other) noexcept { MoveFrom(other); }
+
+  UniqueFunction& operator=(UniqueFunction&& other) noexcept {
+    if (this != &other) {
+      Reset();
+      MoveFrom(other);
+    }
+    return *this;
+  }
+
+  UniqueFunction& operator=(std::nullptr_t) {
+    Reset();
+    return *this;
+  }
+
+  ~UniqueFunction() { Reset(); }
+
+  explicit operator bool() const { return ops_ != nullptr; }
+
+  R operator()(Args... args) const {
+    FML_DCHECK(ops_) << "Tried to invoke an empty function.";
+    return ops_->invoke(&storage_, std::forward<Args>(args)...);
+  }
+
+ private:
+  struct Ops {
+    R (*invoke)(void* storage, Args&&... args);
+    // Moves the callable in |from| to the uninitialized |to| and destroys
+    // what is left in |from|.
+    void (*relocate)(void* from, void* to);
+    void (*destroy)(void* storage);
+  };
+
+  template <typename Callable>
+  static constexpr bool kStoredInline =
+      sizeof(Callable) <= kInlineSize &&
+      alignof(Callable) <= alignof(std::max_align_t) &&
+      std::is_nothrow_move_constructible_v<Callable>;
+
+  template <typename Callable>
+  static constexpr Ops kInlineOps = {
+      [](void* storage, Args&&... args) -> R {
+        return (*static_cast<Callable*>(storage))(std::forward<Args>(args)...);
+      },
+      [](void* from, void* to) {
+        Callable* callable = static_cast<Callable*>(from);
+        new (to) Callable(std::move(*callable));
+        callable->~Callable();
+      },
+      [](void* storage) { static_cast<Callable*>(storage)->~Callable(); },
+  };
+
+  template <typename Callable>
+  static constexpr Ops kHeapOps = {
+      [](void* storage, Args&&... args) -> R {
+        return (**static_cast<Callable**>(storage))(
+            std::forward<Args>(args)...);
+      },
+      [](void* from, void* to) {
+        *static_cast<Callable**>(to) = *static_cast<Callable**>(from);
+      },
+      [](void* storage) { delete *static_cast<Callable**>(storage); },
+  };
+
+  // Mutable since the callable may mutate its captures when invoked, as is
+  // the case with `std::function`.
+  alignas(std::max_align_t) mutable unsigned char storage_[kInlineSize];
+  const Ops* ops_ = nullptr;
+
+  void MoveFrom(UniqueFunction& other) {
+    if (other.ops_) {
+      other.ops_->relocate(&other.storage_, &storage_);
+      ops_ = other.ops_;
+      other.ops_ = nullptr;
+    }
+  }
+
+  void Reset() {
+    if (ops_) {
+      // Clear |ops_| first in case the destructor of the callable reassigns
+      // this function.
+      const Ops* ops = ops_;
+      ops_ = nullptr;
+      ops->destroy(&storage_);
+    }
+  }
+};
+
+}  // namespace fml
+
+#endif  // FLUTTER_FML_UNIQUE_FUNCTION_H_
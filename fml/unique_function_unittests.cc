@@ -0,0 +1,82 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/fml/unique_function.h"
+
+#include <array>
+#include <memory>
+
+#include "flutter/fml/closure.h"
+#include "gtest/gtest.h"
+
+namespace fml {
+namespace testing {
+
+TEST(UniqueFunctionTest, DefaultIsEmpty) {
+  UniqueClosure closure;
+  ASSERT_FALSE(closure);
+  UniqueClosure null_closure = nullptr;
+  ASSERT_FALSE(null_closure);
+}
+
+TEST(UniqueFunctionTest, EmptyStdFunctionIsEmpty) {
+  fml::closure empty;
+  UniqueClosure closure = empty;
+  ASSERT_FALSE(closure);
+
+  void (*function_pointer)() = nullptr;
+  UniqueClosure from_pointer = function_pointer;
+  ASSERT_FALSE(from_pointer);
+}
+
+TEST(UniqueFunctionTest, CanCaptureMoveOnlyState) {
+  auto value = std::make_unique<int>(42);
+  UniqueFunction<int()> function = [value = std::move(value)]() {
+    return *value;
+  };
+  ASSERT_TRUE(function);
+  ASSERT_EQ(function(), 42);
+}
+
+TEST(UniqueFunctionTest, ForwardsArgumentsAndMutatesCaptures) {
+  UniqueFunction<int(int)> add = [sum = 0](int value) mutable {
+    sum += value;
+    return sum;
+  };
+  ASSERT_EQ(add(1), 1);
+  ASSERT_EQ(add(2), 3);
+
+  UniqueFunction<void(std::unique_ptr<int>)> consume =
+      [](std::unique_ptr<int> value) { ASSERT_EQ(*value, 3); };
+  consume(std::make_unique<int>(3));
+}
+
+TEST(UniqueFunctionTest, MovesSmallAndLargeCallables) {
+  // Each callable holds a reference to |token| until it is destroyed.
+  auto token = std::make_shared<int>(0);
+  std::array<char, 2 * UniqueClosure::kInlineSize> large = {};
+  large[0] = 'a';
+  UniqueFunction<char()> large_function = [large, token]() {
+    return large[0];
+  };
+  UniqueFunction<char()> small_function = [token]() { return 'b'; };
+  ASSERT_EQ(token.use_count(), 3);
+
+  UniqueFunction<char()> moved_large = std::move(large_function);
+  UniqueFunction<char()> moved_small = std::move(small_function);
+  ASSERT_FALSE(large_function);  // NOLINT(bugprone-use-after-move)
+  ASSERT_FALSE(small_function);  // NOLINT(bugprone-use-after-move)
+  ASSERT_EQ(moved_large(), 'a');
+  ASSERT_EQ(moved_small(), 'b');
+  ASSERT_EQ(token.use_count(), 3);
+
+  moved_large = std::move(moved_small);
+  ASSERT_EQ(token.use_count(), 2);
+  ASSERT_EQ(moved_large(), 'b');
+  moved_large = nullptr;
+  ASSERT_EQ(token.use_count(), 1);
+}
+
+}  // namespace testing
+}  // namespace fml
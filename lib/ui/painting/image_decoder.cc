@@ -263,7 +263,9 @@ void ImageDecoder::Decode(fml::RefPtr<ImageDescriptor> descriptor_ref_ptr,
     return;
   }
 
-  concurrent_task_runner_->PostTask(
+  // Decodes are requested for images that are about to be displayed, so they
+  // run ahead of speculative work such as shader compilation.
+  concurrent_task_runner_->PostHighPriorityTask(
       fml::MakeCopyable([raw_descriptor,                          //
                          io_manager = io_manager_,                //
                          io_runner = runners_.GetIOTaskRunner(),  //
@@ -34,6 +34,14 @@ fml::RefPtr<PictureRecorder> PictureRecorder::Create() {
   return fml::MakeRefCounted<PictureRecorder>();
 }
 
+// Shared by all recorders so that the storage of the pictures of one frame
+// can be reused to record the next one. The pool is thread safe since
+// pictures are often released on the raster thread.
+static sk_sp<DisplayListStoragePool> GetDisplayListStoragePool() {
+  static DisplayListStoragePool* pool = new DisplayListStoragePool();
+  return sk_ref_sp(pool);
+}
+
 PictureRecorder::PictureRecorder() {}
 
 PictureRecorder::~PictureRecorder() {}
@@ -41,7 +49,9 @@ PictureRecorder::~PictureRecorder() {}
 SkCanvas* PictureRecorder::BeginRecording(SkRect bounds) {
   bool enable_display_list = UIDartState::Current()->enable_display_list();
   if (enable_display_list) {
-    display_list_recorder_ = sk_make_sp<DisplayListCanvasRecorder>(bounds);
+    display_list_recorder_ =
+        sk_make_sp<DisplayListCanvasRecorder>(bounds, true,
+                                              GetDisplayListStoragePool());
     return display_list_recorder_.get();
   } else {
     return picture_recorder_.beginRecording(bounds, &rtree_factory_);
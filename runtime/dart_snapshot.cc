@@ -6,6 +6,7 @@
 
 #include <sstream>
 
+#include "flutter/fml/async_file.h"
 #include "flutter/fml/native_library.h"
 #include "flutter/fml/paths.h"
 #include "flutter/fml/trace_event.h"
@@ -155,6 +156,25 @@ static std::shared_ptr<const fml::Mapping> ResolveIsolateInstructions(
 #endif  // DART_SNAPSHOT_STATIC_LINK
 }
 
+// Starts paging in the snapshot before the VM or the isolate asks for it, so
+// that startup does not fault in pages one at a time.
+static void WarmUpSnapshot(
+    const std::shared_ptr<const fml::Mapping>& data,
+    const std::shared_ptr<const fml::Mapping>& instructions) {
+  // The data is deserialized front to back in full, so it is read in on a
+  // worker while the caller gets on with the rest of the startup. Mappings
+  // of symbols have no known size and are left alone.
+  if (data && data->GetSize() > 0) {
+    data->Advise(fml::Mapping::Advice::kSequential);
+    fml::PrefaultAsync(data);
+  }
+  // Only the code that runs is needed, so the instructions are merely read
+  // ahead by the kernel.
+  if (instructions) {
+    instructions->Advise(fml::Mapping::Advice::kWillNeed);
+  }
+}
+
 fml::RefPtr<const DartSnapshot> DartSnapshot::VMSnapshotFromSettings(
     const Settings& settings) {
   TRACE_EVENT0("flutter", "DartSnapshot::VMSnapshotFromSettings");
@@ -163,6 +183,7 @@ fml::RefPtr<const DartSnapshot> DartSnapshot::VMSnapshotFromSettings(
                                         ResolveVMInstructions(settings)  //
       );
   if (snapshot->IsValid()) {
+    WarmUpSnapshot(snapshot->data_, snapshot->instructions_);
     return snapshot;
   }
   return nullptr;
@@ -176,6 +197,7 @@ fml::RefPtr<const DartSnapshot> DartSnapshot::IsolateSnapshotFromSettings(
                                         ResolveIsolateInstructions(settings)  //
       );
   if (snapshot->IsValid()) {
+    WarmUpSnapshot(snapshot->data_, snapshot->instructions_);
     return snapshot;
   }
   return nullptr;
@@ -180,8 +180,14 @@ PrepareKernelMappings(std::vector<std::string> kernel_pieces_paths,
     auto fetch_task =
         fml::MakeCopyable([asset_manager, kernel_pieces_path,
                            fetch_promise = std::move(fetch_promise)]() mutable {
-          fetch_promise.set_value(
-              asset_manager->GetAsMapping(kernel_pieces_path));
+          auto mapping = asset_manager->GetAsMapping(kernel_pieces_path);
+          // Read the piece in on the worker rather than when the isolate
+          // loads it.
+          if (mapping) {
+            mapping->Advise(fml::Mapping::Advice::kSequential);
+            mapping->Prefault();
+          }
+          fetch_promise.set_value(std::move(mapping));
         });
     // Fulfill the promise on the worker if one is available or the current
     // thread if one is not.
@@ -226,6 +232,8 @@ std::unique_ptr<IsolateConfiguration> IsolateConfiguration::InferFromSettings(
     std::unique_ptr<fml::Mapping> kernel =
         asset_manager->GetAsMapping(settings.application_kernel_asset);
     if (kernel) {
+      // The kernel is read front to back when the isolate loads it.
+      kernel->Advise(fml::Mapping::Advice::kSequential);
       return CreateForKernel(std::move(kernel));
     }
   }
@@ -40,6 +40,11 @@ Animator::Animator(Delegate& delegate,
               ? 1
               : 2)),
 #endif  // SHELL_ENABLE_METAL
+      pipeline_depth_controller_(std::make_shared<PipelineDepthController>(
+          layer_tree_pipeline_->GetDepth(),
+          layer_tree_pipeline_->GetDepth() == 1
+              ? 1
+              : PipelineDepthController::kMaxDepth)),
       pending_frame_semaphore_(1),
       paused_(false),
       regenerate_layer_tree_(false),
@@ -82,6 +87,11 @@ void Animator::EnqueueTraceFlowId(uint64_t trace_flow_id) {
       });
 }
 
+std::shared_ptr<PipelineDepthController>
+Animator::GetPipelineDepthController() const {
+  return pipeline_depth_controller_;
+}
+
 // This Parity is used by the timeline component to correctly align
 // GPU Workloads events with their respective Framework Workload.
 const char* Animator::FrameParity() {
@@ -121,6 +131,12 @@ void Animator::BeginFrame(
   pending_frame_semaphore_.Signal();
 
   if (!producer_continuation_) {
+    // Whether this frame may be built before the previous ones are
+    // rasterized depends on how long the recent frames took.
+    layer_tree_pipeline_->SetDepth(pipeline_depth_controller_->Decide(
+        frame_timings_recorder_->GetVsyncTargetTime() -
+        frame_timings_recorder_->GetVsyncStartTime()));
+
     // We may already have a valid pipeline continuation in case a previous
     // begin frame did not result in an Animation::Render. Simply reuse that
     // instead of asking the pipeline for a fresh continuation.
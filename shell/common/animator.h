@@ -14,6 +14,7 @@
 #include "flutter/fml/synchronization/semaphore.h"
 #include "flutter/fml/time/time_point.h"
 #include "flutter/shell/common/pipeline.h"
+#include "flutter/shell/common/pipeline_depth_controller.h"
 #include "flutter/shell/common/rasterizer.h"
 #include "flutter/shell/common/vsync_waiter.h"
 
@@ -83,6 +84,10 @@ class Animator final {
   // active rendering.
   void EnqueueTraceFlowId(uint64_t trace_flow_id);
 
+  // The controller of the depth of the layer tree pipeline, which expects
+  // the timings of the rasterized frames.
+  std::shared_ptr<PipelineDepthController> GetPipelineDepthController() const;
+
  private:
   using LayerTreePipeline = Pipeline<flutter::LayerTree>;
 
@@ -108,6 +113,7 @@ class Animator final {
   uint64_t frame_request_number_ = 1;
   int64_t dart_frame_deadline_;
   std::shared_ptr<LayerTreePipeline> layer_tree_pipeline_;
+  std::shared_ptr<PipelineDepthController> pipeline_depth_controller_;
   fml::Semaphore pending_frame_semaphore_;
   LayerTreePipeline::ProducerContinuation producer_continuation_;
   bool paused_;
@@ -222,6 +222,7 @@ Engine::RunStatus Engine::Run(RunConfiguration configuration) {
 
 void Engine::BeginFrame(fml::TimePoint frame_time, uint64_t frame_number) {
   TRACE_EVENT0("flutter", "Engine::BeginFrame");
+  pointer_data_dispatcher_->OnBeginFrame(frame_time);
   runtime_controller_->BeginFrame(frame_time, frame_number);
 }
 
@@ -538,6 +539,8 @@ void Engine::HandleAssetPlatformMessage(
     std::unique_ptr<fml::Mapping> asset_mapping =
         asset_manager_->GetAsMapping(asset_name);
     if (asset_mapping) {
+      // The asset is copied to the framework in full.
+      asset_mapping->Advise(fml::Mapping::Advice::kSequential);
       response->Complete(std::move(asset_mapping));
       return;
     }
@@ -45,6 +45,21 @@ void onPointerDataPacketMain() {
   };
 }
 
+void nativeOnEvent(String event) native 'NativeOnEvent';
+
+@pragma('vm:entry-point')
+void onPointerDataPacketAndPlatformMessageMain() {
+  PlatformDispatcher.instance.onPointerDataPacket = (PointerDataPacket packet) {
+    for (PointerData data in packet.data) {
+      nativeOnEvent(data.change.toString());
+    }
+  };
+  PlatformDispatcher.instance.onPlatformMessage =
+      (String name, ByteData? data, PlatformMessageResponseCallback? callback) {
+    nativeOnEvent(name);
+  };
+}
+
 @pragma('vm:entry-point')
 void emptyMain() {}
 
@@ -2,6 +2,7 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include "flutter/fml/synchronization/count_down_latch.h"
 #include "flutter/shell/common/shell_test.h"
 #include "flutter/testing/testing.h"
 
@@ -412,5 +413,58 @@ TEST_F(ShellTest, CanCorrectlySynthesizePointerPacket) {
   ASSERT_FALSE(DartVMRef::IsInstanceRunning());
 }
 
+TEST_F(ShellTest, DispatchesPlatformMessagesBetweenPointerDataPackets) {
+  auto settings = CreateSettingsForFixture();
+  auto task_runners = GetTaskRunnersForFixture();
+  // Unlike the platform views of the other tests, the base platform view
+  // does not hold pointer data packets until the next vsync.
+  std::unique_ptr<Shell> shell = Shell::Create(
+      PlatformData(), task_runners, settings,
+      [](Shell& shell) {
+        return std::make_unique<PlatformView>(shell, shell.GetTaskRunners());
+      },
+      [](Shell& shell) { return std::make_unique<Rasterizer>(shell); });
+  ASSERT_TRUE(shell);
+
+  auto configuration = RunConfiguration::InferFromSettings(settings);
+  configuration.SetEntrypoint("onPointerDataPacketAndPlatformMessageMain");
+  // Only accessed on the UI thread until the latch is released.
+  std::vector<std::string> events;
+  fml::CountDownLatch latch(3);
+  AddNativeCallback("NativeOnEvent",
+                    CREATE_NATIVE_ENTRY([&](Dart_NativeArguments args) {
+                      events.push_back(
+                          tonic::DartConverter<std::string>::FromDart(
+                              Dart_GetNativeArgument(args, 0)));
+                      latch.CountDown();
+                    }));
+  RunEngine(shell.get(), std::move(configuration));
+
+  // The events are sent by a single platform task, so the UI thread receives
+  // the second packet while the task of the first one is still pending.
+  fml::TaskRunner::RunNowOrPostTask(
+      task_runners.GetPlatformTaskRunner(), [&shell]() {
+        auto platform_view = shell->GetPlatformView();
+        PointerData data;
+        auto first_packet = std::make_unique<PointerDataPacket>(1);
+        CreateSimulatedPointerData(data, PointerData::Change::kAdd, 0.0, 0.0);
+        first_packet->SetPointerData(0, data);
+        platform_view->DispatchPointerDataPacket(std::move(first_packet));
+        platform_view->DispatchPlatformMessage(
+            std::make_unique<PlatformMessage>("test/channel", nullptr));
+        auto second_packet = std::make_unique<PointerDataPacket>(1);
+        CreateSimulatedPointerData(data, PointerData::Change::kRemove, 0.0,
+                                   0.0);
+        second_packet->SetPointerData(0, data);
+        platform_view->DispatchPointerDataPacket(std::move(second_packet));
+      });
+  latch.Wait();
+  ASSERT_EQ(events, (std::vector<std::string>{"PointerChange.add",
+                                              "test/channel",
+                                              "PointerChange.remove"}));
+
+  DestroyShell(std::move(shell), std::move(task_runners));
+}
+
 }  // namespace testing
 }  // namespace flutter
@@ -7,6 +7,8 @@
 #include <memory>
 
 #include "flutter/assets/directory_asset_bundle.h"
+#include "flutter/common/graphics/sksl_archive.h"
+#include "flutter/common/graphics/sksl_usage.h"
 #include "flutter/flow/layers/container_layer.h"
 #include "flutter/flow/layers/layer.h"
 #include "flutter/flow/layers/physical_shape_layer.h"
@@ -362,5 +364,285 @@ TEST_F(PersistentCacheTest, PurgeAllowsFutureSkSLCache) {
   DestroyShell(std::move(shell));
 }
 
+TEST_F(PersistentCacheTest, LoadsSkSLsInPriorityOrder) {
+  fml::ScopedTemporaryDirectory base_dir;
+  ASSERT_TRUE(base_dir.fd().is_valid());
+  auto sksl_dir = std::make_shared<fml::UniqueFD>(fml::CreateDirectory(
+      base_dir.fd(),
+      {"flutter_engine", GetFlutterEngineVersion(), "skia", GetSkiaVersion(),
+       PersistentCache::kSkSLSubdirName},
+      fml::FilePermission::kReadWrite));
+  ASSERT_TRUE(sksl_dir->is_valid());
+  {
+    SkSLArchive archive(sksl_dir, false);
+    for (std::string key : {"A", "B", "C"}) {
+      ASSERT_TRUE(archive.Append(fml::DataMapping(key),
+                                 fml::DataMapping(std::string("x"))));
+    }
+    // "C" was used by the first frame of the previous run, and "B" later.
+    SkSLUsage usage(sksl_dir);
+    usage.RecordUse("C");
+    usage.MarkFirstFrameRasterized();
+    usage.RecordUse("B");
+    ASSERT_TRUE(usage.Save());
+  }
+
+  PersistentCache::SetCacheDirectoryPath(base_dir.path());
+  PersistentCache::ResetCacheForProcess();
+  auto sksls = PersistentCache::GetCacheForProcess()->LoadSkSLs();
+  ASSERT_EQ(sksls.size(), 3u);
+  CheckTextSkData(sksls[0].first, "C");
+  CheckTextSkData(sksls[1].first, "B");
+  CheckTextSkData(sksls[2].first, "A");
+
+  // Cleanup
+  fml::RemoveFilesInDirectory(base_dir.fd());
+}
+
+TEST_F(PersistentCacheTest, OnlyRecordsSkSLUsageWhenDeferringPrecompilation) {
+  sk_sp<SkData> shader_key = SkData::MakeWithCString("key");
+  fml::ScopedTemporaryDirectory base_dir;
+  ASSERT_TRUE(base_dir.fd().is_valid());
+  auto sksl_dir = fml::CreateDirectory(
+      base_dir.fd(),
+      {"flutter_engine", GetFlutterEngineVersion(), "skia", GetSkiaVersion(),
+       PersistentCache::kSkSLSubdirName},
+      fml::FilePermission::kReadWrite);
+  ASSERT_TRUE(sksl_dir.is_valid());
+  PersistentCache::SetCacheDirectoryPath(base_dir.path());
+
+  // Destroying the cache saves the recorded usage.
+  PersistentCache::ResetCacheForProcess();
+  PersistentCache::SetCacheSkSL(true);
+  PersistentCache::GetCacheForProcess()->load(*shader_key);
+  PersistentCache::ResetCacheForProcess();
+  ASSERT_FALSE(fml::FileExists(sksl_dir, SkSLUsage::kFileName));
+
+  PersistentCache::SetCacheSkSL(true);
+  PersistentCache::SetDeferSkSLPrecompilation(true);
+  PersistentCache::GetCacheForProcess()->load(*shader_key);
+  PersistentCache::ResetCacheForProcess();
+  ASSERT_TRUE(fml::FileExists(sksl_dir, SkSLUsage::kFileName));
+
+  // Cleanup
+  PersistentCache::SetCacheSkSL(false);
+  PersistentCache::SetDeferSkSLPrecompilation(false);
+  fml::RemoveFilesInDirectory(base_dir.fd());
+}
+
+static std::shared_ptr<fml::UniqueFD> MakeSharedFD(const fml::UniqueFD& dir) {
+  return std::make_shared<fml::UniqueFD>(
+      fml::OpenDirectory(dir, ".", false, fml::FilePermission::kReadWrite));
+}
+
+static std::string FindInArchive(SkSLArchive& archive, const std::string& key) {
+  auto value = archive.Find(fml::DataMapping(key));
+  if (!value) {
+    return "<none>";
+  }
+  return std::string(reinterpret_cast<const char*>(value->GetMapping()),
+                     value->GetSize());
+}
+
+TEST(SkSLArchiveTest, AppendedEntriesSurviveReopening) {
+  fml::ScopedTemporaryDirectory dir;
+  {
+    SkSLArchive archive(MakeSharedFD(dir.fd()), false);
+    ASSERT_EQ(archive.GetEntryCount(), 0u);
+    ASSERT_TRUE(archive.Append(fml::DataMapping(std::string("A")),
+                               fml::DataMapping(std::string("x"))));
+    ASSERT_TRUE(archive.Append(fml::DataMapping(std::string("B")),
+                               fml::DataMapping(std::string("y"))));
+    ASSERT_TRUE(archive.Append(fml::DataMapping(std::string("A")),
+                               fml::DataMapping(std::string("z"))));
+    ASSERT_EQ(archive.GetEntryCount(), 2u);
+  }
+
+  SkSLArchive archive(MakeSharedFD(dir.fd()), true);
+  ASSERT_EQ(archive.GetEntryCount(), 2u);
+  ASSERT_EQ(FindInArchive(archive, "A"), "z");
+  ASSERT_EQ(FindInArchive(archive, "B"), "y");
+  ASSERT_EQ(FindInArchive(archive, "C"), "<none>");
+}
+
+TEST(SkSLArchiveTest, CompactionKeepsTheLatestValues) {
+  fml::ScopedTemporaryDirectory dir;
+  SkSLArchive archive(MakeSharedFD(dir.fd()), false);
+  for (size_t i = 0; i < 100; i++) {
+    ASSERT_TRUE(archive.Append(fml::DataMapping(std::to_string(i)),
+                               fml::DataMapping(std::string("old"))));
+  }
+  ASSERT_TRUE(archive.Compact());
+  ASSERT_TRUE(archive.Append(fml::DataMapping(std::string("7")),
+                             fml::DataMapping(std::string("new"))));
+  ASSERT_TRUE(archive.Compact());
+
+  SkSLArchive reopened(MakeSharedFD(dir.fd()), true);
+  ASSERT_EQ(reopened.GetEntryCount(), 100u);
+  ASSERT_EQ(FindInArchive(reopened, "7"), "new");
+  ASSERT_EQ(FindInArchive(reopened, "42"), "old");
+  size_t visited = 0;
+  reopened.VisitEntries(
+      [&visited](const fml::Mapping& key, const fml::Mapping& value) {
+        visited++;
+      });
+  ASSERT_EQ(visited, 100u);
+}
+
+TEST(SkSLArchiveTest, MigratesShadersStoredOnePerFile) {
+  fml::ScopedTemporaryDirectory dir;
+  // "IE" and "II" are the Base32 encodings of "A" and "B".
+  ASSERT_TRUE(fml::WriteAtomically(dir.fd(), "IE",
+                                   fml::DataMapping(std::string("x"))));
+  ASSERT_TRUE(fml::WriteAtomically(dir.fd(), "II",
+                                   fml::DataMapping(std::string("y"))));
+
+  SkSLArchive read_only_archive(MakeSharedFD(dir.fd()), true);
+  ASSERT_EQ(read_only_archive.GetEntryCount(), 0u);
+
+  SkSLArchive archive(MakeSharedFD(dir.fd()), false);
+  ASSERT_EQ(archive.GetEntryCount(), 2u);
+  ASSERT_EQ(FindInArchive(archive, "A"), "x");
+  ASSERT_EQ(FindInArchive(archive, "B"), "y");
+  ASSERT_FALSE(fml::FileExists(dir.fd(), "IE"));
+  ASSERT_FALSE(fml::FileExists(dir.fd(), "II"));
+  ASSERT_TRUE(fml::FileExists(dir.fd(), SkSLArchive::kFileName));
+}
+
+TEST(SkSLArchiveTest, IgnoresTornRecords) {
+  fml::ScopedTemporaryDirectory dir;
+  {
+    SkSLArchive archive(MakeSharedFD(dir.fd()), false);
+    ASSERT_TRUE(archive.Append(fml::DataMapping(std::string("A")),
+                               fml::DataMapping(std::string("x"))));
+  }
+  {
+    // Simulate a crash in the middle of appending a record.
+    auto file = fml::OpenFile(dir.fd(), SkSLArchive::kFileName, false,
+                              fml::FilePermission::kReadWrite);
+    ASSERT_TRUE(fml::AppendToFile(file, fml::DataMapping(std::string("F"))));
+  }
+
+  SkSLArchive archive(MakeSharedFD(dir.fd()), false);
+  ASSERT_EQ(archive.GetEntryCount(), 1u);
+  ASSERT_EQ(FindInArchive(archive, "A"), "x");
+  ASSERT_TRUE(archive.Append(fml::DataMapping(std::string("B")),
+                             fml::DataMapping(std::string("y"))));
+
+  SkSLArchive reopened(MakeSharedFD(dir.fd()), true);
+  ASSERT_EQ(reopened.GetEntryCount(), 2u);
+  ASSERT_EQ(FindInArchive(reopened, "B"), "y");
+}
+
+TEST(SkSLArchiveTest, DiscardsInvalidArchive) {
+  fml::ScopedTemporaryDirectory dir;
+  ASSERT_TRUE(fml::WriteAtomically(dir.fd(), SkSLArchive::kFileName,
+                                   fml::DataMapping(std::string("garbage"))));
+
+  SkSLArchive archive(MakeSharedFD(dir.fd()), false);
+  ASSERT_EQ(archive.GetEntryCount(), 0u);
+  ASSERT_TRUE(archive.Append(fml::DataMapping(std::string("A")),
+                             fml::DataMapping(std::string("x"))));
+
+  SkSLArchive reopened(MakeSharedFD(dir.fd()), true);
+  ASSERT_EQ(FindInArchive(reopened, "A"), "x");
+}
+
+TEST(SkSLUsageTest, PrioritizesTheShadersOfTheFirstFrame) {
+  fml::ScopedTemporaryDirectory dir;
+  {
+    SkSLUsage usage(MakeSharedFD(dir.fd()));
+    ASSERT_TRUE(usage.RecordUse("B"));
+    ASSERT_FALSE(usage.RecordUse("A"));
+    usage.MarkFirstFrameRasterized();
+    usage.RecordUse("C");
+    usage.RecordUse("D");
+    usage.RecordUse("D");
+    ASSERT_TRUE(usage.Save());
+  }
+
+  SkSLUsage usage(MakeSharedFD(dir.fd()));
+  auto b = usage.GetPriority("B");
+  auto a = usage.GetPriority("A");
+  auto d = usage.GetPriority("D");
+  auto c = usage.GetPriority("C");
+  ASSERT_TRUE(a && b && c && d);
+  ASSERT_EQ(b->rank, 0u);
+  ASSERT_EQ(a->rank, 1u);
+  ASSERT_EQ(d->rank, 2u);
+  ASSERT_EQ(c->rank, 3u);
+  ASSERT_TRUE(b->is_used_by_first_frame);
+  ASSERT_TRUE(a->is_used_by_first_frame);
+  ASSERT_FALSE(d->is_used_by_first_frame);
+  ASSERT_FALSE(usage.GetPriority("E"));
+
+  // The usage file is not mistaken for a shader to migrate.
+  SkSLArchive archive(MakeSharedFD(dir.fd()), false);
+  ASSERT_EQ(archive.GetEntryCount(), 0u);
+  ASSERT_TRUE(fml::FileExists(dir.fd(), SkSLUsage::kFileName));
+}
+
+TEST(SkSLUsageTest, MergesTheUsageOfThePreviousRuns) {
+  fml::ScopedTemporaryDirectory dir;
+  {
+    SkSLUsage usage(MakeSharedFD(dir.fd()));
+    usage.RecordUse("A");
+    usage.MarkFirstFrameRasterized();
+    usage.RecordUse("B");
+    usage.RecordUse("B");
+    usage.RecordUse("C");
+    ASSERT_TRUE(usage.Save());
+  }
+  {
+    SkSLUsage usage(MakeSharedFD(dir.fd()));
+    ASSERT_FALSE(usage.Save());
+    usage.RecordUse("C");
+    usage.MarkFirstFrameRasterized();
+    usage.RecordUse("D");
+    ASSERT_TRUE(usage.Save());
+  }
+
+  // "A" was not used by the second run, and keeps its priority.
+  SkSLUsage usage(MakeSharedFD(dir.fd()));
+  ASSERT_EQ(usage.GetPriority("A")->rank, 0u);
+  ASSERT_TRUE(usage.GetPriority("A")->is_used_by_first_frame);
+  ASSERT_EQ(usage.GetPriority("C")->rank, 1u);
+  ASSERT_TRUE(usage.GetPriority("C")->is_used_by_first_frame);
+  ASSERT_EQ(usage.GetPriority("B")->rank, 2u);
+  ASSERT_EQ(usage.GetPriority("D")->rank, 3u);
+  ASSERT_FALSE(usage.GetPriority("D")->is_used_by_first_frame);
+}
+
+TEST(SkSLUsageTest, KeepsPrecompiledShadersInTheFirstFrame) {
+  fml::ScopedTemporaryDirectory dir;
+  {
+    SkSLUsage usage(MakeSharedFD(dir.fd()));
+    usage.RecordUse("A");
+    usage.RecordUse("B");
+    usage.MarkFirstFrameRasterized();
+    usage.RecordUse("C");
+    ASSERT_TRUE(usage.Save());
+  }
+  // The next runs precompile "A" and "B" before their first frame, so Skia
+  // never loads them, while other shaders keep changing the usage.
+  for (std::string key : {"D", "E"}) {
+    SkSLUsage usage(MakeSharedFD(dir.fd()));
+    ASSERT_TRUE(usage.GetPriority("A")->is_used_by_first_frame);
+    ASSERT_TRUE(usage.GetPriority("B")->is_used_by_first_frame);
+    usage.MarkFirstFrameRasterized();
+    usage.RecordUse(key);
+    ASSERT_TRUE(usage.Save());
+  }
+
+  SkSLUsage usage(MakeSharedFD(dir.fd()));
+  ASSERT_EQ(usage.GetPriority("A")->rank, 0u);
+  ASSERT_TRUE(usage.GetPriority("A")->is_used_by_first_frame);
+  ASSERT_EQ(usage.GetPriority("B")->rank, 1u);
+  ASSERT_TRUE(usage.GetPriority("B")->is_used_by_first_frame);
+  ASSERT_FALSE(usage.GetPriority("C")->is_used_by_first_frame);
+  ASSERT_FALSE(usage.GetPriority("D")->is_used_by_first_frame);
+  ASSERT_FALSE(usage.GetPriority("E")->is_used_by_first_frame);
+}
+
 }  // namespace testing
 }  // namespace flutter
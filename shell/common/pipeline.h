@@ -5,6 +5,7 @@
 #ifndef FLUTTER_SHELL_COMMON_PIPELINE_H_
 #define FLUTTER_SHELL_COMMON_PIPELINE_H_
 
+#include <atomic>
 #include <deque>
 #include <memory>
 #include <mutex>
@@ -91,17 +92,23 @@ class Pipeline {
   };
 
   explicit Pipeline(uint32_t depth)
-      : depth_(depth), empty_(depth), available_(0), inflight_(0) {}
+      : depth_(depth), available_(0), inflight_(0) {}
 
   ~Pipeline() = default;
 
-  bool IsValid() const { return empty_.IsValid() && available_.IsValid(); }
+  bool IsValid() const { return available_.IsValid(); }
+
+  uint32_t GetDepth() const { return depth_.load(); }
+
+  /// Changes the number of resources that may be produced but not consumed
+  /// yet. When reduced below the number in flight, nothing can be produced
+  /// until enough resources are consumed.
+  void SetDepth(uint32_t depth) { depth_ = depth; }
 
   ProducerContinuation Produce() {
-    if (!empty_.TryWait()) {
+    if (!TryReserve()) {
       return {};
     }
-    ++inflight_;
     FML_TRACE_COUNTER("flutter", "Pipeline Depth",
                       reinterpret_cast<int64_t>(this),      //
                       "frames in flight", inflight_.load()  //
@@ -118,10 +125,9 @@ class Pipeline {
   // Prefer using |Produce|. ProducerContinuation returned by this method
   // doesn't guarantee that the frame will be rendered.
   ProducerContinuation ProduceIfEmpty() {
-    if (!empty_.TryWait()) {
+    if (!TryReserve()) {
       return {};
     }
-    ++inflight_;
     FML_TRACE_COUNTER("flutter", "Pipeline Depth",
                       reinterpret_cast<int64_t>(this),      //
                       "frames in flight", inflight_.load()  //
@@ -161,7 +167,6 @@ class Pipeline {
       consumer(std::move(resource));
     }
 
-    empty_.Signal();
     --inflight_;
 
     TRACE_FLOW_END("flutter", "PipelineItem", trace_id);
@@ -172,13 +177,24 @@ class Pipeline {
   }
 
  private:
-  const uint32_t depth_;
-  fml::Semaphore empty_;
+  std::atomic<uint32_t> depth_;
   fml::Semaphore available_;
+  // The resources being produced or waiting to be consumed.
   std::atomic<int> inflight_;
   std::mutex queue_mutex_;
   std::deque<std::pair<ResourcePtr, size_t>> queue_;
 
+  // Reserves a spot for a resource to produce if the pipeline is not full.
+  bool TryReserve() {
+    int inflight = inflight_.load();
+    do {
+      if (inflight >= static_cast<int>(depth_.load())) {
+        return false;
+      }
+    } while (!inflight_.compare_exchange_weak(inflight, inflight + 1));
+    return true;
+  }
+
   bool ProducerCommit(ResourcePtr resource, size_t trace_id) {
     {
       std::scoped_lock lock(queue_mutex_);
@@ -196,7 +212,7 @@ class Pipeline {
       if (!queue_.empty()) {
         // Bail if the queue is not empty, opens up spaces to produce other
         // frames.
-        empty_.Signal();
+        --inflight_;
         return false;
       }
       queue_.emplace_back(std::move(resource), trace_id);
@@ -0,0 +1,106 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/shell/common/pipeline_depth_controller.h"
+
+#include <algorithm>
+#include <string>
+
+#include "flutter/fml/trace_event.h"
+
+namespace flutter {
+
+namespace {
+
+struct Percentiles {
+  fml::TimeDelta median;
+  fml::TimeDelta p90;
+};
+
+template <size_t N>
+Percentiles ComputePercentiles(std::array<fml::TimeDelta, N> durations) {
+  std::sort(durations.begin(), durations.end());
+  return {durations[N / 2], durations[N * 9 / 10]};
+}
+
+}  // namespace
+
+PipelineDepthController::PipelineDepthController(uint32_t initial_depth,
+                                                 uint32_t max_depth)
+    : max_depth_(std::clamp(max_depth, kMinDepth, kMaxDepth)),
+      depth_(std::clamp(initial_depth, kMinDepth, max_depth_)) {}
+
+PipelineDepthController::~PipelineDepthController() = default;
+
+void PipelineDepthController::AddFrameTiming(const FrameTiming& timing) {
+  std::scoped_lock lock(mutex_);
+  const size_t index = frame_count_ % kWindowSize;
+  build_durations_[index] = timing.Get(FrameTiming::kBuildFinish) -
+                            timing.Get(FrameTiming::kBuildStart);
+  raster_durations_[index] = timing.Get(FrameTiming::kRasterFinish) -
+                             timing.Get(FrameTiming::kRasterStart);
+  frame_count_++;
+}
+
+uint32_t PipelineDepthController::Decide(fml::TimeDelta frame_interval) {
+  std::scoped_lock lock(mutex_);
+  if (frame_count_ < kWindowSize || frame_interval <= fml::TimeDelta::Zero()) {
+    return depth_;
+  }
+
+  const Percentiles build = ComputePercentiles(build_durations_);
+  const Percentiles raster = ComputePercentiles(raster_durations_);
+
+  // Leave some slack for the scheduling of the threads when they have to
+  // take turns within a single frame interval.
+  const fml::TimeDelta sequential_budget = frame_interval * 9 / 10;
+
+  uint32_t proposed_depth;
+  const char* reason;
+  if (build.p90 + raster.p90 <= sequential_budget) {
+    proposed_depth = 1;
+    reason = "build and raster fit in a frame";
+  } else if (build.p90 <= frame_interval && raster.p90 <= frame_interval) {
+    proposed_depth = 2;
+    reason = "build and raster fit in a frame each";
+  } else if (build.median <= frame_interval &&
+             raster.median <= frame_interval) {
+    proposed_depth = 3;
+    reason = "absorbing slow frames";
+  } else {
+    // A deeper pipeline does not help when the frames are consistently too
+    // slow, it only adds latency.
+    proposed_depth = 2;
+    reason = "consistently slower than a frame";
+  }
+  proposed_depth = std::clamp(proposed_depth, kMinDepth, max_depth_);
+
+  FML_TRACE_COUNTER("flutter", "PipelineDepthController",
+                    reinterpret_cast<int64_t>(this), "Depth", depth_,
+                    "ProposedDepth", proposed_depth, "BuildP90Micros",
+                    build.p90.ToMicroseconds(), "RasterP90Micros",
+                    raster.p90.ToMicroseconds());
+
+  if (proposed_depth >= depth_) {
+    decisions_for_decrease_ = 0;
+    if (proposed_depth == depth_) {
+      return depth_;
+    }
+  } else if (++decisions_for_decrease_ < kDecisionsBeforeDecrease) {
+    return depth_;
+  }
+
+  decisions_for_decrease_ = 0;
+  depth_ = proposed_depth;
+  TRACE_EVENT_INSTANT2("flutter", "PipelineDepthChanged", "depth",
+                       std::to_string(depth_).c_str(), "reason", reason);
+  return depth_;
+}
+
+uint32_t PipelineDepthController::GetDepth() const {
+  std::scoped_lock lock(mutex_);
+  return depth_;
+}
+
+}  // namespace flutter
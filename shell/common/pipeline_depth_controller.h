@@ -0,0 +1,73 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef FLUTTER_SHELL_COMMON_PIPELINE_DEPTH_CONTROLLER_H_
+#define FLUTTER_SHELL_COMMON_PIPELINE_DEPTH_CONTROLLER_H_
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+
+#include "flutter/common/settings.h"
+#include "flutter/fml/macros.h"
+#include "flutter/fml/time/time_delta.h"
+
+namespace flutter {
+
+/// Chooses the depth of the layer tree pipeline from the build and raster
+/// durations of the recent frames.
+///
+/// With a depth of 1, the UI thread only starts building a frame once the
+/// previous frame has been rasterized. This adds no latency, but the UI and
+/// raster threads have to fit in a single frame interval together. Deeper
+/// pipelines let the UI thread build the next frames while the previous ones
+/// are rasterized, at the cost of a frame of latency each.
+///
+/// The depth is increased as soon as the frames stop fitting, and decreased
+/// once they have fit for a while. Each decision is traced.
+///
+/// Timings are added on the raster thread and the decisions are made on the
+/// UI thread.
+class PipelineDepthController {
+ public:
+  static constexpr uint32_t kMinDepth = 1;
+  static constexpr uint32_t kMaxDepth = 3;
+
+  /// The number of recent frames the decisions are based on.
+  static constexpr size_t kWindowSize = 32;
+
+  /// The number of consecutive decisions for a shallower pipeline before
+  /// the depth is decreased.
+  static constexpr size_t kDecisionsBeforeDecrease = 16;
+
+  /// Creates a controller starting with |initial_depth| that never goes
+  /// deeper than |max_depth|.
+  PipelineDepthController(uint32_t initial_depth, uint32_t max_depth);
+
+  ~PipelineDepthController();
+
+  /// Records the durations of a rasterized frame. Thread-safe.
+  void AddFrameTiming(const FrameTiming& timing);
+
+  /// Returns the depth to use for the next frame, for frames that are
+  /// produced every |frame_interval|.
+  uint32_t Decide(fml::TimeDelta frame_interval);
+
+  uint32_t GetDepth() const;
+
+ private:
+  mutable std::mutex mutex_;
+  const uint32_t max_depth_;
+  uint32_t depth_;
+  size_t decisions_for_decrease_ = 0;
+  size_t frame_count_ = 0;
+  std::array<fml::TimeDelta, kWindowSize> build_durations_;
+  std::array<fml::TimeDelta, kWindowSize> raster_durations_;
+
+  FML_DISALLOW_COPY_AND_ASSIGN(PipelineDepthController);
+};
+
+}  // namespace flutter
+
+#endif  // FLUTTER_SHELL_COMMON_PIPELINE_DEPTH_CONTROLLER_H_
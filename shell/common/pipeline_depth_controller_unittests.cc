@@ -0,0 +1,104 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/shell/common/pipeline_depth_controller.h"
+
+#include "gtest/gtest.h"
+
+namespace flutter {
+namespace testing {
+
+namespace {
+
+const fml::TimeDelta kFrameInterval = fml::TimeDelta::FromMilliseconds(16);
+
+void AddFrames(PipelineDepthController& controller,
+               size_t count,
+               fml::TimeDelta build_duration,
+               fml::TimeDelta raster_duration) {
+  const fml::TimePoint start = fml::TimePoint::Now();
+  FrameTiming timing;
+  timing.Set(FrameTiming::kBuildStart, start);
+  timing.Set(FrameTiming::kBuildFinish, start + build_duration);
+  timing.Set(FrameTiming::kRasterStart, start + build_duration);
+  timing.Set(FrameTiming::kRasterFinish,
+             start + build_duration + raster_duration);
+  for (size_t i = 0; i < count; i++) {
+    controller.AddFrameTiming(timing);
+  }
+}
+
+fml::TimeDelta Milliseconds(int64_t millis) {
+  return fml::TimeDelta::FromMilliseconds(millis);
+}
+
+}  // namespace
+
+TEST(PipelineDepthControllerTest, KeepsInitialDepthUntilWindowIsFull) {
+  PipelineDepthController controller(2, 3);
+  AddFrames(controller, PipelineDepthController::kWindowSize - 1,
+            Milliseconds(1), Milliseconds(1));
+  ASSERT_EQ(controller.Decide(kFrameInterval), 2u);
+}
+
+TEST(PipelineDepthControllerTest, IncreasesDepthImmediately) {
+  PipelineDepthController controller(1, 3);
+  AddFrames(controller, PipelineDepthController::kWindowSize, Milliseconds(10),
+            Milliseconds(10));
+  ASSERT_EQ(controller.Decide(kFrameInterval), 2u);
+  ASSERT_EQ(controller.GetDepth(), 2u);
+}
+
+TEST(PipelineDepthControllerTest, DecreasesDepthAfterStableDecisions) {
+  PipelineDepthController controller(2, 3);
+  AddFrames(controller, PipelineDepthController::kWindowSize, Milliseconds(4),
+            Milliseconds(4));
+  for (size_t i = 1; i < PipelineDepthController::kDecisionsBeforeDecrease;
+       i++) {
+    ASSERT_EQ(controller.Decide(kFrameInterval), 2u);
+  }
+  ASSERT_EQ(controller.Decide(kFrameInterval), 1u);
+}
+
+TEST(PipelineDepthControllerTest, SlowFramesResetDecrease) {
+  PipelineDepthController controller(2, 3);
+  AddFrames(controller, PipelineDepthController::kWindowSize, Milliseconds(4),
+            Milliseconds(4));
+  for (size_t i = 1; i < PipelineDepthController::kDecisionsBeforeDecrease;
+       i++) {
+    ASSERT_EQ(controller.Decide(kFrameInterval), 2u);
+  }
+  AddFrames(controller, PipelineDepthController::kWindowSize, Milliseconds(10),
+            Milliseconds(10));
+  ASSERT_EQ(controller.Decide(kFrameInterval), 2u);
+  AddFrames(controller, PipelineDepthController::kWindowSize, Milliseconds(4),
+            Milliseconds(4));
+  ASSERT_EQ(controller.Decide(kFrameInterval), 2u);
+}
+
+TEST(PipelineDepthControllerTest, AbsorbsOccasionalSlowFrames) {
+  PipelineDepthController controller(2, 3);
+  AddFrames(controller, PipelineDepthController::kWindowSize, Milliseconds(4),
+            Milliseconds(10));
+  AddFrames(controller, PipelineDepthController::kWindowSize / 4,
+            Milliseconds(4), Milliseconds(30));
+  ASSERT_EQ(controller.Decide(kFrameInterval), 3u);
+}
+
+TEST(PipelineDepthControllerTest, DoesNotDeepenForConsistentlySlowFrames) {
+  PipelineDepthController controller(2, 3);
+  AddFrames(controller, PipelineDepthController::kWindowSize, Milliseconds(4),
+            Milliseconds(30));
+  ASSERT_EQ(controller.Decide(kFrameInterval), 2u);
+}
+
+TEST(PipelineDepthControllerTest, RespectsMaxDepth) {
+  PipelineDepthController controller(1, 1);
+  AddFrames(controller, PipelineDepthController::kWindowSize, Milliseconds(12),
+            Milliseconds(12));
+  ASSERT_EQ(controller.Decide(kFrameInterval), 1u);
+}
+
+}  // namespace testing
+}  // namespace flutter
@@ -131,5 +131,45 @@ TEST(PipelineTest, ProduceIfEmptySuccessfulIfQueueIsEmpty) {
   ASSERT_EQ(consume_result_1, PipelineConsumeResult::Done);
 }
 
+TEST(PipelineTest, ReducingDepthBlocksProducingUntilConsumed) {
+  std::shared_ptr<IntPipeline> pipeline = std::make_shared<IntPipeline>(2);
+
+  Continuation continuation_1 = pipeline->Produce();
+  bool result = continuation_1.Complete(std::make_unique<int>(1));
+  ASSERT_EQ(result, true);
+  Continuation continuation_2 = pipeline->Produce();
+  result = continuation_2.Complete(std::make_unique<int>(2));
+  ASSERT_EQ(result, true);
+
+  pipeline->SetDepth(1);
+  ASSERT_EQ(pipeline->GetDepth(), 1u);
+  ASSERT_FALSE(pipeline->Produce());
+
+  PipelineConsumeResult consume_result =
+      pipeline->Consume([](std::unique_ptr<int> v) { ASSERT_EQ(*v, 1); });
+  ASSERT_EQ(consume_result, PipelineConsumeResult::MoreAvailable);
+  ASSERT_FALSE(pipeline->Produce());
+
+  consume_result =
+      pipeline->Consume([](std::unique_ptr<int> v) { ASSERT_EQ(*v, 2); });
+  ASSERT_EQ(consume_result, PipelineConsumeResult::Done);
+  ASSERT_TRUE(pipeline->Produce());
+}
+
+TEST(PipelineTest, IncreasingDepthAllowsProducingMore) {
+  std::shared_ptr<IntPipeline> pipeline = std::make_shared<IntPipeline>(1);
+
+  Continuation continuation_1 = pipeline->Produce();
+  ASSERT_TRUE(continuation_1);
+  ASSERT_FALSE(pipeline->Produce());
+
+  pipeline->SetDepth(3);
+  Continuation continuation_2 = pipeline->Produce();
+  ASSERT_TRUE(continuation_2);
+  Continuation continuation_3 = pipeline->Produce();
+  ASSERT_TRUE(continuation_3);
+  ASSERT_FALSE(pipeline->Produce());
+}
+
 }  // namespace testing
 }  // namespace flutter
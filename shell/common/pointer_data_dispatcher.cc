@@ -4,10 +4,79 @@
 
 #include "flutter/shell/common/pointer_data_dispatcher.h"
 
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <vector>
+
 #include "flutter/fml/trace_event.h"
 
 namespace flutter {
 
+namespace {
+
+bool IsMoveOrHover(const PointerData& data) {
+  return data.signal_kind == PointerData::SignalKind::kNone &&
+         (data.change == PointerData::Change::kMove ||
+          data.change == PointerData::Change::kHover);
+}
+
+double Interpolate(double from, double to, double alpha) {
+  return from + (to - from) * alpha;
+}
+
+// Returns |from| moved towards |to| by |alpha|, extrapolating past |to| if
+// |alpha| is greater than 1.
+PointerData InterpolateSample(const PointerData& from,
+                              const PointerData& to,
+                              int64_t time_stamp) {
+  const double alpha = static_cast<double>(time_stamp - from.time_stamp) /
+                       (to.time_stamp - from.time_stamp);
+  PointerData result = to;
+  result.time_stamp = time_stamp;
+  result.physical_x = Interpolate(from.physical_x, to.physical_x, alpha);
+  result.physical_y = Interpolate(from.physical_y, to.physical_y, alpha);
+  return result;
+}
+
+bool CanCoalesce(const PointerData& previous, const PointerData& next) {
+  return IsMoveOrHover(previous) && IsMoveOrHover(next) &&
+         previous.change == next.change && previous.kind == next.kind &&
+         previous.pointer_identifier == next.pointer_identifier &&
+         previous.buttons == next.buttons;
+}
+
+// Merges the consecutive moves and hovers of each device into the most recent
+// one.
+void CoalesceSamples(std::vector<PointerData>& samples) {
+  std::vector<bool> is_merged(samples.size(), false);
+  // The index of the last sample of each device.
+  std::unordered_map<int64_t, size_t> last_indices;
+  for (size_t i = 0; i < samples.size(); i++) {
+    PointerData& sample = samples[i];
+    auto last_index = last_indices.find(sample.device);
+    if (last_index != last_indices.end()) {
+      const PointerData& previous = samples[last_index->second];
+      if (CanCoalesce(previous, sample)) {
+        sample.physical_delta_x += previous.physical_delta_x;
+        sample.physical_delta_y += previous.physical_delta_y;
+        is_merged[last_index->second] = true;
+      }
+    }
+    last_indices[sample.device] = i;
+  }
+
+  size_t count = 0;
+  for (size_t i = 0; i < samples.size(); i++) {
+    if (!is_merged[i]) {
+      samples[count++] = samples[i];
+    }
+  }
+  samples.resize(count);
+}
+
+}  // namespace
+
 PointerDataDispatcher::~PointerDataDispatcher() = default;
 DefaultPointerDataDispatcher::~DefaultPointerDataDispatcher() = default;
 
@@ -15,6 +84,24 @@ SmoothPointerDataDispatcher::SmoothPointerDataDispatcher(Delegate& delegate)
     : DefaultPointerDataDispatcher(delegate), weak_factory_(this) {}
 SmoothPointerDataDispatcher::~SmoothPointerDataDispatcher() = default;
 
+ResamplingPointerDataDispatcher::ResamplingPointerDataDispatcher(
+    Delegate& delegate,
+    fml::TimeDelta sampling_offset)
+    : DefaultPointerDataDispatcher(delegate),
+      sampling_offset_(sampling_offset),
+      weak_factory_(this) {}
+ResamplingPointerDataDispatcher::~ResamplingPointerDataDispatcher() = default;
+
+CoalescingPointerDataDispatcher::CoalescingPointerDataDispatcher(
+    Delegate& delegate,
+    bool keep_history)
+    : DefaultPointerDataDispatcher(delegate),
+      keep_history_(keep_history),
+      weak_factory_(this) {}
+CoalescingPointerDataDispatcher::~CoalescingPointerDataDispatcher() = default;
+
+void PointerDataDispatcher::OnBeginFrame(fml::TimePoint frame_time) {}
+
 void DefaultPointerDataDispatcher::DispatchPacket(
     std::unique_ptr<PointerDataPacket> packet,
     uint64_t trace_flow_id) {
@@ -68,4 +155,278 @@ void SmoothPointerDataDispatcher::DispatchPendingPacket() {
   ScheduleSecondaryVsyncCallback();
 }
 
+void ResamplingPointerDataDispatcher::DispatchPacket(
+    std::unique_ptr<PointerDataPacket> packet,
+    uint64_t trace_flow_id) {
+  TRACE_EVENT0("flutter", "ResamplingPointerDataDispatcher::DispatchPacket");
+  TRACE_FLOW_STEP("flutter", "PointerEvent", trace_flow_id);
+
+  const size_t count = packet->data().size() / sizeof(PointerData);
+  std::vector<PointerData> samples(count);
+  bool has_resampled_samples = false;
+  for (size_t i = 0; i < count; i++) {
+    memcpy(&samples[i], &packet->data()[i * sizeof(PointerData)],
+           sizeof(PointerData));
+    has_resampled_samples |= IsMoveOrHover(samples[i]);
+  }
+
+  const bool dispatch_now = pending_samples_.empty() && !has_resampled_samples;
+  for (const PointerData& sample : samples) {
+    pending_samples_.push_back({sample, trace_flow_id});
+  }
+  if (dispatch_now) {
+    // Nothing to resample, and nothing to keep the order with.
+    DispatchSamples(std::numeric_limits<int64_t>::max(), false);
+    return;
+  }
+  ScheduleSecondaryVsyncCallback();
+}
+
+void ResamplingPointerDataDispatcher::OnBeginFrame(fml::TimePoint frame_time) {
+  frame_begun_ = true;
+  if (pending_samples_.empty()) {
+    return;
+  }
+  TRACE_EVENT0("flutter", "ResamplingPointerDataDispatcher::OnBeginFrame");
+  DispatchSamples(
+      (frame_time - sampling_offset_).ToEpochDelta().ToMicroseconds(), true);
+}
+
+void ResamplingPointerDataDispatcher::DispatchSamples(int64_t sample_time,
+                                                      bool resample) {
+  std::vector<PointerData> samples;
+  // The indices of the samples to resample once all the samples up to
+  // |sample_time| are known, by device.
+  std::unordered_map<int64_t, size_t> resampled_indices;
+  std::vector<uint64_t> trace_flow_ids;
+
+  while (!pending_samples_.empty() &&
+         pending_samples_.front().data.time_stamp <= sample_time) {
+    const PointerData data = pending_samples_.front().data;
+    const uint64_t trace_flow_id = pending_samples_.front().trace_flow_id;
+    pending_samples_.pop_front();
+    if (trace_flow_ids.empty() || trace_flow_ids.back() != trace_flow_id) {
+      trace_flow_ids.push_back(trace_flow_id);
+    }
+
+    DeviceState& device = devices_[data.device];
+    // The previous sample of the device is not the most recent anymore.
+    auto resampled_index = resampled_indices.find(data.device);
+    if (resampled_index != resampled_indices.end()) {
+      samples[resampled_index->second] = device.last_sample;
+      UpdatePosition(samples[resampled_index->second]);
+      resampled_indices.erase(resampled_index);
+    }
+
+    if (IsMoveOrHover(data)) {
+      device.previous_sample = device.last_sample;
+      device.last_sample = data;
+      device.sample_count++;
+      if (data.time_stamp <= device.resampled_time_stamp) {
+        // The framework was already given a more recent position.
+        continue;
+      }
+      if (resample) {
+        resampled_indices[data.device] = samples.size();
+        samples.push_back(data);
+      } else {
+        samples.push_back(data);
+        UpdatePosition(samples.back());
+      }
+      continue;
+    }
+
+    samples.push_back(data);
+    UpdatePosition(samples.back());
+    switch (data.change) {
+      case PointerData::Change::kAdd:
+      case PointerData::Change::kDown:
+        device.last_sample = data;
+        device.sample_count = 1;
+        device.resampled_time_stamp = 0;
+        break;
+      case PointerData::Change::kUp:
+      case PointerData::Change::kCancel:
+        device.sample_count = 0;
+        device.resampled_time_stamp = 0;
+        break;
+      case PointerData::Change::kRemove:
+        devices_.erase(data.device);
+        break;
+      default:
+        break;
+    }
+  }
+
+  for (const auto& [device_id, index] : resampled_indices) {
+    // Only the samples up to the next change of the device can be used.
+    const PointerData* next_sample = nullptr;
+    for (const PendingSample& pending_sample : pending_samples_) {
+      if (pending_sample.data.device == device_id) {
+        if (IsMoveOrHover(pending_sample.data)) {
+          next_sample = &pending_sample.data;
+        }
+        break;
+      }
+    }
+    DeviceState& device = devices_[device_id];
+    samples[index] = Resample(device, sample_time, next_sample);
+    UpdatePosition(samples[index]);
+    device.resampled_time_stamp = samples[index].time_stamp;
+  }
+
+  if (trace_flow_ids.empty()) {
+    return;
+  }
+  // The samples of several packets may be dispatched together, in which case
+  // the packet carries the flow of the most recent one.
+  for (size_t i = 0; i + 1 < trace_flow_ids.size(); i++) {
+    TRACE_FLOW_END("flutter", "PointerEvent", trace_flow_ids[i]);
+  }
+  if (samples.empty()) {
+    TRACE_FLOW_END("flutter", "PointerEvent", trace_flow_ids.back());
+    return;
+  }
+  auto packet = std::make_unique<PointerDataPacket>(samples.size());
+  for (size_t i = 0; i < samples.size(); i++) {
+    packet->SetPointerData(i, samples[i]);
+  }
+  DefaultPointerDataDispatcher::DispatchPacket(std::move(packet),
+                                               trace_flow_ids.back());
+}
+
+PointerData ResamplingPointerDataDispatcher::Resample(
+    const DeviceState& device,
+    int64_t sample_time,
+    const PointerData* next_sample) const {
+  const PointerData& last_sample = device.last_sample;
+  if (next_sample != nullptr) {
+    if (next_sample->time_stamp <= last_sample.time_stamp) {
+      return last_sample;
+    }
+    return InterpolateSample(last_sample, *next_sample,
+                             std::min(sample_time, next_sample->time_stamp));
+  }
+
+  if (device.sample_count < 2) {
+    return last_sample;
+  }
+  const PointerData& previous_sample = device.previous_sample;
+  const int64_t delta = last_sample.time_stamp - previous_sample.time_stamp;
+  if (delta < kMinResampleDelta.ToMicroseconds() ||
+      delta > kMaxResampleDelta.ToMicroseconds()) {
+    return last_sample;
+  }
+  const int64_t time_stamp =
+      std::min(sample_time,
+               last_sample.time_stamp + kMaxPrediction.ToMicroseconds());
+  if (time_stamp <= last_sample.time_stamp) {
+    return last_sample;
+  }
+  return InterpolateSample(previous_sample, last_sample, time_stamp);
+}
+
+void ResamplingPointerDataDispatcher::UpdatePosition(PointerData& data) {
+  DeviceState& device = devices_[data.device];
+  if (IsMoveOrHover(data) && device.has_position) {
+    data.physical_delta_x = data.physical_x - device.physical_x;
+    data.physical_delta_y = data.physical_y - device.physical_y;
+  }
+  device.has_position = true;
+  device.physical_x = data.physical_x;
+  device.physical_y = data.physical_y;
+}
+
+void ResamplingPointerDataDispatcher::ScheduleSecondaryVsyncCallback() {
+  if (is_vsync_callback_scheduled_) {
+    return;
+  }
+  is_vsync_callback_scheduled_ = true;
+  frame_begun_ = false;
+  delegate_.ScheduleSecondaryVsyncCallback(
+      reinterpret_cast<uintptr_t>(this),
+      [dispatcher = weak_factory_.GetWeakPtr()]() {
+        if (!dispatcher) {
+          return;
+        }
+        dispatcher->is_vsync_callback_scheduled_ = false;
+        if (dispatcher->pending_samples_.empty()) {
+          return;
+        }
+        if (dispatcher->frame_begun_) {
+          // Wait for the next frame to resample the samples that are more
+          // recent than this one.
+          dispatcher->ScheduleSecondaryVsyncCallback();
+          return;
+        }
+        // No frame to resample to, so do not hold on to the samples.
+        dispatcher->DispatchSamples(std::numeric_limits<int64_t>::max(),
+                                    false);
+      });
+}
+
+void CoalescingPointerDataDispatcher::DispatchPacket(
+    std::unique_ptr<PointerDataPacket> packet,
+    uint64_t trace_flow_id) {
+  TRACE_EVENT0("flutter", "CoalescingPointerDataDispatcher::DispatchPacket");
+  TRACE_FLOW_STEP("flutter", "PointerEvent", trace_flow_id);
+
+  const size_t count = packet->data().size() / sizeof(PointerData);
+  const size_t offset = pending_samples_.size();
+  pending_samples_.resize(offset + count);
+  memcpy(&pending_samples_[offset], packet->data().data(),
+         count * sizeof(PointerData));
+  pending_trace_flow_ids_.push_back(trace_flow_id);
+
+  if (!is_pointer_data_in_progress_) {
+    DispatchPendingSamples();
+  }
+}
+
+void CoalescingPointerDataDispatcher::DispatchPendingSamples() {
+  const size_t received_count = pending_samples_.size();
+  if (!keep_history_) {
+    CoalesceSamples(pending_samples_);
+  }
+  TRACE_EVENT2("flutter",
+               "CoalescingPointerDataDispatcher::DispatchPendingSamples",
+               "received", std::to_string(received_count).c_str(),
+               "dispatched", std::to_string(pending_samples_.size()).c_str());
+
+  // The packets are dispatched together, carrying the flow of the most
+  // recent one.
+  const uint64_t trace_flow_id = pending_trace_flow_ids_.back();
+  pending_trace_flow_ids_.pop_back();
+  for (uint64_t merged_trace_flow_id : pending_trace_flow_ids_) {
+    TRACE_FLOW_END("flutter", "PointerEvent", merged_trace_flow_id);
+  }
+  pending_trace_flow_ids_.clear();
+
+  auto packet = std::make_unique<PointerDataPacket>(pending_samples_.size());
+  for (size_t i = 0; i < pending_samples_.size(); i++) {
+    packet->SetPointerData(i, pending_samples_[i]);
+  }
+  pending_samples_.clear();
+  DefaultPointerDataDispatcher::DispatchPacket(std::move(packet),
+                                               trace_flow_id);
+
+  is_pointer_data_in_progress_ = true;
+  ScheduleSecondaryVsyncCallback();
+}
+
+void CoalescingPointerDataDispatcher::ScheduleSecondaryVsyncCallback() {
+  delegate_.ScheduleSecondaryVsyncCallback(
+      reinterpret_cast<uintptr_t>(this),
+      [dispatcher = weak_factory_.GetWeakPtr()]() {
+        if (!dispatcher) {
+          return;
+        }
+        if (dispatcher->pending_trace_flow_ids_.empty()) {
+          dispatcher->is_pointer_data_in_progress_ = false;
+          return;
+        }
+        dispatcher->DispatchPendingSamples();
+      });
+}
+
 }  // namespace flutter
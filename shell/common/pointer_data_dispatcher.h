@@ -5,6 +5,10 @@
 #ifndef POINTER_DATA_DISPATCHER_H_
 #define POINTER_DATA_DISPATCHER_H_
 
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
 #include "flutter/runtime/runtime_controller.h"
 #include "flutter/shell/common/animator.h"
 
@@ -59,8 +63,10 @@ class PointerDataDispatcher {
     ///           secondary callback will still be executed at vsync.
     ///
     ///           This callback is used to provide the vsync signal needed by
-    ///           `SmoothPointerDataDispatcher`, and for `Animator` input flow
-    ///           events.
+    ///           `SmoothPointerDataDispatcher`,
+    ///           `ResamplingPointerDataDispatcher` and
+    ///           `CoalescingPointerDataDispatcher`, and for `Animator` input
+    ///           flow events.
     virtual void ScheduleSecondaryVsyncCallback(
         uintptr_t id,
         const fml::closure& callback) = 0;
@@ -74,6 +80,13 @@ class PointerDataDispatcher {
   virtual void DispatchPacket(std::unique_ptr<PointerDataPacket> packet,
                               uint64_t trace_flow_id) = 0;
 
+  //----------------------------------------------------------------------------
+  /// @brief      Signal that the engine is about to begin a frame, before the
+  ///             framework is asked to build it.
+  ///
+  /// @param[in]  frame_time         The target time of the frame.
+  virtual void OnBeginFrame(fml::TimePoint frame_time);
+
   //----------------------------------------------------------------------------
   /// @brief      Default destructor.
   virtual ~PointerDataDispatcher();
@@ -164,6 +177,166 @@ class SmoothPointerDataDispatcher : public DefaultPointerDataDispatcher {
   FML_DISALLOW_COPY_AND_ASSIGN(SmoothPointerDataDispatcher);
 };
 
+//------------------------------------------------------------------------------
+/// A dispatcher that buffers the pointer samples of each device and resamples
+/// the moves and hovers to the target time of every frame. This smoothes out
+/// drags on displays whose input rate does not match their refresh rate.
+///
+/// It works as follows:
+///
+/// Packets are buffered when they are received, and dispatched at the next
+/// `OnBeginFrame`. The samples older than the frame time are dispatched as
+/// they are, except for the most recent move or hover of each device. That one
+/// is interpolated to the frame time with the next buffered sample of the
+/// device when there is one, which is only the case when samples are delivered
+/// ahead of the frames. Otherwise it is extrapolated from the two most recent
+/// samples, by no more than `kMaxPrediction`. The samples that end up being
+/// older than a previously dispatched resampled sample are dropped, so the
+/// pointer never moves backwards. The deltas are recomputed from the
+/// positions dispatched to the framework.
+///
+/// Downs, ups and other changes are never resampled, and reset the resampling
+/// of their device.
+///
+/// If the vsync passes without a frame, for example because the framework has
+/// not requested one yet, the buffered samples are dispatched as they are.
+/// Packets that do not contain moves or hovers are dispatched right away if
+/// nothing is buffered.
+///
+/// The time stamps of the pointer data are expected to be in microseconds on
+/// the same clock as `fml::TimePoint`.
+class ResamplingPointerDataDispatcher : public DefaultPointerDataDispatcher {
+ public:
+  /// Samples closer than this are too noisy to extrapolate from.
+  static constexpr fml::TimeDelta kMinResampleDelta =
+      fml::TimeDelta::FromMilliseconds(2);
+
+  /// Samples further apart than this are too old to extrapolate from.
+  static constexpr fml::TimeDelta kMaxResampleDelta =
+      fml::TimeDelta::FromMilliseconds(20);
+
+  /// The furthest a sample is extrapolated past the last received one.
+  static constexpr fml::TimeDelta kMaxPrediction =
+      fml::TimeDelta::FromMilliseconds(8);
+
+  //----------------------------------------------------------------------------
+  /// @param[in]  delegate           The `Flutter::Engine`.
+  /// @param[in]  sampling_offset    How long before the frame time the samples
+  ///                                are resampled to. A larger offset trades
+  ///                                latency for more interpolation and less
+  ///                                extrapolation.
+  explicit ResamplingPointerDataDispatcher(
+      Delegate& delegate,
+      fml::TimeDelta sampling_offset = fml::TimeDelta::Zero());
+
+  // |PointerDataDispatcer|
+  void DispatchPacket(std::unique_ptr<PointerDataPacket> packet,
+                      uint64_t trace_flow_id) override;
+
+  // |PointerDataDispatcer|
+  void OnBeginFrame(fml::TimePoint frame_time) override;
+
+  virtual ~ResamplingPointerDataDispatcher();
+
+ private:
+  struct PendingSample {
+    PointerData data;
+    uint64_t trace_flow_id;
+  };
+
+  struct DeviceState {
+    // The two most recent samples dispatched, or about to be.
+    size_t sample_count = 0;
+    PointerData previous_sample;
+    PointerData last_sample;
+    // The position last dispatched to the framework.
+    bool has_position = false;
+    double physical_x = 0;
+    double physical_y = 0;
+    // The time stamp of the last resampled sample.
+    int64_t resampled_time_stamp = 0;
+  };
+
+  const fml::TimeDelta sampling_offset_;
+
+  std::deque<PendingSample> pending_samples_;
+
+  std::unordered_map<int64_t, DeviceState> devices_;
+
+  // Whether a frame began since the secondary vsync callback was scheduled.
+  bool frame_begun_ = false;
+
+  bool is_vsync_callback_scheduled_ = false;
+
+  fml::WeakPtrFactory<ResamplingPointerDataDispatcher> weak_factory_;
+
+  // Dispatches the samples up to |sample_time|, in microseconds. If
+  // |resample| is false, the samples are dispatched as they are.
+  void DispatchSamples(int64_t sample_time, bool resample);
+
+  // Returns the most recent move or hover of the |device| resampled to
+  // |sample_time|, given the next sample of the device, if any.
+  PointerData Resample(const DeviceState& device,
+                       int64_t sample_time,
+                       const PointerData* next_sample) const;
+
+  // Recomputes the delta of |data| from the last dispatched position and
+  // records its position.
+  void UpdatePosition(PointerData& data);
+
+  void ScheduleSecondaryVsyncCallback();
+
+  FML_DISALLOW_COPY_AND_ASSIGN(ResamplingPointerDataDispatcher);
+};
+
+//------------------------------------------------------------------------------
+/// A dispatcher that dispatches the pointer data at most once per VSYNC after
+/// the first packet, and merges the consecutive moves and hovers of each
+/// device. This keeps the cost of the pointer events on the UI thread flat
+/// when the input is sampled at a much higher rate than the display, such as
+/// for 1000Hz mice and pens.
+///
+/// Like `SmoothPointerDataDispatcher`, the first packet is dispatched right
+/// away, and the following ones are held until the next VSYNC while pointer
+/// data is in progress. The held samples are then dispatched as a single
+/// packet.
+///
+/// Consecutive moves or hovers of a device with the same buttons are merged
+/// into the most recent one, whose delta becomes the sum of their deltas. If
+/// the raw history is requested, nothing is merged and only the packets are
+/// batched, so every sample still reaches the framework.
+class CoalescingPointerDataDispatcher : public DefaultPointerDataDispatcher {
+ public:
+  //----------------------------------------------------------------------------
+  /// @param[in]  delegate           The `Flutter::Engine`.
+  /// @param[in]  keep_history       Whether to dispatch every sample instead
+  ///                                of merging the moves and hovers.
+  CoalescingPointerDataDispatcher(Delegate& delegate, bool keep_history);
+
+  // |PointerDataDispatcer|
+  void DispatchPacket(std::unique_ptr<PointerDataPacket> packet,
+                      uint64_t trace_flow_id) override;
+
+  virtual ~CoalescingPointerDataDispatcher();
+
+ private:
+  const bool keep_history_;
+
+  // The samples held until the next VSYNC, and the flows of their packets.
+  std::vector<PointerData> pending_samples_;
+  std::vector<uint64_t> pending_trace_flow_ids_;
+
+  bool is_pointer_data_in_progress_ = false;
+
+  fml::WeakPtrFactory<CoalescingPointerDataDispatcher> weak_factory_;
+
+  void DispatchPendingSamples();
+
+  void ScheduleSecondaryVsyncCallback();
+
+  FML_DISALLOW_COPY_AND_ASSIGN(CoalescingPointerDataDispatcher);
+};
+
 //--------------------------------------------------------------------------
 /// @brief      Signature for constructing PointerDataDispatcher.
 ///
@@ -0,0 +1,293 @@
+// Copyright 2013 The Flutter Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "flutter/shell/common/pointer_data_dispatcher.h"
+
+#include <map>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace flutter {
+namespace testing {
+
+namespace {
+
+class TestDispatcherDelegate : public PointerDataDispatcher::Delegate {
+ public:
+  // |PointerDataDispatcher::Delegate|
+  void DoDispatchPacket(std::unique_ptr<PointerDataPacket> packet,
+                        uint64_t trace_flow_id) override {
+    const size_t count = packet->data().size() / sizeof(PointerData);
+    std::vector<PointerData> samples(count);
+    memcpy(samples.data(), packet->data().data(), packet->data().size());
+    packets_.push_back(std::move(samples));
+  }
+
+  // |PointerDataDispatcher::Delegate|
+  void ScheduleSecondaryVsyncCallback(uintptr_t id,
+                                      const fml::closure& callback) override {
+    callbacks_[id] = callback;
+  }
+
+  void FireVsync() {
+    auto callbacks = std::move(callbacks_);
+    callbacks_.clear();
+    for (const auto& [id, callback] : callbacks) {
+      callback();
+    }
+  }
+
+  std::vector<std::vector<PointerData>>& packets() { return packets_; }
+
+ private:
+  std::vector<std::vector<PointerData>> packets_;
+  std::map<uintptr_t, fml::closure> callbacks_;
+};
+
+PointerData CreateSample(PointerData::Change change,
+                         int64_t time_stamp,
+                         double physical_x) {
+  PointerData data;
+  data.Clear();
+  data.change = change;
+  data.kind = PointerData::DeviceKind::kTouch;
+  data.time_stamp = time_stamp;
+  data.physical_x = physical_x;
+  return data;
+}
+
+PointerData CreateMove(int64_t device, double physical_x, double delta_x) {
+  PointerData data = CreateSample(PointerData::Change::kMove, 0, physical_x);
+  data.device = device;
+  data.physical_delta_x = delta_x;
+  return data;
+}
+
+std::unique_ptr<PointerDataPacket> CreatePacket(
+    const std::vector<PointerData>& samples) {
+  auto packet = std::make_unique<PointerDataPacket>(samples.size());
+  for (size_t i = 0; i < samples.size(); i++) {
+    packet->SetPointerData(i, samples[i]);
+  }
+  return packet;
+}
+
+fml::TimePoint FrameTime(int64_t micros) {
+  return fml::TimePoint::FromEpochDelta(
+      fml::TimeDelta::FromMicroseconds(micros));
+}
+
+}  // namespace
+
+TEST(ResamplingPointerDataDispatcherTest, ExtrapolatesToFrameTime) {
+  TestDispatcherDelegate delegate;
+  ResamplingPointerDataDispatcher dispatcher(delegate);
+
+  dispatcher.DispatchPacket(
+      CreatePacket({CreateSample(PointerData::Change::kDown, 1000, 0),
+                    CreateSample(PointerData::Change::kMove, 9000, 8)}),
+      0);
+  ASSERT_TRUE(delegate.packets().empty());
+
+  dispatcher.OnBeginFrame(FrameTime(13000));
+  ASSERT_EQ(delegate.packets().size(), 1u);
+  std::vector<PointerData> samples = delegate.packets()[0];
+  ASSERT_EQ(samples.size(), 2u);
+  EXPECT_EQ(samples[0].change, PointerData::Change::kDown);
+  EXPECT_EQ(samples[1].time_stamp, 13000);
+  EXPECT_DOUBLE_EQ(samples[1].physical_x, 12);
+  EXPECT_DOUBLE_EQ(samples[1].physical_delta_x, 12);
+
+  // The first sample is older than the extrapolated one, so it is dropped.
+  dispatcher.DispatchPacket(
+      CreatePacket({CreateSample(PointerData::Change::kMove, 12000, 11),
+                    CreateSample(PointerData::Change::kMove, 17000, 16)}),
+      0);
+  dispatcher.OnBeginFrame(FrameTime(21000));
+  ASSERT_EQ(delegate.packets().size(), 2u);
+  samples = delegate.packets()[1];
+  ASSERT_EQ(samples.size(), 1u);
+  EXPECT_EQ(samples[0].time_stamp, 21000);
+  EXPECT_DOUBLE_EQ(samples[0].physical_x, 20);
+  EXPECT_DOUBLE_EQ(samples[0].physical_delta_x, 8);
+}
+
+TEST(ResamplingPointerDataDispatcherTest, LimitsPrediction) {
+  TestDispatcherDelegate delegate;
+  ResamplingPointerDataDispatcher dispatcher(delegate);
+
+  dispatcher.DispatchPacket(
+      CreatePacket({CreateSample(PointerData::Change::kDown, 1000, 0),
+                    CreateSample(PointerData::Change::kMove, 5000, 4)}),
+      0);
+  dispatcher.OnBeginFrame(FrameTime(50000));
+  ASSERT_EQ(delegate.packets().size(), 1u);
+  const PointerData& sample = delegate.packets()[0][1];
+  EXPECT_EQ(sample.time_stamp,
+            5000 + ResamplingPointerDataDispatcher::kMaxPrediction
+                       .ToMicroseconds());
+  EXPECT_DOUBLE_EQ(sample.physical_x, 12);
+}
+
+TEST(ResamplingPointerDataDispatcherTest, InterpolatesSamplesAheadOfFrame) {
+  TestDispatcherDelegate delegate;
+  ResamplingPointerDataDispatcher dispatcher(delegate);
+
+  dispatcher.DispatchPacket(
+      CreatePacket({CreateSample(PointerData::Change::kDown, 1000, 0),
+                    CreateSample(PointerData::Change::kMove, 9000, 8),
+                    CreateSample(PointerData::Change::kMove, 15000, 14)}),
+      0);
+  dispatcher.OnBeginFrame(FrameTime(12000));
+  ASSERT_EQ(delegate.packets().size(), 1u);
+  std::vector<PointerData> samples = delegate.packets()[0];
+  ASSERT_EQ(samples.size(), 2u);
+  EXPECT_EQ(samples[1].time_stamp, 12000);
+  EXPECT_DOUBLE_EQ(samples[1].physical_x, 11);
+
+  dispatcher.OnBeginFrame(FrameTime(20000));
+  ASSERT_EQ(delegate.packets().size(), 2u);
+  samples = delegate.packets()[1];
+  ASSERT_EQ(samples.size(), 1u);
+  EXPECT_EQ(samples[0].time_stamp, 20000);
+  EXPECT_DOUBLE_EQ(samples[0].physical_x, 19);
+  EXPECT_DOUBLE_EQ(samples[0].physical_delta_x, 8);
+}
+
+TEST(ResamplingPointerDataDispatcherTest, DoesNotResampleUps) {
+  TestDispatcherDelegate delegate;
+  ResamplingPointerDataDispatcher dispatcher(delegate);
+
+  dispatcher.DispatchPacket(
+      CreatePacket({CreateSample(PointerData::Change::kDown, 1000, 0),
+                    CreateSample(PointerData::Change::kMove, 9000, 8),
+                    CreateSample(PointerData::Change::kUp, 10000, 9)}),
+      0);
+  dispatcher.OnBeginFrame(FrameTime(16000));
+  ASSERT_EQ(delegate.packets().size(), 1u);
+  const std::vector<PointerData>& samples = delegate.packets()[0];
+  ASSERT_EQ(samples.size(), 3u);
+  EXPECT_EQ(samples[1].time_stamp, 9000);
+  EXPECT_DOUBLE_EQ(samples[1].physical_x, 8);
+  EXPECT_EQ(samples[2].change, PointerData::Change::kUp);
+  EXPECT_DOUBLE_EQ(samples[2].physical_x, 9);
+}
+
+TEST(ResamplingPointerDataDispatcherTest, DispatchesAtVsyncWithoutFrame) {
+  TestDispatcherDelegate delegate;
+  ResamplingPointerDataDispatcher dispatcher(delegate);
+
+  dispatcher.DispatchPacket(
+      CreatePacket({CreateSample(PointerData::Change::kDown, 1000, 0),
+                    CreateSample(PointerData::Change::kMove, 9000, 8)}),
+      0);
+  delegate.FireVsync();
+  ASSERT_EQ(delegate.packets().size(), 1u);
+  const std::vector<PointerData>& samples = delegate.packets()[0];
+  ASSERT_EQ(samples.size(), 2u);
+  EXPECT_EQ(samples[1].time_stamp, 9000);
+  EXPECT_DOUBLE_EQ(samples[1].physical_x, 8);
+}
+
+TEST(ResamplingPointerDataDispatcherTest, KeepsSamplesAheadOfFrameUntilNext) {
+  TestDispatcherDelegate delegate;
+  ResamplingPointerDataDispatcher dispatcher(delegate);
+
+  dispatcher.DispatchPacket(
+      CreatePacket({CreateSample(PointerData::Change::kDown, 1000, 0),
+                    CreateSample(PointerData::Change::kMove, 9000, 8),
+                    CreateSample(PointerData::Change::kMove, 15000, 14)}),
+      0);
+  dispatcher.OnBeginFrame(FrameTime(12000));
+  delegate.FireVsync();
+  ASSERT_EQ(delegate.packets().size(), 1u);
+
+  // No frame for this vsync.
+  delegate.FireVsync();
+  ASSERT_EQ(delegate.packets().size(), 2u);
+  EXPECT_EQ(delegate.packets()[1][0].time_stamp, 15000);
+  EXPECT_DOUBLE_EQ(delegate.packets()[1][0].physical_delta_x, 3);
+}
+
+TEST(ResamplingPointerDataDispatcherTest, DispatchesOtherChangesRightAway) {
+  TestDispatcherDelegate delegate;
+  ResamplingPointerDataDispatcher dispatcher(delegate);
+
+  dispatcher.DispatchPacket(
+      CreatePacket({CreateSample(PointerData::Change::kDown, 1000, 0)}), 0);
+  ASSERT_EQ(delegate.packets().size(), 1u);
+}
+
+TEST(CoalescingPointerDataDispatcherTest, MergesMovesUntilVsync) {
+  TestDispatcherDelegate delegate;
+  CoalescingPointerDataDispatcher dispatcher(delegate, false);
+
+  dispatcher.DispatchPacket(
+      CreatePacket({CreateMove(0, 1, 1), CreateMove(0, 3, 2)}), 0);
+  ASSERT_EQ(delegate.packets().size(), 1u);
+  ASSERT_EQ(delegate.packets()[0].size(), 1u);
+  EXPECT_DOUBLE_EQ(delegate.packets()[0][0].physical_x, 3);
+  EXPECT_DOUBLE_EQ(delegate.packets()[0][0].physical_delta_x, 3);
+
+  for (int i = 1; i <= 8; i++) {
+    dispatcher.DispatchPacket(CreatePacket({CreateMove(0, 3 + i, 1)}), i);
+  }
+  ASSERT_EQ(delegate.packets().size(), 1u);
+
+  delegate.FireVsync();
+  ASSERT_EQ(delegate.packets().size(), 2u);
+  ASSERT_EQ(delegate.packets()[1].size(), 1u);
+  EXPECT_DOUBLE_EQ(delegate.packets()[1][0].physical_x, 11);
+  EXPECT_DOUBLE_EQ(delegate.packets()[1][0].physical_delta_x, 8);
+
+  // Nothing arrived during this frame, so the next packet is dispatched right
+  // away.
+  delegate.FireVsync();
+  dispatcher.DispatchPacket(CreatePacket({CreateMove(0, 12, 1)}), 9);
+  ASSERT_EQ(delegate.packets().size(), 3u);
+}
+
+TEST(CoalescingPointerDataDispatcherTest, DoesNotMergeOtherChanges) {
+  TestDispatcherDelegate delegate;
+  CoalescingPointerDataDispatcher dispatcher(delegate, false);
+
+  PointerData up = CreateSample(PointerData::Change::kUp, 0, 2);
+  PointerData pressed_move = CreateMove(0, 3, 1);
+  pressed_move.buttons = kPointerButtonMousePrimary;
+  dispatcher.DispatchPacket(
+      CreatePacket({CreateMove(0, 1, 1), CreateMove(1, 5, 5),
+                    CreateMove(0, 2, 1), up, CreateMove(0, 2, 0), pressed_move,
+                    CreateMove(1, 7, 2)}),
+      0);
+  ASSERT_EQ(delegate.packets().size(), 1u);
+  const std::vector<PointerData>& samples = delegate.packets()[0];
+  ASSERT_EQ(samples.size(), 5u);
+  EXPECT_EQ(samples[0].device, 0);
+  EXPECT_DOUBLE_EQ(samples[0].physical_delta_x, 2);
+  EXPECT_EQ(samples[1].change, PointerData::Change::kUp);
+  EXPECT_DOUBLE_EQ(samples[2].physical_x, 2);
+  EXPECT_DOUBLE_EQ(samples[3].physical_x, 3);
+  EXPECT_EQ(samples[4].device, 1);
+  EXPECT_DOUBLE_EQ(samples[4].physical_delta_x, 7);
+}
+
+TEST(CoalescingPointerDataDispatcherTest, KeepsHistoryOnRequest) {
+  TestDispatcherDelegate delegate;
+  CoalescingPointerDataDispatcher dispatcher(delegate, true);
+
+  dispatcher.DispatchPacket(CreatePacket({CreateMove(0, 1, 1)}), 0);
+  dispatcher.DispatchPacket(CreatePacket({CreateMove(0, 2, 1)}), 1);
+  dispatcher.DispatchPacket(CreatePacket({CreateMove(0, 3, 1)}), 2);
+  ASSERT_EQ(delegate.packets().size(), 1u);
+
+  delegate.FireVsync();
+  ASSERT_EQ(delegate.packets().size(), 2u);
+  ASSERT_EQ(delegate.packets()[1].size(), 2u);
+  EXPECT_DOUBLE_EQ(delegate.packets()[1][0].physical_x, 2);
+  EXPECT_DOUBLE_EQ(delegate.packets()[1][1].physical_x, 3);
+}
+
+}  // namespace testing
+}  // namespace flutter
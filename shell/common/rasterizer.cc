@@ -10,6 +10,8 @@
 
 #include "flow/frame_timings.h"
 #include "flutter/common/graphics/persistent_cache.h"
+#include "flutter/fml/message_loop.h"
+#include "flutter/fml/message_loop_task_queues.h"
 #include "flutter/fml/time/time_delta.h"
 #include "flutter/fml/time/time_point.h"
 #include "flutter/shell/common/serialization_callbacks.h"
@@ -28,6 +30,16 @@ namespace flutter {
 // used within this interval.
 static constexpr std::chrono::milliseconds kSkiaCleanupExpiration(15000);
 
+// The time the rasterizer spends rasterizing pending raster cache entries
+// before yielding the raster thread back to other tasks.
+static constexpr fml::TimeDelta kRasterCacheIdleBudget =
+    fml::TimeDelta::FromMilliseconds(2);
+
+// The time the rasterizer spends precompiling the SkSLs deferred by the
+// persistent cache before yielding the raster thread back to other tasks.
+static constexpr fml::TimeDelta kSkSLPrecompilationIdleBudget =
+    fml::TimeDelta::FromMilliseconds(2);
+
 Rasterizer::Rasterizer(Delegate& delegate)
     : delegate_(delegate),
       compositor_context_(std::make_unique<flutter::CompositorContext>(
@@ -90,6 +102,7 @@ void Rasterizer::Teardown() {
 
   surface_.reset();
   last_layer_tree_.reset();
+  last_layer_tree_diffed_ = false;
 
   if (raster_thread_merger_.get() != nullptr &&
       raster_thread_merger_.get()->IsMerged()) {
@@ -144,6 +157,8 @@ void Rasterizer::DrawLastLayerTree(
     return;
   }
   frame_timings_recorder->RecordRasterStart(fml::TimePoint::Now());
+  // The layer tree cannot be diffed against itself, so repaint it fully.
+  last_layer_tree_diffed_ = false;
   DrawToSurface(*frame_timings_recorder, *last_layer_tree_);
 }
 
@@ -161,6 +176,7 @@ void Rasterizer::Draw(
   FML_DCHECK(delegate_.GetTaskRunners()
                  .GetRasterTaskRunner()
                  ->RunsTasksOnCurrentThread());
+  is_pipeline_drained_ = false;
 
   std::unique_ptr<FrameTimingsRecorder> resubmit_recorder =
       frame_timings_recorder->CloneUntil(
@@ -215,10 +231,124 @@ void Rasterizer::Draw(
       break;
     }
     default:
+      // The pipeline is drained, so use the idle time until the next frame to
+      // rasterize the entries the raster cache deferred and to precompile the
+      // remaining SkSLs.
+      is_pipeline_drained_ = true;
+      last_vsync_target_time_ = resubmit_recorder->GetVsyncTargetTime();
+      OpenIdleWindow();
+      PostRasterizePendingCacheEntries();
+      PostPrecompilePendingSkSLs();
       break;
   }
 }
 
+void Rasterizer::PostRasterizePendingCacheEntries() {
+  if (raster_cache_task_posted_ ||
+      !compositor_context_->raster_cache().HasPendingRasterizations()) {
+    return;
+  }
+  raster_cache_task_posted_ = true;
+  delegate_.GetTaskRunners().GetRasterTaskRunner()->PostTaskWithGrade(
+      [weak_this = weak_factory_.GetWeakPtr()]() {
+        if (weak_this) {
+          weak_this->raster_cache_task_posted_ = false;
+          weak_this->RasterizePendingCacheEntries();
+        }
+      },
+      fml::TimePoint::Now(), fml::TaskSourceGrade::kIdle);
+}
+
+void Rasterizer::OpenIdleWindow() {
+  // Task runners that are not backed by an fml message loop run idle tasks
+  // like any other task.
+  if (!is_pipeline_drained_ ||
+      !fml::MessageLoop::IsInitializedForCurrentThread()) {
+    return;
+  }
+  // With a deep pipeline, or once frames stop coming, the target time of the
+  // last frame has often passed. The window then extends to the first vsync
+  // after now, assuming vsyncs keep coming at the frame budget.
+  const fml::TimePoint now = fml::TimePoint::Now();
+  fml::TimePoint deadline = last_vsync_target_time_;
+  if (deadline <= now) {
+    fml::Milliseconds frame_budget = delegate_.GetFrameBudget();
+    if (frame_budget.count() <= 0) {
+      frame_budget = fml::kDefaultFrameBudget;
+    }
+    const fml::TimeDelta frame_interval =
+        fml::TimeDelta::FromMillisecondsF(frame_budget.count());
+    const int64_t elapsed_frames = (now - deadline) / frame_interval;
+    deadline = deadline + frame_interval * (elapsed_frames + 1);
+  }
+  fml::MessageLoopTaskQueues::GetInstance()->SetIdleDeadline(
+      fml::MessageLoop::GetCurrentTaskQueueId(), deadline);
+}
+
+void Rasterizer::RasterizePendingCacheEntries() {
+  TRACE_EVENT0("flutter", "Rasterizer::RasterizePendingCacheEntries");
+  RasterCache& raster_cache = compositor_context_->raster_cache();
+  if (surface_ == nullptr) {
+    return;
+  }
+  bool did_rasterize = false;
+  delegate_.GetIsGpuDisabledSyncSwitch()->Execute(
+      fml::SyncSwitch::Handlers().SetIfFalse([&] {
+        auto context_switch = surface_->MakeRenderContextCurrent();
+        if (!context_switch->GetResult()) {
+          return;
+        }
+        raster_cache.RasterizePendingEntries(surface_->GetContext(),
+                                             kRasterCacheIdleBudget);
+        did_rasterize = true;
+      }));
+  // Yield between slices so that frames are not delayed by the cache. If the
+  // GPU is unavailable, the next frame will schedule the remaining work.
+  // Until a frame arrives, the window stays open for the next slices.
+  if (did_rasterize) {
+    OpenIdleWindow();
+    PostRasterizePendingCacheEntries();
+  }
+}
+
+void Rasterizer::PostPrecompilePendingSkSLs() {
+  if (sksl_precompilation_task_posted_ || surface_ == nullptr ||
+      !PersistentCache::GetCacheForProcess()->HasPendingSkSLPrecompilations(
+          surface_->GetContext())) {
+    return;
+  }
+  sksl_precompilation_task_posted_ = true;
+  delegate_.GetTaskRunners().GetRasterTaskRunner()->PostTaskWithGrade(
+      [weak_this = weak_factory_.GetWeakPtr()]() {
+        if (weak_this) {
+          weak_this->sksl_precompilation_task_posted_ = false;
+          weak_this->PrecompilePendingSkSLs();
+        }
+      },
+      fml::TimePoint::Now(), fml::TaskSourceGrade::kIdle);
+}
+
+void Rasterizer::PrecompilePendingSkSLs() {
+  if (surface_ == nullptr) {
+    return;
+  }
+  bool did_precompile = false;
+  delegate_.GetIsGpuDisabledSyncSwitch()->Execute(
+      fml::SyncSwitch::Handlers().SetIfFalse([&] {
+        auto context_switch = surface_->MakeRenderContextCurrent();
+        if (!context_switch->GetResult()) {
+          return;
+        }
+        PersistentCache::GetCacheForProcess()->PrecompilePendingSkSLs(
+            surface_->GetContext(), kSkSLPrecompilationIdleBudget);
+        did_precompile = true;
+      }));
+  if (did_precompile) {
+    OpenIdleWindow();
+    PostPrecompilePendingSkSLs();
+  }
+}
+
 namespace {
 sk_sp<SkImage> DrawSnapshot(
     sk_sp<SkSurface> surface,
@@ -368,6 +498,10 @@ RasterStatus Rasterizer::DoDraw(
       DrawToSurface(*frame_timings_recorder, *layer_tree);
   if (raster_status == RasterStatus::kSuccess) {
     last_layer_tree_ = std::move(layer_tree);
+    if (!has_rasterized_frame_) {
+      has_rasterized_frame_ = true;
+      persistent_cache->MarkFirstFrameRasterized();
+    }
   } else if (raster_status == RasterStatus::kResubmit ||
              raster_status == RasterStatus::kSkipAndRetry) {
     resubmitted_layer_tree_ = std::move(layer_tree);
@@ -384,6 +518,10 @@ RasterStatus Rasterizer::DoDraw(
   // TODO(liyuqian): in Fuchsia, the rasterization doesn't finish when
   // Rasterizer::DoDraw finishes. Future work is needed to adapt the timestamp
   // for Fuchsia to capture SceneUpdateContext::ExecutePaintTasks.
+  if (raster_thread_merger_) {
+    frame_timings_recorder->RecordThreadMergeLatency(
+        raster_thread_merger_->TakeTransitionLatency());
+  }
   delegate_.OnFrameRasterized(frame_timings_recorder->GetRecordedTime());
 
 // SceneDisplayLag events are disabled on Fuchsia.
@@ -481,6 +619,19 @@ RasterStatus Rasterizer::DrawToSurface(
   auto root_surface_canvas =
       embedder_root_canvas ? embedder_root_canvas : frame->SkiaCanvas();
 
+  // Partial repaint is left to surfaces that opt into it. It is not used
+  // with an external view embedder, which composites the root canvas itself.
+  std::unique_ptr<FrameDamage> frame_damage;
+  if (frame->framebuffer_info().supports_partial_repaint &&
+      !external_view_embedder_) {
+    frame_damage = std::make_unique<FrameDamage>();
+    const auto& existing_damage = frame->framebuffer_info().existing_damage;
+    if (existing_damage && last_layer_tree_diffed_) {
+      frame_damage->SetPreviousLayerTree(last_layer_tree_.get());
+      frame_damage->AddAdditionalDamage(*existing_damage);
+    }
+  }
+
   auto compositor_frame = compositor_context_->AcquireFrame(
       surface_->GetContext(),         // skia GrContext
       root_surface_canvas,            // root surface canvas
@@ -492,11 +643,16 @@ RasterStatus Rasterizer::DrawToSurface(
   );
 
   if (compositor_frame) {
-    RasterStatus raster_status = compositor_frame->Raster(layer_tree, false);
+    RasterStatus raster_status =
+        compositor_frame->Raster(layer_tree, false, frame_damage.get());
     if (raster_status == RasterStatus::kFailed ||
         raster_status == RasterStatus::kSkipAndRetry) {
       return raster_status;
     }
+    if (frame_damage) {
+      frame->set_submit_info({frame_damage->GetFrameDamage(),
+                              frame_damage->GetBufferDamage()});
+    }
     if (shared_engine_block_thread_merging_ && raster_thread_merger_ &&
         raster_thread_merger_->IsMerged()) {
       // TODO(73620): Remove when platform views are accounted for.
@@ -518,6 +674,12 @@ RasterStatus Rasterizer::DrawToSurface(
       frame->Submit();
     }
 
+    // The layer tree only becomes the last layer tree once it has been drawn
+    // successfully. Other statuses leave the last layer tree in place.
+    if (raster_status == RasterStatus::kSuccess) {
+      last_layer_tree_diffed_ = frame_damage != nullptr;
+    }
+
     frame_timings_recorder.RecordRasterEnd();
     FireNextFrameCallbackIfPresent();
 
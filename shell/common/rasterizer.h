@@ -437,6 +437,9 @@ class Rasterizer final : public SnapshotDelegate {
   std::unique_ptr<flutter::CompositorContext> compositor_context_;
   // This is the last successfully rasterized layer tree.
   std::unique_ptr<flutter::LayerTree> last_layer_tree_;
+  // Whether the paint regions of |last_layer_tree_| were recorded by diffing
+  // it, so that the next frame can be diffed against it.
+  bool last_layer_tree_diffed_ = false;
   // Set when we need attempt to rasterize the layer tree again. This layer_tree
   // has not successfully rasterized. This can happen due to the change in the
   // thread configuration. This will be inserted to the front of the pipeline.
@@ -448,6 +451,13 @@ class Rasterizer final : public SnapshotDelegate {
   fml::TaskRunnerAffineWeakPtrFactory<Rasterizer> weak_factory_;
   std::shared_ptr<ExternalViewEmbedder> external_view_embedder_;
   bool shared_engine_block_thread_merging_ = false;
+  bool raster_cache_task_posted_ = false;
+  bool sksl_precompilation_task_posted_ = false;
+  // Whether the last call to Draw left the pipeline empty, and the vsync
+  // target time of the frame it drew.
+  bool is_pipeline_drained_ = false;
+  fml::TimePoint last_vsync_target_time_;
+  bool has_rasterized_frame_ = false;
 
   // |SnapshotDelegate|
   sk_sp<SkImage> MakeRasterSnapshot(
@@ -480,6 +490,29 @@ class Rasterizer final : public SnapshotDelegate {
 
   void FireNextFrameCallbackIfPresent();
 
+  // Lets the tasks graded |fml::TaskSourceGrade::kIdle| run on the raster
+  // thread until the next vsync, when the next frame may arrive. Does nothing
+  // unless the pipeline was drained by the last call to Draw.
+  void OpenIdleWindow();
+
+  // Schedules RasterizePendingCacheEntries as an idle task on the raster task
+  // runner if the raster cache has deferred rasterizations and no such task is
+  // scheduled.
+  void PostRasterizePendingCacheEntries();
+
+  // Spends a slice of idle time on the rasterizations deferred by the raster
+  // cache, then reschedules itself while more remain.
+  void RasterizePendingCacheEntries();
+
+  // Schedules PrecompilePendingSkSLs as an idle task on the raster task runner
+  // if the persistent cache deferred the precompilation of SkSLs in the
+  // context of the surface and no such task is scheduled.
+  void PostPrecompilePendingSkSLs();
+
+  // Spends a slice of idle time precompiling the deferred SkSLs, then
+  // reschedules itself while more remain.
+  void PrecompilePendingSkSLs();
+
   static bool NoDiscard(const flutter::LayerTree& layer_tree) { return false; }
 
   FML_DISALLOW_COPY_AND_ASSIGN(Rasterizer);
@@ -9,14 +9,18 @@
 #include <memory>
 
 #include "flutter/flow/frame_timings.h"
+#include "flutter/fml/task_source.h"
 #include "flutter/fml/time/time_point.h"
 #include "flutter/shell/common/thread_host.h"
 #include "flutter/testing/testing.h"
+#include "third_party/skia/include/core/SkColorSpace.h"
+#include "third_party/skia/include/core/SkPictureRecorder.h"
 
 #include "gmock/gmock.h"
 
 using testing::_;
 using testing::ByMove;
+using testing::Invoke;
 using testing::Return;
 using testing::ReturnRef;
 
@@ -322,4 +326,103 @@ TEST(RasterizerTest, externalViewEmbedderDoesntEndFrameWhenNoSurfaceIsSet) {
   });
   latch.Wait();
 }
+
+static sk_sp<SkPicture> MakeExpensivePicture(int seed) {
+  SkPictureRecorder recorder;
+  SkCanvas* canvas = recorder.beginRecording(SkRect::MakeWH(512, 512));
+  SkPaint paint;
+  paint.setAntiAlias(true);
+  for (int i = 0; i < 200; i++) {
+    paint.setColor(SkColorSetARGB(128, seed, i, 255 - i));
+    canvas->drawCircle(256, 256, 250 - i, paint);
+  }
+  return recorder.finishRecordingAsPicture();
+}
+
+TEST(RasterizerTest, drainsDeferredRasterizationsWithoutFurtherFrames) {
+  std::string test_name =
+      ::testing::UnitTest::GetInstance()->current_test_info()->name();
+  ThreadHost thread_host("io.flutter.test." + test_name + ".",
+                         ThreadHost::Type::Platform | ThreadHost::Type::RASTER |
+                             ThreadHost::Type::IO | ThreadHost::Type::UI);
+  TaskRunners task_runners("test", thread_host.platform_thread->GetTaskRunner(),
+                           thread_host.raster_thread->GetTaskRunner(),
+                           thread_host.ui_thread->GetTaskRunner(),
+                           thread_host.io_thread->GetTaskRunner());
+  MockDelegate delegate;
+  ON_CALL(delegate, GetTaskRunners()).WillByDefault(ReturnRef(task_runners));
+  ON_CALL(delegate, GetFrameBudget())
+      .WillByDefault(Return(fml::Milliseconds(16)));
+  ON_CALL(delegate, GetIsGpuDisabledSyncSwitch())
+      .WillByDefault(Return(std::make_shared<fml::SyncSwitch>()));
+  auto rasterizer = std::make_unique<Rasterizer>(delegate);
+  auto surface = std::make_unique<MockSurface>();
+  ON_CALL(*surface, MakeRenderContextCurrent()).WillByDefault(Invoke([]() {
+    return std::make_unique<GLContextDefaultResult>(true);
+  }));
+  rasterizer->Setup(std::move(surface));
+
+  fml::AutoResetWaitableEvent latch;
+  thread_host.raster_thread->GetTaskRunner()->PostTask([&] {
+    RasterCache& raster_cache =
+        rasterizer->compositor_context()->raster_cache();
+    raster_cache.SetRasterizeAsynchronously(true);
+    std::vector<sk_sp<SkPicture>> pictures;
+    for (int i = 0; i < 10; i++) {
+      pictures.push_back(MakeExpensivePicture(i));
+    }
+    sk_sp<SkColorSpace> srgb = SkColorSpace::MakeSRGB();
+    // The pictures are deferred once they have been used for enough frames.
+    for (int frame = 0;
+         frame < 10 && !raster_cache.HasPendingRasterizations(); frame++) {
+      for (const sk_sp<SkPicture>& picture : pictures) {
+        raster_cache.Prepare(nullptr, picture.get(), SkMatrix::I(),
+                             srgb.get(), true, false);
+      }
+      raster_cache.SweepAfterFrame();
+    }
+    EXPECT_TRUE(raster_cache.HasPendingRasterizations());
+
+    // The last frame was due long ago, as when frames stopped coming.
+    auto recorder = std::make_unique<FrameTimingsRecorder>();
+    const auto now = fml::TimePoint::Now();
+    const auto vsync_target = now - fml::TimeDelta::FromSeconds(1);
+    recorder->RecordVsync(vsync_target - fml::TimeDelta::FromMilliseconds(16),
+                          vsync_target);
+    recorder->RecordBuildStart(now);
+    recorder->RecordBuildEnd(now);
+    auto pipeline = std::make_shared<Pipeline<LayerTree>>(/*depth=*/10);
+    auto no_discard = [](LayerTree&) { return false; };
+    rasterizer->Draw(std::move(recorder), pipeline, no_discard);
+    latch.Signal();
+  });
+  latch.Wait();
+
+  // Idle tasks posted outside of an idle window wait for
+  // |fml::TaskSource::kMaxIdleTaskDelay|, so the deferred rasterizations
+  // would take at least that long to start without an open window, and
+  // about that long per slice once the window closes.
+  const fml::TimePoint start = fml::TimePoint::Now();
+  bool drained = false;
+  while (!drained && fml::TimePoint::Now() - start <
+                         fml::TaskSource::kMaxIdleTaskDelay / 2) {
+    thread_host.raster_thread->GetTaskRunner()->PostTask([&] {
+      drained = !rasterizer->compositor_context()
+                     ->raster_cache()
+                     .HasPendingRasterizations();
+      latch.Signal();
+    });
+    latch.Wait();
+    if (!drained) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+  }
+  EXPECT_TRUE(drained);
+
+  thread_host.raster_thread->GetTaskRunner()->PostTask([&] {
+    rasterizer.reset();
+    latch.Signal();
+  });
+  latch.Wait();
+}
 }  // namespace flutter
@@ -11,13 +11,16 @@
 
 #include "flutter/assets/directory_asset_bundle.h"
 #include "flutter/common/graphics/persistent_cache.h"
+#include "flutter/fml/build_config.h"
 #include "flutter/fml/file.h"
 #include "flutter/fml/icu_util.h"
 #include "flutter/fml/log_settings.h"
 #include "flutter/fml/logging.h"
 #include "flutter/fml/make_copyable.h"
 #include "flutter/fml/message_loop.h"
+#include "flutter/fml/message_loop_task_queues.h"
 #include "flutter/fml/paths.h"
+#include "flutter/fml/trace_buffer.h"
 #include "flutter/fml/trace_event.h"
 #include "flutter/fml/unique_fd.h"
 #include "flutter/runtime/dart_vm.h"
@@ -32,6 +35,10 @@
 #include "third_party/skia/include/utils/SkBase64.h"
 #include "third_party/tonic/common/log.h"
 
+#if defined(OS_LINUX)
+#include "flutter/fml/platform/linux/message_loop_linux.h"
+#endif  // defined(OS_LINUX)
+
 namespace flutter {
 
 constexpr char kSkiaChannel[] = "flutter/skia";
@@ -100,6 +107,15 @@ void PerformInitializationTasks(Settings& settings) {
       fml::tracing::TraceSetAllowlist(settings.trace_allowlist);
     }
 
+    if (!settings.trace_to_file.empty()) {
+      fml::tracing::TraceBufferStart();
+      if (!fml::tracing::TraceBufferDumpOnCrash(settings.trace_to_file)) {
+        FML_LOG(ERROR) << "Could not install the handlers writing the trace "
+                          "buffer to "
+                       << settings.trace_to_file;
+      }
+    }
+
     if (!settings.skia_deterministic_rendering_on_cpu) {
       SkGraphics::Init();
     } else {
@@ -118,6 +134,13 @@ void PerformInitializationTasks(Settings& settings) {
   });
 
   PersistentCache::SetCacheSkSL(settings.cache_sksl);
+  PersistentCache::SetDeferSkSLPrecompilation(
+      settings.defer_sksl_precompilation);
+
+#if defined(OS_LINUX)
+  fml::MessageLoopLinux::SetTimerSlack(fml::TimeDelta::FromMicroseconds(
+      settings.message_loop_timer_slack_us));
+#endif  // defined(OS_LINUX)
 }
 
 }  // namespace
@@ -192,6 +215,20 @@ std::unique_ptr<Shell> Shell::CreateShellOnPlatformThread(
   ]() {
         TRACE_EVENT0("flutter", "ShellSetupGPUSubsystem");
         std::unique_ptr<Rasterizer> rasterizer(on_create_rasterizer(*shell));
+        rasterizer->compositor_context()->raster_cache().SetRetentionPolicy(
+            shell->GetSettings().raster_cache_max_unused_frames,
+            shell->GetSettings().raster_cache_max_bytes);
+        rasterizer->compositor_context()
+            ->raster_cache()
+            .SetRasterizeAsynchronously(
+                shell->GetSettings().raster_cache_async_rasterization);
+        rasterizer->compositor_context()->raster_cache().SetUseAtlas(
+            shell->GetSettings().raster_cache_use_atlas);
+        if (shell->GetSettings().concurrent_preroll) {
+          rasterizer->compositor_context()
+              ->set_concurrent_preroll_task_runner(
+                  shell->GetDartVM()->GetConcurrentWorkerTaskRunner());
+        }
         snapshot_delegate_promise.set_value(rasterizer->GetSnapshotDelegate());
         rasterizer_promise.set_value(std::move(rasterizer));
       });
@@ -248,6 +285,18 @@ std::unique_ptr<Shell> Shell::CreateShellOnPlatformThread(
   // Send dispatcher_maker to the engine constructor because shell won't have
   // platform_view set until Shell::Setup is called later.
   auto dispatcher_maker = platform_view->GetDispatcherMaker();
+  if (shell->GetSettings().enable_pointer_resampling) {
+    dispatcher_maker = [](PointerDataDispatcher::Delegate& delegate) {
+      return std::make_unique<ResamplingPointerDataDispatcher>(delegate);
+    };
+  } else if (shell->GetSettings().enable_pointer_coalescing) {
+    const bool keep_history = shell->GetSettings().keep_pointer_history;
+    dispatcher_maker =
+        [keep_history](PointerDataDispatcher::Delegate& delegate) {
+          return std::make_unique<CoalescingPointerDataDispatcher>(
+              delegate, keep_history);
+        };
+  }
 
   // Create the engine on the UI thread.
   std::promise<std::unique_ptr<Engine>> engine_promise;
@@ -271,6 +320,8 @@ std::unique_ptr<Shell> Shell::CreateShellOnPlatformThread(
         // from the platform.
         auto animator = std::make_unique<Animator>(*shell, task_runners,
                                                    std::move(vsync_waiter));
+        shell->pipeline_depth_controller_ =
+            animator->GetPipelineDepthController();
 
         engine_promise.set_value(
             on_create_engine(*shell,                          //
@@ -468,6 +519,15 @@ Shell::~Shell() {
         platform_latch.Signal();
       }));
   platform_latch.Wait();
+
+  // The trace buffer is also written when the process crashes, see
+  // |PerformInitializationTasks|. Shutting down is the other way a trace
+  // ends.
+  if (!settings_.trace_to_file.empty() &&
+      !fml::tracing::TraceBufferWriteChromeJSON(settings_.trace_to_file)) {
+    FML_LOG(ERROR) << "Could not write the trace buffer to "
+                   << settings_.trace_to_file;
+  }
 }
 
 std::unique_ptr<Shell> Shell::Spawn(
@@ -941,12 +1001,13 @@ void Shell::OnPlatformViewDispatchPlatformMessage(
   FML_DCHECK(is_setup_);
   FML_DCHECK(task_runners_.GetPlatformTaskRunner()->RunsTasksOnCurrentThread());
 
-  task_runners_.GetUITaskRunner()->PostTask(fml::MakeCopyable(
+  StartNewPointerDataPacketBatch();
+  task_runners_.GetUITaskRunner()->PostTask(
       [engine = engine_->GetWeakPtr(), message = std::move(message)]() mutable {
         if (engine) {
           engine->DispatchPlatformMessage(std::move(message));
         }
-      }));
+      });
 }
 
 // |PlatformView::Delegate|
@@ -956,14 +1017,48 @@ void Shell::OnPlatformViewDispatchPointerDataPacket(
   TRACE_FLOW_BEGIN("flutter", "PointerEvent", next_pointer_flow_id_);
   FML_DCHECK(is_setup_);
   FML_DCHECK(task_runners_.GetPlatformTaskRunner()->RunsTasksOnCurrentThread());
+  bool needs_task = false;
+  {
+    std::scoped_lock lock(pending_pointer_data_packets_->mutex);
+    needs_task = pending_pointer_data_packets_->packets.empty();
+    pending_pointer_data_packets_->packets.emplace_back(std::move(packet),
+                                                        next_pointer_flow_id_);
+  }
+  next_pointer_flow_id_++;
+  if (!needs_task) {
+    // The packet is dispatched by the task of the packets before it.
+    return;
+  }
+  // The packets are not graded as user interactions: the framework expects
+  // them in order with the platform messages, key events and semantics
+  // actions sent before and after them.
   task_runners_.GetUITaskRunner()->PostTask(
-      fml::MakeCopyable([engine = weak_engine_, packet = std::move(packet),
-                         flow_id = next_pointer_flow_id_]() mutable {
-        if (engine) {
-          engine->DispatchPointerDataPacket(std::move(packet), flow_id);
+      [engine = weak_engine_, pending = pending_pointer_data_packets_]() {
+        std::vector<std::pair<std::unique_ptr<PointerDataPacket>, uint64_t>>
+            packets;
+        {
+          std::scoped_lock lock(pending->mutex);
+          packets.swap(pending->packets);
         }
-      }));
-  next_pointer_flow_id_++;
+        for (auto& [packet, flow_id] : packets) {
+          if (engine) {
+            engine->DispatchPointerDataPacket(std::move(packet), flow_id);
+          }
+        }
+      });
+}
+
+void Shell::StartNewPointerDataPacketBatch() {
+  bool has_pending_packets = false;
+  {
+    std::scoped_lock lock(pending_pointer_data_packets_->mutex);
+    has_pending_packets = !pending_pointer_data_packets_->packets.empty();
+  }
+  // The posted task keeps dispatching the packets it was posted for.
+  if (has_pending_packets) {
+    pending_pointer_data_packets_ =
+        std::make_shared<PendingPointerDataPackets>();
+  }
 }
 
 // |PlatformView::Delegate|
@@ -974,13 +1069,14 @@ void Shell::OnPlatformViewDispatchKeyDataPacket(
   FML_DCHECK(is_setup_);
   FML_DCHECK(task_runners_.GetPlatformTaskRunner()->RunsTasksOnCurrentThread());
 
+  StartNewPointerDataPacketBatch();
   task_runners_.GetUITaskRunner()->PostTask(
-      fml::MakeCopyable([engine = weak_engine_, packet = std::move(packet),
-                         callback = std::move(callback)]() mutable {
+      [engine = weak_engine_, packet = std::move(packet),
+       callback = std::move(callback)]() mutable {
         if (engine) {
           engine->DispatchKeyDataPacket(std::move(packet), std::move(callback));
         }
-      }));
+      });
 }
 
 // |PlatformView::Delegate|
@@ -990,13 +1086,14 @@ void Shell::OnPlatformViewDispatchSemanticsAction(int32_t id,
   FML_DCHECK(is_setup_);
   FML_DCHECK(task_runners_.GetPlatformTaskRunner()->RunsTasksOnCurrentThread());
 
+  StartNewPointerDataPacketBatch();
   task_runners_.GetUITaskRunner()->PostTask(
-      fml::MakeCopyable([engine = engine_->GetWeakPtr(), id, action,
-                         args = std::move(args)]() mutable {
+      [engine = engine_->GetWeakPtr(), id, action,
+       args = std::move(args)]() mutable {
         if (engine) {
           engine->DispatchSemanticsAction(id, action, std::move(args));
         }
-      }));
+      });
 }
 
 // |PlatformView::Delegate|
@@ -1125,6 +1222,16 @@ void Shell::OnAnimatorNotifyIdle(int64_t deadline) {
     engine_->NotifyIdle(deadline);
     volatile_path_tracker_->OnFrame();
   }
+
+  // Let the idle tasks of the UI thread run until the deadline, which is in
+  // the timebase of the Dart timeline.
+  if (fml::MessageLoop::IsInitializedForCurrentThread()) {
+    const fml::TimePoint idle_deadline =
+        fml::TimePoint::Now() +
+        fml::TimeDelta::FromMicroseconds(deadline - Dart_TimelineGetMicros());
+    fml::MessageLoopTaskQueues::GetInstance()->SetIdleDeadline(
+        fml::MessageLoop::GetCurrentTaskQueueId(), idle_deadline);
+  }
 }
 
 // |Animator::Delegate|
@@ -1151,7 +1258,7 @@ void Shell::OnAnimatorDraw(
            tree.frame_size() != expected_frame_size_;
   };
 
-  task_runners_.GetRasterTaskRunner()->PostTask(fml::MakeCopyable(
+  task_runners_.GetRasterTaskRunner()->PostTask(
       [&waiting_for_first_frame = waiting_for_first_frame_,
        &waiting_for_first_frame_condition = waiting_for_first_frame_condition_,
        rasterizer = rasterizer_->GetWeakPtr(),
@@ -1170,7 +1277,7 @@ void Shell::OnAnimatorDraw(
             waiting_for_first_frame_condition.notify_all();
           }
         }
-      }));
+      });
 }
 
 // |Animator::Delegate|
@@ -1379,6 +1486,10 @@ void Shell::OnFrameRasterized(const FrameTiming& timing) {
     settings_.frame_rasterized_callback(timing);
   }
 
+  if (pipeline_depth_controller_) {
+    pipeline_depth_controller_->AddFrameTiming(timing);
+  }
+
   if (!needs_report_timings_) {
     return;
   }
@@ -1650,6 +1761,11 @@ double Shell::GetMainDisplayRefreshRate() {
   return display_manager_->GetMainDisplayRefreshRate();
 }
 
+PersistentCache::SkSLPrecompilationProgress
+Shell::GetSkSLPrecompilationProgress() const {
+  return PersistentCache::GetCacheForProcess()->GetSkSLPrecompilationProgress();
+}
+
 bool Shell::OnServiceProtocolGetSkSLs(
     const ServiceProtocol::Handler::ServiceProtocolMap& params,
     rapidjson::Document* response) {
@@ -1693,6 +1809,9 @@ bool Shell::OnServiceProtocolEstimateRasterCacheMemory(
   response->AddMember<uint64_t>("displayListBytes",
                                 raster_cache.EstimateDisplayListCacheByteSize(),
                                 response->GetAllocator());
+  response->AddMember<uint64_t>("atlasBytes",
+                                raster_cache.EstimateAtlasByteSize(),
+                                response->GetAllocator());
   return true;
 }
 
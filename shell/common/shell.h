@@ -11,6 +11,7 @@
 #include <unordered_map>
 
 #include "flutter/assets/directory_asset_bundle.h"
+#include "flutter/common/graphics/persistent_cache.h"
 #include "flutter/common/graphics/texture.h"
 #include "flutter/common/settings.h"
 #include "flutter/common/task_runners.h"
@@ -368,6 +369,15 @@ class Shell final : public PlatformView::Delegate,
   ///
   double GetMainDisplayRefreshRate();
 
+  //----------------------------------------------------------------------------
+  /// @brief      Reports how far the precompilation of the known SkSLs went
+  ///             in the rendering context. With deferred precompilation, the
+  ///             pending SkSLs are precompiled while the raster thread is
+  ///             idle.
+  ///
+  PersistentCache::SkSLPrecompilationProgress GetSkSLPrecompilationProgress()
+      const;
+
  private:
   using ServiceProtocolHandler =
       std::function<bool(const ServiceProtocol::Handler::ServiceProtocolMap&,
@@ -401,6 +411,18 @@ class Shell final : public PlatformView::Delegate,
   bool is_added_to_service_protocol_ = false;
   uint64_t next_pointer_flow_id_ = 0;
 
+  // The pointer data packets received on the platform thread that wait for
+  // the UI task dispatching them, with their flow ids. A burst of packets is
+  // dispatched by a single task, unless another event is sent to the UI
+  // thread in the middle of it. See StartNewPointerDataPacketBatch.
+  struct PendingPointerDataPackets {
+    std::mutex mutex;
+    std::vector<std::pair<std::unique_ptr<PointerDataPacket>, uint64_t>>
+        packets;
+  };
+  std::shared_ptr<PendingPointerDataPackets> pending_pointer_data_packets_ =
+      std::make_shared<PendingPointerDataPackets>();
+
   bool first_frame_rasterized_ = false;
   std::atomic<bool> waiting_for_first_frame_ = true;
   std::mutex waiting_for_first_frame_mutex_;
@@ -419,6 +441,11 @@ class Shell final : public PlatformView::Delegate,
   // here for easier conversions to Dart objects.
   std::vector<int64_t> unreported_timings_;
 
+  // Receives the timings of the rasterized frames to adapt the depth of the
+  // layer tree pipeline of the animator. Set on the UI thread before the
+  // shell is set up, and used from the raster thread afterwards.
+  std::shared_ptr<PipelineDepthController> pipeline_depth_controller_;
+
   /// Manages the displays. This class is thread safe, can be accessed from any
   /// of the threads.
   std::unique_ptr<DisplayManager> display_manager_;
@@ -469,6 +496,11 @@ class Shell final : public PlatformView::Delegate,
 
   void ReportTimings();
 
+  // Makes the pointer data packets received from now on wait for a new UI
+  // task, so that they are not dispatched ahead of the event about to be
+  // posted to the UI thread.
+  void StartNewPointerDataPacketBatch();
+
   // |PlatformView::Delegate|
   void OnPlatformViewCreated(std::unique_ptr<Surface> surface) override;
 
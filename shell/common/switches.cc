@@ -290,6 +290,15 @@ Settings SettingsFromCommandLine(const fml::CommandLine& command_line) {
   settings.enable_software_rendering =
       command_line.HasOption(FlagForSwitch(Switch::EnableSoftwareRendering));
 
+  settings.enable_pointer_resampling =
+      command_line.HasOption(FlagForSwitch(Switch::EnablePointerResampling));
+
+  settings.enable_pointer_coalescing =
+      command_line.HasOption(FlagForSwitch(Switch::EnablePointerCoalescing));
+
+  settings.keep_pointer_history =
+      command_line.HasOption(FlagForSwitch(Switch::KeepPointerHistory));
+
   settings.endless_trace_buffer =
       command_line.HasOption(FlagForSwitch(Switch::EndlessTraceBuffer));
 
@@ -317,6 +326,9 @@ Settings SettingsFromCommandLine(const fml::CommandLine& command_line) {
   settings.trace_systrace =
       command_line.HasOption(FlagForSwitch(Switch::TraceSystrace));
 
+  command_line.GetOptionValue(FlagForSwitch(Switch::TraceToFile),
+                              &settings.trace_to_file);
+
   settings.skia_deterministic_rendering_on_cpu =
       command_line.HasOption(FlagForSwitch(Switch::SkiaDeterministicRendering));
 
@@ -427,6 +439,9 @@ Settings SettingsFromCommandLine(const fml::CommandLine& command_line) {
   settings.cache_sksl =
       command_line.HasOption(FlagForSwitch(Switch::CacheSkSL));
 
+  settings.defer_sksl_precompilation =
+      command_line.HasOption(FlagForSwitch(Switch::DeferSkSLPrecompilation));
+
   settings.purge_persistent_cache =
       command_line.HasOption(FlagForSwitch(Switch::PurgePersistentCache));
 
@@ -436,6 +451,37 @@ Settings SettingsFromCommandLine(const fml::CommandLine& command_line) {
                                 &old_gen_heap_size);
     settings.old_gen_heap_size = std::stoi(old_gen_heap_size);
   }
+
+  if (command_line.HasOption(
+          FlagForSwitch(Switch::RasterCacheMaxUnusedFrames))) {
+    std::string max_unused_frames;
+    command_line.GetOptionValue(
+        FlagForSwitch(Switch::RasterCacheMaxUnusedFrames), &max_unused_frames);
+    settings.raster_cache_max_unused_frames = std::stoul(max_unused_frames);
+  }
+
+  if (command_line.HasOption(FlagForSwitch(Switch::RasterCacheMaxBytes))) {
+    std::string max_bytes;
+    command_line.GetOptionValue(FlagForSwitch(Switch::RasterCacheMaxBytes),
+                                &max_bytes);
+    settings.raster_cache_max_bytes = std::stoull(max_bytes);
+  }
+
+  settings.raster_cache_async_rasterization = command_line.HasOption(
+      FlagForSwitch(Switch::RasterCacheAsyncRasterization));
+
+  settings.raster_cache_use_atlas =
+      command_line.HasOption(FlagForSwitch(Switch::RasterCacheAtlas));
+
+  settings.concurrent_preroll =
+      command_line.HasOption(FlagForSwitch(Switch::ConcurrentPreroll));
+
+  if (command_line.HasOption(FlagForSwitch(Switch::MessageLoopTimerSlack))) {
+    std::string timer_slack;
+    command_line.GetOptionValue(FlagForSwitch(Switch::MessageLoopTimerSlack),
+                                &timer_slack);
+    settings.message_loop_timer_slack_us = std::stoll(timer_slack);
+  }
   return settings;
 }
 
@@ -101,6 +101,21 @@ DEF_SWITCH(EnableSoftwareRendering,
            "Enable rendering using the Skia software backend. This is useful "
            "when testing Flutter on emulators. By default, Flutter will "
            "attempt to either use OpenGL, Metal, or Vulkan.")
+DEF_SWITCH(EnablePointerResampling,
+           "enable-pointer-resampling",
+           "Resample the pointer moves to the time of each frame. This "
+           "smoothes out drags when the input rate of the device does not "
+           "match its refresh rate.")
+DEF_SWITCH(EnablePointerCoalescing,
+           "enable-pointer-coalescing",
+           "Dispatch the pointer events at most once per frame after the "
+           "first one, and merge the consecutive moves of each pointer. This "
+           "keeps the cost of high frequency input devices on the UI thread "
+           "flat.")
+DEF_SWITCH(KeepPointerHistory,
+           "keep-pointer-history",
+           "When coalescing the pointer events, dispatch every move instead "
+           "of merging them.")
 DEF_SWITCH(SkiaDeterministicRendering,
            "skia-deterministic-rendering",
            "Skips the call to SkGraphics::Init(), thus avoiding swapping out "
@@ -162,6 +177,12 @@ DEF_SWITCH(
     "Trace to the system tracer (instead of the timeline) on platforms where "
     "such a tracer is available. Currently only supported on Android and "
     "Fuchsia.")
+DEF_SWITCH(TraceToFile,
+           "trace-to-file",
+           "Record trace events to an in-memory ring buffer and write them as "
+           "Chrome JSON to the file at the specified path if the process "
+           "crashes. In release builds, this requires an engine built with "
+           "the trace buffer enabled.")
 DEF_SWITCH(UseTestFonts,
            "use-test-fonts",
            "Running tests that layout and measure text will not yield "
@@ -206,6 +227,37 @@ DEF_SWITCH(OldGenHeapSize,
 DEF_SWITCH(EnableSkParagraph,
            "enable-skparagraph",
            "Selects the SkParagraph implementation of the text layout engine.")
+DEF_SWITCH(RasterCacheMaxUnusedFrames,
+           "raster-cache-max-unused-frames",
+           "The number of consecutive frames that an entry in the raster cache "
+           "may go unused before it is evicted. Defaults to 1.")
+DEF_SWITCH(RasterCacheMaxBytes,
+           "raster-cache-max-bytes",
+           "The maximum number of bytes of rasterized images that the raster "
+           "cache retains. Defaults to 0, meaning no limit.")
+DEF_SWITCH(DeferSkSLPrecompilation,
+           "defer-sksl-precompilation",
+           "Only precompile the SkSLs used by the first frame of the previous "
+           "runs before the first frame. The other SkSLs are precompiled "
+           "while the raster thread is idle between frames.")
+DEF_SWITCH(RasterCacheAsyncRasterization,
+           "raster-cache-async-rasterization",
+           "Rasterize pictures into the raster cache while the raster thread "
+           "is idle between frames instead of within the frame that first "
+           "makes them eligible for caching.")
+DEF_SWITCH(RasterCacheAtlas,
+           "raster-cache-atlas",
+           "Pack small images in the raster cache into shared atlas pages "
+           "instead of giving each of them a surface of its own.")
+DEF_SWITCH(ConcurrentPreroll,
+           "concurrent-preroll",
+           "Preroll the children of layers with many children on the "
+           "concurrent worker threads instead of only on the raster thread.")
+DEF_SWITCH(MessageLoopTimerSlack,
+           "message-loop-timer-slack",
+           "The number of microseconds by which the message loops may delay "
+           "a delayed task so that it shares a timer wake up with an earlier "
+           "one. Only supported on Linux. Defaults to 0.")
 
 DEF_SWITCHES_END
 
@@ -137,7 +137,9 @@ void VsyncWaiter::FireCallback(fml::TimePoint frame_start_time,
       ui_task_queue_id = task_runners_.GetUITaskRunner()->GetTaskQueueId();
     }
 
-    task_runners_.GetUITaskRunner()->PostTaskForTime(
+    // The frame callback runs ahead of the other pending UI tasks so that
+    // they do not eat into the frame budget.
+    task_runners_.GetUITaskRunner()->PostTaskWithGrade(
         [ui_task_queue_id, callback, flow_identifier, frame_start_time,
          frame_target_time, pause_secondary_tasks]() {
           FML_TRACE_EVENT("flutter", kVsyncTraceName, "StartTime",
@@ -152,7 +154,7 @@ void VsyncWaiter::FireCallback(fml::TimePoint frame_start_time,
             ResumeDartMicroTasks(ui_task_queue_id);
           }
         },
-        frame_start_time);
+        frame_start_time, fml::TaskSourceGrade::kUserInteraction);
   }
 
   for (auto& secondary_callback : secondary_callbacks) {
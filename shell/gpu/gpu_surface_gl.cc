@@ -238,15 +238,18 @@ std::unique_ptr<SurfaceFrame> GPUSurfaceGL::AcquireFrame(const SkISize& size) {
   SurfaceFrame::SubmitCallback submit_callback =
       [weak = weak_factory_.GetWeakPtr()](const SurfaceFrame& surface_frame,
                                           SkCanvas* canvas) {
-        return weak ? weak->PresentSurface(canvas) : false;
+        return weak ? weak->PresentSurface(surface_frame, canvas) : false;
       };
 
-  return std::make_unique<SurfaceFrame>(
+  auto frame = std::make_unique<SurfaceFrame>(
       surface, delegate_->SurfaceSupportsReadback(), submit_callback,
       std::move(context_switch));
+  frame->set_framebuffer_info(delegate_->GLContextFramebufferInfo());
+  return frame;
 }
 
-bool GPUSurfaceGL::PresentSurface(SkCanvas* canvas) {
+bool GPUSurfaceGL::PresentSurface(const SurfaceFrame& frame,
+                                  SkCanvas* canvas) {
   if (delegate_ == nullptr || canvas == nullptr || context_ == nullptr) {
     return false;
   }
@@ -256,7 +259,12 @@ bool GPUSurfaceGL::PresentSurface(SkCanvas* canvas) {
     onscreen_surface_->getCanvas()->flush();
   }
 
-  if (!delegate_->GLContextPresent(fbo_id_)) {
+  GLPresentInfo present_info = {
+      fbo_id_,                            // fbo_id
+      frame.submit_info().frame_damage,   // frame_damage
+      frame.submit_info().buffer_damage,  // buffer_damage
+  };
+  if (!delegate_->GLContextPresentWithInfo(present_info)) {
     return false;
   }
 
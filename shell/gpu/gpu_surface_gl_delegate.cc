@@ -12,10 +12,20 @@ namespace flutter {
 
 GPUSurfaceGLDelegate::~GPUSurfaceGLDelegate() = default;
 
+bool GPUSurfaceGLDelegate::GLContextPresentWithInfo(
+    const GLPresentInfo& present_info) {
+  return GLContextPresent(present_info.fbo_id);
+}
+
 bool GPUSurfaceGLDelegate::GLContextFBOResetAfterPresent() const {
   return false;
 }
 
+SurfaceFrame::FramebufferInfo GPUSurfaceGLDelegate::GLContextFramebufferInfo()
+    const {
+  return SurfaceFrame::FramebufferInfo();
+}
+
 bool GPUSurfaceGLDelegate::SurfaceSupportsReadback() const {
   return true;
 }
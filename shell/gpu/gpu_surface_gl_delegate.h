@@ -5,8 +5,11 @@
 #ifndef FLUTTER_SHELL_GPU_GPU_SURFACE_GL_DELEGATE_H_
 #define FLUTTER_SHELL_GPU_GPU_SURFACE_GL_DELEGATE_H_
 
+#include <optional>
+
 #include "flutter/common/graphics/gl_context_switch.h"
 #include "flutter/flow/embedded_views.h"
+#include "flutter/flow/surface_frame.h"
 #include "flutter/fml/macros.h"
 #include "third_party/skia/include/core/SkMatrix.h"
 #include "third_party/skia/include/gpu/gl/GrGLInterface.h"
@@ -20,6 +23,20 @@ struct GLFrameInfo {
   uint32_t height;
 };
 
+// A structure to represent the information passed to the embedder when a
+// frame is presented.
+struct GLPresentInfo {
+  uint32_t fbo_id;
+
+  // The area of the frame that changed since the previous frame, in pixels.
+  // Not set if the whole frame changed.
+  std::optional<SkIRect> frame_damage;
+
+  // The area of the framebuffer that was painted, in pixels. Not set if the
+  // whole framebuffer was painted.
+  std::optional<SkIRect> buffer_damage;
+};
+
 class GPUSurfaceGLDelegate {
  public:
   ~GPUSurfaceGLDelegate();
@@ -35,6 +52,11 @@ class GPUSurfaceGLDelegate {
   // context and not any of the contexts dedicated for IO.
   virtual bool GLContextPresent(uint32_t fbo_id) = 0;
 
+  // Called instead of GLContextPresent to present the main GL surface with
+  // the damage of the frame, for delegates that support partial repaint (see
+  // GLContextFramebufferInfo). The default implementation ignores the damage.
+  virtual bool GLContextPresentWithInfo(const GLPresentInfo& present_info);
+
   // The ID of the main window bound framebuffer. Typically FBO0.
   virtual intptr_t GLContextFBO(GLFrameInfo frame_info) const = 0;
 
@@ -45,6 +67,12 @@ class GPUSurfaceGLDelegate {
   // rendering subsequent frames.
   virtual bool GLContextFBOResetAfterPresent() const;
 
+  // Describes the framebuffer that the next frame will be rendered into. A
+  // delegate that knows which parts of the framebuffer are out of date, for
+  // example from EGL_EXT_buffer_age, can report them here so that only the
+  // damaged area is repainted. By default partial repaint is not supported.
+  virtual SurfaceFrame::FramebufferInfo GLContextFramebufferInfo() const;
+
   // Indicates whether or not the surface supports pixel readback as used in
   // circumstances such as a BackdropFilter.
   virtual bool SurfaceSupportsReadback() const;
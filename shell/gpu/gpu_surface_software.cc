@@ -66,10 +66,32 @@ std::unique_ptr<SurfaceFrame> GPUSurfaceSoftware::AcquireFrame(
 
     canvas->flush();
 
-    return self->delegate_->PresentBackingStore(surface_frame.SkiaSurface());
+    sk_sp<SkSurface> backing_store = surface_frame.SkiaSurface();
+    const auto& frame_damage = surface_frame.submit_info().frame_damage;
+    bool presented =
+        frame_damage && backing_store == self->last_presented_backing_store_
+            ? self->delegate_->PresentBackingStoreRegion(backing_store,
+                                                         *frame_damage)
+            : self->delegate_->PresentBackingStore(backing_store);
+    self->last_presented_backing_store_ =
+        presented ? std::move(backing_store) : nullptr;
+    return presented;
   };
 
-  return std::make_unique<SurfaceFrame>(backing_store, true, on_submit);
+  auto frame = std::make_unique<SurfaceFrame>(backing_store, true, on_submit);
+
+  // When the delegate keeps the contents of the backing store between frames,
+  // only the area that changed needs to be repainted when it is reused.
+  SurfaceFrame::FramebufferInfo framebuffer_info;
+  framebuffer_info.supports_partial_repaint =
+      delegate_->SupportsPartialRepaint();
+  if (framebuffer_info.supports_partial_repaint &&
+      backing_store == last_presented_backing_store_) {
+    framebuffer_info.existing_damage = SkIRect::MakeEmpty();
+  }
+  frame->set_framebuffer_info(framebuffer_info);
+
+  return frame;
 }
 
 // |Surface|
@@ -38,6 +38,10 @@ class GPUSurfaceSoftware : public Surface {
   // hack to make avoid allocating resources for the root surface when an
   // external view embedder is present.
   const bool render_to_surface_;
+  // The backing store that was presented last. Its contents are those of the
+  // previous frame, so rendering into it again only needs to repaint the area
+  // that changed.
+  sk_sp<SkSurface> last_presented_backing_store_;
   fml::TaskRunnerAffineWeakPtrFactory<GPUSurfaceSoftware> weak_factory_;
 
   FML_DISALLOW_COPY_AND_ASSIGN(GPUSurfaceSoftware);
@@ -48,6 +48,34 @@ class GPUSurfaceSoftwareDelegate {
   ///             the screen.
   ///
   virtual bool PresentBackingStore(sk_sp<SkSurface> backing_store) = 0;
+
+  //----------------------------------------------------------------------------
+  /// @brief      Called instead of `PresentBackingStore` when only part of the
+  ///             backing store changed since it was last presented.
+  ///
+  /// @param[in]  backing_store  The software backing store to present. It is
+  ///                            the same surface that was presented last.
+  /// @param[in]  damage         The area of the backing store that changed, in
+  ///                            pixels.
+  ///
+  /// @return     Returns if the platform could present the backing store onto
+  ///             the screen. The default implementation presents the whole
+  ///             backing store.
+  ///
+  virtual bool PresentBackingStoreRegion(sk_sp<SkSurface> backing_store,
+                                         const SkIRect& damage) {
+    return PresentBackingStore(std::move(backing_store));
+  }
+
+  //----------------------------------------------------------------------------
+  /// @brief      Whether the backing store keeps its contents once presented,
+  ///             so that the next frame rendered into it only needs to repaint
+  ///             the area that changed.
+  ///
+  /// @return     Returns false by default, in which case every frame is
+  ///             repainted in full.
+  ///
+  virtual bool SupportsPartialRepaint() const { return false; }
 };
 
 }  // namespace flutter
@@ -163,6 +163,15 @@ static bool IsRendererValid(const FlutterRendererConfig* config) {
   return false;
 }
 
+static FlutterRect SkIRectToFlutterRect(const SkIRect& rect) {
+  return {
+      static_cast<double>(rect.left()),    // left
+      static_cast<double>(rect.top()),     // top
+      static_cast<double>(rect.right()),   // right
+      static_cast<double>(rect.bottom()),  // bottom
+  };
+}
+
 #if OS_LINUX || OS_WIN
 static void* DefaultGLProcResolver(const char* name) {
   static fml::RefPtr<fml::NativeLibrary> proc_library =
@@ -195,15 +204,23 @@ InferOpenGLPlatformViewCreationCallback(
   auto gl_clear_current = [ptr = config->open_gl.clear_current,
                            user_data]() -> bool { return ptr(user_data); };
 
-  auto gl_present = [present = config->open_gl.present,
-                     present_with_info = config->open_gl.present_with_info,
-                     user_data](uint32_t fbo_id) -> bool {
+  auto gl_present =
+      [present = config->open_gl.present,
+       present_with_info = config->open_gl.present_with_info,
+       user_data](const flutter::GLPresentInfo& gl_present_info) -> bool {
     if (present) {
       return present(user_data);
     } else {
       FlutterPresentInfo present_info = {};
       present_info.struct_size = sizeof(FlutterPresentInfo);
-      present_info.fbo_id = fbo_id;
+      present_info.fbo_id = gl_present_info.fbo_id;
+      if (gl_present_info.frame_damage && gl_present_info.buffer_damage) {
+        present_info.has_damage = true;
+        present_info.frame_damage =
+            SkIRectToFlutterRect(*gl_present_info.frame_damage);
+        present_info.buffer_damage =
+            SkIRectToFlutterRect(*gl_present_info.buffer_damage);
+      }
       return present_with_info(user_data, &present_info);
     }
   };
@@ -269,6 +286,12 @@ InferOpenGLPlatformViewCreationCallback(
 #endif
   }
 
+  std::function<uint32_t(void)> gl_framebuffer_age_callback = nullptr;
+  if (SAFE_ACCESS(open_gl_config, framebuffer_age, nullptr) != nullptr) {
+    gl_framebuffer_age_callback = [ptr = config->open_gl.framebuffer_age,
+                                   user_data]() { return ptr(user_data); };
+  }
+
   bool fbo_reset_after_present =
       SAFE_ACCESS(open_gl_config, fbo_reset_after_present, false);
 
@@ -280,6 +303,7 @@ InferOpenGLPlatformViewCreationCallback(
       gl_make_resource_current_callback,   // gl_make_resource_current_callback
       gl_surface_transformation_callback,  // gl_surface_transformation_callback
       gl_proc_resolver,                    // gl_proc_resolver
+      gl_framebuffer_age_callback,         // gl_framebuffer_age_callback
   };
 
   return fml::MakeCopyable(
@@ -386,9 +410,22 @@ InferSoftwarePlatformViewCreationCallback(
     return ptr(user_data, allocation, row_bytes, height);
   };
 
+  std::function<bool(const void*, size_t, size_t, const SkIRect&)>
+      software_present_backing_store_region;
+  if (auto region_ptr = SAFE_ACCESS(&config->software,
+                                    surface_present_region_callback, nullptr)) {
+    software_present_backing_store_region =
+        [region_ptr, user_data](const void* allocation, size_t row_bytes,
+                                size_t height, const SkIRect& damage) -> bool {
+      FlutterRect rect = SkIRectToFlutterRect(damage);
+      return region_ptr(user_data, allocation, row_bytes, height, &rect);
+    };
+  }
+
   flutter::EmbedderSurfaceSoftware::SoftwareDispatchTable
       software_dispatch_table = {
-          software_present_backing_store,  // required
+          software_present_backing_store,         // required
+          software_present_backing_store_region,  // optional
       };
 
   return fml::MakeCopyable(
@@ -375,6 +375,17 @@ typedef struct {
   size_t struct_size;
   /// Id of the fbo backing the surface that was presented.
   uint32_t fbo_id;
+  /// Whether `frame_damage` and `buffer_damage` are set. They are only set
+  /// when the embedder specifies the `framebuffer_age` callback and the engine
+  /// repainted part of the frame.
+  bool has_damage;
+  /// The area of the frame that changed since the previous frame, in physical
+  /// pixels. This is the area the embedder needs to present, for example with
+  /// eglSwapBuffersWithDamageKHR.
+  FlutterRect frame_damage;
+  /// The area of the framebuffer that the engine painted into, in physical
+  /// pixels.
+  FlutterRect buffer_damage;
 } FlutterPresentInfo;
 
 /// Callback for when a surface is presented.
@@ -440,6 +451,14 @@ typedef struct {
   /// `FlutterPresentInfo` struct that the embedder can use to release any
   /// resources. The return value indicates success of the present call.
   BoolPresentInfoCallback present_with_info;
+  /// Optional callback that returns the age of the contents of the framebuffer
+  /// that the next frame will be rendered into, as defined by
+  /// EGL_EXT_buffer_age: 0 if the contents are undefined, 1 if it holds the
+  /// previous frame, 2 if it holds the frame before that, and so on. When
+  /// specified, the engine only repaints the part of the framebuffer that is
+  /// out of date, and reports the damage of each frame in
+  /// `FlutterPresentInfo` if `present_with_info` is used.
+  UIntCallback framebuffer_age;
 } FlutterOpenGLRendererConfig;
 
 /// Alias for id<MTLDevice>.
@@ -540,6 +559,13 @@ typedef struct {
   FlutterMetalTextureFrameCallback external_texture_frame_callback;
 } FlutterMetalRendererConfig;
 
+typedef bool (*SoftwareSurfacePresentRegionCallback)(
+    void* /* user data */,
+    const void* /* allocation */,
+    size_t /* row bytes */,
+    size_t /* height */,
+    const FlutterRect* /* damage */);
+
 typedef struct {
   /// The size of this struct. Must be sizeof(FlutterSoftwareRendererConfig).
   size_t struct_size;
@@ -548,6 +574,14 @@ typedef struct {
   /// format. The buffer is owned by the Flutter engine and must be copied in
   /// this callback if needed.
   SoftwareSurfacePresentCallback surface_present_callback;
+  /// Optional callback used instead of `surface_present_callback` when only
+  /// part of the buffer changed since it was last presented. The buffer is the
+  /// same as the one passed to `surface_present_callback` and is fully
+  /// populated, but only the pixels within the damage rectangle (in physical
+  /// pixels) differ from the previously presented buffer and need to be
+  /// copied. If not specified, the engine repaints and presents the whole
+  /// buffer every frame.
+  SoftwareSurfacePresentRegionCallback surface_present_region_callback;
 } FlutterSoftwareRendererConfig;
 
 typedef struct {
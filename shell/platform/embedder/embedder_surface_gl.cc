@@ -8,6 +8,10 @@
 
 namespace flutter {
 
+// The number of presented frames whose damage is remembered. Framebuffers
+// older than this are repainted in full.
+static constexpr size_t kMaxDamageHistory = 4;
+
 EmbedderSurfaceGL::EmbedderSurfaceGL(
     GLDispatchTable gl_dispatch_table,
     bool fbo_reset_after_present,
@@ -46,7 +50,17 @@ bool EmbedderSurfaceGL::GLContextClearCurrent() {
 
 // |GPUSurfaceGLDelegate|
 bool EmbedderSurfaceGL::GLContextPresent(uint32_t fbo_id) {
-  return gl_dispatch_table_.gl_present_callback(fbo_id);
+  return GLContextPresentWithInfo({fbo_id, std::nullopt, std::nullopt});
+}
+
+// |GPUSurfaceGLDelegate|
+bool EmbedderSurfaceGL::GLContextPresentWithInfo(
+    const GLPresentInfo& present_info) {
+  damage_history_.push_front(present_info.frame_damage);
+  if (damage_history_.size() > kMaxDamageHistory) {
+    damage_history_.pop_back();
+  }
+  return gl_dispatch_table_.gl_present_callback(present_info);
 }
 
 // |GPUSurfaceGLDelegate|
@@ -59,6 +73,32 @@ bool EmbedderSurfaceGL::GLContextFBOResetAfterPresent() const {
   return fbo_reset_after_present_;
 }
 
+// |GPUSurfaceGLDelegate|
+SurfaceFrame::FramebufferInfo EmbedderSurfaceGL::GLContextFramebufferInfo()
+    const {
+  SurfaceFrame::FramebufferInfo info;
+  if (!gl_dispatch_table_.gl_framebuffer_age_callback) {
+    return info;
+  }
+  info.supports_partial_repaint = true;
+
+  // A framebuffer of age N holds the frame presented N frames ago, so it
+  // misses the damage of the N - 1 frames presented since.
+  const uint32_t age = gl_dispatch_table_.gl_framebuffer_age_callback();
+  if (age == 0 || age - 1 > damage_history_.size()) {
+    return info;
+  }
+  SkIRect existing_damage = SkIRect::MakeEmpty();
+  for (size_t i = 0; i < age - 1; i++) {
+    if (!damage_history_[i]) {
+      return info;
+    }
+    existing_damage.join(*damage_history_[i]);
+  }
+  info.existing_damage = existing_damage;
+  return info;
+}
+
 // |GPUSurfaceGLDelegate|
 SkMatrix EmbedderSurfaceGL::GLContextSurfaceTransformation() const {
   auto callback = gl_dispatch_table_.gl_surface_transformation_callback;
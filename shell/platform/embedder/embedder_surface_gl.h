@@ -5,6 +5,9 @@
 #ifndef FLUTTER_SHELL_PLATFORM_EMBEDDER_EMBEDDER_SURFACE_GL_H_
 #define FLUTTER_SHELL_PLATFORM_EMBEDDER_EMBEDDER_SURFACE_GL_H_
 
+#include <deque>
+#include <optional>
+
 #include "flutter/fml/macros.h"
 #include "flutter/shell/gpu/gpu_surface_gl.h"
 #include "flutter/shell/platform/embedder/embedder_external_view_embedder.h"
@@ -18,12 +21,13 @@ class EmbedderSurfaceGL final : public EmbedderSurface,
   struct GLDispatchTable {
     std::function<bool(void)> gl_make_current_callback;           // required
     std::function<bool(void)> gl_clear_current_callback;          // required
-    std::function<bool(uint32_t)> gl_present_callback;            // required
+    std::function<bool(GLPresentInfo)> gl_present_callback;       // required
     std::function<intptr_t(GLFrameInfo)> gl_fbo_callback;         // required
     std::function<bool(void)> gl_make_resource_current_callback;  // optional
     std::function<SkMatrix(void)>
-        gl_surface_transformation_callback;              // optional
-    std::function<void*(const char*)> gl_proc_resolver;  // optional
+        gl_surface_transformation_callback;                     // optional
+    std::function<void*(const char*)> gl_proc_resolver;         // optional
+    std::function<uint32_t(void)> gl_framebuffer_age_callback;  // optional
   };
 
   EmbedderSurfaceGL(
@@ -37,6 +41,9 @@ class EmbedderSurfaceGL final : public EmbedderSurface,
   bool valid_ = false;
   GLDispatchTable gl_dispatch_table_;
   bool fbo_reset_after_present_;
+  // The frame damage of the most recently presented frames, newest first. An
+  // unset entry stands for a frame that was presented in full.
+  std::deque<std::optional<SkIRect>> damage_history_;
 
   std::shared_ptr<EmbedderExternalViewEmbedder> external_view_embedder_;
 
@@ -58,12 +65,18 @@ class EmbedderSurfaceGL final : public EmbedderSurface,
   // |GPUSurfaceGLDelegate|
   bool GLContextPresent(uint32_t fbo_id) override;
 
+  // |GPUSurfaceGLDelegate|
+  bool GLContextPresentWithInfo(const GLPresentInfo& present_info) override;
+
   // |GPUSurfaceGLDelegate|
   intptr_t GLContextFBO(GLFrameInfo frame_info) const override;
 
   // |GPUSurfaceGLDelegate|
   bool GLContextFBOResetAfterPresent() const override;
 
+  // |GPUSurfaceGLDelegate|
+  SurfaceFrame::FramebufferInfo GLContextFramebufferInfo() const override;
+
   // |GPUSurfaceGLDelegate|
   SkMatrix GLContextSurfaceTransformation() const override;
 
@@ -106,4 +106,37 @@ bool EmbedderSurfaceSoftware::PresentBackingStore(
   );
 }
 
+bool EmbedderSurfaceSoftware::PresentBackingStoreRegion(
+    sk_sp<SkSurface> backing_store,
+    const SkIRect& damage) {
+  if (!software_dispatch_table_.software_present_backing_store_region) {
+    return PresentBackingStore(std::move(backing_store));
+  }
+
+  if (!IsValid()) {
+    FML_LOG(ERROR) << "Tried to present an invalid software surface.";
+    return false;
+  }
+
+  SkPixmap pixmap;
+  if (!backing_store->peekPixels(&pixmap)) {
+    FML_LOG(ERROR) << "Could not peek the pixels of the backing store.";
+    return false;
+  }
+
+  return software_dispatch_table_.software_present_backing_store_region(
+      pixmap.addr(),      //
+      pixmap.rowBytes(),  //
+      pixmap.height(),    //
+      damage              //
+  );
+}
+
+// The embedder is only known to keep the presented pixels when it asks for
+// the damaged region.
+bool EmbedderSurfaceSoftware::SupportsPartialRepaint() const {
+  return static_cast<bool>(
+      software_dispatch_table_.software_present_backing_store_region);
+}
+
 }  // namespace flutter
@@ -18,6 +18,11 @@ class EmbedderSurfaceSoftware final : public EmbedderSurface,
   struct SoftwareDispatchTable {
     std::function<bool(const void* allocation, size_t row_bytes, size_t height)>
         software_present_backing_store;  // required
+    std::function<bool(const void* allocation,
+                       size_t row_bytes,
+                       size_t height,
+                       const SkIRect& damage)>
+        software_present_backing_store_region;  // optional
   };
 
   EmbedderSurfaceSoftware(
@@ -47,6 +52,13 @@ class EmbedderSurfaceSoftware final : public EmbedderSurface,
   // |GPUSurfaceSoftwareDelegate|
   bool PresentBackingStore(sk_sp<SkSurface> backing_store) override;
 
+  // |GPUSurfaceSoftwareDelegate|
+  bool PresentBackingStoreRegion(sk_sp<SkSurface> backing_store,
+                                 const SkIRect& damage) override;
+
+  // |GPUSurfaceSoftwareDelegate|
+  bool SupportsPartialRepaint() const override;
+
   FML_DISALLOW_COPY_AND_ASSIGN(EmbedderSurfaceSoftware);
 };
 
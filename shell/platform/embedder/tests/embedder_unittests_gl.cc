@@ -22,6 +22,7 @@
 #include "flutter/fml/thread.h"
 #include "flutter/lib/ui/painting/image.h"
 #include "flutter/runtime/dart_vm.h"
+#include "flutter/shell/platform/embedder/embedder_surface_gl.h"
 #include "flutter/shell/platform/embedder/tests/embedder_assertions.h"
 #include "flutter/shell/platform/embedder/tests/embedder_config_builder.h"
 #include "flutter/shell/platform/embedder/tests/embedder_test.h"
@@ -3617,5 +3618,105 @@ TEST_F(EmbedderTest, CreateInvalidBackingstoreOpenGLFramebuffer) {
   latch.Wait();
 }
 
+static std::unique_ptr<EmbedderSurfaceGL> CreateSurfaceWithFramebufferAge(
+    const uint32_t* age) {
+  EmbedderSurfaceGL::GLDispatchTable dispatch_table = {};
+  dispatch_table.gl_make_current_callback = []() { return true; };
+  dispatch_table.gl_clear_current_callback = []() { return true; };
+  dispatch_table.gl_present_callback = [](GLPresentInfo) { return true; };
+  dispatch_table.gl_fbo_callback = [](GLFrameInfo) -> intptr_t { return 0; };
+  if (age) {
+    dispatch_table.gl_framebuffer_age_callback = [age]() { return *age; };
+  }
+  return std::make_unique<EmbedderSurfaceGL>(
+      dispatch_table, /*fbo_reset_after_present=*/false,
+      /*external_view_embedder=*/nullptr);
+}
+
+static void PresentWithDamage(GPUSurfaceGLDelegate& delegate,
+                              std::optional<SkIRect> frame_damage) {
+  ASSERT_TRUE(
+      delegate.GLContextPresentWithInfo({0, frame_damage, frame_damage}));
+}
+
+TEST(EmbedderSurfaceGL, DoesNotSupportPartialRepaintWithoutFramebufferAge) {
+  auto surface = CreateSurfaceWithFramebufferAge(nullptr);
+  ASSERT_TRUE(surface->IsValid());
+  GPUSurfaceGLDelegate& delegate = *surface;
+
+  PresentWithDamage(delegate, SkIRect::MakeXYWH(0, 0, 10, 10));
+  SurfaceFrame::FramebufferInfo info = delegate.GLContextFramebufferInfo();
+  ASSERT_FALSE(info.supports_partial_repaint);
+  ASSERT_FALSE(info.existing_damage.has_value());
+}
+
+TEST(EmbedderSurfaceGL, RepaintsFramebuffersOfAgeZeroInFull) {
+  uint32_t age = 0;
+  auto surface = CreateSurfaceWithFramebufferAge(&age);
+  GPUSurfaceGLDelegate& delegate = *surface;
+
+  PresentWithDamage(delegate, SkIRect::MakeXYWH(0, 0, 10, 10));
+  SurfaceFrame::FramebufferInfo info = delegate.GLContextFramebufferInfo();
+  ASSERT_TRUE(info.supports_partial_repaint);
+  // The contents of the framebuffer are undefined.
+  ASSERT_FALSE(info.existing_damage.has_value());
+}
+
+TEST(EmbedderSurfaceGL, FramebuffersOfAgeOneHaveNoExistingDamage) {
+  uint32_t age = 1;
+  auto surface = CreateSurfaceWithFramebufferAge(&age);
+  GPUSurfaceGLDelegate& delegate = *surface;
+
+  PresentWithDamage(delegate, SkIRect::MakeXYWH(0, 0, 10, 10));
+  SurfaceFrame::FramebufferInfo info = delegate.GLContextFramebufferInfo();
+  ASSERT_TRUE(info.supports_partial_repaint);
+  ASSERT_EQ(info.existing_damage, SkIRect::MakeEmpty());
+}
+
+TEST(EmbedderSurfaceGL, FramebuffersOfAgeTwoMissTheDamageOfTheLastFrame) {
+  uint32_t age = 2;
+  auto surface = CreateSurfaceWithFramebufferAge(&age);
+  GPUSurfaceGLDelegate& delegate = *surface;
+
+  PresentWithDamage(delegate, SkIRect::MakeXYWH(0, 0, 10, 10));
+  PresentWithDamage(delegate, SkIRect::MakeXYWH(20, 20, 10, 10));
+  SurfaceFrame::FramebufferInfo info = delegate.GLContextFramebufferInfo();
+  ASSERT_TRUE(info.supports_partial_repaint);
+  ASSERT_EQ(info.existing_damage, SkIRect::MakeXYWH(20, 20, 10, 10));
+
+  // An older framebuffer misses the damage of every frame presented since.
+  age = 3;
+  info = delegate.GLContextFramebufferInfo();
+  ASSERT_EQ(info.existing_damage, SkIRect::MakeXYWH(0, 0, 30, 30));
+}
+
+TEST(EmbedderSurfaceGL, RepaintsInFullWhenTheMissedDamageIsUnknown) {
+  uint32_t age = 3;
+  auto surface = CreateSurfaceWithFramebufferAge(&age);
+  GPUSurfaceGLDelegate& delegate = *surface;
+
+  // Fewer frames were presented than the framebuffer is old.
+  PresentWithDamage(delegate, SkIRect::MakeXYWH(0, 0, 10, 10));
+  SurfaceFrame::FramebufferInfo info = delegate.GLContextFramebufferInfo();
+  ASSERT_TRUE(info.supports_partial_repaint);
+  ASSERT_FALSE(info.existing_damage.has_value());
+
+  // A frame presented in full in between leaves the missed damage unknown.
+  PresentWithDamage(delegate, std::nullopt);
+  PresentWithDamage(delegate, SkIRect::MakeXYWH(20, 20, 10, 10));
+  info = delegate.GLContextFramebufferInfo();
+  ASSERT_FALSE(info.existing_damage.has_value());
+
+  // The damage of frames older than the history is not remembered.
+  for (int i = 0; i < 4; i++) {
+    PresentWithDamage(delegate, SkIRect::MakeXYWH(0, 0, 10, 10));
+  }
+  info = delegate.GLContextFramebufferInfo();
+  ASSERT_EQ(info.existing_damage, SkIRect::MakeXYWH(0, 0, 10, 10));
+  age = 6;
+  info = delegate.GLContextFramebufferInfo();
+  ASSERT_FALSE(info.existing_damage.has_value());
+}
+
 }  // namespace testing
 }  // namespace flutter
@@ -19,23 +19,29 @@ class CompatTaskRunner : public fml::TaskRunner {
     FML_DCHECK(forwarding_target_);
   }
 
-  void PostTask(const fml::closure& task) override {
-    async::PostTask(forwarding_target_, task);
+  void PostTask(fml::UniqueClosure task) override {
+    async::PostTask(forwarding_target_, std::move(task));
   }
 
-  void PostTaskForTime(const fml::closure& task,
+  void PostTaskForTime(fml::UniqueClosure task,
                        fml::TimePoint target_time) override {
     async::PostTaskForTime(
-        forwarding_target_, task,
+        forwarding_target_, std::move(task),
         zx::time(target_time.ToEpochDelta().ToNanoseconds()));
   }
 
-  void PostDelayedTask(const fml::closure& task,
+  void PostDelayedTask(fml::UniqueClosure task,
                        fml::TimeDelta delay) override {
-    async::PostDelayedTask(forwarding_target_, task,
+    async::PostDelayedTask(forwarding_target_, std::move(task),
                            zx::duration(delay.ToNanoseconds()));
   }
 
+  void PostTaskWithGrade(fml::UniqueClosure task,
+                         fml::TimePoint target_time,
+                         fml::TaskSourceGrade task_source_grade) override {
+    PostTaskForTime(std::move(task), target_time);
+  }
+
   bool RunsTasksOnCurrentThread() override {
     return forwarding_target_ == async_get_default_dispatcher();
   }
@@ -212,6 +212,8 @@ def RunEngineBenchmarks(build_dir, filter):
 
   RunEngineExecutable(build_dir, 'fml_benchmarks', filter, icu_flags)
 
+  RunEngineExecutable(build_dir, 'flow_benchmarks', filter, icu_flags)
+
   RunEngineExecutable(build_dir, 'ui_benchmarks', filter, icu_flags)
 
   if IsLinux():